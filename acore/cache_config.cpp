@@ -27,8 +27,18 @@ void cache_config::json_serialize() const
 {
     set_json("default_ttl", int(default_ttl));
     set_json("cache_garbage_collect_ms", int(cache_garbage_collect_ms));
-    set_json("cache_max_referral_rrs", int(cache_max_referral_rrs));
-    set_json("cache_max_answer_rrs", int(cache_max_answer_rrs));
+    set_json("cache_max_referral_kb", int(cache_max_referral_kb));
+    set_json("cache_max_answer_kb", int(cache_max_answer_kb));
+    set_json("cache_shards", int(cache_shards));
+    set_json("prefetch_min_hits", int(prefetch_min_hits));
+    set_json("prefetch_ttl_pct", int(prefetch_ttl_pct));
+    set_json("serve_stale", serve_stale);
+    set_json("stale_answer_ttl", int(stale_answer_ttl));
+    set_json("max_stale_ttl", int(max_stale_ttl));
+    set_json("snapshot_file", snapshot_file);
+    set_json("snapshot_interval_s", int(snapshot_interval_s));
+    set_json("root_zone_file", root_zone_file);
+    set_json("root_zone_refresh_s", int(root_zone_refresh_s));
 
     set_json("client", client.to_json());
 }
@@ -37,8 +47,18 @@ void cache_config::json_unserialize()
 {
     default_ttl = int((*m_json_object)["default_ttl"]);
     cache_garbage_collect_ms = int((*m_json_object)["cache_garbage_collect_ms"]);
-    cache_max_referral_rrs = int((*m_json_object)["cache_max_referral_rrs"]);
-    cache_max_answer_rrs = int((*m_json_object)["cache_max_answer_rrs"]);
+    cache_max_referral_kb = int((*m_json_object)["cache_max_referral_kb"]);
+    cache_max_answer_kb = int((*m_json_object)["cache_max_answer_kb"]);
+    cache_shards = int((*m_json_object)["cache_shards"]);
+    prefetch_min_hits = int((*m_json_object)["prefetch_min_hits"]);
+    prefetch_ttl_pct = int((*m_json_object)["prefetch_ttl_pct"]);
+    serve_stale = (*m_json_object)["serve_stale"];
+    stale_answer_ttl = int((*m_json_object)["stale_answer_ttl"]);
+    max_stale_ttl = int((*m_json_object)["max_stale_ttl"]);
+    snapshot_file = string((*m_json_object)["snapshot_file"]);
+    snapshot_interval_s = int((*m_json_object)["snapshot_interval_s"]);
+    root_zone_file = string((*m_json_object)["root_zone_file"]);
+    root_zone_refresh_s = int((*m_json_object)["root_zone_refresh_s"]);
 
     client.from_json((*m_json_object)["client"]);
 }
@@ -43,11 +43,45 @@ namespace adns
         // how many ms to wait between cache garbage collect operations
         uint cache_garbage_collect_ms;
 
-        // maximum number of referals stored in the cache
-        uint cache_max_referral_rrs;
+        // memory budget for referrals stored in the cache (kilobytes)
+        uint cache_max_referral_kb;
 
-        // maximum number of answers stored in the cache
-        uint cache_max_answer_rrs;
+        // memory budget for answers stored in the cache (kilobytes)
+        uint cache_max_answer_kb;
+
+        // number of separately locked shards the cache is split into, rounded up to a power of two
+        uint cache_shards;
+
+        // answers looked up at least this many times are refreshed in the background before 
+        // they expire (0 to turn prefetch off)
+        uint prefetch_min_hits;
+
+        // how far into the TTL an answer has to be before it's prefetched - percentage of
+        // the TTL left
+        uint prefetch_ttl_pct;
+
+        // serve expired answers if the upstream nameservers aren't responding (RFC 8767)
+        bool serve_stale;
+
+        // TTL given to stale answers (seconds)
+        uint stale_answer_ttl;
+
+        // how long after expiry an answer can still be served stale (seconds)
+        uint max_stale_ttl;
+
+        // file the cache contents are saved to and reloaded from on startup (empty for none). 
+        // Forwarding caches use the same name with the server ID appended.
+        std::string snapshot_file;
+
+        // how often the cache contents are saved (seconds) - they're always saved on shutdown
+        uint snapshot_interval_s;
+
+        // local copy of the root zone in master file format (RFC 8806), empty to always ask
+        // the root servers
+        std::string root_zone_file;
+
+        // how often the root zone file is reloaded (seconds)
+        uint root_zone_refresh_s;
 
         // base config for the DNS client used by the cache for updating root hints
         client_config client;
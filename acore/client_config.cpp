@@ -65,4 +65,5 @@ void client_config::json_unserialize()
     connect_tcp_timeout_ms = int((*m_json_object)["connect_tcp_timeout_ms"]);
     read_tcp_timeout_ms = int((*m_json_object)["read_tcp_timeout_ms"]);
     write_tcp_timeout_ms = int((*m_json_object)["write_tcp_timeout_ms"]);
+    use_tls = false;
 }
@@ -49,6 +49,9 @@ namespace adns
         uint read_tcp_timeout_ms;
         uint write_tcp_timeout_ms;
 
+        // DNS over TLS (RFC 7858) in place of plain TCP, not stored - set per query for forwarders that want it
+        bool use_tls;
+
     protected:
 
         /**
@@ -42,6 +42,7 @@
 
 #include "types.hpp"
 #include "config.hpp"
+#include "log_queue.hpp"
 #include "exception.hpp"
 #include "connection_pool.hpp"
 #include "transaction.hpp"
@@ -89,6 +90,26 @@ string config::ssl_server_key_file()
                 "ssl-server-key-file not set in configuration");
 }
 
+uint config::ssl_session_cache_size()
+{
+    return o_tree.get<uint>("static-config.tls.session-cache-size", 20480);
+}
+
+uint config::ssl_ticket_key_lifetime_s()
+{
+    return o_tree.get<uint>("static-config.tls.ticket-key-lifetime-s", 3600);
+}
+
+bool config::ssl_early_data()
+{
+    return o_tree.get<bool>("static-config.tls.early-data", false);
+}
+
+bool config::ssl_kernel_tls()
+{
+    return o_tree.get<bool>("static-config.tls.kernel-tls", true);
+}
+
 string config::server_config_username()
 {
     return get_tree_string(
@@ -181,31 +202,40 @@ void config::init_log(string bootstrap_config_filename)
     }
 
     string log_level = o_tree.get<string>("static-config.log.level", "info");
+    trivial::severity_level level = trivial::trace;
 
     if (log_level == "trace")
     {
-        core::get()->set_filter(trivial::severity >= trivial::trace);
+        level = trivial::trace;
     }
     else if (log_level == "debug")
     {
-        core::get()->set_filter(trivial::severity >= trivial::debug);
+        level = trivial::debug;
     }
     else if (log_level == "info")
     {
-        core::get()->set_filter(trivial::severity >= trivial::info);
+        level = trivial::info;
     }
     else if (log_level == "warning")
     {
-        core::get()->set_filter(trivial::severity >= trivial::warning);
+        level = trivial::warning;
     }
     else if (log_level == "error")
     {
-        core::get()->set_filter(trivial::severity >= trivial::error);
+        level = trivial::error;
     }
     else if (log_level == "fatal")
     {
-        core::get()->set_filter(trivial::severity >= trivial::fatal);
+        level = trivial::fatal;
     }
+
+    core::get()->set_filter(trivial::severity >= level);
+    log_queue::set_level(level);
+}
+
+bool config::log_async()
+{
+    return o_tree.get<bool>("static-config.log.async", true);
 }
 
 void config::init_db_config()
@@ -81,6 +81,11 @@ namespace adns
          */
         static void init_log(std::string bootstrap_config_filename);
 
+        /**
+         * Should log records be written by a background thread rather than the caller?
+         */
+        static bool log_async();
+
         /**
          * Cache config values from the DB.
          */
@@ -116,6 +121,28 @@ namespace adns
          */
         static std::string ssl_server_key_file();
 
+        /**
+         * most sessions held in the TLS server session cache
+         */
+        static uint ssl_session_cache_size();
+
+        /**
+         * how long a TLS session ticket key is used for before a new one takes over, tickets
+         * are turned off if zero
+         */
+        static uint ssl_ticket_key_lifetime_s();
+
+        /**
+         * accept TLS 1.3 early data (0-RTT) from resuming clients? It can be replayed by an
+         * attacker so it's off unless asked for.
+         */
+        static bool ssl_early_data();
+
+        /**
+         * hand TLS record encryption to the kernel (kTLS) where supported?
+         */
+        static bool ssl_kernel_tls();
+
         /**
          * username for server configuration
          */
@@ -51,6 +51,7 @@ void config_reader::translate_client_row(client_config &c, const row_dns_client
     c.connect_tcp_timeout_ms = r.get_connect_tcp_timeout_ms();
     c.read_tcp_timeout_ms = r.get_read_tcp_timeout_ms();
     c.write_tcp_timeout_ms = r.get_write_tcp_timeout_ms();
+    c.use_tls = false;
 }
 
 void config_reader::read()
@@ -100,6 +101,7 @@ void config_reader::read()
                 s.dns.tcp_max_body_wait_ms = dns_row->get_tcp_max_body_wait_ms();
                 s.dns.num_udp_recursive_slots = dns_row->get_num_udp_recursive_slots();
                 s.dns.num_tcp_recursive_slots = dns_row->get_num_tcp_recursive_slots();
+                s.dns.num_recursive_threads = dns_row->get_num_recursive_threads();
                 s.dns.recursive_timeout_ms = dns_row->get_recursive_timeout_ms();
                 s.dns.max_recursion_depth = dns_row->get_max_recursion_depth();
                 s.dns.max_external_resolutions = dns_row->get_max_external_resolutions();
@@ -115,6 +117,16 @@ void config_reader::read()
                 s.dns.forward_cache_max_age_seconds = dns_row->get_forward_cache_max_age_seconds();
                 s.dns.forward_cache_max_entries = dns_row->get_forward_cache_max_entries();
                 s.dns.forward_cache_garbage_collect_pct = dns_row->get_forward_cache_garbage_collect_pct();
+                s.dns.forward_max_in_flight = dns_row->get_forward_max_in_flight();
+                s.dns.forward_hedge_queries = dns_row->get_forward_hedge_queries();
+                s.dns.max_queue_wait_ms = dns_row->get_max_queue_wait_ms();
+                s.dns.queue_shed_policy = dns_row->get_queue_shed_policy();
+                s.dns.max_tcp_connections = dns_row->get_max_tcp_connections();
+                s.dns.max_tcp_queries_in_flight = dns_row->get_max_tcp_queries_in_flight();
+                s.dns.max_doh_streams = dns_row->get_max_doh_streams();
+                s.dns.receive_thread_cpus = dns_row->get_receive_thread_cpus();
+                s.dns.handler_thread_cpus = dns_row->get_handler_thread_cpus();
+                s.dns.send_thread_cpus = dns_row->get_send_thread_cpus();
 
                 auto dns_client_row = row_dns_client::get_by_client_id(*conn, dns_row->get_client_id());
 
@@ -186,8 +198,18 @@ void config_reader::read()
     m_cache_config.cache_config_id = rcc->get_cache_config_id();
     m_cache_config.default_ttl = rcc->get_default_ttl();
     m_cache_config.cache_garbage_collect_ms = rcc->get_cache_garbage_collect_ms();
-    m_cache_config.cache_max_referral_rrs = rcc->get_cache_max_referral_rrs();
-    m_cache_config.cache_max_answer_rrs = rcc->get_cache_max_answer_rrs();
+    m_cache_config.cache_max_referral_kb = rcc->get_cache_max_referral_kb();
+    m_cache_config.cache_max_answer_kb = rcc->get_cache_max_answer_kb();
+    m_cache_config.cache_shards = rcc->get_cache_shards();
+    m_cache_config.prefetch_min_hits = rcc->get_prefetch_min_hits();
+    m_cache_config.prefetch_ttl_pct = rcc->get_prefetch_ttl_pct();
+    m_cache_config.serve_stale = rcc->get_serve_stale();
+    m_cache_config.stale_answer_ttl = rcc->get_stale_answer_ttl();
+    m_cache_config.max_stale_ttl = rcc->get_max_stale_ttl();
+    m_cache_config.snapshot_file = rcc->get_snapshot_file();
+    m_cache_config.snapshot_interval_s = rcc->get_snapshot_interval_s();
+    m_cache_config.root_zone_file = rcc->get_root_zone_file();
+    m_cache_config.root_zone_refresh_s = rcc->get_root_zone_refresh_s();
 
     translate_client_row(m_cache_config.client, *rccc);
 }
@@ -390,6 +412,7 @@ void config_reader::build_row(const server_config &sc, row_dns_server &rs)
     rs.set_tcp_max_body_wait_ms(sc.dns.tcp_max_body_wait_ms);
     rs.set_num_udp_recursive_slots(sc.dns.num_udp_recursive_slots);
     rs.set_num_tcp_recursive_slots(sc.dns.num_tcp_recursive_slots);
+    rs.set_num_recursive_threads(sc.dns.num_recursive_threads);
     rs.set_recursive_timeout_ms(sc.dns.recursive_timeout_ms);
     rs.set_max_recursion_depth(sc.dns.max_recursion_depth);
     rs.set_max_external_resolutions(sc.dns.max_external_resolutions);
@@ -403,6 +426,16 @@ void config_reader::build_row(const server_config &sc, row_dns_server &rs)
     rs.set_forward_cache_max_age_seconds(sc.dns.forward_cache_max_age_seconds);
     rs.set_forward_cache_max_entries(sc.dns.forward_cache_max_entries);
     rs.set_forward_cache_garbage_collect_pct(sc.dns.forward_cache_garbage_collect_pct);
+    rs.set_forward_max_in_flight(sc.dns.forward_max_in_flight);
+    rs.set_forward_hedge_queries(sc.dns.forward_hedge_queries);
+    rs.set_max_queue_wait_ms(sc.dns.max_queue_wait_ms);
+    rs.set_queue_shed_policy(sc.dns.queue_shed_policy);
+    rs.set_max_tcp_connections(sc.dns.max_tcp_connections);
+    rs.set_max_tcp_queries_in_flight(sc.dns.max_tcp_queries_in_flight);
+    rs.set_max_doh_streams(sc.dns.max_doh_streams);
+    rs.set_receive_thread_cpus(sc.dns.receive_thread_cpus);
+    rs.set_handler_thread_cpus(sc.dns.handler_thread_cpus);
+    rs.set_send_thread_cpus(sc.dns.send_thread_cpus);
 
     rs.set_doh_client_timeout_ms(sc.dns.doh_client_timeout_ms);
     rs.set_maximum_http_request_size(sc.dns.maximum_http_request_size);
@@ -650,8 +683,18 @@ void config_reader::update_cache_config(const cache_config &c)
     rcc.set_cache_config_id(c.cache_config_id);
     rcc.set_default_ttl(c.default_ttl);
     rcc.set_cache_garbage_collect_ms(c.cache_garbage_collect_ms);
-    rcc.set_cache_max_referral_rrs(c.cache_max_referral_rrs);
-    rcc.set_cache_max_answer_rrs(c.cache_max_answer_rrs);
+    rcc.set_cache_max_referral_kb(c.cache_max_referral_kb);
+    rcc.set_cache_max_answer_kb(c.cache_max_answer_kb);
+    rcc.set_cache_shards(c.cache_shards);
+    rcc.set_prefetch_min_hits(c.prefetch_min_hits);
+    rcc.set_prefetch_ttl_pct(c.prefetch_ttl_pct);
+    rcc.set_serve_stale(c.serve_stale);
+    rcc.set_stale_answer_ttl(c.stale_answer_ttl);
+    rcc.set_max_stale_ttl(c.max_stale_ttl);
+    rcc.set_snapshot_file(c.snapshot_file);
+    rcc.set_snapshot_interval_s(c.snapshot_interval_s);
+    rcc.set_root_zone_file(c.root_zone_file);
+    rcc.set_root_zone_refresh_s(c.root_zone_refresh_s);
     rcc.update_row(*conn);
 
     row_dns_client rc;
@@ -0,0 +1,166 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <filesystem>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "cpu_affinity.hpp"
+#include "monitor.hpp"
+
+using namespace std;
+using namespace adns;
+
+vector<int> cpu_affinity::parse(const string &cpus)
+{
+    vector<int> res;
+    vector<string> ranges;
+
+    if (boost::trim_copy(cpus) == "")
+    {
+        return res;
+    }
+
+    long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+
+    boost::split(ranges, cpus, boost::is_any_of(","));
+
+    for (auto r : ranges)
+    {
+        vector<string> ends;
+        boost::split(ends, r, boost::is_any_of("-"));
+
+        try
+        {
+            int from, to;
+
+            if (ends.size() == 1)
+            {
+                from = to = boost::lexical_cast<int>(boost::trim_copy(ends[0]));
+            }
+            else if (ends.size() == 2)
+            {
+                from = boost::lexical_cast<int>(boost::trim_copy(ends[0]));
+                to = boost::lexical_cast<int>(boost::trim_copy(ends[1]));
+            }
+            else
+            {
+                THROW(cpu_affinity_exception, "invalid CPU range", r);
+            }
+
+            if ((from < 0) || (to < from) || (to >= num_cpus) || (to >= CPU_SETSIZE))
+            {
+                THROW(cpu_affinity_exception, "CPU range out of bounds", r);
+            }
+
+            for (int i = from; i <= to; i++)
+            {
+                res.push_back(i);
+            }
+        }
+        catch (boost::bad_lexical_cast &e)
+        {
+            THROW(cpu_affinity_exception, "invalid CPU number", r);
+        }
+    }
+
+    return res;
+}
+
+int cpu_affinity::select(const vector<int> &cpus, uint index)
+{
+    if (cpus.empty())
+    {
+        return -1;
+    }
+    else
+    {
+        return cpus[index % cpus.size()];
+    }
+}
+
+void cpu_affinity::pin(thread &t, int cpu)
+{
+    if (cpu < 0)
+    {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int res = pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &set);
+
+    if (res != 0)
+    {
+        THROW(cpu_affinity_exception, "pthread_setaffinity_np() failed", boost::lexical_cast<string>(cpu), res);
+    }
+}
+
+int cpu_affinity::numa_node(int cpu)
+{
+    try
+    {
+        filesystem::path p("/sys/devices/system/cpu/cpu" + boost::lexical_cast<string>(cpu));
+
+        for (auto &e : filesystem::directory_iterator(p))
+        {
+            string name = e.path().filename().string();
+
+            if (name.starts_with("node"))
+            {
+                return boost::lexical_cast<int>(name.substr(4));
+            }
+        }
+    }
+    catch (...)
+    {
+        // sysfs not available (e.g. in a chroot)
+    }
+
+    return -1;
+}
+
+void cpu_affinity::report(const string &instance, const string &stage, uint index, int cpu)
+{
+    string placement;
+
+    if (cpu < 0)
+    {
+        placement = "unpinned";
+    }
+    else
+    {
+        placement = "cpu " + boost::lexical_cast<string>(cpu);
+
+        int node = numa_node(cpu);
+
+        if (node >= 0)
+        {
+            placement += " node " + boost::lexical_cast<string>(node);
+        }
+    }
+
+    (void)monitor::add_thing("cpu placement", instance, stage + " thread " + boost::lexical_cast<string>(index), placement);
+}
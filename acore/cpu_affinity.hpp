@@ -0,0 +1,69 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "types.hpp"
+#include "exception.hpp"
+
+EXCEPTION_CLASS(cpu_affinity_exception, exception)
+
+namespace adns
+{
+    /**
+     * Helpers for pinning threads to CPUs and reporting where they ended up.
+     */
+    class cpu_affinity final
+    {
+    public:
+
+        cpu_affinity() = delete;
+
+        /**
+         * Turn a CPU list such as "0-3,8,10-11" into the list of CPU numbers. An empty string
+         * gives an empty list which means don't pin.
+         */
+        static std::vector<int> parse(const std::string &cpus);
+
+        /**
+         * The CPU the index'th thread of a stage should be pinned to, -1 if the stage isn't pinned.
+         * Threads are assigned round robin over the list.
+         */
+        static int select(const std::vector<int> &cpus, uint index);
+
+        /**
+         * Pin a thread to a single CPU (no-op for cpu -1).
+         */
+        static void pin(std::thread &t, int cpu);
+
+        /**
+         * The NUMA node a CPU belongs to, -1 if not known.
+         */
+        static int numa_node(int cpu);
+
+        /**
+         * Record where a thread has been placed in the monitor.
+         */
+        static void report(const std::string &instance, const std::string &stage, uint index, int cpu);
+    };
+}
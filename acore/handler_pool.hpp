@@ -20,6 +20,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include <algorithm>
 #include <thread>
 #include <atomic>
@@ -30,6 +31,7 @@
 #include "exception.hpp"
 #include "run_state.hpp"
 #include "monitor.hpp"
+#include "cpu_affinity.hpp"
 
 namespace adns
 {
@@ -46,12 +48,22 @@ namespace adns
         /**
          * Create a queue with the given maximum length and number_of_processor threads
          * to consume messages from it. When the max length is reached, the oldest
-         * messages are dropped to make space for new ones.
+         * messages are dropped to make space for new ones. If cpus isn't empty, the
+         * threads are pinned round robin to the CPUs listed. The input queue has num_lanes
+         * priority lanes and sheds messages according to policy when full.
          */
-        handler_pool(std::string name, const PROCESSOR_PARAMS &params, int max_in_length, int max_out_length, int num_threads) :
+        handler_pool(
+                std::string             name,
+                const PROCESSOR_PARAMS  &params,
+                int                     max_in_length,
+                int                     max_out_length,
+                int                     num_threads,
+                const std::vector<int>  &cpus = std::vector<int>(),
+                uint                    num_lanes = 1,
+                typename message_queue<MESSAGE>::shed_policy_t policy = message_queue<MESSAGE>::refuse_new_e) :
             m_name(name),
             m_params(params),
-            m_in_queue(new message_queue<MESSAGE>(m_name + " input queue", max_in_length)),
+            m_in_queue(new message_queue<MESSAGE>(m_name + " input queue", max_in_length, num_lanes, policy)),
             m_out_queue(new message_queue<MESSAGE>(m_name + " output queue", max_out_length)),
             m_multiplexer(nullptr),
             m_available_threads_monitor_id(monitor::add_thing("handler pool", name, "available threads", num_threads)),
@@ -63,6 +75,13 @@ namespace adns
                 auto p = new PROCESSOR(m_params, *m_out_queue);
                 m_processors.push_back(std::shared_ptr<PROCESSOR>(p));
                 m_threads.push_back(std::make_shared<std::thread>(&handler_pool::run, this, p));
+
+                if (!cpus.empty())
+                {
+                    int cpu = cpu_affinity::select(cpus, i);
+                    cpu_affinity::pin(*m_threads.back(), cpu);
+                    cpu_affinity::report(name, "handler", i, cpu);
+                }
             }
 
             (void)monitor::add_thing("handler pool", name, "maximum threads", num_threads);
@@ -109,6 +128,22 @@ namespace adns
             return m_in_queue->enqueue(m);
         }
 
+        /**
+         * Add a message to the given priority lane of the processing queue, deleting anything
+         * lower priority that was shed to make room for it.
+         * @return  true if there was space to enqueue the message, false otherwise
+         */
+        bool enqueue(MESSAGE m, uint lane)
+        {
+            MESSAGE shed = MESSAGE();
+
+            bool res = m_in_queue->enqueue(m, lane, shed);
+
+            delete shed;
+
+            return res;
+        }
+
         /**
          * Get the next message from the return queue.
          */
@@ -0,0 +1,245 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "log_queue.hpp"
+#include "monitor.hpp"
+
+using namespace std;
+using namespace adns;
+using namespace boost::log;
+using namespace boost::log::trivial;
+
+log_queue::record_t log_queue::o_records[log_queue::queue_size];
+
+atomic<size_t> log_queue::o_enqueue_position(0);
+atomic<size_t> log_queue::o_dequeue_position(0);
+
+atomic<severity_level> log_queue::o_level(trace);
+atomic<bool> log_queue::o_running(false);
+atomic<bool> log_queue::o_stop(false);
+atomic<uint> log_queue::o_dropped(0);
+
+unique_ptr<thread> log_queue::o_writer_thread;
+
+void log_queue::start()
+{
+    if (o_writer_thread)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < queue_size; i++)
+    {
+        o_records[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    o_enqueue_position = 0;
+    o_dequeue_position = 0;
+    o_stop = false;
+    o_writer_thread.reset(new thread(&log_queue::run));
+    o_running = true;
+
+    atexit(&log_queue::stop);
+
+    LOG(info) << "asynchronous logging started";
+}
+
+void log_queue::stop()
+{
+    if (!o_writer_thread)
+    {
+        return;
+    }
+
+    o_running = false;
+    o_stop = true;
+
+    o_writer_thread->join();
+    o_writer_thread = nullptr;
+
+    // pick up anything queued between the writer's last pass and o_running being cleared
+    drain();
+}
+
+void log_queue::set_level(severity_level level)
+{
+    o_level = level;
+}
+
+void log_queue::write(severity_level level, const string &text)
+{
+    if (!o_running)
+    {
+        emit(level, text.c_str(), text.size());
+    }
+    else if (!enqueue(level, text))
+    {
+        o_dropped++;
+    }
+}
+
+bool log_queue::enqueue(severity_level level, const string &text)
+{
+    size_t pos = o_enqueue_position.load(memory_order_relaxed);
+    record_t *r;
+
+    while (true)
+    {
+        r = &o_records[pos & (queue_size - 1)];
+
+        size_t seq = r->sequence.load(memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (o_enqueue_position.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // full
+            return false;
+        }
+        else
+        {
+            pos = o_enqueue_position.load(memory_order_relaxed);
+        }
+    }
+
+    r->level = level;
+    r->length = min(text.size(), max_record_length);
+    memcpy(r->text, text.data(), r->length);
+    r->sequence.store(pos + 1, memory_order_release);
+
+    return true;
+}
+
+size_t log_queue::drain()
+{
+    size_t n = 0;
+
+    // only ever one consumer so no need to contend for the dequeue position
+    while (true)
+    {
+        size_t pos = o_dequeue_position.load(memory_order_relaxed);
+        record_t &r = o_records[pos & (queue_size - 1)];
+
+        if (r.sequence.load(memory_order_acquire) != pos + 1)
+        {
+            return n;
+        }
+
+        emit(r.level, r.text, r.length);
+
+        o_dequeue_position.store(pos + 1, memory_order_relaxed);
+        r.sequence.store(pos + queue_size, memory_order_release);
+        n++;
+    }
+}
+
+void log_queue::run()
+{
+    uint dropped_id = monitor::add_thing("log", "queue", "dropped", 0);
+    uint total_dropped = 0;
+
+    while (!o_stop)
+    {
+        if (drain() == 0)
+        {
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+
+        uint dropped = o_dropped.exchange(0);
+
+        if (dropped > 0)
+        {
+            total_dropped += dropped;
+            monitor::set_value(dropped_id, total_dropped);
+            LOG(warning) << "log queue full, dropped " << dropped << " messages";
+        }
+    }
+}
+
+void log_queue::emit(severity_level level, const char *text, size_t length)
+{
+    BOOST_LOG_STREAM_WITH_PARAMS(logger::get(), (keywords::severity = level)) << string_view(text, length);
+}
+
+log_rate_limiter::log_rate_limiter(uint max_per_second) :
+            m_max_per_second(max_per_second),
+            m_window(0),
+            m_count(0),
+            m_suppressed(0)
+{
+}
+
+bool log_rate_limiter::allow()
+{
+    time_t now = time(nullptr);
+    time_t window = m_window.load(memory_order_relaxed);
+
+    if ((window != now) && m_window.compare_exchange_strong(window, now))
+    {
+        m_count = 0;
+    }
+
+    if (m_count.fetch_add(1, memory_order_relaxed) < m_max_per_second)
+    {
+        return true;
+    }
+    else
+    {
+        m_suppressed++;
+        return false;
+    }
+}
+
+uint log_rate_limiter::take_suppressed()
+{
+    return m_suppressed.exchange(0);
+}
+
+log_line::log_line(severity_level level) : m_level(level), m_limiter(nullptr)
+{
+}
+
+log_line::log_line(severity_level level, log_rate_limiter &limiter) : m_level(level), m_limiter(&limiter)
+{
+}
+
+log_line::~log_line()
+{
+    if (m_limiter)
+    {
+        uint suppressed = m_limiter->take_suppressed();
+
+        if (suppressed > 0)
+        {
+            m_stream << " (suppressed " << suppressed << " similar messages)";
+        }
+    }
+
+    log_queue::write(m_level, m_stream.str());
+}
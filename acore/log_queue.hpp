@@ -0,0 +1,203 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <memory>
+
+#include "types.hpp"
+
+/**
+ * Log through the asynchronous queue rather than directly through Boost.Log. Use this for
+ * logging on paths that may be hit for every packet.
+ */
+#define ALOG(lvl) \
+    for (bool adns_log_on_ = adns::log_queue::enabled(boost::log::trivial::lvl); \
+         adns_log_on_; \
+         adns_log_on_ = false) \
+        adns::log_line(boost::log::trivial::lvl).stream()
+
+/**
+ * As ALOG but allow at most per_second messages a second from this call site. Anything over
+ * that is counted and reported as a suppressed count on the next message that gets through.
+ */
+#define ALOG_LIMITED(lvl, per_second) \
+    switch (static adns::log_rate_limiter adns_log_limiter_(per_second); 0) \
+    default: \
+        for (bool adns_log_on_ = adns::log_queue::enabled(boost::log::trivial::lvl) && adns_log_limiter_.allow(); \
+             adns_log_on_; \
+             adns_log_on_ = false) \
+            adns::log_line(boost::log::trivial::lvl, adns_log_limiter_).stream()
+
+namespace adns
+{
+    /**
+     * A fixed size, lock-free, multiple producer queue of log records drained by a single
+     * background thread that passes them on to Boost.Log. If the queue is full the record is
+     * dropped and counted rather than blocking the caller. Until start() is called (and after
+     * stop() is called) records are written synchronously.
+     */
+    class log_queue final
+    {
+    public:
+
+        /**
+         * Number of records the queue can hold, must be a power of two.
+         */
+        static const size_t queue_size = 4096;
+
+        /**
+         * Longest record text kept, anything longer is truncated.
+         */
+        static const size_t max_record_length = 256;
+
+        log_queue() = delete;
+
+        /**
+         * Start the background writer thread.
+         */
+        static void start();
+
+        /**
+         * Stop the background writer thread, writing out anything still queued.
+         */
+        static void stop();
+
+        /**
+         * Set the minimum severity level for which records are generated at all.
+         */
+        static void set_level(boost::log::trivial::severity_level level);
+
+        /**
+         * Would a record at the given level be logged? The compile time check means that calls
+         * below ADNS_LOG_MIN_LEVEL are removed entirely by the compiler.
+         */
+        static bool enabled(boost::log::trivial::severity_level level)
+        {
+            return (level >= ADNS_LOG_MIN_LEVEL) && (level >= o_level.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * Queue a record for writing (or write it directly if the writer isn't running).
+         */
+        static void write(boost::log::trivial::severity_level level, const std::string &text);
+
+    private:
+
+        typedef struct
+        {
+            std::atomic<size_t>                 sequence;
+            boost::log::trivial::severity_level level;
+            size_t                              length;
+            char                                text[max_record_length];
+        }
+        record_t;
+
+        static record_t o_records[queue_size];
+
+        static std::atomic<size_t> o_enqueue_position;
+        static std::atomic<size_t> o_dequeue_position;
+
+        static std::atomic<boost::log::trivial::severity_level> o_level;
+        static std::atomic<bool> o_running;
+        static std::atomic<bool> o_stop;
+        static std::atomic<uint> o_dropped;
+
+        static std::unique_ptr<std::thread> o_writer_thread;
+
+        /**
+         * Try to add a record to the queue, false if the queue was full.
+         */
+        static bool enqueue(boost::log::trivial::severity_level level, const std::string &text);
+
+        /**
+         * Write out everything currently in the queue, returns the number of records written.
+         */
+        static size_t drain();
+
+        /**
+         * Body of the writer thread.
+         */
+        static void run();
+
+        /**
+         * Write a single record to Boost.Log.
+         */
+        static void emit(boost::log::trivial::severity_level level, const char *text, size_t length);
+    };
+
+    /**
+     * Per call site rate limit, resolution is 1 second.
+     */
+    class log_rate_limiter final
+    {
+    public:
+
+        /**
+         * Allow at most max_per_second messages through each second.
+         */
+        log_rate_limiter(uint max_per_second);
+
+        /**
+         * Should this message be logged? If not, it's counted as suppressed.
+         */
+        bool allow();
+
+        /**
+         * Get the number of messages suppressed since the last call and reset the count.
+         */
+        uint take_suppressed();
+
+    private:
+
+        uint m_max_per_second;
+
+        std::atomic<time_t> m_window;
+        std::atomic<uint>   m_count;
+        std::atomic<uint>   m_suppressed;
+    };
+
+    /**
+     * A single log record being built up, queued on destruction.
+     */
+    class log_line final
+    {
+    public:
+
+        log_line(boost::log::trivial::severity_level level);
+        log_line(boost::log::trivial::severity_level level, log_rate_limiter &limiter);
+
+        ~log_line();
+
+        std::ostream &stream()
+        {
+            return m_stream;
+        }
+
+    private:
+
+        boost::log::trivial::severity_level m_level;
+        log_rate_limiter                    *m_limiter;
+        std::ostringstream                  m_stream;
+    };
+}
@@ -20,6 +20,8 @@
 #pragma once
 
 #include <list>
+#include <vector>
+#include <algorithm>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -27,27 +29,53 @@
 #include "types.hpp"
 #include "exception.hpp"
 #include "monitor.hpp"
+#include "log_queue.hpp"
 
 EXCEPTION_CLASS(message_queue_timeout_exception, exception)
 
 namespace adns
 {
     /**
-     * A threadsafe queue of messages to be processsed.
+     * A threadsafe queue of messages to be processsed. Messages can be put in one of several
+     * lanes, lane 0 being the highest priority. A message is only taken from a lane once all 
+     * higher priority lanes are empty; within a lane it's first in, first out.
      */
     template <class MESSAGE> class message_queue final
     {
     public:
 
         /**
-         * Create a queue with the given maximum length. When the max length is reached, the oldest
-         * messages are dropped to make space for new ones.
+         * what to do with a new message when the queue is full
          */
-        message_queue(std::string name, size_t max_queue_length) : 
+        typedef enum
+        {
+            // turn it away
+            refuse_new_e,
+
+            // make room by dropping the oldest message in the lowest priority lane below the 
+            // new one's, turning it away if there's nothing lower priority queued
+            shed_lowest_e
+        }
+        shed_policy_t;
+
+        /**
+         * Create a queue with the given maximum length shared by all the lanes. 
+         */
+        message_queue(
+                std::string   name, 
+                size_t        max_queue_length, 
+                uint          num_lanes = 1, 
+                shed_policy_t policy = refuse_new_e) : 
                                 m_name(name), 
                                 m_max_queue_length(max_queue_length), 
                                 m_queue_length(0),
-                                m_monitor_length_id(monitor::add_thing("queue", name, "length", 0))
+                                m_policy(policy),
+                                m_num_refused(0),
+                                m_num_shed(0),
+                                m_monitor_length_id(monitor::add_thing("queue", name, "length", 0)),
+                                m_monitor_refused_id(monitor::add_thing("queue", name, "refused when full", 0)),
+                                m_monitor_shed_id(monitor::add_thing("queue", name, "shed for higher priority", 0)),
+                                m_lanes(std::max<uint>(num_lanes, 1))
         {
             (void)monitor::add_thing("queue", name, "maximum length", max_queue_length);
         }
@@ -72,8 +100,16 @@ namespace adns
                         }
                     }
 
-                    m = m_message_queue.back();
-                    m_message_queue.pop_back();
+                    for (auto &lane : m_lanes)
+                    {
+                        if (!lane.empty())
+                        {
+                            m = lane.back();
+                            lane.pop_back();
+                            break;
+                        }
+                    }
+
                     m_queue_length--;
                     monitor::set_value(m_monitor_length_id, m_queue_length);
                 }
@@ -94,22 +130,43 @@ namespace adns
          * @return  true if there was space to enqueue, false otherwise
          */
         bool enqueue(MESSAGE m)
+        {
+            MESSAGE shed = MESSAGE();
+
+            return enqueue(m, 0, shed);
+        }
+
+        /**
+         * Add a message to the given lane (anything past the last lane goes in the last one). 
+         * If an older message had to be dropped to make room, it's handed back in shed for 
+         * the caller to dispose of.
+         * @return  true if there was space to enqueue, false otherwise
+         */
+        bool enqueue(MESSAGE m, uint lane, MESSAGE &shed)
         {
             std::lock_guard<std::mutex> guard(m_lock);
 
+            lane = std::min<uint>(lane, m_lanes.size() - 1);
+
             if (m_queue_length > m_max_queue_length)
             {
-                LOG(warning) << "queue " << m_name << " filled, not adding message";
-                return false;
-            }
-            else
-            {
-                m_message_queue.push_front(m);
-                monitor::set_value(m_monitor_length_id, m_queue_length);
-                m_queue_length++;
-                m_condition.notify_one();
-                return true;
+                if ((m_policy == shed_lowest_e) && shed_below(lane, shed))
+                {
+                    monitor::set_value(m_monitor_shed_id, ++m_num_shed);
+                }
+                else
+                {
+                    ALOG_LIMITED(warning, 1) << "queue " << m_name << " filled, not adding message";
+                    monitor::set_value(m_monitor_refused_id, ++m_num_refused);
+                    return false;
+                }
             }
+
+            m_lanes[lane].push_front(m);
+            m_queue_length++;
+            monitor::set_value(m_monitor_length_id, m_queue_length);
+            m_condition.notify_one();
+            return true;
         }
     
         /** 
@@ -126,11 +183,37 @@ namespace adns
 
         size_t m_max_queue_length;
         size_t m_queue_length;
+
+        shed_policy_t m_policy;
+        uint          m_num_refused;
+        uint          m_num_shed;
     
         uint m_monitor_length_id;
+        uint m_monitor_refused_id;
+        uint m_monitor_shed_id;
 
-        std::list<MESSAGE>      m_message_queue;
-        std::mutex              m_lock;
-        std::condition_variable m_condition;
+        std::vector<std::list<MESSAGE>> m_lanes;
+        std::mutex                      m_lock;
+        std::condition_variable         m_condition;
+
+        /**
+         * take the oldest message from the lowest priority lane below the given one, false
+         * if they're all empty
+         */
+        bool shed_below(uint lane, MESSAGE &shed)
+        {
+            for (uint i = m_lanes.size() - 1; i > lane; i--)
+            {
+                if (!m_lanes[i].empty())
+                {
+                    shed = m_lanes[i].back();
+                    m_lanes[i].pop_back();
+                    m_queue_length--;
+                    return true;
+                }
+            }
+
+            return false;
+        }
     };
 }
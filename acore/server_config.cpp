@@ -71,6 +71,7 @@ void server_config::json_serialize() const
         dnsj["tcp_max_body_wait_ms"] = int(dns.tcp_max_body_wait_ms);
         dnsj["num_udp_recursive_slots"] = int(dns.num_udp_recursive_slots);
         dnsj["num_tcp_recursive_slots"] = int(dns.num_tcp_recursive_slots);
+        dnsj["num_recursive_threads"] = int(dns.num_recursive_threads);
         dnsj["recursive_timeout_ms"] = int(dns.recursive_timeout_ms);
         dnsj["max_recursion_depth"] = int(dns.max_recursion_depth);
         dnsj["max_external_resolutions"] = int(dns.max_external_resolutions);
@@ -86,6 +87,16 @@ void server_config::json_serialize() const
         dnsj["forward_cache_max_age_seconds"] = int(dns.forward_cache_max_age_seconds);
         dnsj["forward_cache_max_entries"] = int(dns.forward_cache_max_entries);
         dnsj["forward_cache_garbage_collect_pct"] = int(dns.forward_cache_garbage_collect_pct);
+        dnsj["forward_max_in_flight"] = int(dns.forward_max_in_flight);
+        dnsj["forward_hedge_queries"] = dns.forward_hedge_queries;
+        dnsj["max_queue_wait_ms"] = int(dns.max_queue_wait_ms);
+        dnsj["queue_shed_policy"] = dns.queue_shed_policy;
+        dnsj["max_tcp_connections"] = int(dns.max_tcp_connections);
+        dnsj["max_tcp_queries_in_flight"] = int(dns.max_tcp_queries_in_flight);
+        dnsj["max_doh_streams"] = int(dns.max_doh_streams);
+        dnsj["receive_thread_cpus"] = dns.receive_thread_cpus;
+        dnsj["handler_thread_cpus"] = dns.handler_thread_cpus;
+        dnsj["send_thread_cpus"] = dns.send_thread_cpus;
 
         dnsj["client"] = dns.client.to_json();
             
@@ -171,6 +182,7 @@ void server_config::json_unserialize()
         dns.tcp_max_body_wait_ms =              int(dnsj["tcp_max_body_wait_ms"]);
         dns.num_udp_recursive_slots =           int(dnsj["num_udp_recursive_slots"]);
         dns.num_tcp_recursive_slots =           int(dnsj["num_tcp_recursive_slots"]);
+        dns.num_recursive_threads =             int(dnsj["num_recursive_threads"]);
         dns.recursive_timeout_ms =              int(dnsj["recursive_timeout_ms"]);
         dns.max_recursion_depth =               int(dnsj["max_recursion_depth"]);
         dns.max_external_resolutions=           int(dnsj["max_external_resolutions"]);
@@ -186,7 +198,21 @@ void server_config::json_unserialize()
         dns.forward_cache_max_age_seconds =     int(dnsj["forward_cache_max_age_seconds"]);
         dns.forward_cache_max_entries =         int(dnsj["forward_cache_max_entries"]);
         dns.forward_cache_garbage_collect_pct = int(dnsj["forward_cache_garbage_collect_pct"]);
-
+        dns.forward_max_in_flight =             int(dnsj["forward_max_in_flight"]);
+        dns.forward_hedge_queries =             bool(dnsj["forward_hedge_queries"]);
+        dns.max_queue_wait_ms =                 int(dnsj["max_queue_wait_ms"]);
+        dns.queue_shed_policy =                 string(dnsj["queue_shed_policy"]);
+        dns.max_tcp_connections =               int(dnsj["max_tcp_connections"]);
+        dns.max_tcp_queries_in_flight =         int(dnsj["max_tcp_queries_in_flight"]);
+        dns.max_doh_streams =                   int(dnsj["max_doh_streams"]);
+        dns.receive_thread_cpus =               string(dnsj["receive_thread_cpus"]);
+        dns.handler_thread_cpus =               string(dnsj["handler_thread_cpus"]);
+        dns.send_thread_cpus =                  string(dnsj["send_thread_cpus"]);
+
+        if ((dns.queue_shed_policy != "refuse_new") && (dns.queue_shed_policy != "shed_lowest"))
+        {
+            THROW(server_config_exception, "queue_shed_policy must be refuse_new or shed_lowest", dns.queue_shed_policy);
+        }
 
         dns.client.from_json(dnsj["client"]);
     }
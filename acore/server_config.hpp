@@ -79,6 +79,7 @@ namespace adns
             uint   tcp_max_body_wait_ms;
             uint   num_udp_recursive_slots;
             uint   num_tcp_recursive_slots;
+            uint   num_recursive_threads;
             uint   recursive_timeout_ms;
             uint   max_recursion_depth;
             uint   max_external_resolutions;
@@ -94,11 +95,40 @@ namespace adns
             uint   forward_cache_max_entries;
             uint   forward_cache_garbage_collect_pct;
 
+            // most queries outstanding to any one forwarder before others are preferred
+            uint   forward_max_in_flight;
+
+            // send a second copy of a forwarded query to another forwarder if the first is slow
+            bool   forward_hedge_queries;
+
+            // drop queries that have waited longer than this since arriving (0 for never), 
+            // the client will have given up on them
+            uint   max_queue_wait_ms;
+
+            // what a full input queue does with new queries, "refuse_new" or "shed_lowest"
+            std::string queue_shed_policy;
+
+            // most client connections a TCP or DoT server will hold open at once
+            uint   max_tcp_connections;
+
+            // most queries from one TCP or DoT connection being answered at once (RFC 7766 
+            // pipelining), later ones wait their turn
+            uint   max_tcp_queries_in_flight;
+
             // DoH specific items
             uint        doh_client_timeout_ms;
             uint        maximum_http_request_size;
             std::string doh_path;
 
+            // most HTTP/2 streams (i.e. queries) one DoH client can have open at once, 
+            // advertised to it in SETTINGS_MAX_CONCURRENT_STREAMS
+            uint        max_doh_streams;
+
+            // CPUs to pin each stage's threads to, e.g. "0-3,8", empty for no pinning
+            std::string receive_thread_cpus;
+            std::string handler_thread_cpus;
+            std::string send_thread_cpus;
+
             // base config for the DNS clients used by this server
             client_config client;
         };
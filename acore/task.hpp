@@ -0,0 +1,246 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "types.hpp"
+
+namespace adns
+{
+    namespace task_detail
+    {
+        /**
+         * When a task finishes, carry straight on with whatever co_awaited it (symmetric
+         * transfer, so long chains of nested tasks don't grow the stack).
+         */
+        template <class PROMISE> struct final_awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PROMISE> h) noexcept
+            {
+                auto c = h.promise().m_continuation;
+                return c ? c : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        struct promise_base
+        {
+            std::coroutine_handle<> m_continuation;
+            std::exception_ptr      m_exception;
+
+            std::suspend_always initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                m_exception = std::current_exception();
+            }
+        };
+    }
+
+    /**
+     * A lazily started coroutine returning a T. Nothing runs until the task is co_awaited,
+     * exceptions thrown inside the coroutine are rethrown in the awaiter.
+     */
+    template <class T> class task final
+    {
+    public:
+
+        struct promise_type : task_detail::promise_base
+        {
+            std::optional<T> m_value;
+
+            task get_return_object()
+            {
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            task_detail::final_awaiter<promise_type> final_suspend() noexcept
+            {
+                return {};
+            }
+
+            template <class U> void return_value(U &&v)
+            {
+                m_value.emplace(std::forward<U>(v));
+            }
+        };
+
+        task(task &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr))
+        {
+        }
+
+        task(const task &other) = delete;
+        task &operator=(const task &other) = delete;
+
+        virtual ~task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            m_handle.promise().m_continuation = awaiter;
+            return m_handle;
+        }
+
+        T await_resume()
+        {
+            if (m_handle.promise().m_exception)
+            {
+                std::rethrow_exception(m_handle.promise().m_exception);
+            }
+            return std::move(*m_handle.promise().m_value);
+        }
+
+    private:
+
+        explicit task(std::coroutine_handle<promise_type> h) : m_handle(h)
+        {
+        }
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    /**
+     * As above for coroutines that don't return anything.
+     */
+    template <> class task<void> final
+    {
+    public:
+
+        struct promise_type : task_detail::promise_base
+        {
+            task get_return_object()
+            {
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            task_detail::final_awaiter<promise_type> final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+        };
+
+        task(task &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr))
+        {
+        }
+
+        task(const task &other) = delete;
+        task &operator=(const task &other) = delete;
+
+        virtual ~task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            m_handle.promise().m_continuation = awaiter;
+            return m_handle;
+        }
+
+        void await_resume()
+        {
+            if (m_handle.promise().m_exception)
+            {
+                std::rethrow_exception(m_handle.promise().m_exception);
+            }
+        }
+
+    private:
+
+        explicit task(std::coroutine_handle<promise_type> h) : m_handle(h)
+        {
+        }
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    /**
+     * A top level coroutine that starts running straight away and cleans up after itself when
+     * it finishes. Nothing can wait for it so it must not let exceptions escape.
+     */
+    class detached_task final
+    {
+    public:
+
+        struct promise_type
+        {
+            detached_task get_return_object() noexcept
+            {
+                return detached_task();
+            }
+
+            std::suspend_never initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never final_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+    };
+}
@@ -0,0 +1,119 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include "timer_service.hpp"
+#include "run_state.hpp"
+#include "exception.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+static shared_ptr<timer_service> instance;
+
+shared_ptr<timer_service> timer_service::get_instance()
+{
+    static mutex lock;
+
+    lock_guard<mutex> guard(lock);
+
+    if (!instance)
+    {
+        instance.reset(new timer_service());
+    }
+
+    return instance;
+}
+
+timer_service::timer_service() : m_wheel(milliseconds(tick_ms)), m_next_wake(steady_clock::now())
+{
+    m_thread.reset(new thread(&timer_service::run, this));
+}
+
+timer_service::~timer_service()
+{
+}
+
+timer_wheel::timer_id_t timer_service::add(milliseconds delay, const function<void ()> &f)
+{
+    lock_guard<mutex> guard(m_lock);
+
+    // the wheel only queues the callback, it's run later with the lock released
+    auto id = m_wheel.add(delay, [this, f]() { m_due.push_back(f); });
+
+    // only wake the service thread if this is due before it was going to wake anyway
+    if (steady_clock::now() + delay < m_next_wake)
+    {
+        m_condition.notify_one();
+    }
+
+    return id;
+}
+
+void timer_service::cancel(timer_wheel::timer_id_t id)
+{
+    lock_guard<mutex> guard(m_lock);
+    m_wheel.cancel(id);
+}
+
+void timer_service::join()
+{
+    lock_guard<mutex> guard(m_join_lock);
+
+    if (m_thread && m_thread->joinable())
+    {
+        m_thread->join();
+    }
+}
+
+void timer_service::run()
+{
+    while (run_state::o_state != run_state::shutdown_e)
+    {
+        list<function<void ()>> due;
+
+        {
+            unique_lock<mutex> guard(m_lock);
+
+            auto wait = milliseconds(m_wheel.advance());
+            due.swap(m_due);
+
+            if (due.empty())
+            {
+                m_next_wake = steady_clock::now() + wait;
+                m_condition.wait_for(guard, wait);
+                m_next_wake = steady_clock::now();
+                continue;
+            }
+        }
+
+        for (auto &f : due)
+        {
+            try
+            {
+                f();
+            }
+            catch (adns::exception &e)
+            {
+                e.log(error, "exception caught in timer callback");
+            }
+        }
+    }
+}
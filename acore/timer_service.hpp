@@ -0,0 +1,87 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <condition_variable>
+
+#include "types.hpp"
+#include "timer_wheel.hpp"
+
+namespace adns
+{
+    /**
+     * A timer wheel with its own thread for things that don't have an event loop of their
+     * own (e.g. cache expiry). Callbacks run on the service thread without any service
+     * locks held, so a timer cancelled at the moment it becomes due may still fire once.
+     */
+    class timer_service final
+    {
+    public:
+
+        /**
+         * the shared instance, started on first use
+         */
+        static std::shared_ptr<timer_service> get_instance();
+
+        virtual ~timer_service();
+
+        /**
+         * call f once after the given delay (thread safe)
+         */
+        timer_wheel::timer_id_t add(std::chrono::milliseconds delay, const std::function<void ()> &f);
+
+        /**
+         * stop a timer firing (thread safe)
+         */
+        void cancel(timer_wheel::timer_id_t id);
+
+        /**
+         * wait for the service thread to finish (safe to call more than once)
+         */
+        void join();
+
+    private:
+
+        // resolution of timers run by the service
+        static const uint tick_ms = 10;
+
+        std::mutex                         m_lock;
+        std::condition_variable            m_condition;
+        timer_wheel                        m_wheel;
+        std::chrono::steady_clock::time_point m_next_wake;
+
+        // callbacks that have come due and are waiting to be run
+        std::list<std::function<void ()>>  m_due;
+
+        std::mutex                   m_join_lock;
+        std::shared_ptr<std::thread> m_thread;
+
+        timer_service();
+
+        /**
+         * service thread
+         */
+        void run();
+    };
+}
@@ -0,0 +1,173 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include "timer_wheel.hpp"
+#include "exception.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+timer_wheel::timer_wheel(milliseconds tick) : 
+                    m_tick(max(tick, milliseconds(1))), 
+                    m_start_time(steady_clock::now()), 
+                    m_current_tick(0), 
+                    m_next_id(1)
+{
+}
+
+timer_wheel::~timer_wheel()
+{
+}
+
+uint64_t timer_wheel::tick_at(steady_clock::time_point t) const
+{
+    return duration_cast<milliseconds>(t - m_start_time).count() / m_tick.count();
+}
+
+timer_wheel::timer_id_t timer_wheel::add(milliseconds delay, const function<void ()> &f)
+{
+    // round up so a timer never fires early, allowing for the part of the current tick that's gone
+    uint64_t ticks = (max<int64_t>(delay.count(), 0) + m_tick.count() - 1) / m_tick.count();
+    uint64_t expiry = max(tick_at(steady_clock::now()), m_current_tick) + ticks + 1;
+
+    entry_t e { m_next_id++, expiry, f };
+    auto id = e.m_id;
+
+    insert(std::move(e));
+
+    return id;
+}
+
+void timer_wheel::cancel(timer_id_t id)
+{
+    auto l = m_locations.find(id);
+
+    if (l != m_locations.end())
+    {
+        l->second.m_slot->erase(l->second.m_entry);
+        m_locations.erase(l);
+    }
+}
+
+size_t timer_wheel::size() const
+{
+    return m_locations.size();
+}
+
+void timer_wheel::insert(entry_t &&e)
+{
+    // anything already due goes in the next slot to be looked at
+    uint64_t expiry = max(e.m_expiry_tick, m_current_tick + 1);
+    uint64_t delta = expiry - m_current_tick;
+
+    uint level = 0;
+
+    while ((level < num_levels - 1) && (delta >= (uint64_t(1) << (level_bits * (level + 1)))))
+    {
+        level++;
+    }
+
+    if (delta >= (uint64_t(1) << (level_bits * num_levels)))
+    {
+        // beyond the end of the wheel, park it as far out as possible and it gets 
+        // reinserted when that slot cascades
+        expiry = m_current_tick + (uint64_t(1) << (level_bits * num_levels)) - 1;
+    }
+
+    slot_t &s = m_slots[level][(expiry >> (level_bits * level)) & (num_slots - 1)];
+
+    auto id = e.m_id;
+    s.push_back(std::move(e));
+    m_locations[id] = location_t { &s, prev(s.end()) };
+}
+
+void timer_wheel::cascade(uint level)
+{
+    slot_t moving;
+    moving.swap(m_slots[level][(m_current_tick >> (level_bits * level)) & (num_slots - 1)]);
+
+    for (auto &e : moving)
+    {
+        insert(std::move(e));
+    }
+}
+
+uint timer_wheel::advance()
+{
+    auto now = steady_clock::now();
+    uint64_t target = tick_at(now);
+
+    if (m_locations.empty())
+    {
+        m_current_tick = max(m_current_tick, target);
+        return 1000;
+    }
+
+    while (m_current_tick < target)
+    {
+        m_current_tick++;
+
+        // when the lower levels wrap, pull the next slot of each higher one down
+        for (uint level = num_levels - 1; level > 0; level--)
+        {
+            if ((m_current_tick & ((uint64_t(1) << (level_bits * level)) - 1)) == 0)
+            {
+                cascade(level);
+            }
+        }
+
+        slot_t &s = m_slots[0][m_current_tick & (num_slots - 1)];
+
+        // one at a time as a callback may cancel others due on the same tick
+        while (!s.empty())
+        {
+            auto f = std::move(s.front().m_callback);
+            m_locations.erase(s.front().m_id);
+            s.pop_front();
+
+            try
+            {
+                f();
+            }
+            catch (adns::exception &e)
+            {
+                e.log(error, "exception caught in timer callback");
+            }
+        }
+    }
+
+    if (m_locations.empty())
+    {
+        return 1000;
+    }
+
+    // wait for the next occupied slot at the bottom level or the next cascade
+    uint64_t next = m_current_tick + 1;
+
+    while (((next & (num_slots - 1)) != 0) && m_slots[0][next & (num_slots - 1)].empty())
+    {
+        next++;
+    }
+
+    auto ms = duration_cast<milliseconds>(m_start_time + next * m_tick - steady_clock::now()).count();
+
+    return static_cast<uint>(max<int64_t>(1, min<int64_t>(ms, 1000)));
+}
@@ -0,0 +1,118 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <list>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "types.hpp"
+
+namespace adns
+{
+    /**
+     * Hierarchical timing wheel (four levels of 256 slots) for large numbers of timers that
+     * mostly get cancelled before they fire - query deadlines, retransmits, idle timeouts
+     * and TTL expiry. Adding and cancelling are O(1). Not thread safe, it's driven by
+     * whichever thread owns it calling advance(); see timer_service for a shared one.
+     */
+    class timer_wheel final
+    {
+    public:
+
+        typedef uint64_t timer_id_t;
+
+        // never returned by add()
+        static const timer_id_t no_timer = 0;
+
+        /**
+         * new, empty wheel with the given tick size (the resolution of all timers)
+         */
+        timer_wheel(std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+
+        virtual ~timer_wheel();
+
+        /**
+         * call f once after the given delay (rounded up to a whole number of ticks)
+         */
+        timer_id_t add(std::chrono::milliseconds delay, const std::function<void ()> &f);
+
+        /**
+         * stop a timer firing, does nothing if it's already fired or been cancelled
+         */
+        void cancel(timer_id_t id);
+
+        /**
+         * Run everything that's due up to now. Callbacks may add and cancel timers. Returns 
+         * the number of ms it's safe to wait before calling again.
+         */
+        uint advance();
+
+        /**
+         * number of timers waiting to fire
+         */
+        size_t size() const;
+
+    private:
+
+        static const uint level_bits = 8;
+        static const uint num_slots = 1 << level_bits;
+        static const uint num_levels = 4;
+
+        struct entry_t
+        {
+            timer_id_t            m_id;
+            uint64_t              m_expiry_tick;
+            std::function<void()> m_callback;
+        };
+
+        typedef std::list<entry_t> slot_t;
+
+        struct location_t
+        {
+            slot_t                  *m_slot;
+            slot_t::iterator        m_entry;
+        };
+
+        std::chrono::milliseconds                          m_tick;
+        std::chrono::steady_clock::time_point              m_start_time;
+        uint64_t                                           m_current_tick;
+        timer_id_t                                         m_next_id;
+        slot_t                                             m_slots[num_levels][num_slots];
+        std::unordered_map<timer_id_t, location_t>         m_locations;
+
+        /**
+         * put an entry in the right slot for its expiry time relative to the current tick
+         */
+        void insert(entry_t &&e);
+
+        /**
+         * move everything in a higher level slot down the hierarchy
+         */
+        void cascade(uint level);
+
+        /**
+         * tick number for a given time
+         */
+        uint64_t tick_at(std::chrono::steady_clock::time_point t) const;
+    };
+}
@@ -29,7 +29,20 @@
  * Typedefs and macros that don't belong anywehere else.
  */
 
-#define LOG BOOST_LOG_TRIVIAL
+/**
+ * Log statements below this severity level (as a boost::log::trivial::severity_level value)
+ * are compiled out entirely. Set from the build, defaults to letting everything through.
+ */
+#ifndef ADNS_LOG_MIN_LEVEL
+#define ADNS_LOG_MIN_LEVEL 0
+#endif
+
+#define LOG(lvl) \
+    for (bool adns_log_on_ = (boost::log::trivial::lvl >= ADNS_LOG_MIN_LEVEL); \
+         adns_log_on_; \
+         adns_log_on_ = false) \
+        BOOST_LOG_TRIVIAL(lvl)
+
 #define VERSION "ADNS-0.1"
 typedef uint8_t octet;
 typedef boost::uuids::uuid uuid;
@@ -33,6 +33,7 @@
 #include "types.hpp"
 #include "server_container.hpp"
 #include "config.hpp"
+#include "log_queue.hpp"
 #include "util.hpp"
 #include "exception.hpp"
 #include "dns_udp_server.hpp"
@@ -257,6 +258,9 @@ void run_servers()
     sc.run();
     sc.join();
 
+    // keep the cache contents so that a restart doesn't begin cold
+    dns_recursive_cache::get_instance()->save_snapshot();
+
     dns_horizon::empty_cache();
 }
 
@@ -315,6 +319,11 @@ int main(int argc, char *argv[], char *envp[])
             make_daemon();
         }
 
+        if (config::log_async())
+        {
+            log_queue::start();
+        }
+
         config::init_db_config();
         schema_manager::update_or_create();
         address_list::load_cache();
@@ -326,6 +335,7 @@ int main(int argc, char *argv[], char *envp[])
         if (run_state::o_restart)
         {
             LOG(info) << "all done, restarting";
+            log_queue::stop();
             run_state::restart();
         }
         else
@@ -0,0 +1,84 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <algorithm>
+
+#include "api_upstream_server_v1.hpp"
+#include "api.hpp"
+#include "dns_ip_selector.hpp"
+
+using namespace std;
+using namespace adns;
+
+shared_ptr<http_response> api_upstream_server_v1::handle_request(shared_ptr<http_request> &req, const api_url_v1 &p)
+{
+    if (req->get_method() == "GET")
+    {
+        return handle_get_request(req, p);
+    }
+    else
+    {
+        THROW(api_method_not_allowed_exception, "method not allowed for upstream_server");
+    }
+}
+
+shared_ptr<http_response> api_upstream_server_v1::handle_get_request(shared_ptr<http_request> &req, const api_url_v1 &p)
+{
+    auto response = json(json::object_e);
+    auto v = json(json::array_e);
+
+    auto stats = dns_ip_selector::get_stats();
+
+    sort(stats.begin(), stats.end(), 
+        [](const dns_ip_selector::server_stats_t &a, const dns_ip_selector::server_stats_t &b) { return a.address < b.address; });
+
+    for (auto &s : stats)
+    {
+        auto j = json(json::object_e);
+
+        j["address"] = s.address.to_string();
+        j["srtt_ms"] = json(s.srtt_ms);
+        j["rttvar_ms"] = json(s.rttvar_ms);
+        j["sent"] = json(s.sent);
+        j["responses"] = json(s.responses);
+        j["timeouts"] = json(s.timeouts);
+        j["consecutive_timeouts"] = json(s.consecutive_timeouts);
+        j["dead"] = json(s.dead);
+        j["last_contact_ms"] = json(s.last_contact_ms);
+
+        switch (s.edns)
+        {
+        case dns_ip_selector::edns_supported_e:
+            j["edns"] = "supported";
+            break;
+        case dns_ip_selector::edns_unsupported_e:
+            j["edns"] = "unsupported";
+            break;
+        default:
+            j["edns"] = "unknown";
+            break;
+        }
+
+        v.append(j);
+    }
+
+    response["upstream_servers"] = v;
+
+    return make_shared<http_response>(req->get_stream_id(), http_response::ok_200, response);
+}
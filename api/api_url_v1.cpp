@@ -50,6 +50,10 @@ api_url_v1::resource_type_t api_url_v1::string_to_type(string type) const
     {
         return monitor_e;
     }
+    else if (type == "upstream_server")
+    {
+        return upstream_server_e;
+    }
     else if (type == "run")
     {
         return run_e;
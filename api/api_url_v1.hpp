@@ -50,6 +50,7 @@ namespace adns
         {
             auth_token_e,
             monitor_e,
+            upstream_server_e,
             run_e,
             server_e,
             horizon_e,
@@ -29,6 +29,7 @@
 #include "api_zone_v1.hpp"
 #include "api_horizon_v1.hpp"
 #include "api_monitor_v1.hpp"
+#include "api_upstream_server_v1.hpp"
 #include "api_resource_record_v1.hpp"
 #include "api_address_list_v1.hpp"
 #include "api_base_configuration_v1.hpp"
@@ -70,6 +71,8 @@ shared_ptr<http_response> api_v1::handle_request(shared_ptr<http_request> &req,
             return api_auth_token_v1::handle_request(req, p);
         case api_url_v1::monitor_e :
             return api_monitor_v1::handle_request(req, p);
+        case api_url_v1::upstream_server_e :
+            return api_upstream_server_v1::handle_request(req, p);
         case api_url_v1::run_e :
             return api_run_state_v1::handle_request(req, p);
         case api_url_v1::server_e :
@@ -0,0 +1,214 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <thread>
+
+#include "util.hpp"
+#include "dns_cache_snapshot.hpp"
+
+using namespace std;
+using namespace adns;
+using namespace boost::log::trivial;
+
+const char dns_cache_snapshot::magic[8] = { 'A', 'D', 'N', 'S', 'S', 'N', 'A', 'P' };
+
+dns_cache_snapshot::dns_cache_snapshot() : m_num_entries(0)
+{
+    m_data.insert(m_data.end(), magic, magic + sizeof(magic));
+    put(m_data, version, 4);
+}
+
+void dns_cache_snapshot::add(entry_type_t t, uint answer_type, time_t created, time_t expiry, const dns_message &m)
+{
+    buffer raw = m_parser.to_wire(m, true, MAX_EXTENDED_MESSAGE_SIZE);
+
+    put(m_data, t, 1);
+    put(m_data, answer_type, 1);
+    put(m_data, created, 8);
+    put(m_data, expiry, 8);
+    put(m_data, raw.get_size(), 4);
+
+    m_data.insert(m_data.end(), raw.get_data(), raw.get_data() + raw.get_size());
+    m_num_entries++;
+}
+
+size_t dns_cache_snapshot::get_num_entries() const
+{
+    return m_num_entries;
+}
+
+void dns_cache_snapshot::save(const string &file_name) const
+{
+    string tmp_name = file_name + ".tmp";
+
+    {
+        ofstream f(tmp_name, ios::binary | ios::trunc);
+
+        f.write(reinterpret_cast<const char *>(m_data.data()), m_data.size());
+        f.close();
+
+        if (!f)
+        {
+            THROW(dns_cache_snapshot_exception, "failed to write cache snapshot " + tmp_name);
+        }
+    }
+
+    if (rename(tmp_name.c_str(), file_name.c_str()) != 0)
+    {
+        THROW(dns_cache_snapshot_exception, "failed to rename cache snapshot " + file_name, util::strerror(), errno);
+    }
+}
+
+size_t dns_cache_snapshot::load(const string &file_name, const loader_t &f, uint num_threads)
+{
+    int fd = open(file_name.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+        {
+            return 0;
+        }
+
+        THROW(dns_cache_snapshot_exception, "failed to open cache snapshot " + file_name, util::strerror(), errno);
+    }
+
+    struct stat st;
+
+    if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(magic) + 4))
+    {
+        close(fd);
+        THROW(dns_cache_snapshot_exception, "cache snapshot too short " + file_name);
+    }
+
+    size_t size = st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (p == MAP_FAILED)
+    {
+        close(fd);
+        THROW(dns_cache_snapshot_exception, "failed to map cache snapshot " + file_name, util::strerror(), errno);
+    }
+
+    close(fd);
+
+    const octet *raw = static_cast<const octet *>(p);
+
+    if ((memcmp(raw, magic, sizeof(magic)) != 0) || (get(raw + sizeof(magic), 4) != version))
+    {
+        munmap(p, size);
+        THROW(dns_cache_snapshot_exception, "not a cache snapshot or the wrong version " + file_name);
+    }
+
+    // find where each entry starts, skipping anything that's already expired so that the
+    // parsing threads only see live entries
+    time_t now = time(nullptr);
+    vector<size_t> offsets;
+    size_t offset = sizeof(magic) + 4;
+
+    while (offset + entry_header_size <= size)
+    {
+        size_t length = get(raw + offset + 18, 4);
+
+        if (offset + entry_header_size + length > size)
+        {
+            LOG(warning) << "cache snapshot " << file_name << " is truncated, ignoring the rest of it";
+            break;
+        }
+
+        if (time_t(get(raw + offset + 10, 8)) > now)
+        {
+            offsets.push_back(offset);
+        }
+
+        offset += entry_header_size + length;
+    }
+
+    atomic<size_t> num_loaded(0);
+
+    auto worker = [&](size_t first)
+    {
+        dns_message_parser parser;
+
+        for (size_t i = first; i < offsets.size(); i += num_threads)
+        {
+            const octet *e = raw + offsets[i];
+
+            try
+            {
+                buffer b(get(e + 18, 4), e + entry_header_size);
+
+                f(entry_type_t(e[0]), e[1], time_t(get(e + 2, 8)), time_t(get(e + 10, 8)), parser.from_wire(b));
+                num_loaded++;
+            }
+            catch (adns::exception &ex)
+            {
+                ex.log(warning, "skipped bad cache snapshot entry");
+            }
+        }
+    };
+
+    num_threads = max(1u, min<uint>(num_threads, offsets.size()));
+
+    vector<thread> threads;
+
+    for (uint t = 1; t < num_threads; t++)
+    {
+        threads.push_back(thread(worker, t));
+    }
+
+    worker(0);
+
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    munmap(p, size);
+
+    return num_loaded;
+}
+
+void dns_cache_snapshot::put(vector<octet> &data, uint64_t v, uint octets)
+{
+    for (int i = octets - 1; i >= 0; i--)
+    {
+        data.push_back((v >> (i * 8)) & 0xff);
+    }
+}
+
+uint64_t dns_cache_snapshot::get(const octet *raw, uint octets)
+{
+    uint64_t v = 0;
+
+    for (uint i = 0; i < octets; i++)
+    {
+        v = (v << 8) | raw[i];
+    }
+
+    return v;
+}
@@ -0,0 +1,104 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "types.hpp"
+#include "exception.hpp"
+#include "dns_message.hpp"
+#include "dns_message_parser.hpp"
+
+EXCEPTION_CLASS(dns_cache_snapshot_exception, exception)
+
+namespace adns
+{
+    /**
+     * A compact binary copy of the contents of a cache so that it can be reloaded after a 
+     * restart. Each entry is a wire format message (question plus records) along with when 
+     * the records were fetched and when the entry expires. Times are wall clock seconds since 
+     * the epoch as the steady clock doesn't survive a restart.
+     */
+    class dns_cache_snapshot final
+    {
+    public:
+
+        typedef enum
+        {
+            answer_e,
+            referral_e,
+            forwarded_e
+        }
+        entry_type_t;
+
+        /**
+         * called for each unexpired entry on load - may be called from several threads at once. 
+         * The callee owns the message.
+         */
+        typedef std::function<void (entry_type_t t, uint answer_type, time_t created, time_t expiry, dns_message *m)> loader_t;
+
+        /**
+         * new empty snapshot ready to have entries added
+         */
+        dns_cache_snapshot();
+
+        /**
+         * add an entry - throws if the message can't be serialised
+         */
+        void add(entry_type_t t, uint answer_type, time_t created, time_t expiry, const dns_message &m);
+
+        /**
+         * how many entries have been added
+         */
+        size_t get_num_entries() const;
+
+        /**
+         * write the snapshot to a file - via a temporary file so there's never a half 
+         * written snapshot in place
+         */
+        void save(const std::string &file_name) const;
+
+        /**
+         * Read a snapshot file, calling f for every entry that hasn't expired. Entries are parsed 
+         * and handed over using num_threads threads. Returns the number of entries loaded, 0 if
+         * there's no snapshot file.
+         */
+        static size_t load(const std::string &file_name, const loader_t &f, uint num_threads);
+
+    private:
+
+        // file identification and format version
+        static const char magic[8];
+        static const uint version = 1;
+
+        // per entry: type, answer type, created, expiry, message length
+        static const size_t entry_header_size = 1 + 1 + 8 + 8 + 4;
+
+        dns_message_parser m_parser;
+        std::vector<octet> m_data;
+        size_t             m_num_entries;
+
+        static void put(std::vector<octet> &data, uint64_t v, uint octets);
+        static uint64_t get(const octet *raw, uint octets);
+    };
+}
@@ -22,6 +22,7 @@
 #include <format>
 
 #include "dns_forwarding_cache.hpp"
+#include "dns_cache_snapshot.hpp"
 
 using namespace std;
 using namespace chrono;
@@ -32,110 +33,212 @@ dns_forwarding_cache::dns_forwarding_cache(int max_age_seconds, int max_entries,
                             m_max_entries(max_entries),
                             m_garbage_collect_pct(garbage_collect_pct)
 {
-    m_answers = make_shared<
-                std::unordered_map<
-                    dns_question, 
-                    std::pair<
-                        std::chrono::time_point<std::chrono::steady_clock>, 
-                        std::shared_ptr<dns_message>
-                    >>>();
+    size_t num_shards = 1;
+
+    while ((num_shards < max_shards) && (num_shards * 2 * min_shard_entries <= static_cast<size_t>(max_entries)))
+    {
+        num_shards <<= 1;
+    }
+
+    m_shard_mask = num_shards - 1;
+    m_shard_max_entries = max((static_cast<size_t>(max_entries) + num_shards - 1) / num_shards, size_t(1));
+    m_shard_target_entries = (m_shard_max_entries * garbage_collect_pct) / 100;
+
+    for (size_t i = 0; i < num_shards; i++)
+    {
+        m_shards.push_back(make_unique<shard_t>());
+    }
 }
 
 dns_forwarding_cache::~dns_forwarding_cache()
 {
 }
 
-void dns_forwarding_cache::add(const dns_question &q, const shared_ptr<dns_message> &a)
+dns_forwarding_cache::shard_t &dns_forwarding_cache::get_shard(const dns_question &q) const
 {
-    lock_guard<mutex> guard(m_lock);
+    size_t h = std::hash<dns_question>()(q);
 
+    // mix the hash first, the low bits are what the shards' own maps bucket on
+    h ^= h >> 32;
+    h *= 0x9e3779b97f4a7c15ull;
+
+    return *m_shards[(h >> 32) & m_shard_mask];
+}
+
+void dns_forwarding_cache::add(const dns_question &q, const shared_ptr<dns_message> &a)
+{
     a->set_min_ttl();
 
-    (*m_answers)[q] = pair<time_point<steady_clock>, shared_ptr<dns_message>>(steady_clock::now(), a);
+    auto &s = get_shard(q);
 
-    if (m_answers->size() >= static_cast<size_t>(m_max_entries))
-    {
-        garbage_collect();
-    }
+    lock_guard<mutex> guard(s.m_lock);
+
+    insert(s, q, steady_clock::now(), a);
 }
 
-void dns_forwarding_cache::garbage_collect()
+void dns_forwarding_cache::insert(shard_t &s, const dns_question &q, time_point_t t, const shared_ptr<dns_message> &a)
 {
-    size_t target = (m_max_entries * m_garbage_collect_pct) / 100;
+    auto i = s.m_index.find(q);
 
-    if (m_answers->size() < target)
+    if (i != s.m_index.end())
     {
-        return;
+        s.m_entries.erase(i->second);
+        s.m_index.erase(i);
     }
 
-    vector<chrono::time_point<chrono::steady_clock>> times;
-
-    transform(m_answers->begin(), m_answers->end(), back_inserter(times), [](const auto& pair) { return pair.second.first; });
+    s.m_entries.push_front(entry_t{ q, t, a });
+    s.m_index[q] = s.m_entries.begin();
 
-    sort(times.begin(), times.end());
-
-    auto now = steady_clock::now();
+    garbage_collect(s, steady_clock::now());
+}
 
-    while (duration_cast<chrono::seconds>(now - times[target]).count() > m_max_age_seconds)
+void dns_forwarding_cache::garbage_collect(shard_t &s, time_point_t now)
+{
+    auto remove_oldest = [&s]()
     {
-        target--;
-    }
+        s.m_index.erase(s.m_entries.back().m_question);
+        s.m_entries.pop_back();
+    };
 
-    if (target <= 0)
+    while (!s.m_entries.empty() && (duration_cast<chrono::seconds>(now - s.m_entries.back().m_time).count() > m_max_age_seconds))
     {
-        m_answers->clear();
+        remove_oldest();
     }
-    else
-    {
-        auto oldest = times[times.size() - target];
-
-        auto new_answers = make_shared<
-                std::unordered_map<
-                    dns_question, 
-                    std::pair<
-                        std::chrono::time_point<std::chrono::steady_clock>, 
-                        std::shared_ptr<dns_message>
-                    >>>();
 
-        for (auto i : *m_answers)
+    if (s.m_entries.size() >= m_shard_max_entries)
+    {
+        while (!s.m_entries.empty() && (s.m_entries.size() > m_shard_target_entries))
         {
-            if (i.second.first > oldest)
-            {
-                (*new_answers)[i.first] = i.second;
-            }
+            remove_oldest();
         }
-    
-        m_answers = new_answers;
     }
 }
 
 shared_ptr<dns_message> dns_forwarding_cache::get(const dns_question &q, int &age_seconds)
 {
-    lock_guard<mutex> guard(m_lock);
+    auto &s = get_shard(q);
+
+    lock_guard<mutex> guard(s.m_lock);
 
     age_seconds = 0;
 
-    auto i = m_answers->find(q);
+    auto i = s.m_index.find(q);
 
-    if (i == m_answers->end())
+    if (i == s.m_index.end())
     {
         return nullptr;
     }
     else
     {
-
-        age_seconds = duration_cast<chrono::seconds>(steady_clock::now() - i->second.first).count();
+        age_seconds = duration_cast<chrono::seconds>(steady_clock::now() - i->second->m_time).count();
         
         if (age_seconds > m_max_age_seconds)
         {
-            m_answers->erase(q);
+            s.m_entries.erase(i->second);
+            s.m_index.erase(i);
             return nullptr;
         }
         else
         {
-            return i->second.second;
+            return i->second->m_answer;
+        }
+    }
+}
+
+bool dns_forwarding_cache::contains(const dns_question &q) const
+{
+    auto &s = get_shard(q);
+
+    lock_guard<mutex> guard(s.m_lock);
+
+    return s.m_index.find(q) != s.m_index.end();
+}
+
+size_t dns_forwarding_cache::save_snapshot(const string &file_name)
+{
+    vector<entry_t> entries;
+
+    for (auto &s : m_shards)
+    {
+        lock_guard<mutex> guard(s->m_lock);
+        entries.insert(entries.end(), s->m_entries.begin(), s->m_entries.end());
+    }
+
+    auto steady_now = steady_clock::now();
+    time_t now = time(nullptr);
+
+    dns_cache_snapshot s;
+
+    for (auto &e : entries)
+    {
+        time_t created = now - duration_cast<seconds>(steady_now - e.m_time).count();
+
+        if (created + m_max_age_seconds <= now)
+        {
+            continue;
+        }
+
+        // the upstream question may differ in case from the one it's cached under
+        dns_message m(*e.m_answer);
+        m.set_question(make_shared<dns_question>(e.m_question));
+
+        try
+        {
+            s.add(dns_cache_snapshot::forwarded_e, 0, created, created + m_max_age_seconds, m);
+        }
+        catch (adns::exception &ex)
+        {
+            // too big to fit in a message, it'll just have to be fetched again
+        }
+    }
+
+    s.save(file_name);
+
+    return s.get_num_entries();
+}
+
+size_t dns_forwarding_cache::load_snapshot(const string &file_name)
+{
+    mutex lock;
+    vector<entry_t> entries;
+
+    auto loader = [&](dns_cache_snapshot::entry_type_t t, uint answer_type, time_t created, time_t expiry, dns_message *m)
+    {
+        shared_ptr<dns_message> a(m);
+
+        if (t != dns_cache_snapshot::forwarded_e)
+        {
+            return;
+        }
+
+        time_t now = time(nullptr);
+        auto cached = steady_clock::now() - seconds((now > created) ? now - created : 0);
+
+        a->set_min_ttl();
+
+        lock_guard<mutex> guard(lock);
+        entries.push_back(entry_t{ *a->get_question(), cached, a });
+    };
+
+    auto n = dns_cache_snapshot::load(file_name, loader, thread::hardware_concurrency());
+
+    // oldest first so that if there are too many it's the newest that are kept
+    sort(entries.begin(), entries.end(), [](const entry_t &a, const entry_t &b) { return a.m_time < b.m_time; });
+
+    for (auto &e : entries)
+    {
+        auto &s = get_shard(e.m_question);
+
+        lock_guard<mutex> guard(s.m_lock);
+
+        // anything added since startup is newer than the snapshot
+        if (s.m_index.find(e.m_question) == s.m_index.end())
+        {
+            insert(s, e.m_question, e.m_time, e.m_answer);
         }
     }
+
+    return n;
 }
 
 void dns_forwarding_cache::test()
@@ -164,7 +267,7 @@ void dns_forwarding_cache::test()
         dns_name name(n);
         dns_question q(name);
 
-        if (c.m_answers->find(q) != c.m_answers->end()) 
+        if (c.contains(q))
         {
             LOG(debug) << "test failed - found " << n;
             return;
@@ -179,7 +282,7 @@ void dns_forwarding_cache::test()
         dns_name name(n);
         dns_question q(name);
 
-        if (c.m_answers->find(q) == c.m_answers->end()) 
+        if (!c.contains(q))
         {
             LOG(debug) << "test failed - didn't find " << n;
             return;
@@ -20,6 +20,10 @@
 #pragma once 
 
 #include <unordered_map>
+#include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
 #include <chrono>
 #include <thread>
 
@@ -61,6 +65,17 @@ namespace adns
          * never be greater than max_age_seconds.
          */
         std::shared_ptr<dns_message> get(const dns_question &q, int &age_seconds);
+
+        /**
+         * save the cache contents to a snapshot file, returns the number of entries saved
+         */
+        size_t save_snapshot(const std::string &file_name);
+
+        /**
+         * reload entries that haven't reached the maximum age from a snapshot file, returns 
+         * the number of entries loaded
+         */
+        size_t load_snapshot(const std::string &file_name);
         
         /**
          * run unit tests
@@ -69,26 +84,70 @@ namespace adns
 
     private:
 
+        typedef std::chrono::time_point<std::chrono::steady_clock> time_point_t;
+
+        /**
+         * a cached answer and when it was added
+         */
+        struct entry_t
+        {
+            dns_question                 m_question;
+            time_point_t                 m_time;
+            std::shared_ptr<dns_message> m_answer;
+        };
+
+        /**
+         * Part of the cache with its own lock. Entries are kept newest first so the oldest, 
+         * which are also the first to expire, are always at the back and can be removed 
+         * without searching for them.
+         */
+        struct shard_t
+        {
+            std::mutex m_lock;
+
+            std::list<entry_t> m_entries;
+
+            std::unordered_map<dns_question, std::list<entry_t>::iterator> m_index;
+        };
+
+        // shards with fewer entries than this aren't worth having
+        static const size_t min_shard_entries = 1024;
+        static const size_t max_shards = 16;
+
         int m_max_age_seconds;
         int m_max_entries;
         int m_garbage_collect_pct;
 
-        std::mutex m_lock;
+        std::vector<std::unique_ptr<shard_t>> m_shards;
+
+        // number of shards - 1, the number of shards is always a power of two
+        size_t m_shard_mask;
+
+        // entries allowed per shard and the number they're cut back to when that's reached
+        size_t m_shard_max_entries;
+        size_t m_shard_target_entries;
+
+        /**
+         * pick the shard for a question
+         */
+        shard_t &get_shard(const dns_question &q) const;
 
-        std::shared_ptr<std::unordered_map<
-                dns_question, 
-                std::pair<
-                    std::chrono::time_point<std::chrono::steady_clock>, 
-                    std::shared_ptr<dns_message>
-                >>> m_answers;
+        /**
+         * add or replace an entry as the newest in its shard, shard lock must be held
+         */
+        void insert(shard_t &s, const dns_question &q, time_point_t t, const std::shared_ptr<dns_message> &a);
 
         /**
-         * make space in the cache. This proceeds as follows:
-         *   until number of entries <= max_extries * garbage_collect_pct / 100:
-         *     remove any entry older than m_max_entries
-         *     remove the oldest entries
+         * Make space in a shard, shard lock must be held. This proceeds as follows:
+         *   remove any entries older than m_max_age_seconds
+         *   if the shard is full, remove the oldest entries until garbage_collect_pct is met
+         * Each entry is only removed once so the cost is constant per entry added.
          */
-        void garbage_collect();
+        void garbage_collect(shard_t &s, time_point_t now);
 
+        /**
+         * is there an entry for the question - used by the tests
+         */
+        bool contains(const dns_question &q) const;
     };
 }
@@ -29,12 +29,15 @@
 #include "dns_rr_A.hpp"
 #include "dns_rr_AAAA.hpp"
 #include "run_state.hpp"
+#include "timer_service.hpp"
 #include "dns_parallel_client.hpp"
+#include "dns_cache_snapshot.hpp"
 
 using namespace std;
 using namespace chrono;
 using namespace adns;
 using namespace db;
+using namespace boost::log::trivial;
 
 static shared_ptr<dns_recursive_cache> instance;
 
@@ -59,33 +62,95 @@ shared_ptr<dns_recursive_cache> dns_recursive_cache::get_instance()
     return instance;
 }
 
-dns_recursive_cache::dns_recursive_cache(const cache_config &c) : m_config(c), m_num_answer_rrs(0), m_num_referral_rrs(0)
+dns_recursive_cache::dns_recursive_cache(const cache_config &c) : 
+                        m_num_prefetches(0), 
+                        m_num_stale_answers(0), 
+                        m_num_inline_lookups(0), 
+                        m_num_inline_hits(0), 
+                        m_config(c)
 {
+    // round the number of shards up to a power of two so a shard can be picked with a mask
+    size_t num_shards = 1;
+
+    while (num_shards < c.cache_shards)
+    {
+        num_shards <<= 1;
+    }
+
+    m_shard_mask = num_shards - 1;
+
+    for (size_t i = 0; i < num_shards; i++)
+    {
+        m_answers.push_back(make_unique<dns_recursive_cache_shard<dns_question>>(
+                                    size_t(c.cache_max_answer_kb) * 1024 / num_shards,
+                                    c.prefetch_min_hits,
+                                    c.prefetch_ttl_pct,
+                                    c.serve_stale ? milliseconds(seconds(c.max_stale_ttl)) : milliseconds(0)));
+        m_answers.back()->add_monitors("answers " + to_string(i));
+
+        m_referrals.push_back(make_unique<dns_recursive_cache_shard<dns_name>>(size_t(c.cache_max_referral_kb) * 1024 / num_shards));
+        m_referrals.back()->add_monitors("referrals " + to_string(i));
+    }
+
     m_monitor_answers_id = monitor::add_thing("recursive cache", "singleton", "number of cached answer records", 0);
     m_monitor_referrals_id = monitor::add_thing("recursive cache", "singleton", "number of cached referral records", 0);
+    m_monitor_answer_kb_id = monitor::add_thing("recursive cache", "singleton", "cached answer kilobytes", 0);
+    m_monitor_referral_kb_id = monitor::add_thing("recursive cache", "singleton", "cached referral kilobytes", 0);
+    m_monitor_misses_id = monitor::add_thing("recursive cache", "singleton", "answer misses", 0);
+    m_monitor_prefetches_id = monitor::add_thing("recursive cache", "singleton", "prefetches", 0);
+    m_monitor_stale_answers_id = monitor::add_thing("recursive cache", "singleton", "stale answers served", 0);
+    m_monitor_inline_lookups_id = monitor::add_thing("recursive cache", "singleton", "inline lookups", 0);
+    m_monitor_inline_hits_id = monitor::add_thing("recursive cache", "singleton", "inline hits", 0);
+    m_monitor_inline_hit_pct_id = monitor::add_thing("recursive cache", "singleton", "inline hit ratio (percent)", 0);
+
+    for (uint t = 0; t < num_types; t++)
+    {
+        auto instance = dns_recursive_cache_answer::get_type_as_string(dns_recursive_cache_answer::type_t(t));
+
+        m_monitor_hits_id[t] = monitor::add_thing("recursive cache", instance, "hits", 0);
+        m_monitor_evictions_id[t] = monitor::add_thing("recursive cache", instance, "evictions", 0);
+        m_monitor_expirations_id[t] = monitor::add_thing("recursive cache", instance, "expirations", 0);
+    }
     m_monitor_last_garbage_collect_id = monitor::add_thing("recursive cache", "singleton", "time of last garbage collection", "<none yet>");
 
     monitor::add_thing("recursive cache", "singleton", "garbage collection interval (miliseconds)", c.cache_garbage_collect_ms);
-    monitor::add_thing("recursive cache", "singleton", "max number of cached answer records", c.cache_max_answer_rrs);
-    monitor::add_thing("recursive cache", "singleton", "max number of cached referral records", c.cache_max_referral_rrs);
+    monitor::add_thing("recursive cache", "singleton", "max cached answer kilobytes", c.cache_max_answer_kb);
+    monitor::add_thing("recursive cache", "singleton", "max cached referral kilobytes", c.cache_max_referral_kb);
+    monitor::add_thing("recursive cache", "singleton", "number of shards", num_shards);
+
+    m_monitor_snapshot_loaded_id = monitor::add_thing("recursive cache", "singleton", "snapshot entries loaded", 0);
+    m_monitor_snapshot_load_ms_id = monitor::add_thing("recursive cache", "singleton", "snapshot load time (miliseconds)", 0);
+    m_monitor_snapshot_saved_id = monitor::add_thing("recursive cache", "singleton", "snapshot entries saved", 0);
+    m_monitor_snapshot_save_ms_id = monitor::add_thing("recursive cache", "singleton", "snapshot save time (miliseconds)", 0);
 
     load_root_hints();
-    m_garbage_collector_thread.reset(new thread(&dns_recursive_cache::garbage_collect, this));
+
+    if (!c.root_zone_file.empty())
+    {
+        m_root_mirror = make_unique<dns_root_mirror>(c.root_zone_file, c.root_zone_refresh_s);
+        m_root_mirror->start();
+    }
+
+    load_snapshot();
+    schedule_garbage_collect();
+    schedule_snapshot();
     m_root_hint_updater_thread.reset(new thread(&dns_recursive_cache::update_root_hints, this));
 }
 
 void dns_recursive_cache::load_root_hints()
 {
+    for (auto &s : m_answers)
     {
-        read_write_lock::write_guard guard1(m_answer_lock);
-        m_answers.clear();
-        m_num_answer_rrs = 0;
+        s->clear();
+    }
 
-        read_write_lock::write_guard guard2(m_referral_lock);
-        m_num_referral_rrs = 0;
-        m_referrals.clear();
+    for (auto &s : m_referrals)
+    {
+        s->clear();
     }
 
+    m_referral_trie.clear();
+
     auto conn = connection_pool::get_connection();
 
     map<string, shared_ptr<dns_rr>> root_ns_records;
@@ -150,7 +215,17 @@ dns_recursive_cache::~dns_recursive_cache()
 {
 }
 
-void dns_recursive_cache::add_answer(const shared_ptr<dns_question> &question, const shared_ptr<const dns_recursive_cache_answer> &answer)
+dns_recursive_cache_shard<dns_question> &dns_recursive_cache::answer_shard(const dns_question &q) const
+{
+    return *m_answers[shard_index(q)];
+}
+
+dns_recursive_cache_shard<dns_name> &dns_recursive_cache::referral_shard(const dns_name &n) const
+{
+    return *m_referrals[shard_index(n)];
+}
+
+void dns_recursive_cache::add_answer(const shared_ptr<dns_question> &question, const shared_ptr<dns_recursive_cache_answer> &answer)
 {
     // don't cache something that has zero TTLs in it
     if (answer->get_min_ttl() == 0)
@@ -170,14 +245,10 @@ void dns_recursive_cache::add_answer(const shared_ptr<dns_question> &question, c
     case dns_recursive_cache_answer::no_data_e:
     case dns_recursive_cache_answer::nxdomain_e:
     case dns_recursive_cache_answer::fail_e:
-        {
-            read_write_lock::write_guard guard(m_answer_lock);
-
-            m_answers[*question] = answer;
-            m_answer_list.push_back(pair<dns_question, shared_ptr<const dns_recursive_cache_answer>>(*question, answer));
-            m_num_answer_rrs += answer->get_num_records();
-            monitor::set_value(m_monitor_answers_id, m_num_answer_rrs);
-        }
+        // build the wire format now so that hits only need the TTLs patching
+        answer->encode(*question);
+        answer_shard(*question).add(*question, answer);
+        expire_answer_later(*question, answer);
         break;
     default:
         THROW(dns_recursive_cache_exception, "attempt to cache an answer of uncacheable type", answer->get_type());
@@ -186,100 +257,285 @@ void dns_recursive_cache::add_answer(const shared_ptr<dns_question> &question, c
 
 void dns_recursive_cache::add_referral(const dns_name &qname, const shared_ptr<const dns_recursive_cache_answer> &answer)
 {
-    read_write_lock::write_guard guard(m_referral_lock);
-
     if (answer->get_referral_name().is_root())
     {
-        m_referrals[dns_name::root] = answer;
+        // the root hints are never evicted or expired
+        referral_shard(dns_name::root).add(dns_name::root, answer, false);
     }
     else
     {
-        m_num_referral_rrs += answer->get_num_records();
-        m_referral_list.push_back(pair<dns_name, shared_ptr<const dns_recursive_cache_answer>>(answer->get_referral_name(), answer));
-        m_referrals[answer->get_referral_name()] = answer;
-        monitor::set_value(m_monitor_referrals_id, m_num_referral_rrs);
+        referral_shard(answer->get_referral_name()).add(answer->get_referral_name(), answer);
+        expire_referral_later(answer->get_referral_name(), answer);
     }
+
+    m_referral_trie.add(answer);
 }
 
-void dns_recursive_cache::garbage_collect()
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_root_zone_answer(const dns_question &question) const
 {
-    duration<int, milli> timeout(m_config.cache_garbage_collect_ms);
+    if (!m_root_mirror)
+    {
+        return nullptr;
+    }
 
-    time_point<steady_clock> start_time = steady_clock::now();
+    return m_root_mirror->lookup(question);
+}
 
-    while (true)
+void dns_recursive_cache::schedule_garbage_collect()
+{
+    timer_service::get_instance()->add(milliseconds(m_config.cache_garbage_collect_ms), [this]() { garbage_collect(); });
+}
+
+void dns_recursive_cache::schedule_snapshot()
+{
+    if (m_config.snapshot_file.empty() || (m_config.snapshot_interval_s == 0))
+    {
+        return;
+    }
+
+    timer_service::get_instance()->add(seconds(m_config.snapshot_interval_s), [this]() 
     {
         if (run_state::o_state == run_state::shutdown_e)
         {
             return;
         }
 
-        time_point<steady_clock> time_now = steady_clock::now();
+        save_snapshot();
+        schedule_snapshot();
+    });
+}
+
+void dns_recursive_cache::save_snapshot()
+{
+    if (m_config.snapshot_file.empty())
+    {
+        return;
+    }
+
+    lock_guard<mutex> guard(m_snapshot_lock);
 
-        if ((time_now - start_time) > timeout)
+    auto start = steady_clock::now();
+    time_t now = time(nullptr);
+
+    dns_cache_snapshot s;
+
+    auto add = [&s, now](dns_cache_snapshot::entry_type_t t, const dns_question &q, const shared_ptr<const dns_recursive_cache_answer> &a)
+    {
+        if (a->expired())
         {
-            // garbage colllect
-            garbage_collect_answers();
-            garbage_collect_referrals();
+            return;
+        }
+
+        dns_message m;
 
-            // reset the clock
-            start_time = steady_clock::now();
+        m.set_type(dns_message::response_e);
+        m.set_question(make_shared<dns_question>(q));
+        m.add_answers(a->get_answer_records());
+        m.add_nameservers(a->get_nameserver_records());
+        m.add_additional_records(a->get_additional_records());
 
-            // update the monitor showing time of last GC - use the standard system clock for this
-            monitor::set_value(m_monitor_last_garbage_collect_id, datetime::now().to_string());
+        try
+        {
+            s.add(t, a->get_type(), now - a->get_age(), now + duration_cast<seconds>(a->time_to_expiry()).count(), m);
         }
-        else
+        catch (adns::exception &e)
         {
-            sleep(1);
+            // too big to fit in a message, it'll just have to be fetched again
         }
+    };
+
+    // take copies of the entries so the shards are only locked for as long as it takes to 
+    // copy some pointers
+    for (auto &sh : m_answers)
+    {
+        vector<pair<dns_question, shared_ptr<const dns_recursive_cache_answer>>> entries;
+
+        sh->for_each([&entries](const dns_question &q, const shared_ptr<const dns_recursive_cache_answer> &a) { entries.push_back(make_pair(q, a)); });
+
+        for (auto &e : entries)
+        {
+            add(dns_cache_snapshot::answer_e, e.first, e.second);
+        }
+    }
+
+    for (auto &sh : m_referrals)
+    {
+        vector<pair<dns_name, shared_ptr<const dns_recursive_cache_answer>>> entries;
+
+        sh->for_each([&entries](const dns_name &n, const shared_ptr<const dns_recursive_cache_answer> &a) { entries.push_back(make_pair(n, a)); });
+
+        for (auto &e : entries)
+        {
+            // the root comes from the root hints
+            if (!e.first.is_root())
+            {
+                add(dns_cache_snapshot::referral_e, dns_question(e.first, dns_question::QT_RR_e, dns_rr::T_NS_e), e.second);
+            }
+        }
+    }
+
+    try
+    {
+        s.save(m_config.snapshot_file);
+
+        auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+        LOG(info) << "saved " << s.get_num_entries() << " recursive cache entries to " << m_config.snapshot_file << " in " << ms << "ms";
+
+        monitor::set_value(m_monitor_snapshot_saved_id, uint(s.get_num_entries()));
+        monitor::set_value(m_monitor_snapshot_save_ms_id, uint(ms));
+    }
+    catch (adns::exception &e)
+    {
+        e.log(warning, "failed to save recursive cache snapshot");
     }
 }
 
-void dns_recursive_cache::join()
+void dns_recursive_cache::load_snapshot()
 {
-    if (m_garbage_collector_thread)
+    if (m_config.snapshot_file.empty())
     {
-        m_garbage_collector_thread->join();
-        m_root_hint_updater_thread->join();
-        m_garbage_collector_thread = nullptr;
-        m_root_hint_updater_thread = nullptr;
+        return;
+    }
+
+    auto start = steady_clock::now();
+    size_t n = 0;
+
+    auto loader = [this](dns_cache_snapshot::entry_type_t t, uint answer_type, time_t created, time_t expiry, dns_message *m)
+    {
+        unique_ptr<dns_message> mp(m);
+
+        time_t now = time(nullptr);
+        uint age = (now > created) ? now - created : 0;
+
+        // bring the TTLs up to date
+        for (auto rrs : { &m->get_answers(), &m->get_nameservers(), &m->get_additional_records() })
+        {
+            for (auto &rr : *rrs)
+            {
+                rr->set_ttl(rr->get_ttl() > age ? rr->get_ttl() - age : 0);
+            }
+        }
+
+        auto a = make_shared<dns_recursive_cache_answer>(
+                            dns_recursive_cache_answer::type_t(answer_type),
+                            (expiry > now) ? expiry - now : 0,
+                            m->get_answers(),
+                            m->get_nameservers(),
+                            m->get_additional_records());
+
+        if (t == dns_cache_snapshot::answer_e)
+        {
+            add_answer(m->get_question(), a);
+        }
+        else if (t == dns_cache_snapshot::referral_e)
+        {
+            add_referral(a->get_referral_name(), a);
+        }
+    };
+
+    try
+    {
+        n = dns_cache_snapshot::load(m_config.snapshot_file, loader, thread::hardware_concurrency());
+    }
+    catch (adns::exception &e)
+    {
+        e.log(warning, "failed to load recursive cache snapshot");
+    }
+
+    auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+    LOG(info) << "loaded " << n << " recursive cache entries from " << m_config.snapshot_file << " in " << ms << "ms";
+
+    monitor::set_value(m_monitor_snapshot_loaded_id, uint(n));
+    monitor::set_value(m_monitor_snapshot_load_ms_id, uint(ms));
+}
+
+void dns_recursive_cache::garbage_collect()
+{
+    if (run_state::o_state == run_state::shutdown_e)
+    {
+        return;
     }
+
+    // expired entries have mostly gone already (see expire_answer) and eviction happens as 
+    // entries are added, this catches anything left over and updates the monitors
+    garbage_collect_answers();
+    garbage_collect_referrals();
+    update_monitors();
+
+    // update the monitor showing time of last GC - use the standard system clock for this
+    monitor::set_value(m_monitor_last_garbage_collect_id, datetime::now().to_string());
+
+    schedule_garbage_collect();
 }
 
-bool dns_recursive_cache::answer_expired(const dns_question &q)
+void dns_recursive_cache::expire_answer_later(const dns_question &q, const shared_ptr<const dns_recursive_cache_answer> &answer)
 {
-    read_write_lock::read_guard guard(m_answer_lock);
+    auto sequence = answer->get_sequence();
+
+    // kept on past expiry if it might be served stale
+    auto expiry = answer->time_to_expiry(answer_shard(q).get_stale_window());
+
+    timer_service::get_instance()->add(expiry, [this, q, sequence]() { expire_answer(q, sequence); });
+}
 
-    auto i = m_answers.find(q);
-    if (i == m_answers.end())
+void dns_recursive_cache::expire_referral_later(const dns_name &n, const shared_ptr<const dns_recursive_cache_answer> &answer)
+{
+    auto sequence = answer->get_sequence();
+
+    timer_service::get_instance()->add(answer->time_to_expiry(), [this, n, sequence]() { expire_referral(n, sequence); });
+}
+
+void dns_recursive_cache::expire_answer(const dns_question &q, size_t sequence)
+{
+    auto a = answer_shard(q).expire(q, sequence);
+
+    if (a)
     {
-        return false;
+        expire_answer_later(q, a);
     }
-    else
+}
+
+void dns_recursive_cache::expire_referral(const dns_name &n, size_t sequence)
+{
+    auto r = referral_shard(n).expire(n, sequence);
+
+    if (r)
     {
-        return i->second->expired();
+        expire_referral_later(n, r);
     }
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_answer(const shared_ptr<dns_question> &question, bool referral_requested) 
+void dns_recursive_cache::join()
 {
+    if (m_root_hint_updater_thread)
     {
-        read_write_lock::read_guard guard(m_answer_lock);
+        m_root_hint_updater_thread->join();
+        m_root_hint_updater_thread = nullptr;
+    }
 
-        auto i = m_answers.find(*question);
+    timer_service::get_instance()->join();
+}
 
-        if (i != m_answers.end())
-        {
-            auto a = i->second;
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_answer(const shared_ptr<dns_question> &question, bool referral_requested) 
+{
+    auto &s = answer_shard(*question);
+    bool refresh = false;
+    auto a = s.find(*question, &refresh);
 
-            if (!a->expired())
-            {
-                a->update_ttls();
-                return a;
-            }
+    if (a)
+    {
+        if (refresh)
+        {
+            prefetch(question);
         }
+
+        return a;
     }
 
+    s.miss();
+
     if (referral_requested)
     {
         return get_referral(question);
@@ -290,52 +546,108 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_answer(con
     }
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_referral(const shared_ptr<dns_question> &question) const
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_stale_answer(const dns_question &question)
+{
+    if (!m_config.serve_stale)
+    {
+        return nullptr;
+    }
+
+    auto a = answer_shard(question).find_stale(question);
+
+    if (!a)
+    {
+        return nullptr;
+    }
+
+    m_num_stale_answers++;
+
+    auto res = a->copy_with_ttl(m_config.stale_answer_ttl);
+    res->encode(question);
+
+    return res;
+}
+
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_inline_answer(const shared_ptr<dns_question> &question)
 {
-    read_write_lock::read_guard guard(m_referral_lock);
+    m_num_inline_lookups++;
 
-    auto name = question->get_qname().clone();
+    bool refresh = false;
+    auto a = answer_shard(*question).find(*question, &refresh);
 
-    while (true)
+    if (!a)
     {
-        auto i = m_referrals.find(*name);
-        if (i != m_referrals.end())
-        {
-            auto a = i->second;
+        return nullptr;
+    }
 
-            if (!a->expired())
-            {
-                return a;
-            }
-        }
+    if (refresh)
+    {
+        prefetch(question);
+    }
 
-        if (name->size() == 0)
-        {
-            break;
-        }
-        else
-        {
-            name->remove_first();
-        }
+    // anything that wasn't encoded (e.g. server fails) goes the long way round
+    if (!a->is_encoded_for(*question))
+    {
+        return nullptr;
     }
-    
-    THROW(dns_recursive_cache_exception, "no root hints loaded");
+
+    m_num_inline_hits++;
+
+    return a;
+}
+
+void dns_recursive_cache::set_prefetcher(const function<void(const shared_ptr<dns_question> &)> &prefetcher)
+{
+    lock_guard<mutex> guard(m_prefetcher_lock);
+    m_prefetcher = prefetcher;
+}
+
+void dns_recursive_cache::prefetch(const shared_ptr<dns_question> &question)
+{
+    lock_guard<mutex> guard(m_prefetcher_lock);
+
+    if (m_prefetcher)
+    {
+        m_num_prefetches++;
+        m_prefetcher(question);
+    }
+}
+
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_cache::get_referral(const shared_ptr<dns_question> &question) const
+{
+    auto a = m_referral_trie.find(question->get_qname());
+
+    if (!a)
+    {
+        THROW(dns_recursive_cache_exception, "no root hints loaded");
+    }
+
+    // look it up in its shard as well so that the hit counts towards keeping it
+    auto c = referral_shard(a->get_referral_name()).find(a->get_referral_name());
+
+    return c ? c : a;
 }
 
 void dns_recursive_cache::dump() const
 {
     LOG(debug) << "dumping recursive cache - answers";
-    for (auto i : m_answers)
+    for (auto &s : m_answers)
     {
-        LOG(debug) << "name is '" << i.first << "'";
-        i.second->dump();
+        s->for_each([](const dns_question &q, const shared_ptr<const dns_recursive_cache_answer> &a)
+        {
+            LOG(debug) << "name is '" << q << "'";
+            a->dump();
+        });
     }
 
     LOG(debug) << "dumping recursive cache - referrals";
-    for (auto i : m_referrals)
+    for (auto &s : m_referrals)
     {
-        LOG(debug) << "name is '" << i.first << "'";
-        i.second->dump();
+        s->for_each([](const dns_name &n, const shared_ptr<const dns_recursive_cache_answer> &a)
+        {
+            LOG(debug) << "name is '" << n << "'";
+            a->dump();
+        });
     }
 }
 
@@ -367,8 +679,7 @@ void dns_recursive_cache::update_root_hints_now(const set<ip_address> &ip_addres
                             res->get_additional_records());
             // set the TTLs to 48 hours regardless of what we got back from the root
             // servers
-            ans->set_ttls(TWO_DAYS);
-            add_referral(dns_name::root, ans);
+            add_referral(dns_name::root, ans->copy_with_ttl(TWO_DAYS));
         }
 
         delete res;
@@ -377,7 +688,7 @@ void dns_recursive_cache::update_root_hints_now(const set<ip_address> &ip_addres
     {
         LOG(warning) << "no responses from any root servers, hints not updated";
         // reset the TTLs to 48 hours, root servers don't change very often
-        dns_recursive_cache::get_instance()->get_referral(q)->set_ttls(TWO_DAYS);
+        add_referral(dns_name::root, get_referral(q)->copy_with_ttl(TWO_DAYS));
     }
 }
 
@@ -458,7 +769,6 @@ void dns_recursive_cache::update_root_hints()
         }
 
         auto ca = dns_recursive_cache::get_instance()->get_referral(q);
-        ca->update_ttls();
 
         if (first_pass || (ca->get_min_ttl() < ONE_DAY))
         {
@@ -474,7 +784,7 @@ void dns_recursive_cache::update_root_hints()
             {
                 // something has gone badly wrong, reset the root server TTLs to 2 days
                 LOG(warning) << "continually failed to update root hints, resetting TTLs to 48 hours";
-                ca->set_ttls(TWO_DAYS);
+                dns_recursive_cache::get_instance()->add_referral(dns_name::root, ca->copy_with_ttl(TWO_DAYS));
             }
         }
     }
@@ -509,122 +819,92 @@ void dns_recursive_cache::get_glue_ips(
 
 void dns_recursive_cache::garbage_collect_answers()
 {
-    read_write_lock::write_guard guard2(m_answer_lock);
-
-    auto i = m_answer_list.begin();
-
-    // get rid of anything expired or anything in the list that is no longer in the cache
-    // due to having being overwitten
-    while (i != m_answer_list.end())
+    for (auto &s : m_answers)
     {
-        if (m_answers.find(i->first) == m_answers.end())
-        {
-            // no longer in the cache
-            m_num_answer_rrs -= i->second->get_num_records();
-            m_answer_list.erase(i++);
-        }
-        else
-        {
-            if (i->second->get_sequence() != m_answers[i->first]->get_sequence())
-            {
-                // in the cache but replaced with a new version
-                m_num_answer_rrs -= i->second->get_num_records();
-                m_answer_list.erase(i++);
-            }
-            else
-            {
-                if (i->second->expired())
-                {
-                    // in the cache and expires
-                    m_num_answer_rrs -= i->second->get_num_records();
-                    m_answers.erase(i->first);
-                    m_answer_list.erase(i++);
-                }
-                else
-                {
-                    // in the cache, not expired, skip to next item
-                    i++;
-                }
-            }
-        }
+        s->garbage_collect();
     }
+}
 
-    i = m_answer_list.begin();
-
-    // now get rid of the entries that have been in the cache the longest until we're down
-    // to the required size
-    while (i != m_answer_list.end() && (m_num_answer_rrs > m_config.cache_max_answer_rrs))
+void dns_recursive_cache::garbage_collect_referrals()
+{
+    for (auto &s : m_referrals)
     {
-        m_num_answer_rrs -= i->second->get_num_records();
-        m_answers.erase(i->first);
-        m_answer_list.erase(i++);
+        s->garbage_collect();
     }
 
-    monitor::set_value(m_monitor_answers_id, m_num_answer_rrs);
+    m_referral_trie.prune();
 }
 
-void dns_recursive_cache::garbage_collect_referrals()
+void dns_recursive_cache::update_monitors()
 {
-    read_write_lock::write_guard guard2(m_referral_lock);
+    uint64_t hits[num_types] = {};
+    uint64_t evictions[num_types] = {};
+    uint64_t expirations[num_types] = {};
+    uint64_t misses = 0;
 
-    auto i = m_referral_list.begin();
+    uint answer_rrs = 0;
+    size_t answer_bytes = 0;
 
-    // get rid of anything expired or anything in the list that is no longer in the cache
-    // due to having being overwitten
-    while (i != m_referral_list.end())
+    for (auto &s : m_answers)
     {
-        if (m_referrals.find(i->first) == m_referrals.end())
+        s->update_monitors();
+
+        answer_rrs += s->get_num_rrs();
+        answer_bytes += s->get_num_bytes();
+        misses += s->get_num_misses();
+
+        for (uint t = 0; t < num_types; t++)
         {
-            // no longer in the cache at all
-            //LOG(warning) << "found referral that's no in the cache";
-            m_num_referral_rrs -= i->second->get_num_records();
-            m_referral_list.erase(i++);
+            hits[t] += s->get_num_hits(t);
+            evictions[t] += s->get_num_evictions(t);
+            expirations[t] += s->get_num_expirations(t);
         }
-        else
+    }
+
+    uint referral_rrs = 0;
+    size_t referral_bytes = 0;
+
+    for (auto &s : m_referrals)
+    {
+        s->update_monitors();
+
+        referral_rrs += s->get_num_rrs();
+        referral_bytes += s->get_num_bytes();
+
+        for (uint t = 0; t < num_types; t++)
         {
-            if (i->second->get_sequence() != m_referrals[i->first]->get_sequence())
-            {
-                // in the cache but replaced with a newer version
-                //LOG(warning) << "found referral that's been replaced by newer version for " << i->first;
-                //LOG(warning) << "list record is";
-                //i->second->dump();
-                //LOG(warning) << "cache record is";
-                //m_referrals[i->first]->dump();
-                m_num_referral_rrs -= i->second->get_num_records();
-                m_referral_list.erase(i++);
-            }
-            else
-            {
-                if (i->second->expired())
-                {
-                    // in the cache but expired
-                    //LOG(warning) << "found referral that's expired";
-                    m_num_referral_rrs -= i->second->get_num_records();
-                    m_referrals.erase(i->first);
-                    m_referral_list.erase(i++);
-                }
-                else
-                {
-                    // still in the cache, not overwitten, not expired, so skip to the next
-                    i++;
-                }
-            }
+            hits[t] += s->get_num_hits(t);
+            evictions[t] += s->get_num_evictions(t);
+            expirations[t] += s->get_num_expirations(t);
         }
     }
 
-    i = m_referral_list.begin();
+    monitor::set_value(m_monitor_answers_id, answer_rrs);
+    monitor::set_value(m_monitor_referrals_id, referral_rrs);
+    monitor::set_value(m_monitor_answer_kb_id, uint(answer_bytes / 1024));
+    monitor::set_value(m_monitor_referral_kb_id, uint(referral_bytes / 1024));
+    monitor::set_value(m_monitor_misses_id, uint(misses));
+    monitor::set_value(m_monitor_prefetches_id, m_num_prefetches);
+    monitor::set_value(m_monitor_stale_answers_id, m_num_stale_answers);
 
-    // now get rid of the entries that have been in the cache the longest until we're down
-    // to the required size
+    uint inline_lookups = m_num_inline_lookups;
+    uint inline_hits = m_num_inline_hits;
 
-    while (i != m_referral_list.end() && (m_num_referral_rrs > m_config.cache_max_referral_rrs))
+    monitor::set_value(m_monitor_inline_lookups_id, inline_lookups);
+    monitor::set_value(m_monitor_inline_hits_id, inline_hits);
+    monitor::set_value(m_monitor_inline_hit_pct_id, inline_lookups ? uint(uint64_t(inline_hits) * 100 / inline_lookups) : 0);
+
+    if (m_root_mirror)
     {
-        m_num_referral_rrs -= i->second->get_num_records();
-        m_referrals.erase(i->first);
-        m_referral_list.erase(i++);
+        m_root_mirror->update_monitors();
     }
 
-    monitor::set_value(m_monitor_referrals_id, m_num_referral_rrs);
+    for (uint t = 0; t < num_types; t++)
+    {
+        monitor::set_value(m_monitor_hits_id[t], uint(hits[t]));
+        monitor::set_value(m_monitor_evictions_id[t], uint(evictions[t]));
+        monitor::set_value(m_monitor_expirations_id[t], uint(expirations[t]));
+    }
 }
 
 uint dns_recursive_cache::get_default_ttl() const
@@ -636,12 +916,10 @@ map<dns_name, uint> dns_recursive_cache::get_referral_name_record_counts()
 {
     map<dns_name, uint> res;
 
-    read_write_lock::read_guard guard2(m_referral_lock);
-
-    for (auto i : m_referrals)
+    m_referral_trie.for_each([&res](const shared_ptr<const dns_recursive_cache_answer> &a)
     {
-        res[i.first] = i.second->get_num_records();
-    }
+        res[a->get_referral_name()] = a->get_num_records();
+    });
 
     return res;
 }
@@ -19,10 +19,11 @@
  
 #pragma once
 
-#include <unordered_map>
+#include <vector>
 #include <set>
 #include <map>
 #include <thread>
+#include <functional>
 
 #include "types.hpp"
 #include "dns_rr.hpp"
@@ -30,7 +31,9 @@
 #include "exception.hpp"
 #include "cache_config.hpp"
 #include "dns_recursive_cache_answer.hpp"
-#include "read_write_lock.hpp"
+#include "dns_recursive_cache_shard.hpp"
+#include "dns_referral_trie.hpp"
+#include "dns_root_mirror.hpp"
 
 EXCEPTION_CLASS(dns_recursive_cache_exception, exception)
 
@@ -65,17 +68,43 @@ namespace adns
                             const std::shared_ptr<dns_question> &question, 
                             bool                                referral_requested);
 
+        /**
+         * given a question, get an answer that may have expired but is still within the configured
+         * stale window, with its TTLs set to the stale answer TTL. nullptr if there isn't one or
+         * serve-stale is off.
+         */
+        std::shared_ptr<const dns_recursive_cache_answer> get_stale_answer(const dns_question &question);
+
+        /**
+         * given a question, get a cached answer that's ready to be sent straight back to the client
+         * without going through a recursive slot. nullptr if there isn't one, the query then needs
+         * to be resolved as normal.
+         */
+        std::shared_ptr<const dns_recursive_cache_answer> get_inline_answer(const std::shared_ptr<dns_question> &question);
+
+        /**
+         * set the function called to refresh popular answers before they expire
+         */
+        void set_prefetcher(const std::function<void(const std::shared_ptr<dns_question> &)> &prefetcher);
+
         /**
          * get the nearest nameserver referal for a question that can't be answered from the cache.
          */
         std::shared_ptr<const dns_recursive_cache_answer> get_referral(const std::shared_ptr<dns_question> &question) const;
 
         /**
-         * add an answer to the cache
+         * Get a TLD referral or NXDOMAIN from the local copy of the root zone, used in place of
+         * asking the root servers. nullptr if there's no local root zone.
+         */
+        std::shared_ptr<const dns_recursive_cache_answer> get_root_zone_answer(const dns_question &question) const;
+
+        /**
+         * add an answer to the cache. The answer is encoded for the question on the way in so it
+         * mustn't have been shared with anything else yet.
          */
         void add_answer(
-                    const std::shared_ptr<dns_question>                     &question, 
-                    const std::shared_ptr<const dns_recursive_cache_answer> &answer);
+                    const std::shared_ptr<dns_question>               &question, 
+                    const std::shared_ptr<dns_recursive_cache_answer> &answer);
 
         /**
          * add a referral to the cache
@@ -92,6 +121,11 @@ namespace adns
          */
         void join();
 
+        /**
+         * save the cache contents to the snapshot file, if there is one
+         */
+        void save_snapshot();
+
         /**
          * dump the cache contents for debug
          */
@@ -104,26 +138,32 @@ namespace adns
 
     private:
 
-        // lock for the answer cache
-        mutable read_write_lock m_answer_lock;
+        // query/answer data, sharded by question hash
+        std::vector<std::unique_ptr<dns_recursive_cache_shard<dns_question>>> m_answers;
+
+        // referral to elsewhere if the answer wasn't found, sharded by name hash
+        std::vector<std::unique_ptr<dns_recursive_cache_shard<dns_name>>> m_referrals;
 
-        // query/answer data
-        std::unordered_map<dns_question, std::shared_ptr<const dns_recursive_cache_answer>> m_answers;
+        // the same referrals indexed by delegation point for finding the closest one to a name
+        dns_referral_trie m_referral_trie;
 
-        // lock for the referral cache
-        mutable read_write_lock m_referral_lock;
+        // local copy of the root zone (RFC 8806), if configured
+        std::unique_ptr<dns_root_mirror> m_root_mirror;
 
-        // referral to elsewhere if the answer wasn't found
-        std::unordered_map<dns_name, std::shared_ptr<const dns_recursive_cache_answer>> m_referrals;
+        // number of shards - 1, the number of shards is always a power of two
+        size_t m_shard_mask;
 
-        // list of referral entries - used for FIFO garbage collection
-        std::list<std::pair<dns_name, std::shared_ptr<const dns_recursive_cache_answer>>> m_referral_list;
+        // refreshes popular answers before they expire
+        std::mutex m_prefetcher_lock;
+        std::function<void(const std::shared_ptr<dns_question> &)> m_prefetcher;
 
-        // list of answer entries - used for FIFO garbage collection
-        std::list<std::pair<dns_question, std::shared_ptr<const dns_recursive_cache_answer>>> m_answer_list;
+        // prefetch and serve-stale counters
+        std::atomic<uint> m_num_prefetches;
+        std::atomic<uint> m_num_stale_answers;
 
-        // garbage collection thread
-        std::shared_ptr<std::thread> m_garbage_collector_thread;
+        // lookups made by the server handlers before handing a query to a slot, and how many were answered
+        std::atomic<uint> m_num_inline_lookups;
+        std::atomic<uint> m_num_inline_hits;
 
         // root hint updater thread
         std::shared_ptr<std::thread> m_root_hint_updater_thread;
@@ -131,12 +171,6 @@ namespace adns
         // cache config (included client)
         cache_config m_config;
 
-        // number of cached answer rrs - for monitoring
-        uint m_num_answer_rrs;
-
-        // number of cached referal rrs  - for monitoring
-        uint m_num_referral_rrs;
-
         // ID of the monitor for number of cached answers
         uint m_monitor_answers_id;
 
@@ -146,6 +180,38 @@ namespace adns
         // ID of the monitor for time of last garbage collect
         uint m_monitor_last_garbage_collect_id;
 
+        // IDs of the monitors for estimated memory use
+        uint m_monitor_answer_kb_id;
+        uint m_monitor_referral_kb_id;
+
+        // ID of the monitor for answer lookups not found in the cache
+        uint m_monitor_misses_id;
+
+        // IDs of the prefetch and serve-stale monitors
+        uint m_monitor_prefetches_id;
+        uint m_monitor_stale_answers_id;
+
+        // IDs of the monitors for answers sent straight from the handlers
+        uint m_monitor_inline_lookups_id;
+        uint m_monitor_inline_hits_id;
+        uint m_monitor_inline_hit_pct_id;
+
+        // only one snapshot is written at a time
+        std::mutex m_snapshot_lock;
+
+        // IDs of the snapshot monitors
+        uint m_monitor_snapshot_loaded_id;
+        uint m_monitor_snapshot_load_ms_id;
+        uint m_monitor_snapshot_saved_id;
+        uint m_monitor_snapshot_save_ms_id;
+
+        static const uint num_types = dns_recursive_cache_shard<dns_question>::num_types;
+
+        // IDs of the per answer type monitors
+        uint m_monitor_hits_id[num_types];
+        uint m_monitor_evictions_id[num_types];
+        uint m_monitor_expirations_id[num_types];
+
         /**
          * load root hints from DB
          */
@@ -157,15 +223,69 @@ namespace adns
         dns_recursive_cache(const cache_config &c);
 
         /**
-         * figure out if an answer to a question is in the cache and, if so, has it expired.
+         * pick the shard for a key
+         */
+        template <typename K> size_t shard_index(const K &k) const
+        {
+            size_t h = std::hash<K>()(k);
+
+            // mix the hash first, the low bits are what the shards' own maps bucket on
+            h ^= h >> 32;
+            h *= 0x9e3779b97f4a7c15ull;
+
+            return (h >> 32) & m_shard_mask;
+        }
+
+        /**
+         * the shard holding the answer for a question
          */
-        bool answer_expired(const dns_question &q);
+        dns_recursive_cache_shard<dns_question> &answer_shard(const dns_question &q) const;
 
         /**
-         * garbage collect cache entries
+         * the shard holding the referral for a name
+         */
+        dns_recursive_cache_shard<dns_name> &referral_shard(const dns_name &n) const;
+
+        /**
+         * garbage collect cache entries, runs periodically on the timer service
          */
         void garbage_collect();
 
+        /**
+         * run garbage_collect() again after the configured interval
+         */
+        void schedule_garbage_collect();
+
+        /**
+         * reload anything still current from the snapshot file
+         */
+        void load_snapshot();
+
+        /**
+         * save a snapshot after the configured interval, and keep doing so
+         */
+        void schedule_snapshot();
+
+        /**
+         * set a timer to drop an answer from the cache when its TTL runs out
+         */
+        void expire_answer_later(const dns_question &q, const std::shared_ptr<const dns_recursive_cache_answer> &answer);
+
+        /**
+         * set a timer to drop a referral from the cache when its TTL runs out
+         */
+        void expire_referral_later(const dns_name &n, const std::shared_ptr<const dns_recursive_cache_answer> &answer);
+
+        /**
+         * drop an answer if it's still the same one and has expired (timer callback)
+         */
+        void expire_answer(const dns_question &q, size_t sequence);
+
+        /**
+         * drop a referral if it's still the same one and has expired (timer callback)
+         */
+        void expire_referral(const dns_name &n, size_t sequence);
+
         /**
          * update root hints if they're getting a bit old
          */
@@ -199,5 +319,15 @@ namespace adns
          * Garbage collect cached referrals - delete anything with 0 TTL
          */
         void garbage_collect_referrals();
+
+        /**
+         * ask for a popular answer to be refreshed
+         */
+        void prefetch(const std::shared_ptr<dns_question> &question);
+
+        /**
+         * total up the shard counters and publish them
+         */
+        void update_monitors();
     };
 }
@@ -17,9 +17,13 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
  
+#include <string.h>
+
 #include <set>
 
 #include "dns_rr_SOA.hpp"
+#include "dns_rr_parser.hpp"
+#include "dns_message_parser.hpp"
 #include "dns_recursive_cache_answer.hpp"
 
 using namespace std;
@@ -30,11 +34,14 @@ atomic<size_t> dns_recursive_cache_answer::o_sequence = 0;
 dns_recursive_cache_answer::dns_recursive_cache_answer(const dns_recursive_cache_answer &other) :
         m_sequence(o_sequence++),
         m_num_records(other.m_num_records),
+        m_size(other.m_size),
         m_type(other.m_type),
         m_referral_name(other.m_referral_name),
         m_answer_rr_strings(other.m_answer_rr_strings),
-        m_create_time(chrono::steady_clock::now()),
+        m_create_time(other.m_create_time),
         m_min_ttl(other.m_min_ttl),
+        m_expiry(other.m_expiry),
+        m_question_end(0),
         m_answer_records(other.m_answer_records),
         m_ns_records(other.m_ns_records),
         m_additional_records(other.m_additional_records)
@@ -49,9 +56,11 @@ dns_recursive_cache_answer::dns_recursive_cache_answer(
                     const list<shared_ptr<dns_rr>> &additional_records) :
                             m_sequence(o_sequence++),
                             m_num_records(0),
+                            m_size(0),
                             m_type(t),
                             m_create_time(chrono::steady_clock::now()),
                             m_min_ttl(chrono::duration<double>(default_ttl)),
+                            m_question_end(0),
                             m_answer_records(answer_records),
                             m_additional_records(additional_records)
 {
@@ -106,6 +115,7 @@ dns_recursive_cache_answer::dns_recursive_cache_answer(
     }
 
     m_num_records = m_answer_records.size() + m_additional_records.size() + m_ns_records.size();
+    m_expiry = m_create_time + chrono::duration_cast<chrono::steady_clock::duration>(m_min_ttl);
 
     for (auto i : m_answer_records)
     {
@@ -113,7 +123,7 @@ dns_recursive_cache_answer::dns_recursive_cache_answer(
     }
 }
 
-void dns_recursive_cache_answer::update_min_ttl(bool &min_set, const list<shared_ptr<dns_rr>> &rrs) const
+void dns_recursive_cache_answer::update_min_ttl(bool &min_set, const list<shared_ptr<dns_rr>> &rrs)
 {
     for (auto rr : rrs)
     {
@@ -165,6 +175,12 @@ void dns_recursive_cache_answer::add_answer_records(const list<shared_ptr<dns_rr
             m_answer_records.push_back(nrr);
             m_answer_rr_strings.insert(s);
             m_num_records++;
+            m_size = 0;
+
+            // records have changed so any encoding is now out of date
+            m_wire.clear();
+            m_ttl_offsets.clear();
+            m_question_end = 0;
         }
     }
 }
@@ -223,50 +239,46 @@ list<shared_ptr<dns_rr>> dns_recursive_cache_answer::get_additional_records() co
     return m_additional_records;
 }
 
-bool dns_recursive_cache_answer::expired() const
+bool dns_recursive_cache_answer::expired(chrono::milliseconds grace) const
 {
-    unique_lock<mutex> guard(m_lock);
+    return chrono::steady_clock::now() > (m_expiry + grace);
+}
 
-    chrono::time_point<chrono::steady_clock> time_now = chrono::steady_clock::now();
+bool dns_recursive_cache_answer::near_expiry(uint pct) const
+{
+    auto left = m_expiry - chrono::steady_clock::now();
 
-    return (time_now - m_create_time) > m_min_ttl;
+    return left <= (m_min_ttl * pct / 100);
 }
 
-void dns_recursive_cache_answer::update_ttls() const
+shared_ptr<dns_recursive_cache_answer> dns_recursive_cache_answer::copy_with_ttl(uint ttl) const
 {
     unique_lock<mutex> guard(m_lock);
 
-    chrono::time_point<chrono::steady_clock> now = chrono::steady_clock::now();
-
-    chrono::duration<double> diff = now - m_create_time;
-
-    if (diff < chrono::duration<double>(1))
+    auto copy_rrs = [ttl](const list<shared_ptr<dns_rr>> &rrs)
     {
-        return;
-    }
+        list<shared_ptr<dns_rr>> res;
 
-    if (diff > m_min_ttl)
-    {
-        diff = m_min_ttl;
-    }
+        for (auto rr : rrs)
+        {
+            shared_ptr<dns_rr> c(rr->clone());
+            c->set_ttl(ttl);
+            res.push_back(c);
+        }
 
-    m_min_ttl -= diff;
-    m_create_time = now;
+        return res;
+    };
 
-    int sdiff = -chrono::duration_cast<chrono::seconds>(diff).count();
+    auto res = make_shared<dns_recursive_cache_answer>(*this);
 
-    for (auto rr : m_answer_records)
-    {
-        rr->update_ttl(sdiff);
-    }
-    for (auto rr : m_ns_records)
-    {
-        rr->update_ttl(sdiff);
-    }
-    for (auto rr : m_additional_records)
-    {
-        rr->update_ttl(sdiff);
-    }
+    res->m_answer_records = copy_rrs(m_answer_records);
+    res->m_ns_records = copy_rrs(m_ns_records);
+    res->m_additional_records = copy_rrs(m_additional_records);
+    res->m_create_time = chrono::steady_clock::now();
+    res->m_min_ttl = chrono::duration<double>(ttl);
+    res->m_expiry = res->m_create_time + chrono::seconds(ttl);
+
+    return res;
 }
 
 shared_ptr<dns_rr> dns_recursive_cache_answer::get_soa_record() const
@@ -284,7 +296,21 @@ shared_ptr<dns_rr> dns_recursive_cache_answer::get_soa_record() const
 
 uint dns_recursive_cache_answer::get_min_ttl() const
 {
-    return chrono::duration_cast<chrono::seconds>(m_min_ttl).count();
+    auto left = chrono::duration_cast<chrono::seconds>(m_expiry - chrono::steady_clock::now()).count();
+
+    return left > 0 ? left : 0;
+}
+
+uint dns_recursive_cache_answer::get_age() const
+{
+    return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - m_create_time).count();
+}
+
+chrono::milliseconds dns_recursive_cache_answer::time_to_expiry(chrono::milliseconds grace) const
+{
+    auto left = chrono::duration_cast<chrono::milliseconds>(m_expiry + grace - chrono::steady_clock::now());
+
+    return max(left, chrono::milliseconds(0));
 }
 
 list<shared_ptr<dns_rr>> dns_recursive_cache_answer::get_nameserver_NS_records() const
@@ -325,39 +351,209 @@ std::string dns_recursive_cache_answer::get_type_as_string(type_t t)
     return "<INVALID>";
 }
 
-void dns_recursive_cache_answer::set_ttls(uint ttl) const
+const dns_name &dns_recursive_cache_answer::get_referral_name() const
+{
+    return m_referral_name;
+}
+
+size_t dns_recursive_cache_answer::get_sequence() const
+{
+    return m_sequence;
+}
+
+uint dns_recursive_cache_answer::get_num_records() const
+{
+    return m_num_records;
+}
+
+size_t dns_recursive_cache_answer::get_size() const
 {
     unique_lock<mutex> guard(m_lock);
 
-    for (auto rr : m_answer_records)
+    if (m_size == 0)
     {
-        rr->set_ttl(ttl);
+        m_size = sizeof(dns_recursive_cache_answer) +
+                 get_size(m_answer_records) + 
+                 get_size(m_ns_records) + 
+                 get_size(m_additional_records);
+
+        // the strings used to spot duplicate answer records, plus the set nodes holding them
+        for (auto &s : m_answer_rr_strings)
+        {
+            m_size += sizeof(string) + s.capacity() + 4 * sizeof(void *);
+        }
+
+        m_size += m_wire.capacity() + (m_ttl_offsets.capacity() * sizeof(size_t));
     }
-    for (auto rr : m_ns_records)
+
+    return m_size;
+}
+
+size_t dns_recursive_cache_answer::get_size(const list<shared_ptr<dns_rr>> &rrs)
+{
+    // every record and label is held by a shared_ptr (control block) in a list (node)
+    static const size_t overhead = (2 * sizeof(void *)) + (2 * sizeof(long)) + (2 * sizeof(void *));
+
+    static thread_local octet buffer[0x10000 + 512];
+
+    dns_rr_parser p;
+    size_t res = 0;
+
+    for (auto &rr : rrs)
     {
-        rr->set_ttl(ttl);
+        // the uncompressed wire format is a good stand in for the size of the record specific data
+        unordered_map<dns_name, unsigned short> name_offsets;
+        size_t offset = 0;
+
+        try
+        {
+            p.unparse(buffer, name_offsets, *rr, sizeof(buffer), offset, false);
+        }
+        catch (adns::exception &e)
+        {
+            offset = 512;
+        }
+
+        res += overhead + sizeof(dns_rr) + offset + (rr->get_name()->size() * (overhead + sizeof(dns_label)));
     }
-    for (auto rr : m_additional_records)
+
+    return res;
+}
+
+void dns_recursive_cache_answer::encode(const dns_question &q)
+{
+    m_wire.clear();
+    m_ttl_offsets.clear();
+    m_question_end = 0;
+    m_size = 0;
+
+    if ((m_type != data_e) && (m_type != no_data_e) && (m_type != nxdomain_e))
+    {
+        return;
+    }
+
+    // the same response the recursive slot would construct, the header is filled in per request
+    dns_message m;
+
+    m.set_type(dns_message::response_e);
+    m.set_op_code(dns_message::op_query_e);
+    m.set_question(make_shared<dns_question>(q));
+
+    if (m_type == data_e)
+    {
+        m.set_response_code(dns_message::no_error_e);
+        m.add_answers(get_answer_records());
+    }
+    else
+    {
+        m.set_response_code(m_type == nxdomain_e ? dns_message::name_error_e : dns_message::no_error_e);
+
+        auto soa = get_soa_record();
+        if (soa)
+        {
+            m.add_nameserver(soa);
+        }
+
+        m.add_answers(get_answer_records(dns_rr::T_CNAME_e));
+        m.add_answers(get_answer_records(dns_rr::T_DNAME_e));
+    }
+
+    buffer raw;
+
+    try
+    {
+        dns_message_parser p;
+        raw = p.to_wire(m, true, MAX_EXTENDED_MESSAGE_SIZE);
+    }
+    catch (adns::exception &e)
     {
-        rr->set_ttl(ttl);
+        // too big or otherwise unencodable, the response will be built the slow way
+        return;
     }
 
-    m_min_ttl = chrono::duration<double>(ttl);
+    const octet *w = raw.get_data();
+    size_t size = raw.get_size();
+    size_t offset = 12;
+    bool pointer;
+
+    if ((size < 12) || !skip_name(w, size, offset, pointer) || (offset + 4 > size))
+    {
+        return;
+    }
+
+    offset += 4;
+
+    size_t question_end = offset;
+    uint count = ((w[6] << 8) | w[7]) + ((w[8] << 8) | w[9]) + ((w[10] << 8) | w[11]);
+    vector<size_t> ttl_offsets;
+
+    // find the TTL in every record so it can be patched at send time
+    for (uint i = 0; i < count; i++)
+    {
+        if (!skip_name(w, size, offset, pointer) || (offset + 10 > size))
+        {
+            return;
+        }
+
+        ttl_offsets.push_back(offset + 4);
+        offset += 10 + ((w[offset + 8] << 8) | w[offset + 9]);
+
+        if (offset > size)
+        {
+            return;
+        }
+    }
+
+    m_wire.assign(w, w + size);
+    m_ttl_offsets = move(ttl_offsets);
+    m_question_end = question_end;
+    m_encoded_question = q;
 }
 
-const dns_name &dns_recursive_cache_answer::get_referral_name() const
+bool dns_recursive_cache_answer::is_encoded() const
 {
-    return m_referral_name;
+    return !m_wire.empty();
 }
 
-size_t dns_recursive_cache_answer::get_sequence() const
+bool dns_recursive_cache_answer::is_encoded_for(const dns_question &q) const
 {
-    return m_sequence;
+    return !m_wire.empty() && (m_encoded_question == q);
 }
 
-uint dns_recursive_cache_answer::get_num_records() const
+buffer dns_recursive_cache_answer::to_wire(
+                    const dns_message &request, 
+                    const buffer      &raw_request, 
+                    bool              recursion_available, 
+                    unsigned short    edns_size,
+                    size_t            max_size) const
 {
-    return m_num_records;
+    if (m_wire.empty())
+    {
+        THROW(dns_recursive_cache_answer_exception, "attempt to send an answer that hasn't been encoded");
+    }
+
+    bool truncated;
+    buffer res = patch_response(m_wire, m_question_end, request, raw_request, recursion_available, edns_size, max_size, truncated);
+
+    if (!truncated)
+    {
+        octet *raw = res.get_data();
+        uint age = get_age();
+
+        for (auto o : m_ttl_offsets)
+        {
+            uint ttl = (raw[o] << 24) | (raw[o + 1] << 16) | (raw[o + 2] << 8) | raw[o + 3];
+
+            ttl = (ttl > age) ? (ttl - age) : 0;
+
+            raw[o] = (ttl >> 24) & 0xff;
+            raw[o + 1] = (ttl >> 16) & 0xff;
+            raw[o + 2] = (ttl >> 8) & 0xff;
+            raw[o + 3] = ttl & 0xff;
+        }
+    }
+
+    return res;
 }
 
 void dns_recursive_cache_answer::dump() const
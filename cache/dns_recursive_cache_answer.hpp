@@ -24,8 +24,11 @@
 #include <mutex>
 #include <atomic>
 #include <set>
+#include <vector>
 
 #include "dns_rr.hpp"
+#include "dns_question.hpp"
+#include "dns_encoded_answer.hpp"
 #include "types.hpp"
 #include "exception.hpp"
 
@@ -33,7 +36,13 @@ EXCEPTION_CLASS(dns_recursive_cache_answer_exception, exception)
 
 namespace adns
 {
-    class dns_recursive_cache_answer final
+    /**
+     * A cached answer. Once it's in the cache it's never changed - the TTLs in the records are the
+     * ones it was created with and the time left is worked out from an absolute expiry time. Answers
+     * that can be sent straight back to a client also hold a pre-encoded copy of the response so that
+     * a cache hit is a copy and a few TTL patches rather than a full serialisation.
+     */
+    class dns_recursive_cache_answer final : public dns_encoded_answer
     {
     public:
 
@@ -97,26 +106,67 @@ namespace adns
         std::list<std::shared_ptr<dns_rr>> get_nameserver_NS_records() const;
 
         /**
-         * update the TTLs for all of the records in the answer based on the time now and
-         * when it was first cached.
+         * has the answer timed out? (i.e. TTLs <= 0), or, with a grace period, timed out more
+         * than that long ago
          */
-        void update_ttls() const;
+        bool expired(std::chrono::milliseconds grace = std::chrono::milliseconds(0)) const;
 
         /**
-         * set the TTL of all records to a given value. Only needed when setting root
-         * hints.
+         * get the minimum ttl of all the records in the answer as it stands now (i.e. the 
+         * number of seconds until it expires)
          */
-        void set_ttls(uint ttl) const;
+        uint get_min_ttl() const override;
 
         /**
-         * has the answer timed out? (i.e. TTLs <= 0)
+         * how many whole seconds since the answer was created - the amount to take off the
+         * TTLs of the records before sending them
          */
-        bool expired() const;
+        uint get_age() const;
 
         /**
-         * get the minimum ttl of all the records in the answer
+         * how long until the answer expires, plus any grace period (zero if it already has)
          */
-        uint get_min_ttl() const;
+        std::chrono::milliseconds time_to_expiry(std::chrono::milliseconds grace = std::chrono::milliseconds(0)) const;
+
+        /**
+         * is the answer into the last pct percent of its original TTL?
+         */
+        bool near_expiry(uint pct) const;
+
+        /**
+         * copy of the answer with copies of all its records, all with the given TTL and with the 
+         * clock restarted - for root hints and for serving stale answers without touching the 
+         * cached records
+         */
+        std::shared_ptr<dns_recursive_cache_answer> copy_with_ttl(uint ttl) const;
+
+        /**
+         * Build the wire format response for the answer to the given question. Only data, no data
+         * and NXDOMAIN answers are encoded, for anything else (or if the response won't fit in
+         * a message) this does nothing. Must be called before the answer is shared.
+         */
+        void encode(const dns_question &q);
+
+        /**
+         * has the answer been encoded for this question?
+         */
+        bool is_encoded_for(const dns_question &q) const;
+
+        /**
+         * has the answer been encoded for any question?
+         */
+        bool is_encoded() const;
+
+        /**
+         * write a response to the request from the pre-encoded answer with the TTLs reduced by 
+         * the age of the answer
+         */
+        buffer to_wire(
+                    const dns_message &request, 
+                    const buffer      &raw_request, 
+                    bool              recursion_available, 
+                    unsigned short    edns_size,
+                    size_t            max_size) const override;
 
         /**
          * get the type as a string - debug or log
@@ -139,10 +189,16 @@ namespace adns
         size_t get_sequence() const;
 
         /**     
-         * how many records in total in the answer? - used during garbage collection as a proxy for memory use
+         * how many records in total in the answer? - used for monitoring
          */
         uint get_num_records() const;
 
+        /**
+         * estimate of the memory used by the answer in bytes - used to keep the cache
+         * within its memory budget
+         */
+        size_t get_size() const;
+
         /**
          * dump - for debug
          */
@@ -154,6 +210,7 @@ namespace adns
 
         size_t             m_sequence;
         uint               m_num_records;
+        mutable size_t     m_size;
         mutable std::mutex m_lock;
         type_t             m_type;
         dns_name           m_referral_name;
@@ -161,10 +218,19 @@ namespace adns
         // string representation of existing answer RRs (no TTL)
         std::set<std::string> m_answer_rr_strings;
 
-        mutable std::chrono::time_point<std::chrono::steady_clock> m_create_time;
+        std::chrono::time_point<std::chrono::steady_clock> m_create_time;
+
+        // minimum TTL value for all of the records in the answer when it was created
+        std::chrono::duration<double> m_min_ttl;
+
+        // when the answer times out - m_create_time + m_min_ttl
+        std::chrono::time_point<std::chrono::steady_clock> m_expiry;
 
-        // current minimum TTL value for all of the records in the answer
-        mutable std::chrono::duration<double> m_min_ttl;
+        // pre-encoded response, empty if the answer hasn't been encoded
+        std::vector<octet>  m_wire;
+        std::vector<size_t> m_ttl_offsets;
+        size_t              m_question_end;
+        dns_question        m_encoded_question;
 
         // records for the answer
         std::list<std::shared_ptr<dns_rr>> m_answer_records;
@@ -174,6 +240,11 @@ namespace adns
         /**
          * go through a set of records updating the minimum TTL
          */
-        void update_min_ttl(bool &min_set, const std::list<std::shared_ptr<dns_rr>> &rrs) const;
+        void update_min_ttl(bool &min_set, const std::list<std::shared_ptr<dns_rr>> &rrs);
+
+        /**
+         * estimate of the memory used by a list of records
+         */
+        static size_t get_size(const std::list<std::shared_ptr<dns_rr>> &rrs);
     };
 }
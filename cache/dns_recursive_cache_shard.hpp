@@ -0,0 +1,656 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <shared_mutex>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <deque>
+#include <mutex>
+
+#include "types.hpp"
+#include "monitor.hpp"
+#include "dns_recursive_cache_answer.hpp"
+
+namespace adns
+{
+    /**
+     * One shard of the recursive cache. The cache splits answers and referrals over a
+     * power-of-two number of these, chosen by key hash, so that lookups from different
+     * threads mostly take different locks.
+     *
+     * Each shard keeps itself within a memory budget using S3-FIFO eviction. New entries
+     * go into a small FIFO queue and only move to the main queue if they're looked up
+     * again before they reach the front. Entries in the main queue get another trip round
+     * for each (recent) lookup. Keys evicted from the small queue are remembered for a
+     * while in a ghost queue so that if they come back they go straight into the main one.
+     * A scan of one-off lookups only ever churns the small queue.
+     *
+     * Expired entries can be kept on for a while after they expire so that they can be
+     * served stale (RFC 8767) if the upstream nameservers stop responding.
+     */
+    template <typename K> class dns_recursive_cache_shard final
+    {
+    public:
+
+        typedef std::shared_ptr<const dns_recursive_cache_answer> answer_t;
+
+        // number of different answer types - for the per-type counters
+        static const uint num_types = dns_recursive_cache_answer::referral_e + 1;
+
+        /**
+         * new, empty shard with a memory budget in bytes. Entries looked up at least prefetch_min_hits 
+         * times (0 for never) are flagged for prefetch once into the last prefetch_ttl_pct percent 
+         * of their TTL. Expired entries are kept for stale_window.
+         */
+        dns_recursive_cache_shard(
+                size_t                    max_bytes, 
+                uint                      prefetch_min_hits = 0, 
+                uint                      prefetch_ttl_pct = 0, 
+                std::chrono::milliseconds stale_window = std::chrono::milliseconds(0)) : 
+            m_max_bytes(max_bytes),
+            m_prefetch_min_hits(prefetch_min_hits),
+            m_prefetch_ttl_pct(prefetch_ttl_pct),
+            m_stale_window(stale_window),
+            m_next_stamp(1),
+            m_small_bytes(0),
+            m_main_bytes(0),
+            m_num_main(0),
+            m_num_rrs(0),
+            m_num_misses(0),
+            m_num_contended(0),
+            m_monitor_rrs_id(0),
+            m_monitor_bytes_id(0),
+            m_monitor_contended_id(0)
+        {
+            for (uint i = 0; i < num_types; i++)
+            {
+                m_num_hits[i] = 0;
+                m_num_evictions[i] = 0;
+                m_num_expirations[i] = 0;
+            }
+        }
+
+        /**
+         * add the per-shard occupancy and contention monitors
+         */
+        void add_monitors(const std::string &instance)
+        {
+            m_monitor_rrs_id = monitor::add_thing("recursive cache shard", instance, "number of cached records", 0);
+            m_monitor_bytes_id = monitor::add_thing("recursive cache shard", instance, "cached bytes", 0);
+            m_monitor_contended_id = monitor::add_thing("recursive cache shard", instance, "contended lock acquisitions", 0);
+        }
+
+        /**
+         * publish the current occupancy and contention figures
+         */
+        void update_monitors() const
+        {
+            monitor::set_value(m_monitor_rrs_id, m_num_rrs);
+            monitor::set_value(m_monitor_bytes_id, uint(get_num_bytes()));
+            monitor::set_value(m_monitor_contended_id, uint(m_num_contended));
+        }
+
+        /**
+         * find an unexpired entry and count a hit - nullptr if there isn't one. If prefetch is 
+         * given, it's set to true the first time a popular entry gets close to expiring.
+         */
+        answer_t find(const K &k, bool *prefetch = nullptr) const
+        {
+            std::shared_lock<counting_mutex> guard(m_lock);
+
+            auto i = m_entries.find(k);
+
+            if ((i == m_entries.end()) || i->second.answer->expired())
+            {
+                return nullptr;
+            }
+
+            // racy but only ever a hint for eviction
+            if (i->second.freq < 3)
+            {
+                i->second.freq++;
+            }
+
+            m_num_hits[i->second.answer->get_type()]++;
+
+            if (prefetch && 
+                m_prefetch_min_hits > 0 && 
+                ++i->second.hits >= m_prefetch_min_hits && 
+                !i->second.prefetching &&
+                i->second.answer->near_expiry(m_prefetch_ttl_pct))
+            {
+                *prefetch = !i->second.prefetching.exchange(true);
+            }
+
+            return i->second.answer;
+        }
+
+        /**
+         * find an entry that's unexpired or expired but still within the stale window, nullptr 
+         * if there isn't one
+         */
+        answer_t find_stale(const K &k) const
+        {
+            std::shared_lock<counting_mutex> guard(m_lock);
+
+            auto i = m_entries.find(k);
+
+            if ((i == m_entries.end()) || i->second.answer->expired(m_stale_window))
+            {
+                return nullptr;
+            }
+
+            return i->second.answer;
+        }
+
+        /**
+         * count a lookup that the cache couldn't answer
+         */
+        void miss() const
+        {
+            m_num_misses++;
+        }
+
+        /**
+         * add or replace an entry, evicting others if that takes the shard over budget.
+         * Entries that aren't evictable are never evicted or garbage collected and don't 
+         * count towards the budget.
+         */
+        void add(const K &k, const answer_t &a, bool evictable = true)
+        {
+            std::unique_lock<counting_mutex> guard(m_lock);
+
+            auto i = m_entries.find(k);
+
+            if (i != m_entries.end())
+            {
+                // keep the existing place in the queues and the lookup history
+                forget(i->second);
+                i->second.answer = a;
+                i->second.size = a->get_size();
+                i->second.hits = 0;
+                i->second.prefetching = false;
+                remember(i->second);
+            }
+            else
+            {
+                auto &e = m_entries[k];
+
+                e.answer = a;
+                e.size = a->get_size();
+                e.stamp = m_next_stamp++;
+                e.freq = 0;
+                e.hits = 0;
+                e.prefetching = false;
+
+                if (!evictable)
+                {
+                    e.queue = none_e;
+                }
+                else if (m_ghost.find(std::hash<K>()(k)) != m_ghost.end())
+                {
+                    // seen recently enough that it deserves a place in the main queue
+                    e.queue = main_e;
+                    m_main.push_back(queued_t(k, e.stamp));
+                    m_num_main++;
+                }
+                else
+                {
+                    e.queue = small_e;
+                    m_small.push_back(queued_t(k, e.stamp));
+                }
+
+                remember(e);
+            }
+
+            evict();
+        }
+
+        /**
+         * drop an entry if it's still the one with the given sequence number and has expired. 
+         * Returns the entry if it's still there but not yet expired so the caller can try again 
+         * later, nullptr otherwise.
+         */
+        answer_t expire(const K &k, size_t sequence)
+        {
+            std::unique_lock<counting_mutex> guard(m_lock);
+
+            auto i = m_entries.find(k);
+
+            // may have been replaced, or had its TTLs changed, since the timer was set
+            if ((i != m_entries.end()) && (i->second.answer->get_sequence() == sequence))
+            {
+                if (i->second.answer->expired(m_stale_window))
+                {
+                    // the queue entry is skipped when it reaches the front
+                    erase(i, m_num_expirations);
+                }
+                else
+                {
+                    return i->second.answer;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * get rid of anything expired and tidy up the queues
+         */
+        void garbage_collect()
+        {
+            std::unique_lock<counting_mutex> guard(m_lock);
+
+            auto i = m_entries.begin();
+
+            while (i != m_entries.end())
+            {
+                if ((i->second.queue != none_e) && i->second.answer->expired(m_stale_window))
+                {
+                    erase(i++, m_num_expirations);
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            compact(m_small);
+            compact(m_main);
+        }
+
+        /**
+         * empty the shard
+         */
+        void clear()
+        {
+            std::unique_lock<counting_mutex> guard(m_lock);
+
+            m_entries.clear();
+            m_small.clear();
+            m_main.clear();
+            m_small_bytes = 0;
+            m_main_bytes = 0;
+            m_num_main = 0;
+            m_num_rrs = 0;
+        }
+
+        /**
+         * call f for every entry - for monitoring, debug and snapshots
+         */
+        void for_each(const std::function<void(const K &, const answer_t &)> &f) const
+        {
+            std::shared_lock<counting_mutex> guard(m_lock);
+
+            for (auto &e : m_entries)
+            {
+                f(e.first, e.second.answer);
+            }
+        }
+
+        /**
+         * how long expired entries are kept for
+         */
+        std::chrono::milliseconds get_stale_window() const
+        {
+            return m_stale_window;
+        }
+
+        /**
+         * number of evictable records in the shard
+         */
+        uint get_num_rrs() const
+        {
+            return m_num_rrs;
+        }
+
+        /**
+         * estimated memory used by evictable entries in the shard
+         */
+        size_t get_num_bytes() const
+        {
+            return m_small_bytes + m_main_bytes;
+        }
+
+        // counters, totalled across shards for monitoring
+        uint64_t get_num_hits(uint type) const { return m_num_hits[type]; }
+        uint64_t get_num_evictions(uint type) const { return m_num_evictions[type]; }
+        uint64_t get_num_expirations(uint type) const { return m_num_expirations[type]; }
+        uint64_t get_num_misses() const { return m_num_misses; }
+
+    private:
+
+        /**
+         * shared mutex that counts how often a caller couldn't get it straight away
+         */
+        class counting_mutex final
+        {
+        public:
+
+            counting_mutex(std::atomic<uint64_t> &num_contended) : m_num_contended(num_contended)
+            {
+            }
+
+            void lock()
+            {
+                if (!m_lock.try_lock())
+                {
+                    m_num_contended++;
+                    m_lock.lock();
+                }
+            }
+
+            void unlock()
+            {
+                m_lock.unlock();
+            }
+
+            void lock_shared()
+            {
+                if (!m_lock.try_lock_shared())
+                {
+                    m_num_contended++;
+                    m_lock.lock_shared();
+                }
+            }
+
+            void unlock_shared()
+            {
+                m_lock.unlock_shared();
+            }
+
+        private:
+
+            std::shared_mutex m_lock;
+            std::atomic<uint64_t> &m_num_contended;
+        };
+
+        typedef enum
+        {
+            none_e,     // not evictable
+            small_e,    // in the small queue
+            main_e      // in the main queue
+        }
+        queue_t;
+
+        class entry final
+        {
+        public:
+
+            answer_t answer;
+
+            // estimated size in bytes
+            size_t size;
+
+            // tells the queue entry for this entry apart from any left over from a previous one 
+            // with the same key
+            uint64_t stamp;
+
+            queue_t queue;
+
+            // lookups since the entry was queued (or last went round the main queue), max 3
+            mutable std::atomic<uint8_t> freq;
+
+            // lookups since the entry was added, only counted once prefetch is on
+            mutable std::atomic<uint> hits;
+
+            // set once the entry has been flagged for prefetch
+            mutable std::atomic<bool> prefetching;
+        };
+
+        // queue entry - key and stamp of the entry it was queued for
+        typedef std::pair<K, uint64_t> queued_t;
+
+        // entries in this shard
+        std::unordered_map<K, entry> m_entries;
+
+        // the S3-FIFO queues, oldest at the front
+        std::deque<queued_t> m_small;
+        std::deque<queued_t> m_main;
+
+        // hashes of keys recently evicted from the small queue, in the order they were evicted
+        std::unordered_set<size_t> m_ghost;
+        std::deque<size_t> m_ghost_fifo;
+
+        // memory budget for the shard
+        size_t m_max_bytes;
+
+        // prefetch and serve-stale settings
+        uint                      m_prefetch_min_hits;
+        uint                      m_prefetch_ttl_pct;
+        std::chrono::milliseconds m_stale_window;
+
+        uint64_t m_next_stamp;
+
+        size_t m_small_bytes;
+        size_t m_main_bytes;
+
+        // number of entries in the main queue, also the size of the ghost queue
+        size_t m_num_main;
+
+        // number of evictable records
+        std::atomic<uint> m_num_rrs;
+
+        // counters by answer type
+        mutable std::atomic<uint64_t> m_num_hits[num_types];
+        std::atomic<uint64_t> m_num_evictions[num_types];
+        std::atomic<uint64_t> m_num_expirations[num_types];
+
+        mutable std::atomic<uint64_t> m_num_misses;
+
+        // number of lock acquisitions that had to wait
+        mutable std::atomic<uint64_t> m_num_contended;
+
+        // lock for everything above
+        mutable counting_mutex m_lock { m_num_contended };
+
+        // monitor IDs
+        uint m_monitor_rrs_id;
+        uint m_monitor_bytes_id;
+        uint m_monitor_contended_id;
+
+        /**
+         * add an entry's size to the totals for its queue
+         */
+        void remember(const entry &e)
+        {
+            if (e.queue == small_e)
+            {
+                m_small_bytes += e.size;
+            }
+            else if (e.queue == main_e)
+            {
+                m_main_bytes += e.size;
+            }
+
+            if (e.queue != none_e)
+            {
+                m_num_rrs += e.answer->get_num_records();
+            }
+        }
+
+        /**
+         * take an entry's size off the totals for its queue
+         */
+        void forget(const entry &e)
+        {
+            if (e.queue == small_e)
+            {
+                m_small_bytes -= e.size;
+            }
+            else if (e.queue == main_e)
+            {
+                m_main_bytes -= e.size;
+            }
+
+            if (e.queue != none_e)
+            {
+                m_num_rrs -= e.answer->get_num_records();
+            }
+        }
+
+        /**
+         * remove an entry, counting it against its answer type
+         */
+        void erase(typename std::unordered_map<K, entry>::iterator i, std::atomic<uint64_t> *counters)
+        {
+            forget(i->second);
+
+            if (i->second.queue == main_e)
+            {
+                m_num_main--;
+            }
+
+            counters[i->second.answer->get_type()]++;
+
+            m_entries.erase(i);
+        }
+
+        /**
+         * the entry a queue entry refers to, or end() if it's left over from one that's gone
+         */
+        typename std::unordered_map<K, entry>::iterator lookup(const queued_t &q)
+        {
+            auto i = m_entries.find(q.first);
+
+            if ((i != m_entries.end()) && (i->second.stamp != q.second))
+            {
+                return m_entries.end();
+            }
+
+            return i;
+        }
+
+        /**
+         * evict until the shard is back within budget
+         */
+        void evict()
+        {
+            while ((get_num_bytes() > m_max_bytes) && (!m_small.empty() || !m_main.empty()))
+            {
+                // the small queue gets 10% of the budget
+                if (!m_small.empty() && ((m_small_bytes > m_max_bytes / 10) || m_main.empty()))
+                {
+                    evict_small();
+                }
+                else
+                {
+                    evict_main();
+                }
+            }
+        }
+
+        /**
+         * take the oldest entry in the small queue and either promote it to the main queue or 
+         * evict it
+         */
+        void evict_small()
+        {
+            auto q = m_small.front();
+            m_small.pop_front();
+
+            auto i = lookup(q);
+
+            if (i == m_entries.end())
+            {
+                return;
+            }
+
+            if (i->second.freq > 0)
+            {
+                forget(i->second);
+                i->second.queue = main_e;
+                i->second.freq = 0;
+                remember(i->second);
+
+                m_main.push_back(q);
+                m_num_main++;
+            }
+            else
+            {
+                auto h = std::hash<K>()(q.first);
+
+                if (m_ghost.insert(h).second)
+                {
+                    m_ghost_fifo.push_back(h);
+                }
+
+                while (m_ghost_fifo.size() > std::max(m_num_main, size_t(16)))
+                {
+                    m_ghost.erase(m_ghost_fifo.front());
+                    m_ghost_fifo.pop_front();
+                }
+
+                erase(i, m_num_evictions);
+            }
+        }
+
+        /**
+         * take the oldest entry in the main queue and either give it another go round (if it's
+         * been looked up) or evict it
+         */
+        void evict_main()
+        {
+            auto q = m_main.front();
+            m_main.pop_front();
+
+            auto i = lookup(q);
+
+            if (i == m_entries.end())
+            {
+                return;
+            }
+
+            if (i->second.freq > 0)
+            {
+                i->second.freq--;
+                m_main.push_back(q);
+            }
+            else
+            {
+                erase(i, m_num_evictions);
+            }
+        }
+
+        /**
+         * drop queue entries left over from entries that have gone
+         */
+        void compact(std::deque<queued_t> &queue)
+        {
+            std::deque<queued_t> res;
+
+            for (auto &q : queue)
+            {
+                if (lookup(q) != m_entries.end())
+                {
+                    res.push_back(q);
+                }
+            }
+
+            queue.swap(res);
+        }
+    };
+}
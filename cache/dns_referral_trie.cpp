@@ -0,0 +1,144 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <mutex>
+
+#include "dns_referral_trie.hpp"
+
+using namespace std;
+using namespace adns;
+
+dns_referral_trie::dns_referral_trie()
+{
+}
+
+dns_referral_trie::~dns_referral_trie()
+{
+}
+
+void dns_referral_trie::add(const answer_t &a)
+{
+    auto &labels = a->get_referral_name().get_labels();
+
+    unique_lock<shared_mutex> guard(m_lock);
+
+    node_t *n = &m_root;
+
+    for (auto l = labels.rbegin(); l != labels.rend(); l++)
+    {
+        auto &c = n->m_children[**l];
+
+        if (!c)
+        {
+            c = make_unique<node_t>();
+        }
+
+        n = c.get();
+    }
+
+    n->m_answer = a;
+}
+
+dns_referral_trie::answer_t dns_referral_trie::find(const dns_name &name) const
+{
+    auto &labels = name.get_labels();
+
+    shared_lock<shared_mutex> guard(m_lock);
+
+    const node_t *n = &m_root;
+    answer_t res = m_root.m_answer.lock();
+
+    if (res && res->expired())
+    {
+        res = nullptr;
+    }
+
+    for (auto l = labels.rbegin(); l != labels.rend(); l++)
+    {
+        auto c = n->m_children.find(**l);
+
+        if (c == n->m_children.end())
+        {
+            break;
+        }
+
+        n = c->second.get();
+
+        auto a = n->m_answer.lock();
+
+        if (a && !a->expired())
+        {
+            res = a;
+        }
+    }
+
+    return res;
+}
+
+void dns_referral_trie::prune()
+{
+    unique_lock<shared_mutex> guard(m_lock);
+    prune(m_root);
+}
+
+bool dns_referral_trie::prune(node_t &n)
+{
+    for (auto c = n.m_children.begin(); c != n.m_children.end(); )
+    {
+        if (prune(*c->second))
+        {
+            c = n.m_children.erase(c);
+        }
+        else
+        {
+            c++;
+        }
+    }
+
+    return n.m_children.empty() && n.m_answer.expired();
+}
+
+void dns_referral_trie::clear()
+{
+    unique_lock<shared_mutex> guard(m_lock);
+
+    m_root.m_children.clear();
+    m_root.m_answer.reset();
+}
+
+void dns_referral_trie::for_each(const function<void(const answer_t &)> &f) const
+{
+    shared_lock<shared_mutex> guard(m_lock);
+    for_each(m_root, f);
+}
+
+void dns_referral_trie::for_each(const node_t &n, const function<void(const answer_t &)> &f)
+{
+    auto a = n.m_answer.lock();
+
+    if (a)
+    {
+        f(a);
+    }
+
+    for (auto &c : n.m_children)
+    {
+        for_each(*c.second, f);
+    }
+}
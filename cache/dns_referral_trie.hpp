@@ -0,0 +1,101 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <map>
+#include <memory>
+#include <functional>
+#include <shared_mutex>
+
+#include "types.hpp"
+#include "dns_name.hpp"
+#include "dns_label.hpp"
+#include "dns_recursive_cache_answer.hpp"
+
+namespace adns
+{
+    /**
+     * Index of cached delegations held in a trie of labels, TLD first, so that the deepest 
+     * delegation covering a name is found in a single walk down from the root without 
+     * building any intermediate names. The referral shards still own the answers (and 
+     * decide when they're evicted), the trie only holds weak references to them. Nodes for 
+     * delegations that have gone are removed by prune().
+     */
+    class dns_referral_trie final
+    {
+    public:
+
+        typedef std::shared_ptr<const dns_recursive_cache_answer> answer_t;
+
+        /**
+         * empty trie
+         */
+        dns_referral_trie();
+
+        /**
+         * destructor
+         */
+        virtual ~dns_referral_trie();
+
+        /**
+         * add or replace the delegation for the name the answer refers to
+         */
+        void add(const answer_t &a);
+
+        /**
+         * the deepest unexpired delegation at or above a name, nullptr if there isn't one
+         */
+        answer_t find(const dns_name &n) const;
+
+        /**
+         * remove nodes for delegations that are no longer cached
+         */
+        void prune();
+
+        /**
+         * empty the trie
+         */
+        void clear();
+
+        /**
+         * call f for every delegation still cached - for monitoring
+         */
+        void for_each(const std::function<void(const answer_t &)> &f) const;
+
+    private:
+
+        struct node_t
+        {
+            std::map<dns_label, std::unique_ptr<node_t>> m_children;
+            std::weak_ptr<const dns_recursive_cache_answer> m_answer;
+        };
+
+        node_t m_root;
+
+        mutable std::shared_mutex m_lock;
+
+        /**
+         * prune below a node, true if the node itself can go
+         */
+        static bool prune(node_t &n);
+
+        static void for_each(const node_t &n, const std::function<void(const answer_t &)> &f);
+    };
+}
@@ -0,0 +1,467 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "monitor.hpp"
+#include "datetime.hpp"
+#include "run_state.hpp"
+#include "timer_service.hpp"
+#include "dns_rr_NS.hpp"
+#include "dns_rr_A.hpp"
+#include "dns_rr_AAAA.hpp"
+#include "dns_rr_SOA.hpp"
+#include "dns_root_mirror.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+namespace
+{
+    /**
+     * one resource record as read from the master file
+     */
+    struct record_t
+    {
+        string         owner;
+        uint           ttl;
+        string         type;
+        vector<string> rdata;
+    };
+
+    bool is_number(const string &s)
+    {
+        return !s.empty() && all_of(s.begin(), s.end(), [](char c) { return isdigit(c); });
+    }
+
+    /**
+     * Split a master file into records. Handles comments, parentheses, $TTL and owners
+     * carried forward from the previous record. Only the root may be used as $ORIGIN.
+     */
+    list<record_t> read_records(const string &file)
+    {
+        ifstream in(file);
+
+        if (!in)
+        {
+            THROW(dns_root_mirror_exception, "unable to open root zone file", file);
+        }
+
+        list<record_t> records;
+        vector<string> tokens;
+
+        string line;
+        string owner;
+        uint   default_ttl = 0;
+        bool   blank_owner = false;
+        int    depth = 0;
+        uint   line_number = 0;
+
+        while (getline(in, line))
+        {
+            line_number++;
+
+            if (depth == 0)
+            {
+                tokens.clear();
+                blank_owner = !line.empty() && isspace(line[0]);
+            }
+
+            string token;
+            bool   quoted = false;
+
+            for (char c : line)
+            {
+                if (quoted)
+                {
+                    token += c;
+                    quoted = (c != '"');
+                }
+                else if (c == '"')
+                {
+                    token += c;
+                    quoted = true;
+                }
+                else if (c == ';')
+                {
+                    break;
+                }
+                else if (c == '(' || c == ')' || isspace(c))
+                {
+                    if (!token.empty())
+                    {
+                        tokens.push_back(token);
+                        token.clear();
+                    }
+
+                    depth += (c == '(') ? 1 : (c == ')') ? -1 : 0;
+                }
+                else
+                {
+                    token += c;
+                }
+            }
+
+            if (!token.empty())
+            {
+                tokens.push_back(token);
+            }
+
+            if (depth < 0)
+            {
+                THROW(dns_root_mirror_exception, "unbalanced parentheses in root zone file", file + ":" + to_string(line_number));
+            }
+
+            if (depth > 0 || tokens.empty())
+            {
+                continue;
+            }
+
+            if (tokens[0] == "$TTL" && tokens.size() == 2 && is_number(tokens[1]))
+            {
+                default_ttl = stoul(tokens[1]);
+                continue;
+            }
+
+            if (tokens[0] == "$ORIGIN" && tokens.size() == 2 && tokens[1] == ".")
+            {
+                continue;
+            }
+
+            if (tokens[0][0] == '$')
+            {
+                THROW(dns_root_mirror_exception, "unsupported directive in root zone file", file + ":" + to_string(line_number));
+            }
+
+            size_t i = 0;
+
+            if (!blank_owner)
+            {
+                owner = tokens[i++];
+            }
+
+            if (owner.empty())
+            {
+                THROW(dns_root_mirror_exception, "record without an owner in root zone file", file + ":" + to_string(line_number));
+            }
+
+            record_t r;
+
+            r.owner = owner;
+            r.ttl = default_ttl;
+
+            // TTL and class are both optional and may come in either order
+            for (int n = 0; n < 2 && i < tokens.size(); n++)
+            {
+                if (is_number(tokens[i]))
+                {
+                    r.ttl = stoul(tokens[i++]);
+                }
+                else if (boost::iequals(tokens[i], "IN"))
+                {
+                    i++;
+                }
+            }
+
+            if (i >= tokens.size())
+            {
+                THROW(dns_root_mirror_exception, "record without a type in root zone file", file + ":" + to_string(line_number));
+            }
+
+            r.type = boost::to_upper_copy(tokens[i++]);
+            r.rdata.assign(tokens.begin() + i, tokens.end());
+
+            records.push_back(r);
+        }
+
+        if (depth != 0)
+        {
+            THROW(dns_root_mirror_exception, "unbalanced parentheses in root zone file", file);
+        }
+
+        return records;
+    }
+
+    template <class T> shared_ptr<T> make_record(const record_t &r)
+    {
+        auto rr = make_shared<T>();
+
+        rr->set_name(make_shared<dns_name>(r.owner));
+        rr->set_ttl(r.ttl);
+        rr->set_class(dns_rr::C_IN_e);
+
+        return rr;
+    }
+
+    void check_rdata(const record_t &r, size_t n)
+    {
+        if (r.rdata.size() != n)
+        {
+            THROW(dns_root_mirror_exception, "wrong number of fields in root zone record", r.owner + " " + r.type);
+        }
+    }
+}
+
+dns_root_mirror::dns_root_mirror(const string &file, uint refresh_s) :
+                        m_file(file),
+                        m_refresh_s(refresh_s),
+                        m_num_referrals(0),
+                        m_num_nxdomains(0)
+{
+    m_monitor_serial_id = monitor::add_thing("root mirror", "singleton", "zone serial", 0);
+    m_monitor_records_id = monitor::add_thing("root mirror", "singleton", "records loaded", 0);
+    m_monitor_tlds_id = monitor::add_thing("root mirror", "singleton", "number of TLDs", 0);
+    m_monitor_referrals_id = monitor::add_thing("root mirror", "singleton", "local referrals", 0);
+    m_monitor_nxdomains_id = monitor::add_thing("root mirror", "singleton", "local nxdomains", 0);
+    m_monitor_load_time_id = monitor::add_thing("root mirror", "singleton", "time of last load", "<none yet>");
+
+    monitor::add_thing("root mirror", "singleton", "zone file", file);
+    monitor::add_thing("root mirror", "singleton", "refresh interval (seconds)", refresh_s);
+}
+
+dns_root_mirror::~dns_root_mirror()
+{
+}
+
+void dns_root_mirror::start()
+{
+    load();
+    schedule_refresh();
+}
+
+void dns_root_mirror::schedule_refresh()
+{
+    if (m_refresh_s == 0)
+    {
+        return;
+    }
+
+    timer_service::get_instance()->add(seconds(m_refresh_s), [this]()
+    {
+        if (run_state::o_state == run_state::shutdown_e)
+        {
+            return;
+        }
+
+        // always reread even if the serial hasn't changed so that the TTLs handed out restart 
+        load();
+        schedule_refresh();
+    });
+}
+
+void dns_root_mirror::load()
+{
+    try
+    {
+        auto zone = read_zone(m_file);
+
+        {
+            lock_guard<mutex> guard(m_lock);
+            m_zone = zone;
+        }
+
+        monitor::set_value(m_monitor_serial_id, zone->m_serial);
+        monitor::set_value(m_monitor_records_id, zone->m_num_records);
+        monitor::set_value(m_monitor_tlds_id, uint(zone->m_tlds.size()));
+        monitor::set_value(m_monitor_load_time_id, datetime::now().to_string());
+
+        LOG(info) << "loaded root zone serial " << zone->m_serial << " with " << zone->m_tlds.size() << " TLDs from " << m_file;
+    }
+    catch (adns::exception &e)
+    {
+        e.log(warning, "failed to load root zone, keeping the previous copy (if any)");
+    }
+    catch (std::exception &e)
+    {
+        // bad numbers in the file end up here
+        LOG(warning) << "failed to load root zone from " << m_file << ": " << e.what();
+    }
+}
+
+dns_root_mirror::answer_t dns_root_mirror::lookup(const dns_question &q) const
+{
+    shared_ptr<const zone_t> zone;
+
+    {
+        lock_guard<mutex> guard(m_lock);
+        zone = m_zone;
+    }
+
+    if (!zone)
+    {
+        return nullptr;
+    }
+
+    auto &labels = q.get_qname().get_labels();
+
+    for (auto l = labels.rbegin(); l != labels.rend(); l++)
+    {
+        if ((*l)->get_length() == 0)
+        {
+            continue;
+        }
+
+        auto i = zone->m_tlds.find(**l);
+
+        if (i != zone->m_tlds.end())
+        {
+            m_num_referrals++;
+            return i->second;
+        }
+
+        m_num_nxdomains++;
+        return zone->m_nxdomain;
+    }
+
+    // the root itself is left to the root servers
+    return nullptr;
+}
+
+void dns_root_mirror::update_monitors() const
+{
+    monitor::set_value(m_monitor_referrals_id, uint(m_num_referrals.load()));
+    monitor::set_value(m_monitor_nxdomains_id, uint(m_num_nxdomains.load()));
+}
+
+shared_ptr<dns_root_mirror::zone_t> dns_root_mirror::read_zone(const string &file)
+{
+    auto records = read_records(file);
+
+    shared_ptr<dns_rr_SOA> soa;
+    uint soa_ttl = 0;
+
+    map<dns_name, list<shared_ptr<dns_rr>>> delegations;
+    map<dns_name, list<shared_ptr<dns_rr>>> addresses;
+
+    auto zone = make_shared<zone_t>();
+
+    zone->m_num_records = 0;
+
+    for (auto &r : records)
+    {
+        if (r.type == "SOA")
+        {
+            check_rdata(r, 7);
+
+            if (!dns_name(r.owner).is_root())
+            {
+                THROW(dns_root_mirror_exception, "SOA record is not for the root", r.owner);
+            }
+
+            soa = make_record<dns_rr_SOA>(r);
+            soa->set_mname(make_shared<dns_name>(r.rdata[0]));
+            soa->set_rname(make_shared<dns_name>(r.rdata[1]));
+            soa->set_serial(stoul(r.rdata[2]));
+            soa->set_refresh(stoi(r.rdata[3]));
+            soa->set_retry(stoi(r.rdata[4]));
+            soa->set_expire(stoi(r.rdata[5]));
+            soa->set_minimum(stoul(r.rdata[6]));
+            soa_ttl = r.ttl;
+        }
+        else if (r.type == "NS")
+        {
+            check_rdata(r, 1);
+
+            dns_name owner(r.owner);
+
+            // the root's own servers come from the root hints, and anything deeper than 
+            // a TLD shouldn't be in a root zone
+            if (owner.size() != 1)
+            {
+                continue;
+            }
+
+            auto ns = make_record<dns_rr_NS>(r);
+            ns->set_nsdname(make_shared<dns_name>(r.rdata[0]));
+            delegations[owner].push_back(ns);
+        }
+        else if (r.type == "A")
+        {
+            check_rdata(r, 1);
+
+            auto a = make_record<dns_rr_A>(r);
+            a->set_ip4_addr(ip_address(r.rdata[0]));
+            addresses[dns_name(r.owner)].push_back(a);
+        }
+        else if (r.type == "AAAA")
+        {
+            check_rdata(r, 1);
+
+            auto aaaa = make_record<dns_rr_AAAA>(r);
+            aaaa->set_ip6_addr(ip_address(r.rdata[0]));
+            addresses[dns_name(r.owner)].push_back(aaaa);
+        }
+        else
+        {
+            continue;
+        }
+
+        zone->m_num_records++;
+    }
+
+    if (!soa)
+    {
+        THROW(dns_root_mirror_exception, "no SOA record in root zone file", file);
+    }
+
+    if (delegations.empty())
+    {
+        THROW(dns_root_mirror_exception, "no TLD delegations in root zone file", file);
+    }
+
+    zone->m_serial = soa->get_serial();
+
+    // RFC 2308 - the negative TTL is the lower of the SOA TTL and its minimum field
+    zone->m_nxdomain = make_shared<dns_recursive_cache_answer>(
+                                dns_recursive_cache_answer::nxdomain_e,
+                                min(soa_ttl, soa->get_minimum()));
+
+    for (auto &d : delegations)
+    {
+        list<shared_ptr<dns_rr>> glue;
+        uint ttl = d.second.front()->get_ttl();
+
+        for (auto &rr : d.second)
+        {
+            auto i = addresses.find(*(dynamic_pointer_cast<dns_rr_NS>(rr)->get_nsdname()));
+
+            if (i != addresses.end())
+            {
+                glue.insert(glue.end(), i->second.begin(), i->second.end());
+            }
+
+            ttl = min(ttl, rr->get_ttl());
+        }
+
+        zone->m_tlds[*(d.first.get_labels().front())] = make_shared<dns_recursive_cache_answer>(
+                                dns_recursive_cache_answer::referral_e,
+                                ttl,
+                                list<shared_ptr<dns_rr>>(),
+                                d.second,
+                                glue);
+    }
+
+    return zone;
+}
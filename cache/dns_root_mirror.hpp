@@ -0,0 +1,121 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "types.hpp"
+#include "exception.hpp"
+#include "dns_label.hpp"
+#include "dns_question.hpp"
+#include "dns_recursive_cache_answer.hpp"
+
+EXCEPTION_CLASS(dns_root_mirror_exception, exception)
+
+namespace adns
+{
+    /**
+     * A local copy of the root zone (RFC 8806) loaded from a master file and reloaded 
+     * periodically. Referrals to the TLDs and NXDOMAINs for names under TLDs that don't
+     * exist are answered from it instead of asking the root servers. Only the SOA, NS, 
+     * A and AAAA records are kept, everything else in the file is skipped.
+     */
+    class dns_root_mirror final
+    {
+    public:
+
+        typedef std::shared_ptr<const dns_recursive_cache_answer> answer_t;
+
+        /**
+         * mirror of the root zone in the given file, nothing is loaded until start()
+         */
+        dns_root_mirror(const std::string &file, uint refresh_s);
+
+        /**
+         * destructor
+         */
+        virtual ~dns_root_mirror();
+
+        /**
+         * load the zone and schedule reloads
+         */
+        void start();
+
+        /**
+         * A referral to the TLD a question falls under, or NXDOMAIN if there's no such TLD.
+         * nullptr if nothing's loaded or the question is for the root itself.
+         */
+        answer_t lookup(const dns_question &q) const;
+
+        /**
+         * publish the hit counters
+         */
+        void update_monitors() const;
+
+    private:
+
+        /**
+         * one version of the zone, replaced as a whole on reload
+         */
+        struct zone_t
+        {
+            // referral for each TLD, by TLD label
+            std::map<dns_label, answer_t> m_tlds;
+
+            // answer for names under TLDs that don't exist
+            answer_t m_nxdomain;
+
+            uint m_serial;
+            uint m_num_records;
+        };
+
+        std::string m_file;
+        uint        m_refresh_s;
+
+        mutable std::mutex            m_lock;
+        std::shared_ptr<const zone_t> m_zone;
+
+        mutable std::atomic<uint64_t> m_num_referrals;
+        mutable std::atomic<uint64_t> m_num_nxdomains;
+
+        uint m_monitor_serial_id;
+        uint m_monitor_records_id;
+        uint m_monitor_tlds_id;
+        uint m_monitor_referrals_id;
+        uint m_monitor_nxdomains_id;
+        uint m_monitor_load_time_id;
+
+        /**
+         * (re)load the file, the previous version is kept if it can't be read
+         */
+        void load();
+
+        void schedule_refresh();
+
+        /**
+         * parse a root zone master file
+         */
+        static std::shared_ptr<zone_t> read_zone(const std::string &file);
+    };
+}
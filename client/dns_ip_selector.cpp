@@ -17,46 +17,126 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
  
+#include <random>
+#include <tuple>
+#include <algorithm>
+
 #include "dns_ip_selector.hpp"
 
 using namespace std;
 using namespace chrono;
 using namespace adns;
 
-map<ip_address, time_point<steady_clock>> dns_ip_selector::o_last_contact;
-map<ip_address, time_point<steady_clock>> dns_ip_selector::o_dead_ips;
-mutex dns_ip_selector::o_last_contact_m;
+const uint dns_ip_selector::num_shards;
+const uint dns_ip_selector::unknown_srtt_ms;
+const uint dns_ip_selector::max_srtt_ms;
+const uint dns_ip_selector::max_dead_ms;
+const uint dns_ip_selector::explore_one_in;
+
+dns_ip_selector::shard_t dns_ip_selector::o_shards[dns_ip_selector::num_shards];
+
+static uint random_below(uint n)
+{
+    static thread_local mt19937 g(random_device{}());
+    return uniform_int_distribution<uint>(0, n - 1)(g);
+}
+
+dns_ip_selector::server_t::server_t() :
+    m_srtt8(0),
+    m_rttvar4(0),
+    m_measured(false),
+    m_sent(0),
+    m_responses(0),
+    m_timeouts(0),
+    m_consecutive_timeouts(0),
+    m_edns(edns_unknown_e)
+{
+}
+
+dns_ip_selector::shard_t &dns_ip_selector::get_shard(const ip_address &i)
+{
+    return o_shards[i.get_hash() & (num_shards - 1)];
+}
 
 void dns_ip_selector::update_last_contact(const ip_address &i)
 {
-    unique_lock<mutex> guard(o_last_contact_m);
-    o_last_contact[i] = steady_clock::now();
+    auto &sh = get_shard(i);
+    unique_lock<mutex> guard(sh.m_lock);
+
+    auto &s = sh.m_servers[i];
+    s.m_last_contact = steady_clock::now();
+    s.m_sent++;
+}
+
+void dns_ip_selector::record_rtt(const ip_address &i, uint rtt_ms)
+{
+    auto &sh = get_shard(i);
+    unique_lock<mutex> guard(sh.m_lock);
+
+    auto &s = sh.m_servers[i];
+    int r = static_cast<int>(min(rtt_ms, max_srtt_ms));
+
+    if (!s.m_measured)
+    {
+        s.m_srtt8 = r << 3;
+        s.m_rttvar4 = r << 1;
+        s.m_measured = true;
+    }
+    else
+    {
+        // RFC 6298 with alpha 1/8 and beta 1/4
+        int delta = r - static_cast<int>(s.m_srtt8 >> 3);
+        s.m_srtt8 = static_cast<uint>(static_cast<int>(s.m_srtt8) + delta);
+        s.m_rttvar4 = static_cast<uint>(static_cast<int>(s.m_rttvar4) + abs(delta) - static_cast<int>(s.m_rttvar4 >> 2));
+    }
+
+    s.m_responses++;
+    s.m_consecutive_timeouts = 0;
+    s.m_dead_until = steady_clock::time_point();
 }
 
 void dns_ip_selector::mark_dead(const ip_address &i)
 {
-    unique_lock<mutex> guard(o_last_contact_m);
-    o_dead_ips[i] = steady_clock::now();
+    auto &sh = get_shard(i);
+    unique_lock<mutex> guard(sh.m_lock);
+
+    auto &s = sh.m_servers[i];
+
+    // back off: double the SRTT and how long the server is left alone for
+    s.m_srtt8 = min<uint>(max<uint>(s.m_srtt8 << 1, unknown_srtt_ms << 3), max_srtt_ms << 3);
+    s.m_measured = true;
+    s.m_timeouts++;
+    s.m_consecutive_timeouts++;
+    s.m_dead_until = steady_clock::now() + milliseconds(min<uint>(1000 << min<uint>(s.m_consecutive_timeouts - 1, 6), max_dead_ms));
 }
 
-void dns_ip_selector::find_ips(const set<ip_address> &all_ips, vector<pair<time_point<steady_clock>, ip_address>> &ip_by_lc, bool include_dead)
+void dns_ip_selector::set_edns_support(const ip_address &i, bool supported)
 {
-    for (auto i : all_ips)
-    {
-        if (!include_dead && o_dead_ips.count(i) != 0)
-        {
-            continue;
-        }        
+    auto &sh = get_shard(i);
+    unique_lock<mutex> guard(sh.m_lock);
 
-        auto lc = o_last_contact.find(i);
-        if (lc == o_last_contact.end())
-        {
-            ip_by_lc.push_back(pair<time_point<steady_clock>, ip_address>(steady_clock::now(), i));
-        }
-        else
-        {
-            ip_by_lc.push_back(pair<time_point<steady_clock>, ip_address>(lc->second, i));
-        }
+    sh.m_servers[i].m_edns = supported ? edns_supported_e : edns_unsupported_e;
+}
+
+dns_ip_selector::edns_support_t dns_ip_selector::get_edns_support(const ip_address &i)
+{
+    auto &sh = get_shard(i);
+    unique_lock<mutex> guard(sh.m_lock);
+
+    auto s = sh.m_servers.find(i);
+
+    return (s == sh.m_servers.end()) ? edns_unknown_e : s->second.m_edns;
+}
+
+uint dns_ip_selector::ranking_srtt(const server_t &s)
+{
+    if (s.m_measured)
+    {
+        return s.m_srtt8 >> 3;
+    }
+    else
+    {
+        return 1 + random_below(unknown_srtt_ms);
     }
 }
 
@@ -68,31 +148,112 @@ void dns_ip_selector::select_ips(const set<ip_address> &all_ips, set<ip_address>
     }
     else
     {
-        vector<pair<time_point<steady_clock>, ip_address>> ip_by_lc;
+        vector<ip_address> v;
+        select_ips(all_ips, v, include_dead, num_to_select);
+        selected_ips = set<ip_address>(v.begin(), v.end());
+    }
+}
 
-        unique_lock<mutex> guard(o_last_contact_m);
+void dns_ip_selector::select_ips(const set<ip_address> &all_ips, vector<ip_address> &selected_ips, bool include_dead, uint num_to_select)
+{
+    // dead, SRTT, last contact (least recent first to spread the load between equals)
+    vector<tuple<bool, uint, steady_clock::time_point, ip_address>> ranked;
+    auto now = steady_clock::now();
+    size_t live = 0;
 
-        find_ips(all_ips, ip_by_lc, include_dead);
+    ranked.reserve(all_ips.size());
 
-        // if we can't find enough, include dead ones regardless
-        if (ip_by_lc.size() <= num_to_select)
+    for (auto &i : all_ips)
+    {
+        auto &sh = get_shard(i);
+        unique_lock<mutex> guard(sh.m_lock);
+
+        auto s = sh.m_servers.find(i);
+
+        if (s == sh.m_servers.end())
+        {
+            ranked.emplace_back(false, ranking_srtt(server_t()), steady_clock::time_point(), i);
+            live++;
+        }
+        else
         {
-            find_ips(all_ips, ip_by_lc, true);
+            bool dead = s->second.m_dead_until > now;
+            ranked.emplace_back(dead, ranking_srtt(s->second), s->second.m_last_contact, i);
+            live += dead ? 0 : 1;
         }
+    }
+
+    sort(ranked.begin(), ranked.end());
+
+    // if we can't find enough, include dead ones regardless
+    size_t candidates = (include_dead || live < num_to_select) ? ranked.size() : live;
+    size_t n = min<size_t>(num_to_select, candidates);
+
+    // now and again swap the last one picked for a random one of the rest so slower 
+    // servers get measured once in a while
+    if ((n > 0) && (n < candidates) && (random_below(explore_one_in) == 0))
+    {
+        swap(ranked[n - 1], ranked[n + random_below(candidates - n)]);
+    }
+
+    selected_ips.clear();
 
-        sort(ip_by_lc.begin(), ip_by_lc.end());
-        selected_ips.clear();
+    for (size_t i = 0; i < n; i++)
+    {
+        selected_ips.push_back(get<3>(ranked[i]));
+    }
+}
 
-        for (size_t i = 0; i < num_to_select; i++)
+dns_ip_selector::server_stats_t dns_ip_selector::make_stats(const ip_address &i, const server_t &s, steady_clock::time_point now)
+{
+    server_stats_t st;
+
+    st.address = i;
+    st.srtt_ms = s.m_srtt8 >> 3;
+    st.rttvar_ms = s.m_rttvar4 >> 2;
+    st.sent = s.m_sent;
+    st.responses = s.m_responses;
+    st.timeouts = s.m_timeouts;
+    st.consecutive_timeouts = s.m_consecutive_timeouts;
+    st.edns = s.m_edns;
+    st.dead = s.m_dead_until > now;
+    st.last_contact_ms = (s.m_sent == 0) ? 0 : static_cast<uint>(duration_cast<milliseconds>(now - s.m_last_contact).count());
+
+    return st;
+}
+
+bool dns_ip_selector::get_stats(const ip_address &i, server_stats_t &stats)
+{
+    auto &sh = get_shard(i);
+
+    unique_lock<mutex> guard(sh.m_lock);
+
+    auto s = sh.m_servers.find(i);
+
+    if (s == sh.m_servers.end() || !s->second.m_measured)
+    {
+        return false;
+    }
+
+    stats = make_stats(i, s->second, steady_clock::now());
+
+    return true;
+}
+
+vector<dns_ip_selector::server_stats_t> dns_ip_selector::get_stats()
+{
+    vector<server_stats_t> res;
+    auto now = steady_clock::now();
+
+    for (auto &sh : o_shards)
+    {
+        unique_lock<mutex> guard(sh.m_lock);
+
+        for (auto &s : sh.m_servers)
         {
-            if (i < ip_by_lc.size())
-            {
-                selected_ips.insert(ip_by_lc[i].second);
-            }
-            else
-            {
-                break;
-            }
+            res.push_back(make_stats(s.first, s.second, now));
         }
     }
+
+    return res;
 }
@@ -19,21 +19,53 @@
  
 #pragma once
 
-#include <thread>
 #include <mutex>
 #include <set>
-#include <map>
+#include <vector>
 #include <chrono>
+#include <unordered_map>
 
 #include "types.hpp"
 #include "ip_address.hpp"
 
 namespace adns
 {
+    /**
+     * Infrastructure cache for upstream nameservers. Keeps a smoothed round trip time
+     * (SRTT) and variance per server address along with timeout counts and whether the 
+     * server copes with EDNS, and uses them to prefer fast servers. Now and again a 
+     * slower server is picked instead so that its figures don't go stale. Entries are
+     * spread over a number of independently locked shards by address.
+     */
     class dns_ip_selector
     {
     public:
 
+        typedef enum
+        {
+            edns_unknown_e,
+            edns_supported_e,
+            edns_unsupported_e
+        }
+        edns_support_t;
+
+        /**
+         * snapshot of what's known about one server
+         */
+        struct server_stats_t
+        {
+            ip_address     address;
+            uint           srtt_ms;
+            uint           rttvar_ms;
+            uint           sent;
+            uint           responses;
+            uint           timeouts;
+            uint           consecutive_timeouts;
+            edns_support_t edns;
+            bool           dead;
+            uint           last_contact_ms;
+        };
+
         dns_ip_selector() = delete;
 
         /**
@@ -42,12 +74,28 @@ namespace adns
         static void update_last_contact(const ip_address &i);
 
         /**
-         * mark an address as non-responsive
+         * record a response from an address that took the given time to arrive
+         */
+        static void record_rtt(const ip_address &i, uint rtt_ms);
+
+        /**
+         * mark an address as non-responsive, it's avoided for a while that doubles with each
+         * successive timeout
          */
         static void mark_dead(const ip_address &i);
 
         /**
-         * select the least recently contacted from a set (aim is not to get rate throttled)
+         * record whether a server handled a query with EDNS in it
+         */
+        static void set_edns_support(const ip_address &i, bool supported);
+
+        /**
+         * what's known about a server's EDNS support
+         */
+        static edns_support_t get_edns_support(const ip_address &i);
+
+        /**
+         * select the servers most likely to answer quickly from a set
          * @param IN    all_ips - set to choose from
          * @param OUT   selected_ips - selection made
          * @param IN    include_dead - whether to include dead IPs or not
@@ -55,16 +103,74 @@ namespace adns
          */
         static void select_ips(const std::set<ip_address> &all_ips, std::set<ip_address> &selected_ips, bool include_dead, uint num_to_select);
 
+        /**
+         * as above but with the selection in the order the servers should be tried
+         */
+        static void select_ips(const std::set<ip_address> &all_ips, std::vector<ip_address> &selected_ips, bool include_dead, uint num_to_select);
+
+        /**
+         * get the statistics for one server, false if nothing has been heard from it yet
+         */
+        static bool get_stats(const ip_address &i, server_stats_t &stats);
+
+        /**
+         * get the statistics for every server seen so far
+         */
+        static std::vector<server_stats_t> get_stats();
+
     private:
 
-        static std::map<ip_address, std::chrono::time_point<std::chrono::steady_clock>> o_last_contact;
-        static std::map<ip_address, std::chrono::time_point<std::chrono::steady_clock>> o_dead_ips;
-        static std::mutex o_last_contact_m;
+        /**
+         * infrastructure cache entry
+         */
+        struct server_t
+        {
+            server_t();
+
+            // smoothed round trip time and variance, scaled by 8 and 4 as in RFC 6298
+            uint m_srtt8;
+            uint m_rttvar4;
+            bool m_measured;
+
+            uint m_sent;
+            uint m_responses;
+            uint m_timeouts;
+            uint m_consecutive_timeouts;
+
+            edns_support_t m_edns;
+
+            std::chrono::steady_clock::time_point m_last_contact;
+            std::chrono::steady_clock::time_point m_dead_until;
+        };
 
-        static void find_ips(
-                const std::set<ip_address> &all_ips, 
-                std::vector<std::pair<std::chrono::time_point<std::chrono::steady_clock>, ip_address>> &ip_by_lc, 
-                bool include_dead);
+        struct shard_t
+        {
+            std::mutex                              m_lock;
+            std::unordered_map<ip_address, server_t> m_servers;
+        };
+
+        // number of shards, a power of 2
+        static const uint num_shards = 16;
+
+        // servers never heard from are given a random SRTT below this so they get tried early
+        static const uint unknown_srtt_ms = 32;
+
+        // cap on SRTT and on the time a non-responsive server is avoided for
+        static const uint max_srtt_ms = 5000;
+        static const uint max_dead_ms = 60000;
+
+        // on average, one selection in this many includes a server picked at random
+        static const uint explore_one_in = 20;
+
+        static shard_t o_shards[num_shards];
+
+        static shard_t &get_shard(const ip_address &i);
+
+        /**
+         * SRTT used to rank a server, entry must be locked
+         */
+        static uint ranking_srtt(const server_t &s);
 
+        static server_stats_t make_stats(const ip_address &i, const server_t &s, std::chrono::steady_clock::time_point now);
     };
 }
@@ -0,0 +1,999 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <random>
+#include <algorithm>
+#include <string.h>
+
+#include "config.hpp"
+#include "monitor.hpp"
+#include "run_state.hpp"
+#include "dns_message_parser.hpp"
+#include "dns_ip_selector.hpp"
+#include "dns_outbound_multiplexer.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+static random_device rd;
+
+static shared_ptr<dns_outbound_multiplexer> instance;
+
+dns_outbound_multiplexer::outbound_query::outbound_query(
+                        const dns_message     &request, 
+                        const set<ip_address> &ips, 
+                        const client_config   &config, 
+                        const completion_t    &done) :
+                    m_request(request),
+                    m_all_ips(ips),
+                    m_config(config),
+                    m_done(done),
+                    m_use_edns(true),
+                    m_connection(nullptr),
+                    m_tcp_id(0),
+                    m_tcp_started(false),
+                    m_timer(timer_wheel::no_timer)
+{
+}
+
+dns_outbound_multiplexer::tcp_connection::tcp_connection(const socket_address &remote, bool tls) :
+                    m_remote(remote),
+                    m_tls(tls),
+                    m_state(connecting_e),
+                    m_reused(false),
+                    m_keepalive_ms(-1),
+                    m_timer(timer_wheel::no_timer)
+{
+}
+
+size_t dns_outbound_multiplexer::tcp_connection::get_load() const
+{
+    return m_queries.size() + m_waiting.size();
+}
+
+shared_ptr<dns_outbound_multiplexer> dns_outbound_multiplexer::get_instance()
+{
+    static mutex lock;
+
+    lock_guard<mutex> guard(lock);
+
+    if (!instance)
+    {
+        instance.reset(new dns_outbound_multiplexer());
+    }
+
+    return instance;
+}
+
+dns_outbound_multiplexer::dns_outbound_multiplexer() : 
+                    m_notify(make_shared<notify_socket>()),
+                    m_in_flight(0),
+                    m_sent_udp(0),
+                    m_sent_tcp(0),
+                    m_udp_timeouts(0),
+                    m_tcp_timeouts(0),
+                    m_failed(0),
+                    m_tcp_reused(0),
+                    m_tcp_pipelined(0),
+                    m_tls_handshakes(0),
+                    m_tls_resumed(0)
+{
+    m_sockets.add(m_notify);
+
+    m_monitor_in_flight_id = monitor::add_thing("outbound multiplexer", "singleton", "queries in flight", 0);
+    m_monitor_sent_udp_id = monitor::add_thing("outbound multiplexer", "singleton", "UDP queries sent", 0);
+    m_monitor_sent_tcp_id = monitor::add_thing("outbound multiplexer", "singleton", "TCP queries sent", 0);
+    m_monitor_udp_timeouts_id = monitor::add_thing("outbound multiplexer", "singleton", "UDP timeouts", 0);
+    m_monitor_tcp_timeouts_id = monitor::add_thing("outbound multiplexer", "singleton", "TCP timeouts", 0);
+    m_monitor_failed_id = monitor::add_thing("outbound multiplexer", "singleton", "failed queries", 0);
+    m_monitor_tcp_open_id = monitor::add_thing("outbound multiplexer", "singleton", "open TCP connections", 0);
+    m_monitor_tcp_reused_id = monitor::add_thing("outbound multiplexer", "singleton", "reused TCP connections", 0);
+    m_monitor_tcp_pipelined_id = monitor::add_thing("outbound multiplexer", "singleton", "pipelined TCP queries", 0);
+    m_monitor_tls_handshakes_id = monitor::add_thing("outbound multiplexer", "singleton", "TLS handshakes", 0);
+    m_monitor_tls_resumed_id = monitor::add_thing("outbound multiplexer", "singleton", "resumed TLS sessions", 0);
+
+    m_thread.reset(new thread(&dns_outbound_multiplexer::run, this));
+}
+
+dns_outbound_multiplexer::~dns_outbound_multiplexer()
+{
+    for (auto &e : m_udp_entries)
+    {
+        delete e.second;
+    }
+}
+
+void dns_outbound_multiplexer::query(
+                    const dns_message     &request, 
+                    const set<ip_address> &ips, 
+                    const client_config   &config, 
+                    const completion_t    &done)
+{
+    auto q = new outbound_query(request, ips, config, done);
+
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        m_posted.push_back(q);
+    }
+
+    m_notify->notify();
+}
+
+void dns_outbound_multiplexer::join()
+{
+    lock_guard<mutex> guard(m_join_lock);
+
+    if (m_thread && m_thread->joinable())
+    {
+        m_thread->join();
+    }
+}
+
+void dns_outbound_multiplexer::run()
+{
+    uint wait_ms = 1000;
+
+    while (run_state::o_state != run_state::shutdown_e)
+    {
+        try
+        {
+            auto e = m_sockets.wait_one(wait_ms);
+            auto s = get<0>(e).get();
+
+            if (s == m_notify.get())
+            {
+                m_notify->clear();
+                start_posted();
+            }
+            else
+            {
+                auto u = m_udp_entries.find(s);
+
+                if (u != m_udp_entries.end())
+                {
+                    receive_udp(u->second);
+                }
+                else
+                {
+                    auto c = m_connections.find(s);
+
+                    if (c != m_connections.end())
+                    {
+                        handle_tcp(c->second.get());
+                    }
+                }
+            }
+        }
+        catch (socket_set_timeout_exception &e)
+        {
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught in dns_outbound_multiplexer::run");
+        }
+
+        reap_udp();
+        wait_ms = m_timers.advance();
+    }
+}
+
+void dns_outbound_multiplexer::start_posted()
+{
+    list<outbound_query *> posted;
+
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        posted.swap(m_posted);
+    }
+
+    for (auto q : posted)
+    {
+        q->m_start_time = steady_clock::now();
+        monitor::set_value(m_monitor_in_flight_id, ++m_in_flight);
+
+        bool sent = false;
+
+        if (q->m_config.use_udp)
+        {
+            try
+            {
+                sent = send_udp(q);
+            }
+            catch (adns::exception &e)
+            {
+                e.log(warning, "failed to send upstream UDP query");
+                clear_udp(q);
+            }
+        }
+
+        if (!sent)
+        {
+            if (q->m_config.use_tcp)
+            {
+                next_tcp(q);
+            }
+            else
+            {
+                finish(q, nullptr);
+            }
+        }
+    }
+}
+
+dns_outbound_multiplexer::udp_entry_t *dns_outbound_multiplexer::get_udp_socket(ip_address::ip_type_t t)
+{
+    auto &pool = (t == ip_address::ip_v4_e) ? m_udp4 : m_udp6;
+
+    udp_entry_t *e;
+
+    if (pool.size() < num_udp_sockets)
+    {
+        // the kernel picks a random ephemeral port on first send
+        e = new udp_entry_t { make_shared<udp_socket>(t), 0, 0, false };
+        m_sockets.add(e->m_socket);
+        m_udp_entries[e->m_socket.get()] = e;
+        pool.push_back(e);
+    }
+    else
+    {
+        e = pool[rd() % pool.size()];
+    }
+
+    if (++e->m_uses >= max_udp_socket_uses)
+    {
+        // take it out of use for new queries, it's closed once any responses are in
+        e->m_retired = true;
+        pool.erase(find(pool.begin(), pool.end(), e));
+    }
+
+    return e;
+}
+
+void dns_outbound_multiplexer::reap_udp()
+{
+    for (auto i = m_udp_entries.begin(); i != m_udp_entries.end(); )
+    {
+        auto e = i->second;
+
+        if (e->m_retired && (e->m_outstanding == 0))
+        {
+            m_sockets.remove(e->m_socket);
+            delete e;
+            i = m_udp_entries.erase(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+bool dns_outbound_multiplexer::send_udp(outbound_query *q)
+{
+    dns_message_parser p;
+
+    dns_ip_selector::select_ips(q->m_all_ips, q->m_ips, false, q->m_config.num_parallel_udp);
+
+    // don't bother with EDNS if none of the chosen servers are known to handle it
+    if (q->m_use_edns && !q->m_ips.empty() && 
+        all_of(q->m_ips.begin(), q->m_ips.end(), [](const ip_address &ip) 
+            { return dns_ip_selector::get_edns_support(ip) == dns_ip_selector::edns_unsupported_e; }))
+    {
+        q->m_use_edns = false;
+    }
+
+    if (q->m_use_edns && (config::edns_size() > STANDARD_MESSAGE_SIZE))
+    {
+        q->m_request.set_edns(true, config::edns_size());
+    }
+    else
+    {
+        q->m_request.set_edns(false, STANDARD_MESSAGE_SIZE);
+    }
+
+    buffer raw = p.to_wire(q->m_request);
+
+    if (raw.get_size() > config::edns_size())
+    {
+        // unclear why this would ever happen but, if it does, then fall back to TCP
+        return false;
+    }
+
+    q->m_sent_time = steady_clock::now();
+
+    for (auto &ip : q->m_ips)
+    {
+        if ((ip.get_type() == ip_address::ip_v4_e) ? !q->m_config.use_ip4 : !q->m_config.use_ip6)
+        {
+            continue;
+        }
+
+        auto e = get_udp_socket(ip.get_type());
+        socket_address sa(ip, q->m_config.server_port);
+
+        // IDs only need to be unique per socket and server
+        unsigned short id;
+        do
+        {
+            id = rd() & 0xffff;
+        }
+        while (m_udp_pending.find(udp_key_t(e->m_socket.get(), sa, id)) != m_udp_pending.end());
+
+        p.set_id(raw, id);
+
+        try
+        {
+            e->m_socket->send(raw, sa);
+        }
+        catch (adns::exception &ex)
+        {
+            ex.log(warning, "failed to send upstream UDP query");
+            continue;
+        }
+
+        dns_ip_selector::update_last_contact(ip);
+
+        udp_key_t key(e->m_socket.get(), sa, id);
+        m_udp_pending[key] = q;
+        q->m_udp_keys.push_back(key);
+        e->m_outstanding++;
+        m_sent_udp++;
+    }
+
+    monitor::set_value(m_monitor_sent_udp_id, m_sent_udp);
+
+    if (q->m_udp_keys.empty())
+    {
+        return false;
+    }
+
+    set_deadline(q, cap_deadline(q, q->m_config.udp_timeout_ms));
+
+    return true;
+}
+
+void dns_outbound_multiplexer::receive_udp(udp_entry_t *e)
+{
+    udp_socket::message *messages[20];
+    dns_message_parser p;
+    int n;
+
+    do
+    {
+        n = e->m_socket->receive_many(20, messages);
+
+        for (int i = 0; i < n; i++)
+        {
+            unique_ptr<udp_socket::message> um(messages[i]);
+            unique_ptr<dns_message> m;
+
+            try
+            {
+                m.reset(p.from_wire(um->get_message()));
+            }
+            catch (adns::message_parser_exception &ex)
+            {
+                // can't tell which query a garbled message was for so just ignore it
+                continue;
+            }
+
+            auto pq = m_udp_pending.find(udp_key_t(e->m_socket.get(), um->get_remote_address(), m->get_id()));
+
+            if (pq == m_udp_pending.end())
+            {
+                // late or unsolicited, nothing is waiting for it
+                continue;
+            }
+
+            auto q = pq->second;
+
+            if (!m->get_question() || !(m->get_question()->get_qname() == q->m_request.get_question()->get_qname()))
+            {
+                continue;
+            }
+
+            auto ip = um->get_remote_address().get_ip_address();
+
+            dns_ip_selector::record_rtt(ip, static_cast<uint>(duration_cast<milliseconds>(steady_clock::now() - q->m_sent_time).count()));
+
+            if (q->m_use_edns && (m->get_response_code() != dns_message::format_error_e))
+            {
+                dns_ip_selector::set_edns_support(ip, m->get_is_edns());
+            }
+
+            if (m->get_is_truncated() && q->m_config.use_tcp)
+            {
+                clear_udp(q);
+                clear_deadline(q);
+                next_tcp(q);
+                continue;
+            }
+
+            switch (m->get_response_code())
+            {
+            case dns_message::no_error_e:
+            case dns_message::name_error_e:
+                finish(q, m.release());
+                break;
+
+            case dns_message::format_error_e:
+                if (q->m_use_edns)
+                {
+                    // format error most likely means EDNS isn't supported, so try again without
+                    dns_ip_selector::set_edns_support(ip, false);
+                    q->m_use_edns = false;
+                    clear_udp(q);
+                    clear_deadline(q);
+
+                    if (!send_udp(q))
+                    {
+                        udp_failed(q);
+                    }
+                    break;
+                }
+                [[fallthrough]];
+
+            default:
+                // wait for one of the other servers unless they've all answered
+                q->m_udp_keys.remove(pq->first);
+                e->m_outstanding--;
+                m_udp_pending.erase(pq);
+
+                if (q->m_udp_keys.empty())
+                {
+                    udp_failed(q);
+                }
+                break;
+            }
+        }
+    }
+    while (n == 20);
+}
+
+void dns_outbound_multiplexer::clear_udp(outbound_query *q)
+{
+    for (auto &k : q->m_udp_keys)
+    {
+        m_udp_pending.erase(k);
+
+        auto e = m_udp_entries.find(get<0>(k));
+
+        if (e != m_udp_entries.end())
+        {
+            e->second->m_outstanding--;
+        }
+    }
+
+    q->m_udp_keys.clear();
+}
+
+void dns_outbound_multiplexer::udp_failed(outbound_query *q)
+{
+    // anything that didn't answer at all is presumed dead for a while
+    for (auto &k : q->m_udp_keys)
+    {
+        dns_ip_selector::mark_dead(get<1>(k).get_ip_address());
+    }
+
+    clear_udp(q);
+    clear_deadline(q);
+
+    if (q->m_config.use_tcp && !out_of_time(q))
+    {
+        next_tcp(q);
+    }
+    else
+    {
+        finish(q, nullptr);
+    }
+}
+
+void dns_outbound_multiplexer::next_tcp(outbound_query *q)
+{
+    if (!q->m_tcp_started)
+    {
+        q->m_tcp_started = true;
+
+        vector<ip_address> ips;
+        dns_ip_selector::select_ips(q->m_all_ips, ips, true, q->m_all_ips.size());
+
+        for (auto &ip : ips)
+        {
+            if ((ip.get_type() == ip_address::ip_v4_e) ? q->m_config.use_ip4 : q->m_config.use_ip6)
+            {
+                q->m_tcp_ips.push_back(ip);
+            }
+        }
+    }
+
+    while (!q->m_tcp_ips.empty() && !out_of_time(q) && (run_state::o_state != run_state::shutdown_e))
+    {
+        socket_address sa(q->m_tcp_ips.front(), q->m_config.server_port);
+        q->m_tcp_ips.pop_front();
+
+        auto c = find_connection(sa, q->m_config.use_tls);
+
+        if (c)
+        {
+            if (c->m_state != tcp_connection::open_e)
+            {
+                // still being set up, goes out with everything else waiting once it's open
+                c->m_waiting.push_back(q);
+                q->m_connection = c;
+                set_deadline(q, cap_deadline(q, q->m_config.connect_tcp_timeout_ms));
+                return;
+            }
+
+            try
+            {
+                send_tcp(c, q);
+                return;
+            }
+            catch (adns::exception &e)
+            {
+                // most likely closed at the far end, try the same server on a new connection
+                q->m_tcp_ips.push_front(sa.get_ip_address());
+                close_connection(c);
+                continue;
+            }
+        }
+
+        try
+        {
+            unique_ptr<tcp_connection> c(new tcp_connection(sa, q->m_config.use_tls));
+
+            if (c->m_tls)
+            {
+                c->m_socket = make_shared<ssl_client_socket>(sa.get_ip_address().get_type());
+            }
+            else
+            {
+                c->m_socket = make_shared<tcp_client_socket>(sa.get_ip_address().get_type());
+            }
+
+            c->m_socket->start_connect(sa);
+            m_sockets.add(c->m_socket);
+
+            c->m_waiting.push_back(q);
+            q->m_connection = c.get();
+
+            m_open.insert(make_pair(connection_key_t(sa, c->m_tls), c.get()));
+            m_connections[c->m_socket.get()] = std::move(c);
+            monitor::set_value(m_monitor_tcp_open_id, m_connections.size());
+
+            set_deadline(q, cap_deadline(q, q->m_config.connect_tcp_timeout_ms));
+            return;
+        }
+        catch (adns::exception &e)
+        {
+            q->m_connection = nullptr;
+            e.log(warning, "failed to connect to upstream server");
+        }
+    }
+
+    finish(q, nullptr);
+}
+
+dns_outbound_multiplexer::tcp_connection *dns_outbound_multiplexer::find_connection(const socket_address &sa, bool tls)
+{
+    tcp_connection *res = nullptr;
+
+    auto r = m_open.equal_range(connection_key_t(sa, tls));
+
+    for (auto i = r.first; i != r.second; i++)
+    {
+        auto c = i->second;
+
+        if ((c->get_load() < max_tcp_pipelined) && (!res || (c->get_load() < res->get_load())))
+        {
+            res = c;
+        }
+    }
+
+    return res;
+}
+
+void dns_outbound_multiplexer::send_tcp(tcp_connection *c, outbound_query *q)
+{
+    dns_message_parser p;
+    auto ip = c->m_remote.get_ip_address();
+
+    // IDs only need to be unique on the connection, including queries that gave up on it
+    unsigned short id;
+    do
+    {
+        id = rd() & 0xffff;
+    }
+    while ((c->m_queries.find(id) != c->m_queries.end()) || (c->m_abandoned.find(id) != c->m_abandoned.end()));
+
+    q->m_request.set_id(id);
+
+    // EDNS is needed to ask how long the server will keep the connection open (RFC 7828). Only
+    // used over plain TCP with servers known to handle it but DNS over TLS servers are recent
+    // enough to be given the benefit of the doubt.
+    auto edns = dns_ip_selector::get_edns_support(ip);
+
+    if (q->m_use_edns && 
+        ((edns == dns_ip_selector::edns_supported_e) || (c->m_tls && (edns == dns_ip_selector::edns_unknown_e))))
+    {
+        q->m_request.set_edns(true, config::edns_size());
+        q->m_request.set_tcp_keepalive(true);
+    }
+    else
+    {
+        q->m_request.set_edns(false, STANDARD_MESSAGE_SIZE);
+        q->m_request.set_tcp_keepalive(false);
+    }
+
+    buffer raw = p.to_wire(q->m_request);
+
+    if (raw.get_size() > 65534)
+    {
+        THROW(outbound_multiplexer_exception, "request size bigger than max tcp message size ", raw.get_size());
+    }
+
+    vector<octet> out(raw.get_size() + 2);
+    out[0] = (raw.get_size() >> 8) & 0xff;
+    out[1] = raw.get_size() & 0xff;
+    memcpy(out.data() + 2, raw.get_data(), raw.get_size());
+
+    c->m_socket->write(out.data(), out.size(), q->m_config.write_tcp_timeout_ms);
+
+    dns_ip_selector::update_last_contact(ip);
+    q->m_sent_time = steady_clock::now();
+
+    if (c->m_reused)
+    {
+        monitor::set_value(m_monitor_tcp_reused_id, ++m_tcp_reused);
+    }
+
+    if (!c->m_queries.empty())
+    {
+        monitor::set_value(m_monitor_tcp_pipelined_id, ++m_tcp_pipelined);
+    }
+
+    clear_idle_deadline(c);
+    c->m_queries[id] = q;
+    q->m_tcp_id = id;
+    q->m_connection = c;
+
+    monitor::set_value(m_monitor_sent_tcp_id, ++m_sent_tcp);
+
+    set_deadline(q, cap_deadline(q, q->m_config.read_tcp_timeout_ms));
+}
+
+void dns_outbound_multiplexer::handle_tcp(tcp_connection *c)
+{
+    bool eof = false;
+
+    try
+    {
+        if (c->m_state == tcp_connection::connecting_e)
+        {
+            c->m_socket->finish_connect();
+            c->m_state = c->m_tls ? tcp_connection::handshaking_e : tcp_connection::open_e;
+        }
+
+        if (c->m_state == tcp_connection::handshaking_e)
+        {
+            auto s = static_cast<ssl_client_socket *>(c->m_socket.get());
+
+            if (!s->handshake())
+            {
+                return;
+            }
+
+            c->m_state = tcp_connection::open_e;
+            monitor::set_value(m_monitor_tls_handshakes_id, ++m_tls_handshakes);
+
+            if (s->get_session_reused())
+            {
+                monitor::set_value(m_monitor_tls_resumed_id, ++m_tls_resumed);
+            }
+        }
+
+        octet data[4096];
+        int n;
+
+        try
+        {
+            while ((n = c->m_socket->read_some(data, sizeof(data))) > 0)
+            {
+                c->m_read.insert(c->m_read.end(), data, data + n);
+            }
+        }
+        catch (tcp_socket_eof_exception &e)
+        {
+            eof = true;
+        }
+
+        // answers can come back in any order so match each complete one by ID
+        while (c->m_read.size() >= 2)
+        {
+            size_t len = (c->m_read[0] << 8) | c->m_read[1];
+
+            if (c->m_read.size() < len + 2)
+            {
+                break;
+            }
+
+            dns_message_parser p;
+
+            unique_ptr<dns_message> m(p.from_wire(buffer(len, c->m_read.data() + 2)));
+            c->m_read.erase(c->m_read.begin(), c->m_read.begin() + len + 2);
+
+            auto i = c->m_queries.find(m->get_id());
+
+            if (i == c->m_queries.end())
+            {
+                if (c->m_abandoned.erase(m->get_id()) == 0)
+                {
+                    LOG(warning) << "got a response with the wrong message id, possible cache poisoning attempt";
+                    close_connection(c);
+                    return;
+                }
+
+                // late answer to a query that had already moved on
+                continue;
+            }
+
+            auto q = i->second;
+            auto ip = c->m_remote.get_ip_address();
+
+            c->m_queries.erase(i);
+            c->m_reused = true;
+            q->m_connection = nullptr;
+
+            dns_ip_selector::record_rtt(ip, static_cast<uint>(duration_cast<milliseconds>(steady_clock::now() - q->m_sent_time).count()));
+
+            if (m->get_tcp_keepalive_timeout() >= 0)
+            {
+                // timeout is in units of 100ms
+                c->m_keepalive_ms = min<int>(m->get_tcp_keepalive_timeout() * 100, max_tcp_idle_timeout_ms);
+            }
+
+            if (q->m_request.get_is_edns())
+            {
+                if (m->get_response_code() == dns_message::format_error_e)
+                {
+                    // most likely doesn't handle EDNS after all so ask again without
+                    dns_ip_selector::set_edns_support(ip, false);
+                    q->m_use_edns = false;
+                    c->m_waiting.push_back(q);
+                    q->m_connection = c;
+                    continue;
+                }
+
+                dns_ip_selector::set_edns_support(ip, m->get_is_edns());
+            }
+
+            finish(q, m.release());
+        }
+
+        if (eof)
+        {
+            close_connection(c);
+            return;
+        }
+
+        if (c->m_state == tcp_connection::open_e)
+        {
+            while (!c->m_waiting.empty())
+            {
+                // only comes off the waiting list once sent so it's moved on if this fails
+                send_tcp(c, c->m_waiting.front());
+                c->m_waiting.pop_front();
+            }
+        }
+
+        if ((c->get_load() == 0) && (c->m_timer == timer_wheel::no_timer))
+        {
+            set_idle_deadline(c);
+        }
+    }
+    catch (adns::exception &e)
+    {
+        e.log(warning, "exception encountered using tcp connection");
+        close_connection(c);
+    }
+}
+
+void dns_outbound_multiplexer::detach_query(outbound_query *q)
+{
+    auto c = q->m_connection;
+
+    if (!c)
+    {
+        return;
+    }
+
+    auto i = c->m_queries.find(q->m_tcp_id);
+
+    if ((i != c->m_queries.end()) && (i->second == q))
+    {
+        c->m_queries.erase(i);
+        c->m_abandoned.insert(q->m_tcp_id);
+    }
+    else
+    {
+        c->m_waiting.remove(q);
+    }
+
+    q->m_connection = nullptr;
+}
+
+void dns_outbound_multiplexer::close_connection(tcp_connection *c)
+{
+    // anything on a connection that has been used before gets another go at the same server
+    // on a new one since it was most likely just dropped at the far end
+    bool retry = c->m_reused;
+    auto ip = c->m_remote.get_ip_address();
+
+    list<outbound_query *> queries(c->m_waiting.begin(), c->m_waiting.end());
+
+    for (auto &i : c->m_queries)
+    {
+        queries.push_back(i.second);
+    }
+
+    clear_idle_deadline(c);
+
+    auto r = m_open.equal_range(connection_key_t(c->m_remote, c->m_tls));
+
+    for (auto i = r.first; i != r.second; i++)
+    {
+        if (i->second == c)
+        {
+            m_open.erase(i);
+            break;
+        }
+    }
+
+    m_sockets.remove(c->m_socket);
+    m_connections.erase(c->m_socket.get());
+    monitor::set_value(m_monitor_tcp_open_id, m_connections.size());
+
+    for (auto q : queries)
+    {
+        q->m_connection = nullptr;
+        clear_deadline(q);
+
+        if (retry)
+        {
+            q->m_tcp_ips.push_front(ip);
+        }
+
+        next_tcp(q);
+    }
+}
+
+void dns_outbound_multiplexer::finish(outbound_query *q, dns_message *response)
+{
+    clear_udp(q);
+    clear_deadline(q);
+
+    if (q->m_connection)
+    {
+        // the connection is still fine for anything else on it, a late answer is just dropped
+        auto c = q->m_connection;
+        detach_query(q);
+
+        if (c->get_load() == 0)
+        {
+            set_idle_deadline(c);
+        }
+    }
+
+    if (!response)
+    {
+        monitor::set_value(m_monitor_failed_id, ++m_failed);
+    }
+
+    monitor::set_value(m_monitor_in_flight_id, --m_in_flight);
+
+    try
+    {
+        q->m_done(response);
+    }
+    catch (adns::exception &e)
+    {
+        e.log(error, "exception caught in outbound query completion");
+    }
+
+    delete q;
+}
+
+void dns_outbound_multiplexer::on_deadline(outbound_query *q)
+{
+    q->m_timer = timer_wheel::no_timer;
+
+    if (q->m_connection)
+    {
+        monitor::set_value(m_monitor_tcp_timeouts_id, ++m_tcp_timeouts);
+
+        auto c = q->m_connection;
+        dns_ip_selector::mark_dead(c->m_remote.get_ip_address());
+        detach_query(q);
+
+        // anything else on the connection waits out its own deadline
+        if (c->get_load() == 0)
+        {
+            close_connection(c);
+        }
+
+        next_tcp(q);
+    }
+    else
+    {
+        monitor::set_value(m_monitor_udp_timeouts_id, ++m_udp_timeouts);
+        udp_failed(q);
+    }
+}
+
+void dns_outbound_multiplexer::set_deadline(outbound_query *q, uint ms)
+{
+    clear_deadline(q);
+    q->m_timer = m_timers.add(milliseconds(ms), [this, q]() { on_deadline(q); });
+}
+
+void dns_outbound_multiplexer::clear_deadline(outbound_query *q)
+{
+    m_timers.cancel(q->m_timer);
+    q->m_timer = timer_wheel::no_timer;
+}
+
+void dns_outbound_multiplexer::set_idle_deadline(tcp_connection *c)
+{
+    clear_idle_deadline(c);
+
+    uint ms = (c->m_keepalive_ms >= 0) ? c->m_keepalive_ms : tcp_idle_timeout_ms;
+
+    c->m_timer = m_timers.add(milliseconds(ms), [this, c]()
+    {
+        c->m_timer = timer_wheel::no_timer;
+        close_connection(c);
+    });
+}
+
+void dns_outbound_multiplexer::clear_idle_deadline(tcp_connection *c)
+{
+    m_timers.cancel(c->m_timer);
+    c->m_timer = timer_wheel::no_timer;
+}
+
+uint dns_outbound_multiplexer::cap_deadline(const outbound_query *q, uint step_ms) const
+{
+    if (q->m_config.total_timeout_ms > 0)
+    {
+        auto left = duration_cast<milliseconds>(
+                        q->m_start_time + milliseconds(q->m_config.total_timeout_ms) - steady_clock::now()).count();
+
+        return static_cast<uint>(max<int64_t>(0, min<int64_t>(left, step_ms)));
+    }
+
+    return step_ms;
+}
+
+bool dns_outbound_multiplexer::out_of_time(const outbound_query *q) const
+{
+    return (q->m_config.total_timeout_ms > 0) && 
+           (steady_clock::now() >= q->m_start_time + milliseconds(q->m_config.total_timeout_ms));
+}
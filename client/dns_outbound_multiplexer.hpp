@@ -0,0 +1,358 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <set>
+#include <map>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "types.hpp"
+#include "exception.hpp"
+#include "client_config.hpp"
+#include "timer_wheel.hpp"
+#include "socket_set.hpp"
+#include "notify_socket.hpp"
+#include "udp_socket.hpp"
+#include "tcp_client_socket.hpp"
+#include "ssl_client_socket.hpp"
+#include "socket_address.hpp"
+#include "dns_message.hpp"
+
+EXCEPTION_CLASS(outbound_multiplexer_exception, exception)
+
+namespace adns
+{
+    /**
+     * Sends queries to upstream nameservers on behalf of the resolvers. One thread owns a pool
+     * of UDP sockets bound to random ports plus a set of TCP (or DNS over TLS) connections that 
+     * are kept open for reuse, and matches responses to queries by server, port, ID and name. 
+     * Several queries can be outstanding on a connection at once with answers coming back in 
+     * any order (RFC 7766). Callers hand over a query with a completion and carry on rather 
+     * than blocking.
+     */
+    class dns_outbound_multiplexer final
+    {
+    public:
+
+        /**
+         * Called on the multiplexer thread with the response (which the callee then owns) or 
+         * nullptr if nothing useful came back in time. Keep it short.
+         */
+        typedef std::function<void (dns_message *response)> completion_t;
+
+        /**
+         * the one and only multiplexer, started on first use
+         */
+        static std::shared_ptr<dns_outbound_multiplexer> get_instance();
+
+        virtual ~dns_outbound_multiplexer();
+
+        /**
+         * Send a query to one of a set of nameservers using the UDP/TCP settings and timeouts 
+         * in the client config. May be called from any thread.
+         */
+        void query(
+                const dns_message          &request, 
+                const std::set<ip_address> &ips, 
+                const client_config        &config, 
+                const completion_t         &done);
+
+        /**
+         * wait for the multiplexer thread to finish (safe to call more than once)
+         */
+        void join();
+
+    private:
+
+        class tcp_connection;
+
+        // key for matching UDP responses: socket sent from, server sent to and message ID
+        typedef std::tuple<socket *, socket_address, unsigned short> udp_key_t;
+
+        /**
+         * a query in progress
+         */
+        class outbound_query final
+        {
+        public:
+
+            outbound_query(const dns_message &request, const std::set<ip_address> &ips, const client_config &config, const completion_t &done);
+
+            dns_message          m_request;
+            std::set<ip_address> m_all_ips;
+            client_config        m_config;
+            completion_t         m_done;
+
+            std::chrono::steady_clock::time_point m_start_time;
+
+            // when the current round of UDP or the TCP request went out, for round trip times
+            std::chrono::steady_clock::time_point m_sent_time;
+
+            // addresses the current round of UDP went to
+            std::set<ip_address> m_ips;
+
+            // outstanding UDP sends for the current round
+            std::list<udp_key_t> m_udp_keys;
+
+            // set to false to retry without EDNS after a format error
+            bool m_use_edns;
+
+            // addresses still to try over TCP, the connection currently in use and the ID
+            // the query went out on it with
+            std::list<ip_address> m_tcp_ips;
+            tcp_connection        *m_connection;
+            unsigned short        m_tcp_id;
+            bool                  m_tcp_started;
+
+            // deadline for the current step
+            timer_wheel::timer_id_t m_timer;
+        };
+
+        /**
+         * a TCP or TLS connection to an upstream server, kept open after use in case it's 
+         * wanted again
+         */
+        class tcp_connection final
+        {
+        public:
+
+            typedef enum
+            {
+                connecting_e,
+                handshaking_e,
+                open_e
+            }
+            state_t;
+
+            tcp_connection(const socket_address &remote, bool tls);
+
+            /**
+             * number of queries sent or waiting to be sent on the connection
+             */
+            size_t get_load() const;
+
+            std::shared_ptr<tcp_client_socket> m_socket;
+            socket_address                     m_remote;
+            bool                               m_tls;
+            state_t                            m_state;
+
+            // has had at least one answer back on it
+            bool m_reused;
+
+            // queries sent on the connection by the ID they went out with and those waiting
+            // for it to open
+            std::map<unsigned short, outbound_query *> m_queries;
+            std::list<outbound_query *>                m_waiting;
+
+            // IDs of queries that gave up on the connection but might still get an answer
+            std::set<unsigned short> m_abandoned;
+
+            // partial responses read so far
+            std::vector<octet> m_read;
+
+            // idle time the server asked for with edns-tcp-keepalive, -1 if it hasn't
+            int m_keepalive_ms;
+
+            // idle timeout
+            timer_wheel::timer_id_t m_timer;
+        };
+
+        // key for finding open connections: server and whether it's TLS
+        typedef std::tuple<socket_address, bool> connection_key_t;
+
+        /**
+         * one socket in the UDP pool
+         */
+        struct udp_entry_t
+        {
+            std::shared_ptr<udp_socket> m_socket;
+
+            // number of queries sent through it so far and the number still waiting
+            uint m_uses;
+            uint m_outstanding;
+
+            // no longer used for new queries, closed once m_outstanding reaches zero
+            bool m_retired;
+        };
+
+        // UDP sockets per address family
+        static const uint num_udp_sockets = 8;
+
+        // swap a UDP socket for a new one (new random port) after this many queries
+        static const uint max_udp_socket_uses = 2000;
+
+        // close TCP connections that have been idle this long unless the server says otherwise
+        static const uint tcp_idle_timeout_ms = 10000;
+
+        // longest a connection is kept idle whatever the server says
+        static const uint max_tcp_idle_timeout_ms = 120000;
+
+        // most queries outstanding on one connection before another is opened
+        static const uint max_tcp_pipelined = 32;
+
+        std::mutex                 m_posted_lock;
+        std::list<outbound_query*> m_posted;
+
+        socket_set                     m_sockets;
+        std::shared_ptr<notify_socket> m_notify;
+
+        // UDP pool, current sockets for new queries per family and all of them by socket
+        std::vector<udp_entry_t *>                     m_udp4;
+        std::vector<udp_entry_t *>                     m_udp6;
+        std::unordered_map<socket *, udp_entry_t *>    m_udp_entries;
+        std::map<udp_key_t, outbound_query *>          m_udp_pending;
+
+        // TCP connections by socket and by server
+        std::unordered_map<socket *, std::unique_ptr<tcp_connection>> m_connections;
+        std::multimap<connection_key_t, tcp_connection *>             m_open;
+
+        // query deadlines and idle connection timeouts
+        timer_wheel m_timers;
+
+        // statistics
+        uint m_in_flight;
+        uint m_monitor_in_flight_id;
+        uint m_monitor_sent_udp_id;
+        uint m_monitor_sent_tcp_id;
+        uint m_monitor_udp_timeouts_id;
+        uint m_monitor_tcp_timeouts_id;
+        uint m_monitor_failed_id;
+        uint m_monitor_tcp_open_id;
+        uint m_monitor_tcp_reused_id;
+        uint m_monitor_tcp_pipelined_id;
+        uint m_monitor_tls_handshakes_id;
+        uint m_monitor_tls_resumed_id;
+        uint m_sent_udp;
+        uint m_sent_tcp;
+        uint m_udp_timeouts;
+        uint m_tcp_timeouts;
+        uint m_failed;
+        uint m_tcp_reused;
+        uint m_tcp_pipelined;
+        uint m_tls_handshakes;
+        uint m_tls_resumed;
+
+        std::mutex                   m_join_lock;
+        std::shared_ptr<std::thread> m_thread;
+
+        dns_outbound_multiplexer();
+
+        /**
+         * main loop
+         */
+        void run();
+
+        /**
+         * pick up queries handed over from other threads
+         */
+        void start_posted();
+
+        /**
+         * a query's current step has taken too long
+         */
+        void on_deadline(outbound_query *q);
+
+        /**
+         * start a new round of UDP sends, false if nothing could be sent
+         */
+        bool send_udp(outbound_query *q);
+
+        /**
+         * get a socket from the pool for the given address family
+         */
+        udp_entry_t *get_udp_socket(ip_address::ip_type_t t);
+
+        /**
+         * read and match responses on a pool socket
+         */
+        void receive_udp(udp_entry_t *e);
+
+        /**
+         * close retired UDP sockets that nothing is waiting on any more
+         */
+        void reap_udp();
+
+        /**
+         * forget about outstanding UDP sends for a query
+         */
+        void clear_udp(outbound_query *q);
+
+        /**
+         * nothing useful came back over UDP
+         */
+        void udp_failed(outbound_query *q);
+
+        /**
+         * try the next server over TCP
+         */
+        void next_tcp(outbound_query *q);
+
+        /**
+         * find the least busy connection to a server with room for another query
+         */
+        tcp_connection *find_connection(const socket_address &sa, bool tls);
+
+        /**
+         * send a query on an open connection
+         */
+        void send_tcp(tcp_connection *c, outbound_query *q);
+
+        /**
+         * handle an event on a TCP connection
+         */
+        void handle_tcp(tcp_connection *c);
+
+        /**
+         * take a query off its connection, leaving the connection for anything else using it
+         */
+        void detach_query(outbound_query *q);
+
+        /**
+         * close a connection, anything using it moves on to the next server
+         */
+        void close_connection(tcp_connection *c);
+
+        /**
+         * call the completion and clean up
+         */
+        void finish(outbound_query *q, dns_message *response);
+
+        void set_deadline(outbound_query *q, uint ms);
+        void clear_deadline(outbound_query *q);
+        void set_idle_deadline(tcp_connection *c);
+        void clear_idle_deadline(tcp_connection *c);
+
+        /**
+         * time allowed for the current step capped by what's left of the query's overall limit
+         */
+        uint cap_deadline(const outbound_query *q, uint step_ms) const;
+
+        /**
+         * has the query used up its overall time limit?
+         */
+        bool out_of_time(const outbound_query *q) const;
+    };
+}
@@ -109,6 +109,7 @@ bool dns_parallel_client::send_udp(dns_message &request, bool use_edns, set<unsi
     else
     {
         dns_ip_selector::select_ips(m_all_ips, m_ips, false, m_config.num_parallel_udp);
+        m_udp_sent_time = steady_clock::now();
 
         for (auto &ip : m_ips)
         {
@@ -246,6 +247,9 @@ dns_message *dns_parallel_client::extract_matching_response(
                     (ids.find(m->get_id()) != ids.end()) &&
                     (m->get_question()->get_qname() == qname))
                 {
+                    dns_ip_selector::record_rtt(
+                            receive_remote_address.get_ip_address(), 
+                            static_cast<uint>(duration_cast<milliseconds>(steady_clock::now() - m_udp_sent_time).count()));
                     return m.release();
                 }
             }
@@ -266,9 +270,10 @@ dns_message *dns_parallel_client::extract_matching_response(
 
 dns_message *dns_parallel_client::query_tcp(dns_message &request)
 {
-    dns_ip_selector::select_ips(m_all_ips, m_ips, true, m_all_ips.size());
+    vector<ip_address> ips;
+    dns_ip_selector::select_ips(m_all_ips, ips, true, m_all_ips.size());
 
-    for (auto ip : m_ips)
+    for (auto ip : ips)
     {
         check_timeout();
 
@@ -88,6 +88,9 @@ namespace adns
         // time the query started
         std::chrono::steady_clock::time_point m_query_start_time;
 
+        // time the last round of UDP requests went out
+        std::chrono::steady_clock::time_point m_udp_sent_time;
+
         // full set of IPs that might be used 
         std::set<ip_address> m_all_ips;
 
@@ -52,8 +52,16 @@ row_cache_config::row_cache_config()
 {
     m_default_ttl = 0;
     m_cache_garbage_collect_ms = 0;
-    m_cache_max_referral_rrs = 0;
-    m_cache_max_answer_rrs = 0;
+    m_cache_max_referral_kb = 0;
+    m_cache_max_answer_kb = 0;
+    m_cache_shards = 0;
+    m_prefetch_min_hits = 0;
+    m_prefetch_ttl_pct = 0;
+    m_serve_stale = false;
+    m_stale_answer_ttl = 0;
+    m_max_stale_ttl = 0;
+    m_snapshot_interval_s = 0;
+    m_root_zone_refresh_s = 0;
 }
 
 row_cache_config::~row_cache_config()
@@ -88,8 +96,14 @@ void row_cache_config::set_column_value(const column &c, int value)
 
 void row_cache_config::set_column_value(const column &c, bool value)
 {
-    (void)value;
-    THROW(row_exception, "no columns of type bool found", c.get_position());
+    switch (c.get_position())
+    {
+    case 10:
+        m_serve_stale = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type bool found at position", c.get_position());
+    }
 }
 
 void row_cache_config::set_column_value(const column &c, uint value)
@@ -103,10 +117,31 @@ void row_cache_config::set_column_value(const column &c, uint value)
         m_cache_garbage_collect_ms = value;
         break;
     case 5:
-        m_cache_max_referral_rrs = value;
+        m_cache_max_referral_kb = value;
         break;
     case 6:
-        m_cache_max_answer_rrs = value;
+        m_cache_max_answer_kb = value;
+        break;
+    case 7:
+        m_cache_shards = value;
+        break;
+    case 8:
+        m_prefetch_min_hits = value;
+        break;
+    case 9:
+        m_prefetch_ttl_pct = value;
+        break;
+    case 11:
+        m_stale_answer_ttl = value;
+        break;
+    case 12:
+        m_max_stale_ttl = value;
+        break;
+    case 14:
+        m_snapshot_interval_s = value;
+        break;
+    case 16:
+        m_root_zone_refresh_s = value;
         break;
     default:
         THROW(row_exception, "no columns of type uint found at position", c.get_position());
@@ -136,8 +171,17 @@ void row_cache_config::set_column_value(const column &c, uuid value)
 
 void row_cache_config::set_column_value(const column &c, const string &value)
 {
-    (void)value;
-    THROW(row_exception, "no columns of type string found", c.get_position());
+    switch (c.get_position())
+    {
+    case 13:
+        m_snapshot_file = value;
+        break;
+    case 15:
+        m_root_zone_file = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type string found at position", c.get_position());
+    }
 }
 
 void row_cache_config::set_column_value(const column &c, const datetime &value)
@@ -207,7 +251,13 @@ int row_cache_config::get_int_column_value(const column &c) const
 
 bool row_cache_config::get_bool_column_value(const column &c) const
 {
-    THROW(row_exception, "no columns of type bool found", c.get_name(), c.get_position());
+    switch (c.get_position())
+    {
+    case 10:
+        return m_serve_stale;
+    default:
+        THROW(row_exception, "no columns of type bool found at position", c.get_name(), c.get_position());
+    }
 }
 
 uint row_cache_config::get_uint_column_value(const column &c) const
@@ -219,9 +269,23 @@ uint row_cache_config::get_uint_column_value(const column &c) const
     case 4:
         return m_cache_garbage_collect_ms;
     case 5:
-        return m_cache_max_referral_rrs;
+        return m_cache_max_referral_kb;
     case 6:
-        return m_cache_max_answer_rrs;
+        return m_cache_max_answer_kb;
+    case 7:
+        return m_cache_shards;
+    case 8:
+        return m_prefetch_min_hits;
+    case 9:
+        return m_prefetch_ttl_pct;
+    case 11:
+        return m_stale_answer_ttl;
+    case 12:
+        return m_max_stale_ttl;
+    case 14:
+        return m_snapshot_interval_s;
+    case 16:
+        return m_root_zone_refresh_s;
     default:
         THROW(row_exception, "no columns of type uint found at position", c.get_name(), c.get_position());
     }
@@ -247,7 +311,15 @@ uuid row_cache_config::get_uuid_column_value(const column &c) const
 
 const string &row_cache_config::get_string_column_value(const column &c) const
 {
-    THROW(row_exception, "no columns of type string found", c.get_name(), c.get_position());
+    switch (c.get_position())
+    {
+    case 13:
+        return m_snapshot_file;
+    case 15:
+        return m_root_zone_file;
+    default:
+        THROW(row_exception, "no columns of type string found at position", c.get_name(), c.get_position());
+    }
 }
 
 const datetime &row_cache_config::get_datetime_column_value(const column &c) const
@@ -335,8 +407,18 @@ void row_cache_config::init_static()
             o_columns.push_back(column(column::uuid_e, "client_id", 2, false));
             o_columns.push_back(column(column::uint_e, "default_ttl", 3, false));
             o_columns.push_back(column(column::uint_e, "cache_garbage_collect_ms", 4, false));
-            o_columns.push_back(column(column::uint_e, "cache_max_referral_rrs", 5, false));
-            o_columns.push_back(column(column::uint_e, "cache_max_answer_rrs", 6, false));
+            o_columns.push_back(column(column::uint_e, "cache_max_referral_kb", 5, false));
+            o_columns.push_back(column(column::uint_e, "cache_max_answer_kb", 6, false));
+            o_columns.push_back(column(column::uint_e, "cache_shards", 7, false));
+            o_columns.push_back(column(column::uint_e, "prefetch_min_hits", 8, false));
+            o_columns.push_back(column(column::uint_e, "prefetch_ttl_pct", 9, false));
+            o_columns.push_back(column(column::bool_e, "serve_stale", 10, false));
+            o_columns.push_back(column(column::uint_e, "stale_answer_ttl", 11, false));
+            o_columns.push_back(column(column::uint_e, "max_stale_ttl", 12, false));
+            o_columns.push_back(column(column::string_e, "snapshot_file", 13, false));
+            o_columns.push_back(column(column::uint_e, "snapshot_interval_s", 14, false));
+            o_columns.push_back(column(column::string_e, "root_zone_file", 15, false));
+            o_columns.push_back(column(column::uint_e, "root_zone_refresh_s", 16, false));
             
             o_initialised = true;
         }
@@ -391,14 +473,64 @@ uint row_cache_config::get_cache_garbage_collect_ms() const
     return m_cache_garbage_collect_ms;
 }
 
-uint row_cache_config::get_cache_max_referral_rrs() const
+uint row_cache_config::get_cache_max_referral_kb() const
+{
+    return m_cache_max_referral_kb;
+}
+
+uint row_cache_config::get_cache_max_answer_kb() const
+{
+    return m_cache_max_answer_kb;
+}
+
+uint row_cache_config::get_cache_shards() const
+{
+    return m_cache_shards;
+}
+
+uint row_cache_config::get_prefetch_min_hits() const
+{
+    return m_prefetch_min_hits;
+}
+
+uint row_cache_config::get_prefetch_ttl_pct() const
+{
+    return m_prefetch_ttl_pct;
+}
+
+bool row_cache_config::get_serve_stale() const
+{
+    return m_serve_stale;
+}
+
+uint row_cache_config::get_stale_answer_ttl() const
+{
+    return m_stale_answer_ttl;
+}
+
+uint row_cache_config::get_max_stale_ttl() const
 {
-    return m_cache_max_referral_rrs;
+    return m_max_stale_ttl;
 }
 
-uint row_cache_config::get_cache_max_answer_rrs() const
+string row_cache_config::get_snapshot_file() const
 {
-    return m_cache_max_answer_rrs;
+    return m_snapshot_file;
+}
+
+uint row_cache_config::get_snapshot_interval_s() const
+{
+    return m_snapshot_interval_s;
+}
+
+string row_cache_config::get_root_zone_file() const
+{
+    return m_root_zone_file;
+}
+
+uint row_cache_config::get_root_zone_refresh_s() const
+{
+    return m_root_zone_refresh_s;
 }
 
 
@@ -423,14 +555,64 @@ void row_cache_config::set_cache_garbage_collect_ms(uint v)
     m_cache_garbage_collect_ms = v;
 }
 
-void row_cache_config::set_cache_max_referral_rrs(uint v)
+void row_cache_config::set_cache_max_referral_kb(uint v)
+{
+    m_cache_max_referral_kb = v;
+}
+
+void row_cache_config::set_cache_max_answer_kb(uint v)
+{
+    m_cache_max_answer_kb = v;
+}
+
+void row_cache_config::set_cache_shards(uint v)
+{
+    m_cache_shards = v;
+}
+
+void row_cache_config::set_prefetch_min_hits(uint v)
+{
+    m_prefetch_min_hits = v;
+}
+
+void row_cache_config::set_prefetch_ttl_pct(uint v)
+{
+    m_prefetch_ttl_pct = v;
+}
+
+void row_cache_config::set_serve_stale(bool v)
+{
+    m_serve_stale = v;
+}
+
+void row_cache_config::set_stale_answer_ttl(uint v)
+{
+    m_stale_answer_ttl = v;
+}
+
+void row_cache_config::set_max_stale_ttl(uint v)
+{
+    m_max_stale_ttl = v;
+}
+
+void row_cache_config::set_snapshot_file(string v)
+{
+    m_snapshot_file = v;
+}
+
+void row_cache_config::set_snapshot_interval_s(uint v)
+{
+    m_snapshot_interval_s = v;
+}
+
+void row_cache_config::set_root_zone_file(string v)
 {
-    m_cache_max_referral_rrs = v;
+    m_root_zone_file = v;
 }
 
-void row_cache_config::set_cache_max_answer_rrs(uint v)
+void row_cache_config::set_root_zone_refresh_s(uint v)
 {
-    m_cache_max_answer_rrs = v;
+    m_root_zone_refresh_s = v;
 }
 
 
@@ -57,15 +57,35 @@ namespace adns
             uuid get_client_id() const;
             uint get_default_ttl() const;
             uint get_cache_garbage_collect_ms() const;
-            uint get_cache_max_referral_rrs() const;
-            uint get_cache_max_answer_rrs() const;
+            uint get_cache_max_referral_kb() const;
+            uint get_cache_max_answer_kb() const;
+            uint get_cache_shards() const;
+            uint get_prefetch_min_hits() const;
+            uint get_prefetch_ttl_pct() const;
+            bool get_serve_stale() const;
+            uint get_stale_answer_ttl() const;
+            uint get_max_stale_ttl() const;
+            std::string get_snapshot_file() const;
+            uint get_snapshot_interval_s() const;
+            std::string get_root_zone_file() const;
+            uint get_root_zone_refresh_s() const;
 
             void set_cache_config_id(uuid v);
             void set_client_id(uuid v);
             void set_default_ttl(uint v);
             void set_cache_garbage_collect_ms(uint v);
-            void set_cache_max_referral_rrs(uint v);
-            void set_cache_max_answer_rrs(uint v);
+            void set_cache_max_referral_kb(uint v);
+            void set_cache_max_answer_kb(uint v);
+            void set_cache_shards(uint v);
+            void set_prefetch_min_hits(uint v);
+            void set_prefetch_ttl_pct(uint v);
+            void set_serve_stale(bool v);
+            void set_stale_answer_ttl(uint v);
+            void set_max_stale_ttl(uint v);
+            void set_snapshot_file(std::string v);
+            void set_snapshot_interval_s(uint v);
+            void set_root_zone_file(std::string v);
+            void set_root_zone_refresh_s(uint v);
 
 
             /**
@@ -155,8 +175,18 @@ namespace adns
             uuid m_client_id;
             uint m_default_ttl;
             uint m_cache_garbage_collect_ms;
-            uint m_cache_max_referral_rrs;
-            uint m_cache_max_answer_rrs;
+            uint m_cache_max_referral_kb;
+            uint m_cache_max_answer_kb;
+            uint m_cache_shards;
+            uint m_prefetch_min_hits;
+            uint m_prefetch_ttl_pct;
+            bool m_serve_stale;
+            uint m_stale_answer_ttl;
+            uint m_max_stale_ttl;
+            std::string m_snapshot_file;
+            uint m_snapshot_interval_s;
+            std::string m_root_zone_file;
+            uint m_root_zone_refresh_s;
 
 
             static std::atomic<bool> o_initialised;
@@ -76,6 +76,13 @@ row_dns_server::row_dns_server()
     m_forward_cache_max_age_seconds = 0;
     m_forward_cache_max_entries = 0;
     m_forward_cache_garbage_collect_pct = 0;
+    m_num_recursive_threads = 0;
+    m_forward_max_in_flight = 0;
+    m_forward_hedge_queries = false;
+    m_max_queue_wait_ms = 0;
+    m_max_tcp_connections = 0;
+    m_max_tcp_queries_in_flight = 0;
+    m_max_doh_streams = 0;
 }
 
 row_dns_server::~row_dns_server()
@@ -118,6 +125,9 @@ void row_dns_server::set_column_value(const column &c, bool value)
     case 26:
         m_use_forwarding_emergency_cache = value;
         break;
+    case 35:
+        m_forward_hedge_queries = value;
+        break;
     default:
         THROW(row_exception, "no columns of type bool found at position", c.get_position());
     }
@@ -199,6 +209,24 @@ void row_dns_server::set_column_value(const column &c, uint value)
     case 29:
         m_forward_cache_garbage_collect_pct = value;
         break;
+    case 33:
+        m_num_recursive_threads = value;
+        break;
+    case 34:
+        m_forward_max_in_flight = value;
+        break;
+    case 36:
+        m_max_queue_wait_ms = value;
+        break;
+    case 38:
+        m_max_tcp_connections = value;
+        break;
+    case 39:
+        m_max_tcp_queries_in_flight = value;
+        break;
+    case 40:
+        m_max_doh_streams = value;
+        break;
     default:
         THROW(row_exception, "no columns of type uint found at position", c.get_position());
     }
@@ -232,6 +260,18 @@ void row_dns_server::set_column_value(const column &c, const string &value)
     case 24:
         m_doh_path = value;
         break;
+    case 30:
+        m_receive_thread_cpus = value;
+        break;
+    case 31:
+        m_handler_thread_cpus = value;
+        break;
+    case 32:
+        m_send_thread_cpus = value;
+        break;
+    case 37:
+        m_queue_shed_policy = value;
+        break;
     default:
         THROW(row_exception, "no columns of type string found at position", c.get_position());
     }
@@ -310,6 +350,8 @@ bool row_dns_server::get_bool_column_value(const column &c) const
         return m_use_forwarding_cache;
     case 26:
         return m_use_forwarding_emergency_cache;
+    case 35:
+        return m_forward_hedge_queries;
     default:
         THROW(row_exception, "no columns of type bool found at position", c.get_name(), c.get_position());
     }
@@ -367,6 +409,18 @@ uint row_dns_server::get_uint_column_value(const column &c) const
         return m_forward_cache_max_entries;
     case 29:
         return m_forward_cache_garbage_collect_pct;
+    case 33:
+        return m_num_recursive_threads;
+    case 34:
+        return m_forward_max_in_flight;
+    case 36:
+        return m_max_queue_wait_ms;
+    case 38:
+        return m_max_tcp_connections;
+    case 39:
+        return m_max_tcp_queries_in_flight;
+    case 40:
+        return m_max_doh_streams;
     default:
         THROW(row_exception, "no columns of type uint found at position", c.get_name(), c.get_position());
     }
@@ -396,6 +450,14 @@ const string &row_dns_server::get_string_column_value(const column &c) const
     {
     case 24:
         return m_doh_path;
+    case 30:
+        return m_receive_thread_cpus;
+    case 31:
+        return m_handler_thread_cpus;
+    case 32:
+        return m_send_thread_cpus;
+    case 37:
+        return m_queue_shed_policy;
     default:
         THROW(row_exception, "no columns of type string found at position", c.get_name(), c.get_position());
     }
@@ -511,6 +573,17 @@ void row_dns_server::init_static()
             o_columns.push_back(column(column::uint_e, "forward_cache_max_age_seconds", 27, false));
             o_columns.push_back(column(column::uint_e, "forward_cache_max_entries", 28, false));
             o_columns.push_back(column(column::uint_e, "forward_cache_garbage_collect_pct", 29, false));
+            o_columns.push_back(column(column::string_e, "receive_thread_cpus", 30, false));
+            o_columns.push_back(column(column::string_e, "handler_thread_cpus", 31, false));
+            o_columns.push_back(column(column::string_e, "send_thread_cpus", 32, false));
+            o_columns.push_back(column(column::uint_e, "num_recursive_threads", 33, false));
+            o_columns.push_back(column(column::uint_e, "forward_max_in_flight", 34, false));
+            o_columns.push_back(column(column::bool_e, "forward_hedge_queries", 35, false));
+            o_columns.push_back(column(column::uint_e, "max_queue_wait_ms", 36, false));
+            o_columns.push_back(column(column::string_e, "queue_shed_policy", 37, false));
+            o_columns.push_back(column(column::uint_e, "max_tcp_connections", 38, false));
+            o_columns.push_back(column(column::uint_e, "max_tcp_queries_in_flight", 39, false));
+            o_columns.push_back(column(column::uint_e, "max_doh_streams", 40, false));
             
             o_initialised = true;
         }
@@ -690,6 +763,61 @@ uint row_dns_server::get_forward_cache_garbage_collect_pct() const
     return m_forward_cache_garbage_collect_pct;
 }
 
+string row_dns_server::get_receive_thread_cpus() const
+{
+    return m_receive_thread_cpus;
+}
+
+string row_dns_server::get_handler_thread_cpus() const
+{
+    return m_handler_thread_cpus;
+}
+
+string row_dns_server::get_send_thread_cpus() const
+{
+    return m_send_thread_cpus;
+}
+
+uint row_dns_server::get_num_recursive_threads() const
+{
+    return m_num_recursive_threads;
+}
+
+uint row_dns_server::get_forward_max_in_flight() const
+{
+    return m_forward_max_in_flight;
+}
+
+bool row_dns_server::get_forward_hedge_queries() const
+{
+    return m_forward_hedge_queries;
+}
+
+uint row_dns_server::get_max_queue_wait_ms() const
+{
+    return m_max_queue_wait_ms;
+}
+
+string row_dns_server::get_queue_shed_policy() const
+{
+    return m_queue_shed_policy;
+}
+
+uint row_dns_server::get_max_tcp_connections() const
+{
+    return m_max_tcp_connections;
+}
+
+uint row_dns_server::get_max_tcp_queries_in_flight() const
+{
+    return m_max_tcp_queries_in_flight;
+}
+
+uint row_dns_server::get_max_doh_streams() const
+{
+    return m_max_doh_streams;
+}
+
 
 
 void row_dns_server::set_allowed_connection_backlog(uint v)
@@ -837,4 +965,59 @@ void row_dns_server::set_forward_cache_garbage_collect_pct(uint v)
     m_forward_cache_garbage_collect_pct = v;
 }
 
+void row_dns_server::set_receive_thread_cpus(string v)
+{
+    m_receive_thread_cpus = v;
+}
+
+void row_dns_server::set_handler_thread_cpus(string v)
+{
+    m_handler_thread_cpus = v;
+}
+
+void row_dns_server::set_send_thread_cpus(string v)
+{
+    m_send_thread_cpus = v;
+}
+
+void row_dns_server::set_num_recursive_threads(uint v)
+{
+    m_num_recursive_threads = v;
+}
+
+void row_dns_server::set_forward_max_in_flight(uint v)
+{
+    m_forward_max_in_flight = v;
+}
+
+void row_dns_server::set_forward_hedge_queries(bool v)
+{
+    m_forward_hedge_queries = v;
+}
+
+void row_dns_server::set_max_queue_wait_ms(uint v)
+{
+    m_max_queue_wait_ms = v;
+}
+
+void row_dns_server::set_queue_shed_policy(string v)
+{
+    m_queue_shed_policy = v;
+}
+
+void row_dns_server::set_max_tcp_connections(uint v)
+{
+    m_max_tcp_connections = v;
+}
+
+void row_dns_server::set_max_tcp_queries_in_flight(uint v)
+{
+    m_max_tcp_queries_in_flight = v;
+}
+
+void row_dns_server::set_max_doh_streams(uint v)
+{
+    m_max_doh_streams = v;
+}
+
 
@@ -82,6 +82,17 @@ namespace adns
             uint get_forward_cache_max_age_seconds() const;
             uint get_forward_cache_max_entries() const;
             uint get_forward_cache_garbage_collect_pct() const;
+            std::string get_receive_thread_cpus() const;
+            std::string get_handler_thread_cpus() const;
+            std::string get_send_thread_cpus() const;
+            uint get_num_recursive_threads() const;
+            uint get_forward_max_in_flight() const;
+            bool get_forward_hedge_queries() const;
+            uint get_max_queue_wait_ms() const;
+            std::string get_queue_shed_policy() const;
+            uint get_max_tcp_connections() const;
+            uint get_max_tcp_queries_in_flight() const;
+            uint get_max_doh_streams() const;
 
             void set_allowed_connection_backlog(uint v);
             void set_client_id(uuid v);
@@ -112,6 +123,17 @@ namespace adns
             void set_forward_cache_max_age_seconds(uint v);
             void set_forward_cache_max_entries(uint v);
             void set_forward_cache_garbage_collect_pct(uint v);
+            void set_receive_thread_cpus(std::string v);
+            void set_handler_thread_cpus(std::string v);
+            void set_send_thread_cpus(std::string v);
+            void set_num_recursive_threads(uint v);
+            void set_forward_max_in_flight(uint v);
+            void set_forward_hedge_queries(bool v);
+            void set_max_queue_wait_ms(uint v);
+            void set_queue_shed_policy(std::string v);
+            void set_max_tcp_connections(uint v);
+            void set_max_tcp_queries_in_flight(uint v);
+            void set_max_doh_streams(uint v);
 
 
             /**
@@ -226,6 +248,17 @@ namespace adns
             uint m_forward_cache_max_age_seconds;
             uint m_forward_cache_max_entries;
             uint m_forward_cache_garbage_collect_pct;
+            std::string m_receive_thread_cpus;
+            std::string m_handler_thread_cpus;
+            std::string m_send_thread_cpus;
+            uint m_num_recursive_threads;
+            uint m_forward_max_in_flight;
+            bool m_forward_hedge_queries;
+            uint m_max_queue_wait_ms;
+            std::string m_queue_shed_policy;
+            uint m_max_tcp_connections;
+            uint m_max_tcp_queries_in_flight;
+            uint m_max_doh_streams;
 
 
             static std::atomic<bool> o_initialised;
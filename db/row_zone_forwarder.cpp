@@ -0,0 +1,449 @@
+// 
+// Copyright 2025 Andrew Haisley
+// 
+// This program is free software: you can redistribute it and/or modify it under the terms 
+// of the GNU General Public License as published by the Free Software Foundation, either 
+// version 3 of the License, or (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; 
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+// See the GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License along with this program. 
+// If not, see https://www.gnu.org/licenses/.
+// 
+/**
+ * autogenerated by dbgen.py at 09:25AM on October 19, 2026, do not hand edit
+ */
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "row_zone_forwarder.hpp"
+
+using namespace adns;
+using namespace db;
+using namespace std;
+
+mutex row_zone_forwarder::o_lock;
+vector<column> row_zone_forwarder::o_columns;
+atomic<bool> row_zone_forwarder::o_initialised(false);
+column row_zone_forwarder::o_primary_key;
+vector<foreign_key> row_zone_forwarder::o_foreign_keys;
+
+static row_zone_forwarder instance;
+
+static shared_ptr<row_zone_forwarder> convert_row_type(row *r)
+{
+    return shared_ptr<row_zone_forwarder>(static_cast<row_zone_forwarder*>(r));
+}
+
+static vector<shared_ptr<row_zone_forwarder>> convert_row_type(vector<row *> vr)
+{
+    vector<shared_ptr<row_zone_forwarder>> res(vr.size());
+    for (size_t i = 0; i < vr.size(); i++)
+    {
+        res[i] = shared_ptr<row_zone_forwarder>(static_cast<row_zone_forwarder*>(vr[i]));
+    }
+    return res;
+}
+
+    
+row_zone_forwarder::row_zone_forwarder()
+{
+    m_port = 0;
+    m_weight = 0;
+    m_use_tls = false;
+}
+
+row_zone_forwarder::~row_zone_forwarder()
+{
+}
+
+vector<shared_ptr<row_zone_forwarder>> row_zone_forwarder::get_rows(connection &conn)
+{
+    return convert_row_type(instance.fetch_rows(conn));
+}
+
+string row_zone_forwarder::get_table_name() const
+{
+    return "zone_forwarder";
+}
+
+table::table_t row_zone_forwarder::get_table_id() const
+{
+    return table::zone_forwarder_e;
+}
+
+row *row_zone_forwarder::create_instance() const
+{
+    return new row_zone_forwarder();
+}
+
+void row_zone_forwarder::set_column_value(const column &c, int value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type int found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, bool value)
+{
+    switch (c.get_position())
+    {
+    case 6:
+        m_use_tls = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type bool found at position", c.get_position());
+    }
+}
+
+void row_zone_forwarder::set_column_value(const column &c, uint value)
+{
+    switch (c.get_position())
+    {
+    case 4:
+        m_port = value;
+        break;
+    case 5:
+        m_weight = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type uint found at position", c.get_position());
+    }
+}
+
+void row_zone_forwarder::set_column_value(const column &c, octet value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type octet found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, uuid value)
+{
+    switch (c.get_position())
+    {
+    case 1:
+        m_zone_forwarder_id = value;
+        break;
+    case 2:
+        m_zone_id = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type uuid found at position", c.get_position());
+    }
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const string &value)
+{
+    switch (c.get_position())
+    {
+    case 3:
+        m_ip_address = value;
+        break;
+    default:
+        THROW(row_exception, "no columns of type string found at position", c.get_position());
+    }
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const datetime &value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type datetime found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const buffer &value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type buffer found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, nullable<int> value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type int found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, nullable<bool> value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type bool found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, nullable<uint> value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type uint found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, nullable<octet> value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type octet found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, nullable<uuid> value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type uuid found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const nullable<string> &value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type string found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const nullable<datetime> &value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type datetime found", c.get_position());
+}
+
+void row_zone_forwarder::set_column_value(const column &c, const nullable<buffer> &value)
+{
+    (void)value;
+    THROW(row_exception, "no columns of type buffer found", c.get_position());
+}
+
+int row_zone_forwarder::get_int_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type int found", c.get_name(), c.get_position());
+}
+
+bool row_zone_forwarder::get_bool_column_value(const column &c) const
+{
+    switch (c.get_position())
+    {
+    case 6:
+        return m_use_tls;
+    default:
+        THROW(row_exception, "no columns of type bool found at position", c.get_name(), c.get_position());
+    }
+}
+
+uint row_zone_forwarder::get_uint_column_value(const column &c) const
+{
+    switch (c.get_position())
+    {
+    case 4:
+        return m_port;
+    case 5:
+        return m_weight;
+    default:
+        THROW(row_exception, "no columns of type uint found at position", c.get_name(), c.get_position());
+    }
+}
+
+octet row_zone_forwarder::get_octet_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type octet found", c.get_name(), c.get_position());
+}
+
+uuid row_zone_forwarder::get_uuid_column_value(const column &c) const
+{
+    switch (c.get_position())
+    {
+    case 1:
+        return m_zone_forwarder_id;
+    case 2:
+        return m_zone_id;
+    default:
+        THROW(row_exception, "no columns of type uuid found at position", c.get_name(), c.get_position());
+    }
+}
+
+const string &row_zone_forwarder::get_string_column_value(const column &c) const
+{
+    switch (c.get_position())
+    {
+    case 3:
+        return m_ip_address;
+    default:
+        THROW(row_exception, "no columns of type string found at position", c.get_name(), c.get_position());
+    }
+}
+
+const datetime &row_zone_forwarder::get_datetime_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type datetime found", c.get_name(), c.get_position());
+}
+
+const buffer &row_zone_forwarder::get_buffer_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type buffer found", c.get_name(), c.get_position());
+}
+
+nullable<int> row_zone_forwarder::get_nullable_int_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type int found", c.get_name(), c.get_position());
+}
+
+nullable<bool> row_zone_forwarder::get_nullable_bool_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type bool found", c.get_name(), c.get_position());
+}
+
+nullable<uint> row_zone_forwarder::get_nullable_uint_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type uint found", c.get_name(), c.get_position());
+}
+
+nullable<octet> row_zone_forwarder::get_nullable_octet_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type octet found", c.get_name(), c.get_position());
+}
+
+nullable<uuid> row_zone_forwarder::get_nullable_uuid_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type uuid found", c.get_name(), c.get_position());
+}
+
+const nullable<string> &row_zone_forwarder::get_nullable_string_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type string found", c.get_name(), c.get_position());
+}
+
+const nullable<datetime> &row_zone_forwarder::get_nullable_datetime_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type datetime found", c.get_name(), c.get_position());
+}
+
+const nullable<buffer> &row_zone_forwarder::get_nullable_buffer_column_value(const column &c) const
+{
+    THROW(row_exception, "no columns of type buffer found", c.get_name(), c.get_position());
+}
+
+const vector<column> &row_zone_forwarder::get_columns() const
+{
+    init_static();
+    return o_columns;
+}
+
+const vector<foreign_key> &row_zone_forwarder::get_foreign_keys() const
+{
+    init_static();
+    return o_foreign_keys;
+}
+
+const column &row_zone_forwarder::get_primary_key() const
+{
+    init_static();
+    return o_primary_key;
+}
+
+uuid row_zone_forwarder::get_primary_key_value() const
+{
+    return get_uuid_column_value(get_primary_key());
+}
+
+void row_zone_forwarder::init_static()
+{
+    if (!o_initialised)
+    {
+        lock_guard<mutex> guard(o_lock);
+        if (!o_initialised)
+        {
+            o_columns.push_back(column(column::uuid_e, "zone_forwarder_id", 1, false));
+            o_primary_key = column(column::uuid_e, "zone_forwarder_id", 1, false);
+            o_columns.push_back(column(column::uuid_e, "zone_id", 2, false));
+            o_columns.push_back(column(column::string_e, "ip_address", 3, false));
+            o_columns.push_back(column(column::uint_e, "port", 4, false));
+            o_columns.push_back(column(column::uint_e, "weight", 5, false));
+            o_columns.push_back(column(column::bool_e, "use_tls", 6, false));
+            
+            o_initialised = true;
+        }
+    }
+}
+
+shared_ptr<row_zone_forwarder> row_zone_forwarder::get_by_zone_forwarder_id(connection &c, uuid zone_forwarder_id)
+{
+    init_static();
+    return convert_row_type(instance.fetch_row(c, o_columns[0], zone_forwarder_id));
+}
+
+vector<shared_ptr<row_zone_forwarder>> row_zone_forwarder::get_by_zone_id(connection &c, uuid zone_id)
+{
+    init_static();
+    return convert_row_type(instance.fetch_rows(c, o_columns[1], zone_id));
+}
+
+
+
+void row_zone_forwarder::delete_by_zone_forwarder_id(connection &c, uuid zone_forwarder_id)
+{
+    init_static();
+    instance.delete_rows(c, o_columns[0], zone_forwarder_id);
+}
+
+void row_zone_forwarder::delete_by_zone_id(connection &c, uuid zone_id)
+{
+    init_static();
+    instance.delete_rows(c, o_columns[1], zone_id);
+}
+
+
+
+uuid row_zone_forwarder::get_zone_forwarder_id() const
+{
+    return m_zone_forwarder_id;
+}
+
+uuid row_zone_forwarder::get_zone_id() const
+{
+    return m_zone_id;
+}
+
+string row_zone_forwarder::get_ip_address() const
+{
+    return m_ip_address;
+}
+
+uint row_zone_forwarder::get_port() const
+{
+    return m_port;
+}
+
+uint row_zone_forwarder::get_weight() const
+{
+    return m_weight;
+}
+
+bool row_zone_forwarder::get_use_tls() const
+{
+    return m_use_tls;
+}
+
+
+
+void row_zone_forwarder::set_zone_forwarder_id(uuid v)
+{
+    m_zone_forwarder_id = v;
+}
+
+void row_zone_forwarder::set_zone_id(uuid v)
+{
+    m_zone_id = v;
+}
+
+void row_zone_forwarder::set_ip_address(string v)
+{
+    m_ip_address = v;
+}
+
+void row_zone_forwarder::set_port(uint v)
+{
+    m_port = v;
+}
+
+void row_zone_forwarder::set_weight(uint v)
+{
+    m_weight = v;
+}
+
+void row_zone_forwarder::set_use_tls(bool v)
+{
+    m_use_tls = v;
+}
+
+
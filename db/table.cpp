@@ -35,6 +35,7 @@
 #include "row_server.hpp"
 #include "row_server_socket_address.hpp"
 #include "row_zone.hpp"
+#include "row_zone_forwarder.hpp"
 #include "row_rr_a.hpp"
 #include "row_rr_aaaa.hpp"
 #include "row_rr_afsdb.hpp"
@@ -101,10 +102,10 @@ list<pair<table::table_t, string>> table::get_table_sql(type_t db_type)
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(basic_config_e, "CREATE TABLE basic_config(config_id VARCHAR(36) NOT NULL PRIMARY KEY, name VARCHAR(100) NOT NULL, value VARCHAR(100) NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(basic_config_e, "basic_config"));
         o_table_sql[postgres_e].push_back(pair<table_t, string>(basic_config_e, "CREATE TABLE basic_config(config_id VARCHAR(36) NOT NULL PRIMARY KEY, name VARCHAR(100) NOT NULL, value VARCHAR(100) NOT NULL)"));
-        o_table_sql[mysql_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER UNSIGNED NOT NULL, cache_garbage_collect_ms INTEGER UNSIGNED NOT NULL, cache_max_referral_rrs INTEGER UNSIGNED NOT NULL, cache_max_answer_rrs INTEGER UNSIGNED NOT NULL)"));
-        o_table_sql[sqlite_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER UNSIGNED NOT NULL, cache_garbage_collect_ms INTEGER UNSIGNED NOT NULL, cache_max_referral_rrs INTEGER UNSIGNED NOT NULL, cache_max_answer_rrs INTEGER UNSIGNED NOT NULL)"));
+        o_table_sql[mysql_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER UNSIGNED NOT NULL, cache_garbage_collect_ms INTEGER UNSIGNED NOT NULL, cache_max_referral_kb INTEGER UNSIGNED NOT NULL, cache_max_answer_kb INTEGER UNSIGNED NOT NULL, cache_shards INTEGER UNSIGNED NOT NULL, prefetch_min_hits INTEGER UNSIGNED NOT NULL, prefetch_ttl_pct INTEGER UNSIGNED NOT NULL, serve_stale BOOLEAN NOT NULL, stale_answer_ttl INTEGER UNSIGNED NOT NULL, max_stale_ttl INTEGER UNSIGNED NOT NULL, snapshot_file VARCHAR(255) NOT NULL, snapshot_interval_s INTEGER UNSIGNED NOT NULL, root_zone_file VARCHAR(255) NOT NULL, root_zone_refresh_s INTEGER UNSIGNED NOT NULL)"));
+        o_table_sql[sqlite_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER UNSIGNED NOT NULL, cache_garbage_collect_ms INTEGER UNSIGNED NOT NULL, cache_max_referral_kb INTEGER UNSIGNED NOT NULL, cache_max_answer_kb INTEGER UNSIGNED NOT NULL, cache_shards INTEGER UNSIGNED NOT NULL, prefetch_min_hits INTEGER UNSIGNED NOT NULL, prefetch_ttl_pct INTEGER UNSIGNED NOT NULL, serve_stale BOOLEAN NOT NULL, stale_answer_ttl INTEGER UNSIGNED NOT NULL, max_stale_ttl INTEGER UNSIGNED NOT NULL, snapshot_file VARCHAR(255) NOT NULL, snapshot_interval_s INTEGER UNSIGNED NOT NULL, root_zone_file VARCHAR(255) NOT NULL, root_zone_refresh_s INTEGER UNSIGNED NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(cache_config_e, "cache_config"));
-        o_table_sql[postgres_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER NOT NULL, cache_garbage_collect_ms INTEGER NOT NULL, cache_max_referral_rrs INTEGER NOT NULL, cache_max_answer_rrs INTEGER NOT NULL)"));
+        o_table_sql[postgres_e].push_back(pair<table_t, string>(cache_config_e, "CREATE TABLE cache_config(cache_config_id VARCHAR(36) NOT NULL PRIMARY KEY, client_id VARCHAR(36) NOT NULL, default_ttl INTEGER NOT NULL, cache_garbage_collect_ms INTEGER NOT NULL, cache_max_referral_kb INTEGER NOT NULL, cache_max_answer_kb INTEGER NOT NULL, cache_shards INTEGER NOT NULL, prefetch_min_hits INTEGER NOT NULL, prefetch_ttl_pct INTEGER NOT NULL, serve_stale BOOLEAN NOT NULL, stale_answer_ttl INTEGER NOT NULL, max_stale_ttl INTEGER NOT NULL, snapshot_file VARCHAR(255) NOT NULL, snapshot_interval_s INTEGER NOT NULL, root_zone_file VARCHAR(255) NOT NULL, root_zone_refresh_s INTEGER NOT NULL)"));
         o_table_sql[mysql_e].push_back(pair<table_t, string>(control_server_e, "CREATE TABLE control_server(address_list_id VARCHAR(36) NOT NULL, allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_connection_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_payload_size INTEGER UNSIGNED NOT NULL, num_threads INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, use_ssl BOOLEAN NOT NULL)"));
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(control_server_e, "CREATE TABLE control_server(address_list_id VARCHAR(36) NOT NULL, allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_connection_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_payload_size INTEGER UNSIGNED NOT NULL, num_threads INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, use_ssl BOOLEAN NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(control_server_e, "control_server"));
@@ -117,10 +118,10 @@ list<pair<table::table_t, string>> table::get_table_sql(type_t db_type)
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(dns_client_e, "CREATE TABLE dns_client(client_id VARCHAR(36) NOT NULL PRIMARY KEY, connect_tcp_timeout_ms INTEGER UNSIGNED NOT NULL, num_parallel_udp INTEGER UNSIGNED NOT NULL, read_tcp_timeout_ms INTEGER UNSIGNED NOT NULL, server_port INTEGER UNSIGNED NOT NULL, total_timeout_ms INTEGER UNSIGNED NOT NULL, udp_timeout_ms INTEGER UNSIGNED NOT NULL, use_ip4 BOOLEAN NOT NULL, use_ip6 BOOLEAN NOT NULL, use_tcp BOOLEAN NOT NULL, use_udp BOOLEAN NOT NULL, wait_udp_response_ms INTEGER UNSIGNED NOT NULL, write_tcp_timeout_ms INTEGER UNSIGNED NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(dns_client_e, "dns_client"));
         o_table_sql[postgres_e].push_back(pair<table_t, string>(dns_client_e, "CREATE TABLE dns_client(client_id VARCHAR(36) NOT NULL PRIMARY KEY, connect_tcp_timeout_ms INTEGER NOT NULL, num_parallel_udp INTEGER NOT NULL, read_tcp_timeout_ms INTEGER NOT NULL, server_port INTEGER NOT NULL, total_timeout_ms INTEGER NOT NULL, udp_timeout_ms INTEGER NOT NULL, use_ip4 BOOLEAN NOT NULL, use_ip6 BOOLEAN NOT NULL, use_tcp BOOLEAN NOT NULL, use_udp BOOLEAN NOT NULL, wait_udp_response_ms INTEGER NOT NULL, write_tcp_timeout_ms INTEGER NOT NULL)"));
-        o_table_sql[mysql_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER UNSIGNED NOT NULL, max_in_message_queue_length INTEGER UNSIGNED NOT NULL, max_out_message_queue_length INTEGER UNSIGNED NOT NULL, max_queued_per_question INTEGER UNSIGNED NOT NULL, max_recursion_depth INTEGER UNSIGNED NOT NULL, min_cache_ttl INTEGER UNSIGNED NOT NULL, num_forwarding_threads INTEGER UNSIGNED NOT NULL, num_receive_threads INTEGER UNSIGNED NOT NULL, num_send_threads INTEGER UNSIGNED NOT NULL, num_tcp_recursive_slots INTEGER UNSIGNED NOT NULL, num_tcp_threads INTEGER UNSIGNED NOT NULL, num_udp_recursive_slots INTEGER UNSIGNED NOT NULL, num_udp_threads INTEGER UNSIGNED NOT NULL, recursive_timeout_ms INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER UNSIGNED NOT NULL, tcp_max_len_wait_ms INTEGER UNSIGNED NOT NULL, udp_reply_timeout_ms INTEGER UNSIGNED NOT NULL, udp_retry_count INTEGER UNSIGNED NOT NULL, doh_client_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_http_request_size INTEGER UNSIGNED NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER UNSIGNED NOT NULL, forward_cache_max_entries INTEGER UNSIGNED NOT NULL, forward_cache_garbage_collect_pct INTEGER UNSIGNED NOT NULL)"));
-        o_table_sql[sqlite_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER UNSIGNED NOT NULL, max_in_message_queue_length INTEGER UNSIGNED NOT NULL, max_out_message_queue_length INTEGER UNSIGNED NOT NULL, max_queued_per_question INTEGER UNSIGNED NOT NULL, max_recursion_depth INTEGER UNSIGNED NOT NULL, min_cache_ttl INTEGER UNSIGNED NOT NULL, num_forwarding_threads INTEGER UNSIGNED NOT NULL, num_receive_threads INTEGER UNSIGNED NOT NULL, num_send_threads INTEGER UNSIGNED NOT NULL, num_tcp_recursive_slots INTEGER UNSIGNED NOT NULL, num_tcp_threads INTEGER UNSIGNED NOT NULL, num_udp_recursive_slots INTEGER UNSIGNED NOT NULL, num_udp_threads INTEGER UNSIGNED NOT NULL, recursive_timeout_ms INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER UNSIGNED NOT NULL, tcp_max_len_wait_ms INTEGER UNSIGNED NOT NULL, udp_reply_timeout_ms INTEGER UNSIGNED NOT NULL, udp_retry_count INTEGER UNSIGNED NOT NULL, doh_client_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_http_request_size INTEGER UNSIGNED NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER UNSIGNED NOT NULL, forward_cache_max_entries INTEGER UNSIGNED NOT NULL, forward_cache_garbage_collect_pct INTEGER UNSIGNED NOT NULL)"));
+        o_table_sql[mysql_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER UNSIGNED NOT NULL, max_in_message_queue_length INTEGER UNSIGNED NOT NULL, max_out_message_queue_length INTEGER UNSIGNED NOT NULL, max_queued_per_question INTEGER UNSIGNED NOT NULL, max_recursion_depth INTEGER UNSIGNED NOT NULL, min_cache_ttl INTEGER UNSIGNED NOT NULL, num_forwarding_threads INTEGER UNSIGNED NOT NULL, num_receive_threads INTEGER UNSIGNED NOT NULL, num_send_threads INTEGER UNSIGNED NOT NULL, num_tcp_recursive_slots INTEGER UNSIGNED NOT NULL, num_tcp_threads INTEGER UNSIGNED NOT NULL, num_udp_recursive_slots INTEGER UNSIGNED NOT NULL, num_udp_threads INTEGER UNSIGNED NOT NULL, recursive_timeout_ms INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER UNSIGNED NOT NULL, tcp_max_len_wait_ms INTEGER UNSIGNED NOT NULL, udp_reply_timeout_ms INTEGER UNSIGNED NOT NULL, udp_retry_count INTEGER UNSIGNED NOT NULL, doh_client_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_http_request_size INTEGER UNSIGNED NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER UNSIGNED NOT NULL, forward_cache_max_entries INTEGER UNSIGNED NOT NULL, forward_cache_garbage_collect_pct INTEGER UNSIGNED NOT NULL, receive_thread_cpus VARCHAR(255) NOT NULL, handler_thread_cpus VARCHAR(255) NOT NULL, send_thread_cpus VARCHAR(255) NOT NULL, num_recursive_threads INTEGER UNSIGNED NOT NULL, forward_max_in_flight INTEGER UNSIGNED NOT NULL, forward_hedge_queries BOOLEAN NOT NULL, max_queue_wait_ms INTEGER UNSIGNED NOT NULL, queue_shed_policy VARCHAR(16) NOT NULL, max_tcp_connections INTEGER UNSIGNED NOT NULL, max_tcp_queries_in_flight INTEGER UNSIGNED NOT NULL, max_doh_streams INTEGER UNSIGNED NOT NULL)"));
+        o_table_sql[sqlite_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER UNSIGNED NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER UNSIGNED NOT NULL, max_in_message_queue_length INTEGER UNSIGNED NOT NULL, max_out_message_queue_length INTEGER UNSIGNED NOT NULL, max_queued_per_question INTEGER UNSIGNED NOT NULL, max_recursion_depth INTEGER UNSIGNED NOT NULL, min_cache_ttl INTEGER UNSIGNED NOT NULL, num_forwarding_threads INTEGER UNSIGNED NOT NULL, num_receive_threads INTEGER UNSIGNED NOT NULL, num_send_threads INTEGER UNSIGNED NOT NULL, num_tcp_recursive_slots INTEGER UNSIGNED NOT NULL, num_tcp_threads INTEGER UNSIGNED NOT NULL, num_udp_recursive_slots INTEGER UNSIGNED NOT NULL, num_udp_threads INTEGER UNSIGNED NOT NULL, recursive_timeout_ms INTEGER UNSIGNED NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER UNSIGNED NOT NULL, tcp_max_len_wait_ms INTEGER UNSIGNED NOT NULL, udp_reply_timeout_ms INTEGER UNSIGNED NOT NULL, udp_retry_count INTEGER UNSIGNED NOT NULL, doh_client_timeout_ms INTEGER UNSIGNED NOT NULL, maximum_http_request_size INTEGER UNSIGNED NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER UNSIGNED NOT NULL, forward_cache_max_entries INTEGER UNSIGNED NOT NULL, forward_cache_garbage_collect_pct INTEGER UNSIGNED NOT NULL, receive_thread_cpus VARCHAR(255) NOT NULL, handler_thread_cpus VARCHAR(255) NOT NULL, send_thread_cpus VARCHAR(255) NOT NULL, num_recursive_threads INTEGER UNSIGNED NOT NULL, forward_max_in_flight INTEGER UNSIGNED NOT NULL, forward_hedge_queries BOOLEAN NOT NULL, max_queue_wait_ms INTEGER UNSIGNED NOT NULL, queue_shed_policy VARCHAR(16) NOT NULL, max_tcp_connections INTEGER UNSIGNED NOT NULL, max_tcp_queries_in_flight INTEGER UNSIGNED NOT NULL, max_doh_streams INTEGER UNSIGNED NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(dns_server_e, "dns_server"));
-        o_table_sql[postgres_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER NOT NULL, max_in_message_queue_length INTEGER NOT NULL, max_out_message_queue_length INTEGER NOT NULL, max_queued_per_question INTEGER NOT NULL, max_recursion_depth INTEGER NOT NULL, min_cache_ttl INTEGER NOT NULL, num_forwarding_threads INTEGER NOT NULL, num_receive_threads INTEGER NOT NULL, num_send_threads INTEGER NOT NULL, num_tcp_recursive_slots INTEGER NOT NULL, num_tcp_threads INTEGER NOT NULL, num_udp_recursive_slots INTEGER NOT NULL, num_udp_threads INTEGER NOT NULL, recursive_timeout_ms INTEGER NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER NOT NULL, tcp_max_len_wait_ms INTEGER NOT NULL, udp_reply_timeout_ms INTEGER NOT NULL, udp_retry_count INTEGER NOT NULL, doh_client_timeout_ms INTEGER NOT NULL, maximum_http_request_size INTEGER NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER NOT NULL, forward_cache_max_entries INTEGER NOT NULL, forward_cache_garbage_collect_pct INTEGER NOT NULL)"));
+        o_table_sql[postgres_e].push_back(pair<table_t, string>(dns_server_e, "CREATE TABLE dns_server(allowed_connection_backlog INTEGER NOT NULL, client_id VARCHAR(36) NOT NULL, max_external_resolutions INTEGER NOT NULL, max_in_message_queue_length INTEGER NOT NULL, max_out_message_queue_length INTEGER NOT NULL, max_queued_per_question INTEGER NOT NULL, max_recursion_depth INTEGER NOT NULL, min_cache_ttl INTEGER NOT NULL, num_forwarding_threads INTEGER NOT NULL, num_receive_threads INTEGER NOT NULL, num_send_threads INTEGER NOT NULL, num_tcp_recursive_slots INTEGER NOT NULL, num_tcp_threads INTEGER NOT NULL, num_udp_recursive_slots INTEGER NOT NULL, num_udp_threads INTEGER NOT NULL, recursive_timeout_ms INTEGER NOT NULL, server_id VARCHAR(36) NOT NULL PRIMARY KEY, tcp_max_body_wait_ms INTEGER NOT NULL, tcp_max_len_wait_ms INTEGER NOT NULL, udp_reply_timeout_ms INTEGER NOT NULL, udp_retry_count INTEGER NOT NULL, doh_client_timeout_ms INTEGER NOT NULL, maximum_http_request_size INTEGER NOT NULL, doh_path VARCHAR(255) NOT NULL, use_forwarding_cache BOOLEAN NOT NULL, use_forwarding_emergency_cache BOOLEAN NOT NULL, forward_cache_max_age_seconds INTEGER NOT NULL, forward_cache_max_entries INTEGER NOT NULL, forward_cache_garbage_collect_pct INTEGER NOT NULL, receive_thread_cpus VARCHAR(255) NOT NULL, handler_thread_cpus VARCHAR(255) NOT NULL, send_thread_cpus VARCHAR(255) NOT NULL, num_recursive_threads INTEGER NOT NULL, forward_max_in_flight INTEGER NOT NULL, forward_hedge_queries BOOLEAN NOT NULL, max_queue_wait_ms INTEGER NOT NULL, queue_shed_policy VARCHAR(16) NOT NULL, max_tcp_connections INTEGER NOT NULL, max_tcp_queries_in_flight INTEGER NOT NULL, max_doh_streams INTEGER NOT NULL)"));
         o_table_sql[mysql_e].push_back(pair<table_t, string>(horizon_e, "CREATE TABLE horizon(address_list_id VARCHAR(36) NOT NULL, allow_recursion BOOLEAN NOT NULL, horizon_id VARCHAR(36) NOT NULL PRIMARY KEY, check_order INTEGER UNSIGNED NOT NULL)"));
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(horizon_e, "CREATE TABLE horizon(address_list_id VARCHAR(36) NOT NULL, allow_recursion BOOLEAN NOT NULL, horizon_id VARCHAR(36) NOT NULL PRIMARY KEY, check_order INTEGER UNSIGNED NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(horizon_e, "horizon"));
@@ -141,6 +142,10 @@ list<pair<table::table_t, string>> table::get_table_sql(type_t db_type)
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(zone_e, "CREATE TABLE zone(forward_ip_address VARCHAR(45) NULL, forward_port INTEGER UNSIGNED NULL, horizon_id VARCHAR(36) NOT NULL, is_forwarded BOOLEAN NOT NULL, name VARCHAR(255) NOT NULL, zone_id VARCHAR(36) NOT NULL PRIMARY KEY)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(zone_e, "zone"));
         o_table_sql[postgres_e].push_back(pair<table_t, string>(zone_e, "CREATE TABLE zone(forward_ip_address VARCHAR(45) NULL, forward_port INTEGER NULL, horizon_id VARCHAR(36) NOT NULL, is_forwarded BOOLEAN NOT NULL, name VARCHAR(255) NOT NULL, zone_id VARCHAR(36) NOT NULL PRIMARY KEY)"));
+        o_table_sql[mysql_e].push_back(pair<table_t, string>(zone_forwarder_e, "CREATE TABLE zone_forwarder(zone_forwarder_id VARCHAR(36) NOT NULL PRIMARY KEY, zone_id VARCHAR(36) NOT NULL, ip_address VARCHAR(45) NOT NULL, port INTEGER UNSIGNED NOT NULL, weight INTEGER UNSIGNED NOT NULL, use_tls BOOLEAN NOT NULL)"));
+        o_table_sql[sqlite_e].push_back(pair<table_t, string>(zone_forwarder_e, "CREATE TABLE zone_forwarder(zone_forwarder_id VARCHAR(36) NOT NULL PRIMARY KEY, zone_id VARCHAR(36) NOT NULL, ip_address VARCHAR(45) NOT NULL, port INTEGER UNSIGNED NOT NULL, weight INTEGER UNSIGNED NOT NULL, use_tls BOOLEAN NOT NULL)"));
+        o_table_sql[mongodb_e].push_back(pair<table_t, string>(zone_forwarder_e, "zone_forwarder"));
+        o_table_sql[postgres_e].push_back(pair<table_t, string>(zone_forwarder_e, "CREATE TABLE zone_forwarder(zone_forwarder_id VARCHAR(36) NOT NULL PRIMARY KEY, zone_id VARCHAR(36) NOT NULL, ip_address VARCHAR(45) NOT NULL, port INTEGER NOT NULL, weight INTEGER NOT NULL, use_tls BOOLEAN NOT NULL)"));
         o_table_sql[mysql_e].push_back(pair<table_t, string>(rr_a_e, "CREATE TABLE rr_a(ip4_addr VARCHAR(15) NOT NULL, name VARCHAR(255) NOT NULL, rr_a_id VARCHAR(36) NOT NULL PRIMARY KEY, ttl INTEGER UNSIGNED NOT NULL, zone_id VARCHAR(36) NOT NULL)"));
         o_table_sql[sqlite_e].push_back(pair<table_t, string>(rr_a_e, "CREATE TABLE rr_a(ip4_addr VARCHAR(15) NOT NULL, name VARCHAR(255) NOT NULL, rr_a_id VARCHAR(36) NOT NULL PRIMARY KEY, ttl INTEGER UNSIGNED NOT NULL, zone_id VARCHAR(36) NOT NULL)"));
         o_table_sql[mongodb_e].push_back(pair<table_t, string>(rr_a_e, "rr_a"));
@@ -384,6 +389,15 @@ list<pair<table::table_t, list<string>>> table::get_index_sql(type_t db_type)
         o_index_sql[postgres_e].back().second.push_back("CREATE INDEX i_zone_horizon_id ON zone(horizon_id)");
         o_index_sql[mongodb_e].back().second.push_back("{\"table\": \"zone\", \"column\": \"zone_id\", \"unique\": true}");
         o_index_sql[mongodb_e].back().second.push_back("{\"table\": \"zone\", \"column\": \"horizon_id\", \"unique\": false}");
+        o_index_sql[mysql_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_index_sql[sqlite_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_index_sql[mongodb_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_index_sql[postgres_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_index_sql[mysql_e].back().second.push_back("CREATE INDEX i_zone_forwarder_zone_id ON zone_forwarder(zone_id)");
+        o_index_sql[sqlite_e].back().second.push_back("CREATE INDEX i_zone_forwarder_zone_id ON zone_forwarder(zone_id)");
+        o_index_sql[postgres_e].back().second.push_back("CREATE INDEX i_zone_forwarder_zone_id ON zone_forwarder(zone_id)");
+        o_index_sql[mongodb_e].back().second.push_back("{\"table\": \"zone_forwarder\", \"column\": \"zone_forwarder_id\", \"unique\": true}");
+        o_index_sql[mongodb_e].back().second.push_back("{\"table\": \"zone_forwarder\", \"column\": \"zone_id\", \"unique\": false}");
         o_index_sql[mysql_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
         o_index_sql[sqlite_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
         o_index_sql[mongodb_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
@@ -731,6 +745,9 @@ list<pair<table::table_t, list<string>>> table::get_foreign_key_sql(type_t db_ty
         o_fk_sql[mysql_e].push_back(pair<table_t, list<string>>(zone_e, list<string>()));
         o_fk_sql[sqlite_e].push_back(pair<table_t, list<string>>(zone_e, list<string>()));
         o_fk_sql[postgres_e].push_back(pair<table_t, list<string>>(zone_e, list<string>()));
+        o_fk_sql[mysql_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_fk_sql[sqlite_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
+        o_fk_sql[postgres_e].push_back(pair<table_t, list<string>>(zone_forwarder_e, list<string>()));
         o_fk_sql[mysql_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
         o_fk_sql[sqlite_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
         o_fk_sql[postgres_e].push_back(pair<table_t, list<string>>(rr_a_e, list<string>()));
@@ -1265,8 +1282,18 @@ void table::create_static(connection &conn)
         _cache_config.set_client_id(client_id_0);
         _cache_config.set_default_ttl(300);
         _cache_config.set_cache_garbage_collect_ms(60000);
-        _cache_config.set_cache_max_referral_rrs(10000);
-        _cache_config.set_cache_max_answer_rrs(10000);
+        _cache_config.set_cache_max_referral_kb(16384);
+        _cache_config.set_cache_max_answer_kb(65536);
+        _cache_config.set_cache_shards(16);
+        _cache_config.set_prefetch_min_hits(10);
+        _cache_config.set_prefetch_ttl_pct(10);
+        _cache_config.set_serve_stale(false);
+        _cache_config.set_stale_answer_ttl(30);
+        _cache_config.set_max_stale_ttl(86400);
+        _cache_config.set_snapshot_file("");
+        _cache_config.set_snapshot_interval_s(300);
+        _cache_config.set_root_zone_file("");
+        _cache_config.set_root_zone_refresh_s(3600);
         _cache_config.insert_row(conn);
     }
     {
@@ -1300,6 +1327,17 @@ void table::create_static(connection &conn)
         _dns_server.set_forward_cache_garbage_collect_pct(90);
         _dns_server.set_maximum_http_request_size(4000);
         _dns_server.set_doh_path("/dns-query");
+        _dns_server.set_receive_thread_cpus("");
+        _dns_server.set_handler_thread_cpus("");
+        _dns_server.set_send_thread_cpus("");
+        _dns_server.set_num_recursive_threads(2);
+        _dns_server.set_forward_max_in_flight(256);
+        _dns_server.set_forward_hedge_queries(false);
+        _dns_server.set_max_queue_wait_ms(1500);
+        _dns_server.set_queue_shed_policy("shed_lowest");
+        _dns_server.set_max_tcp_connections(10000);
+        _dns_server.set_max_tcp_queries_in_flight(64);
+        _dns_server.set_max_doh_streams(100);
         _dns_server.insert_row(conn);
     }
     {
@@ -1333,6 +1371,17 @@ void table::create_static(connection &conn)
         _dns_server.set_forward_cache_garbage_collect_pct(90);
         _dns_server.set_maximum_http_request_size(4000);
         _dns_server.set_doh_path("/dns-query");
+        _dns_server.set_receive_thread_cpus("");
+        _dns_server.set_handler_thread_cpus("");
+        _dns_server.set_send_thread_cpus("");
+        _dns_server.set_num_recursive_threads(2);
+        _dns_server.set_forward_max_in_flight(256);
+        _dns_server.set_forward_hedge_queries(false);
+        _dns_server.set_max_queue_wait_ms(1500);
+        _dns_server.set_queue_shed_policy("shed_lowest");
+        _dns_server.set_max_tcp_connections(10000);
+        _dns_server.set_max_tcp_queries_in_flight(64);
+        _dns_server.set_max_doh_streams(100);
         _dns_server.insert_row(conn);
     }
     {
@@ -1366,6 +1415,17 @@ void table::create_static(connection &conn)
         _dns_server.set_forward_cache_garbage_collect_pct(90);
         _dns_server.set_maximum_http_request_size(4000);
         _dns_server.set_doh_path("/dns-query");
+        _dns_server.set_receive_thread_cpus("");
+        _dns_server.set_handler_thread_cpus("");
+        _dns_server.set_send_thread_cpus("");
+        _dns_server.set_num_recursive_threads(2);
+        _dns_server.set_forward_max_in_flight(256);
+        _dns_server.set_forward_hedge_queries(false);
+        _dns_server.set_max_queue_wait_ms(1500);
+        _dns_server.set_queue_shed_policy("shed_lowest");
+        _dns_server.set_max_tcp_connections(10000);
+        _dns_server.set_max_tcp_queries_in_flight(64);
+        _dns_server.set_max_doh_streams(100);
         _dns_server.insert_row(conn);
     }
     {
@@ -1399,6 +1459,17 @@ void table::create_static(connection &conn)
         _dns_server.set_forward_cache_garbage_collect_pct(90);
         _dns_server.set_maximum_http_request_size(4000);
         _dns_server.set_doh_path("/dns-query");
+        _dns_server.set_receive_thread_cpus("");
+        _dns_server.set_handler_thread_cpus("");
+        _dns_server.set_send_thread_cpus("");
+        _dns_server.set_num_recursive_threads(2);
+        _dns_server.set_forward_max_in_flight(256);
+        _dns_server.set_forward_hedge_queries(false);
+        _dns_server.set_max_queue_wait_ms(1500);
+        _dns_server.set_queue_shed_policy("shed_lowest");
+        _dns_server.set_max_tcp_connections(10000);
+        _dns_server.set_max_tcp_queries_in_flight(64);
+        _dns_server.set_max_doh_streams(100);
         _dns_server.insert_row(conn);
     }
     {
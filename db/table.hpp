@@ -53,6 +53,7 @@ namespace adns
                 server_e,
                 server_socket_address_e,
                 zone_e,
+                zone_forwarder_e,
                 rr_a_e,
                 rr_aaaa_e,
                 rr_afsdb_e,
@@ -28,7 +28,7 @@ using namespace std;
 using namespace adns;
 using namespace boost::log::trivial;
 
-http::http(usage_t u, tcp_socket &s, uint timeout)
+http::http(usage_t u, tcp_socket &s, uint timeout, uint max_streams)
 {
     if ((s.get_protocol() == tcp_socket::http_1_1_e) || (s.get_protocol() == tcp_socket::none_e))
     {
@@ -36,7 +36,7 @@ http::http(usage_t u, tcp_socket &s, uint timeout)
     }
     else if (s.get_protocol() == tcp_socket::http_2_e)
     {
-        m_protocol = new http2(u, s, timeout);
+        m_protocol = new http2(u, s, timeout, max_streams);
     }
     else
     {
@@ -63,3 +63,13 @@ bool http::keep_alive()
 {
     return m_protocol->keep_alive();
 }
+
+bool http::is_multiplexed()
+{
+    return m_protocol->is_multiplexed();
+}
+
+vector<shared_ptr<http_request>> http::from_wire_available()
+{
+    return m_protocol->from_wire_available();
+}
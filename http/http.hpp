@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "types.hpp"
 #include "exception.hpp"
@@ -34,6 +35,7 @@ EXCEPTION_CLASS(http_header_line_too_long, http_exception)
 EXCEPTION_CLASS(http_bad_format_exception, http_exception)
 
 #define HTTP_MAX_HEADER_LINE_LENGTH 1000
+#define HTTP_DEFAULT_MAX_STREAMS 100
 
 namespace adns
 {
@@ -54,9 +56,10 @@ namespace adns
         /**
          * new HTTP session. Note that this is stateful and designed to live for the length
          * of the HTTP connection. HTTP 1.1 and HTTP 2 are handled with the protocol choice
-         * coming from the socket and negotiated at connection time (ALPN).
+         * coming from the socket and negotiated at connection time (ALPN). For HTTP 2 the
+         * client is limited to max_streams requests in progress at once.
          */
-        http(usage_t u, tcp_socket &s, uint timeout);
+        http(usage_t u, tcp_socket &s, uint timeout, uint max_streams = HTTP_DEFAULT_MAX_STREAMS);
 
         /**
          * cleanup
@@ -80,6 +83,18 @@ namespace adns
          */
         bool keep_alive();
 
+        /**
+         * can several requests be in progress at once and answered in any order (true for
+         * HTTP 2)?
+         */
+        bool is_multiplexed();
+
+        /**
+         * Read whatever is available from a non-blocking socket without waiting and return 
+         * any requests it completes, possibly none. Only for multiplexed sessions.
+         */
+        std::vector<std::shared_ptr<http_request>> from_wire_available();
+
     private:
 
         http_impl *m_protocol;
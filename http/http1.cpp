@@ -17,6 +17,9 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
  
+#include <algorithm>
+#include <cstring>
+
 #include <boost/lexical_cast.hpp>
 
 #include "types.hpp"
@@ -29,7 +32,10 @@ using namespace std;
 using namespace adns;
 using namespace boost::log::trivial;
 
-http1::http1(http::usage_t u, tcp_socket &s, uint timeout) : m_usage(u), m_socket(s), m_timeout(timeout), m_keep_alive(false)
+// how much to ask the socket for in one go when filling the input buffer
+#define HTTP1_READ_CHUNK_SIZE 16384
+
+http1::http1(http::usage_t u, tcp_socket &s, uint timeout) : m_usage(u), m_socket(s), m_timeout(timeout), m_keep_alive(false), m_in_pos(0)
 {
 }
 
@@ -37,51 +43,83 @@ http1::~http1()
 {
 }
 
-string http1::read_line()
+void http1::fill()
 {
-    string res;
+    if (m_in_pos > 0)
+    {
+        m_in.erase(m_in.begin(), m_in.begin() + m_in_pos);
+        m_in_pos = 0;
+    }
+
+    size_t used = m_in.size();
+
+    m_in.resize(used + HTTP1_READ_CHUNK_SIZE);
+
+    try
+    {
+        m_in.resize(used + m_socket.read_available(m_in.data() + used, HTTP1_READ_CHUNK_SIZE, m_timeout));
+    }
+    catch (...)
+    {
+        m_in.resize(used);
+        throw;
+    }
+}
 
-    res.reserve(HTTP_MAX_HEADER_LINE_LENGTH);
+string http1::read_line()
+{
+    // how far into the unused data has already been searched for the end of line
+    size_t scanned = 0;
 
-    while (res.size() < HTTP_MAX_HEADER_LINE_LENGTH)
+    while (true)
     {
-        buffer b = m_socket.read(1, m_timeout);
-        if (b.get_size() == 1)
+        auto start = m_in.begin() + m_in_pos;
+        auto eol = find(start + scanned, m_in.end(), '\n');
+
+        if (eol != m_in.end())
         {
-            char c = static_cast<char>(b.get_data()[0]);
-            if (c == '\n')
-            {
-                if (res.size() > 0 && res.back() == '\r')
-                {
-                    res.pop_back();
-                }
+            size_t length = eol - start;
 
-                return res;
+            if (length >= HTTP_MAX_HEADER_LINE_LENGTH)
+            {
+                THROW(http_header_line_too_long, "http header line exceeded maximum length", HTTP_MAX_HEADER_LINE_LENGTH);
             }
-            else    
+
+            string res(reinterpret_cast<const char *>(m_in.data() + m_in_pos), length);
+            m_in_pos += length + 1;
+
+            if (res.size() > 0 && res.back() == '\r')
             {
-                res += c;
+                res.pop_back();
             }
+
+            return res;
         }
-        else
+
+        scanned = m_in.size() - m_in_pos;
+
+        if (scanned >= HTTP_MAX_HEADER_LINE_LENGTH)
         {
-            THROW(http_bad_format_exception, "http line not terminated with CFLR");
+            THROW(http_header_line_too_long, "http header line exceeded maximum length", HTTP_MAX_HEADER_LINE_LENGTH);
         }
-    }
 
-    THROW(http_header_line_too_long, "http header line exceeded maximum length", HTTP_MAX_HEADER_LINE_LENGTH);
+        try
+        {
+            fill();
+        }
+        catch (tcp_socket_eof_exception &e)
+        {
+            if (scanned > 0)
+            {
+                THROW(http_bad_format_exception, "http line not terminated with CFLR");
+            }
+            throw;
+        }
+    }
 }
 
 void http1::to_wire(http_response &res)
 {
-    m_socket.write(buffer(
-                        "HTTP/1.1 " + 
-                        boost::lexical_cast<string>(res.get_status()) + 
-                        " " + 
-                        res.get_status_text() +
-                        "\r\n"), 
-                   m_timeout);
-
     string json_string;
 
     if (m_usage == http::api_e) 
@@ -97,21 +135,38 @@ void http1::to_wire(http_response &res)
         add_headers(m_usage, res, res.get_data().get_size());
     }
     
+    string head = "HTTP/1.1 " + boost::lexical_cast<string>(res.get_status()) + " " + res.get_status_text() + "\r\n";
+
     for (auto h : res.get_headers())
     {
-        m_socket.write(buffer(h.first + ": " + h.second + "\r\n"), m_timeout);
+        head += h.first + ": " + h.second + "\r\n";
     }
 
-    m_socket.write(buffer("\r\n"), m_timeout);
+    head += "\r\n";
+
+    const octet *body;
+    size_t body_size;
 
     if (m_usage == http::api_e)
     {
-        m_socket.write(buffer(json_string), m_timeout);
+        body = reinterpret_cast<const octet *>(json_string.data());
+        body_size = json_string.size();
     }
     else
     {
-        m_socket.write(res.get_data(), m_timeout);
+        body = res.get_data().get_data();
+        body_size = res.get_data().get_size();
     }
+
+    // status line, headers and body go out in a single write (and so a single TLS
+    // record where it fits) rather than one per line
+    vector<octet> out;
+
+    out.reserve(head.size() + body_size);
+    out.insert(out.end(), head.begin(), head.end());
+    out.insert(out.end(), body, body + body_size);
+
+    m_socket.write(out.data(), out.size(), m_timeout);
 }
 
 shared_ptr<http_request> http1::from_wire()
@@ -141,7 +196,20 @@ shared_ptr<http_request> http1::from_wire()
 
     if (ps > 0)
     {
-        res->m_raw_payload = m_socket.read(ps, m_timeout);
+        // some or all of the payload may have come in with the headers
+        size_t buffered = min(static_cast<size_t>(ps), m_in.size() - m_in_pos);
+
+        buffer payload(ps);
+        memcpy(payload.get_data(), m_in.data() + m_in_pos, buffered);
+        m_in_pos += buffered;
+
+        if (buffered < ps)
+        {
+            buffer rest = m_socket.read(ps - buffered, m_timeout);
+            memcpy(payload.get_data() + buffered, rest.get_data(), rest.get_size());
+        }
+
+        res->m_raw_payload = payload;
     }
 
     m_keep_alive = (res->get_header("connection") == "keep-alive");
@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "types.hpp"
 #include "exception.hpp"
@@ -80,10 +81,25 @@ namespace adns
         // keep alive value from last request
         bool m_keep_alive;
 
+        // data read from the socket but not yet used. The socket is read in chunks rather
+        // than a byte at a time so anything beyond the current request (e.g. a pipelined
+        // one) is left here for the next call to from_wire().
+        std::vector<octet> m_in;
+
+        // position of the first unused octet in m_in
+        size_t m_in_pos;
+
         /**
-         * read a single line of text from the socket
+         * read a single line of text from the input buffer, filling it from the socket 
+         * as needed
          */
         std::string read_line();
 
+        /**
+         * read whatever is available from the socket (waiting up to the timeout for at
+         * least something) onto the end of the input buffer
+         */
+        void fill();
+
     };
 }
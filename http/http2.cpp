@@ -68,6 +68,16 @@ int http2::on_frame_recv_callback(
     return o->on_frame_recv_callback(session, frame);
 }
 
+int http2::on_stream_close_callback(
+        nghttp2_session *session,
+        int32_t         stream_id,
+        uint32_t        error_code,
+        void            *http2_instance)
+{
+    http2 *o = reinterpret_cast<http2 *>(http2_instance);
+    return o->on_stream_close_callback(session, stream_id);
+}
+
 ssize_t http2::send_callback(
         nghttp2_session *session,
         const uint8_t   *data, 
@@ -163,8 +173,9 @@ int http2::on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame
 
     auto stream_id = frame->hd.stream_id;
 
-    if ((frame->hd.type == NGHTTP2_DATA) ||
-        ((frame->hd.type == NGHTTP2_HEADERS) && (m_content_length[stream_id] == 0)))
+    // the request is complete once the client has finished its side of the stream
+    if (((frame->hd.type == NGHTTP2_DATA) || (frame->hd.type == NGHTTP2_HEADERS)) &&
+        (frame->hd.flags & NGHTTP2_FLAG_END_STREAM))
     {
         auto m = m_headers[stream_id].find(":method");
 
@@ -180,23 +191,44 @@ int http2::on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame
             THROW(http_exception, ":path header missing");
         }
 
-        m_request = make_shared<http_request>(
+        m_requests.push_back(make_shared<http_request>(
                 m_socket.get_remote_address().get_ip_address(),
                 stream_id,
                 m_headers[stream_id],
                 m->second,
                 p->second,
                 url(p->second),
-                buffer(m_payload_bytes_read[stream_id], m_payload[stream_id]));
+                buffer(m_payload_bytes_read[stream_id], m_payload[stream_id])));
+    }
+
+    return 0;
+}
+
+int http2::on_stream_close_callback(nghttp2_session *session, int32_t stream_id)
+{
+    auto p = m_payload.find(stream_id);
+
+    if (p != m_payload.end())
+    {
+        delete [] p->second;
+        m_payload.erase(p);
     }
 
+    m_payload_bytes_read.erase(stream_id);
+    m_headers.erase(stream_id);
+    m_raw_method.erase(stream_id);
+    m_content_length.erase(stream_id);
+    m_path.erase(stream_id);
+    m_response_data.erase(stream_id);
+
     return 0;
 }
 
-http2::http2(http::usage_t u, tcp_socket &s, uint timeout) :
+http2::http2(http::usage_t u, tcp_socket &s, uint timeout, uint max_streams) :
                             m_usage(u),
                             m_socket(s), 
-                            m_timeout(timeout)
+                            m_timeout(timeout),
+                            m_eof(false)
 {
     if (m_usage == http::doh_e)
     {
@@ -214,6 +246,7 @@ http2::http2(http::usage_t u, tcp_socket &s, uint timeout) :
     nghttp2_session_callbacks_set_on_header_callback(callbacks, on_header_callback);
     nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, on_data_chunk_callback);
     nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, on_frame_recv_callback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, on_stream_close_callback);
 
     int r = nghttp2_session_server_new(&m_session, callbacks, this);
 
@@ -224,7 +257,9 @@ http2::http2(http::usage_t u, tcp_socket &s, uint timeout) :
         THROW(http_exception, "failed to create HTTP2 session");
     }
 
-    r = nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, NULL, 0);
+    nghttp2_settings_entry settings[] = { { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, max_streams } };
+
+    r = nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, settings, 1);
 
     if (r != 0) 
     {
@@ -260,9 +295,9 @@ ssize_t http2::read_data_callback(
                 nghttp2_data_source *source,
                 void                *user_data) 
 {
-    pair<size_t, buffer *> *br = (pair<size_t, buffer *> *)source->ptr;
+    pair<size_t, buffer> *br = (pair<size_t, buffer> *)source->ptr;
 
-    buffer *b = br->second; 
+    buffer *b = &br->second; 
     size_t bytes_read_so_far = br->first;
     size_t bytes_available = 0;
 
@@ -315,38 +350,56 @@ void http2::to_wire(http_response &res)
         make_nv(hdrs[n++], h.first, h.second);
     }
 
-    buffer b;
+    // the data has to stay around until the stream closes as the send may not complete
+    // in one go
+    auto &br = m_response_data[res.get_stream_id()];
+
+    br.first = 0;
 
     if (m_usage == http::api_e)
     {
-        b = buffer(json_string);
+        br.second = buffer(json_string);
     }
     else
     {
-        b = res.get_data();
+        br.second = res.get_data();
     }
 
-    pair<size_t, buffer *> br(0, &b);
-
     nghttp2_data_provider data_prd;
     data_prd.source.ptr = &br;
     data_prd.read_callback = read_data_callback;
 
     int r = nghttp2_submit_response(m_session, res.get_stream_id(), hdrs, n, &data_prd);
     
+    // clean up headers before the possibility of throwing anything
+    for (int i = 0; i < n; i++)
+    {
+        free(hdrs[i].name);
+        free(hdrs[i].value);
+    }
+
     if (r != 0)
     {
+        m_response_data.erase(res.get_stream_id());
         THROW(http_exception, "nghttp2_submit_response2 error", nghttp2_strerror(r));
     }
 
-    // clean up headers before the possibility of throwing anything
-    for (int i = 0; i < n; i++)
+    send();
+}
+
+void http2::receive(const octet *data, size_t length)
+{
+    int r = nghttp2_session_mem_recv(m_session, data, length);
+
+    if (r < 0) 
     {
-        free(hdrs[i].name);
-        free(hdrs[i].value);
+        THROW(http_exception, "nghttp2 session error", nghttp2_strerror(r));
     }
+}
 
-    r = nghttp2_session_send(m_session);
+void http2::send()
+{
+    int r = nghttp2_session_send(m_session);
 
     if (r != 0)
     {
@@ -356,30 +409,54 @@ void http2::to_wire(http_response &res)
 
 shared_ptr<http_request> http2::from_wire()
 {
-    m_request = nullptr;
+    octet data[HTTP2_READ_CHUNK_SIZE];
 
-    while (true)
+    while (m_requests.empty())
+    {
+        receive(data, m_socket.read_available(data, sizeof(data), m_timeout));
+        send();
+    }
+
+    auto res = m_requests.front();
+    m_requests.pop_front();
+
+    return res;
+}
+
+vector<shared_ptr<http_request>> http2::from_wire_available()
+{
+    if (m_eof)
     {
-        buffer b = m_socket.read(1, m_timeout);
-        if (b.get_size() > 0)
+        THROW(tcp_socket_eof_exception, "end of file");
+    }
+
+    octet data[HTTP2_READ_CHUNK_SIZE];
+    int n;
+
+    try
+    {
+        while ((n = m_socket.read_some(data, sizeof(data))) > 0)
         {
-            int r = nghttp2_session_mem_recv(m_session, b.get_data(), b.get_size());
-        
-            if (r < 0) 
-            {
-                THROW(http_exception, "nghttp2 session error", nghttp2_strerror(r));
-            }
-        
-            if (m_request)
-            {
-                return m_request;
-            }
+            receive(data, n);
         }
-        else
+
+        send();
+    }
+    catch (tcp_socket_eof_exception &e)
+    {
+        // hand over anything the client sent before closing, the end of file is reported
+        // next time
+        if (m_requests.empty())
         {
-            THROW(http_exception, "no request received");
+            throw;
         }
+        m_eof = true;
     }
+
+    vector<shared_ptr<http_request>> res(m_requests.begin(), m_requests.end());
+    m_requests.clear();
+
+    return res;
 }
 
 ssize_t http2::send_callback(
@@ -397,3 +474,8 @@ bool http2::keep_alive()
 {
     return true;
 }
+
+bool http2::is_multiplexed()
+{
+    return true;
+}
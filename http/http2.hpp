@@ -19,8 +19,11 @@
  
 #pragma once
 
+#include <map>
+#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <nghttp2/nghttp2.h>
 
@@ -36,6 +39,7 @@ EXCEPTION_CLASS(http2_exception, http_exception)
 EXCEPTION_CLASS(http2_invalid_stream_exception, http2_exception)
 
 #define HTTP2_MAX_HEADERS 100
+#define HTTP2_READ_CHUNK_SIZE 16384
 
 namespace adns
 {
@@ -46,9 +50,10 @@ namespace adns
         /**
          * new HTTP session. Note that this is stateful and designed to live for the length
          * of the HTTP connection. HTTP 1.1 and HTTP 2 are handled with the protocol choice
-         * coming from the socket and negotiated at connection time.
+         * coming from the socket and negotiated at connection time. The client is told it
+         * can have at most max_streams requests in progress at once.
          */
-        http2(http::usage_t u, tcp_socket &s, uint timeout);
+        http2(http::usage_t u, tcp_socket &s, uint timeout, uint max_streams = HTTP_DEFAULT_MAX_STREAMS);
 
         /**
          * cleanup
@@ -62,7 +67,8 @@ namespace adns
         std::shared_ptr<http_request> from_wire();
 
         /**
-         * Send a response to a stream socket. 
+         * Send a response to a stream socket. The response can be for any stream that's 
+         * still open, not just the one last read.
          */
         void to_wire(http_response &res);
 
@@ -71,6 +77,18 @@ namespace adns
          */
         bool keep_alive();
 
+        /**
+         * always true, each stream is a request in its own right
+         */
+        bool is_multiplexed();
+
+        /**
+         * Read whatever is available from a non-blocking socket without waiting and return 
+         * any requests it completes. Anything nghttp2 wants to send back as a result (settings
+         * acks, window updates etc.) is written before returning.
+         */
+        std::vector<std::shared_ptr<http_request>> from_wire_available();
+
     private:
 
         // what the session is being used for
@@ -101,8 +119,15 @@ namespace adns
         std::map<size_t, size_t>      m_content_length;
         std::map<size_t, std::string> m_path;
 
-        // request constructed by on_frame_recv_callback
-        std::shared_ptr<http_request> m_request;
+        // response data by stream, kept until the stream closes as nghttp2 may not send
+        // all of it straight away (flow control). First is the number of bytes sent so far.
+        std::map<size_t, std::pair<size_t, buffer>> m_response_data;
+
+        // complete requests constructed by on_frame_recv_callback, not yet returned
+        std::list<std::shared_ptr<http_request>> m_requests;
+
+        // the client closed the connection whilst there were requests still to return
+        bool m_eof;
 
         // callback which then calls the relevant member function when a header field is received
         static int on_header_callback(
@@ -130,6 +155,13 @@ namespace adns
             const nghttp2_frame *frame, 
             void                *http2_instance);
 
+        // callback which then calls the relevant member function when a stream is closed
+        static int on_stream_close_callback(
+            nghttp2_session *session,
+            int32_t         stream_id,
+            uint32_t        error_code,
+            void            *http2_instance);
+
         // callback for getting the data to be sent in a response. Note that user_data can't be set to
         // anything due to the limited nghttp2 data provider interface
         static ssize_t read_data_callback(
@@ -167,10 +199,22 @@ namespace adns
 
         int on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame *frame);
 
+        int on_stream_close_callback(nghttp2_session *session, int32_t stream_id);
+
         ssize_t send_callback(
             nghttp2_session *session, 
             const uint8_t   *data, 
             size_t          length, 
             int             flags);
+
+        /**
+         * pass data read from the socket to nghttp2
+         */
+        void receive(const octet *data, size_t length);
+
+        /**
+         * write whatever nghttp2 has queued up to send
+         */
+        void send();
     };
 }
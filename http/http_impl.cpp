@@ -35,6 +35,16 @@ http_impl::~http_impl()
 {
 }
 
+bool http_impl::is_multiplexed()
+{
+    return false;
+}
+
+vector<shared_ptr<http_request>> http_impl::from_wire_available()
+{
+    THROW(http_exception, "reading whatever is available is only supported for multiplexed protocols");
+}
+
 void http_impl::add_headers(http::usage_t u, http_response &res, int content_length)
 {
     datetime now = datetime::now();
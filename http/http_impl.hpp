@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "types.hpp"
 #include "tcp_socket.hpp"
@@ -63,6 +64,18 @@ namespace adns
          */
         virtual bool keep_alive() = 0;
 
+        /**
+         * can several requests be in progress at once and answered in any order? Not
+         * unless the protocol says so.
+         */
+        virtual bool is_multiplexed();
+
+        /**
+         * Read whatever is available from a non-blocking socket without waiting and return 
+         * any requests it completes. Throws unless the protocol is multiplexed.
+         */
+        virtual std::vector<std::shared_ptr<http_request>> from_wire_available();
+
     protected:
 
         /**
@@ -0,0 +1,122 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <string.h>
+
+#include "dns_rr.hpp"
+#include "dns_encoded_answer.hpp"
+
+using namespace std;
+using namespace adns;
+
+buffer dns_encoded_answer::patch_response(
+                    const vector<octet> &wire,
+                    size_t              question_end,
+                    const dns_message   &request, 
+                    const buffer        &raw_request, 
+                    bool                recursion_available, 
+                    unsigned short      edns_size,
+                    size_t              max_size,
+                    bool                &truncated)
+{
+    // root name, type, class (payload size), extended rcode/flags and rdlength
+    static const size_t opt_size = 11;
+
+    size_t extra = (edns_size > 0) ? opt_size : 0;
+
+    truncated = (wire.size() + extra) > max_size;
+
+    size_t size = truncated ? question_end : wire.size();
+
+    buffer res(size + extra);
+    octet *raw = res.get_data();
+
+    memcpy(raw, wire.data(), size);
+
+    uint id = request.get_id();
+    bool checking_disabled = (raw_request.get_size() >= 12) && ((raw_request.get_data()[3] & 0x10) != 0);
+
+    raw[0] = (id >> 8) & 0xff;
+    raw[1] = id & 0xff;
+    raw[2] = 0x80 | ((static_cast<uint>(request.get_op_code()) & 0x0f) << 3) | (wire[2] & 0x04) |
+             (truncated ? 0x02 : 0) | (request.get_is_recursion_desired() ? 0x01 : 0);
+    raw[3] = (recursion_available ? 0x80 : 0) | (checking_disabled ? 0x10 : 0) | (wire[3] & 0x0f);
+
+    if (truncated)
+    {
+        memset(raw + 6, 0, 6);
+    }
+
+    // echo the question back as it was asked (case and all) if it's laid out the same way
+    size_t qend = 12;
+    bool pointer = false;
+
+    if ((raw_request.get_size() >= question_end) && 
+        skip_name(raw_request.get_data(), raw_request.get_size(), qend, pointer) && 
+        !pointer && 
+        ((qend + 4) == question_end))
+    {
+        memcpy(raw + 12, raw_request.get_data() + 12, question_end - 12);
+    }
+
+    if (extra > 0)
+    {
+        octet *opt = raw + size;
+
+        memset(opt, 0, opt_size);
+        opt[2] = dns_rr::T_OPT_e;
+        opt[3] = (edns_size >> 8) & 0xff;
+        opt[4] = edns_size & 0xff;
+
+        uint arcount = ((raw[10] << 8) | raw[11]) + 1;
+
+        raw[10] = (arcount >> 8) & 0xff;
+        raw[11] = arcount & 0xff;
+    }
+
+    return res;
+}
+
+bool dns_encoded_answer::skip_name(const octet *raw, size_t size, size_t &offset, bool &pointer)
+{
+    pointer = false;
+
+    while (offset < size)
+    {
+        octet l = raw[offset];
+
+        if ((l & 0xc0) == 0xc0)
+        {
+            pointer = true;
+            offset += 2;
+            return offset <= size;
+        }
+
+        offset++;
+
+        if (l == 0)
+        {
+            return true;
+        }
+
+        offset += l;
+    }
+
+    return false;
+}
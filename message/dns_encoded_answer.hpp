@@ -0,0 +1,85 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "buffer.hpp"
+#include "dns_message.hpp"
+
+namespace adns
+{
+    /**
+     * An answer that already holds its records in wire format and can write a complete
+     * response straight into a buffer, without building a dns_message first.
+     */
+    class dns_encoded_answer
+    {
+    public:
+
+        /**
+         * destructor
+         */
+        virtual ~dns_encoded_answer() {}
+
+        /**
+         * Write a complete response to the request. The question is copied from the raw request 
+         * where possible so that the case of the name matches. If edns_size is non-zero then an 
+         * OPT record is added advertising that payload size. If the response won't fit in max_size
+         * octets then it's sent with the TC bit set and no records.
+         */
+        virtual buffer to_wire(
+                    const dns_message &request, 
+                    const buffer      &raw_request, 
+                    bool              recursion_available, 
+                    unsigned short    edns_size,
+                    size_t            max_size) const = 0;
+
+        /**
+         * the smallest TTL the response will carry if sent now
+         */
+        virtual uint get_min_ttl() const = 0;
+
+    protected:
+
+        /**
+         * Copy a response that was encoded without an OPT record for a request, patching in 
+         * the ID, opcode, RD and CD bits and the case of the question from the request. If it 
+         * won't fit in max_size then everything after the question is dropped and TC set. 
+         * @param OUT   truncated - set if the records were dropped
+         */
+        static buffer patch_response(
+                    const std::vector<octet> &wire,
+                    size_t                   question_end,
+                    const dns_message        &request, 
+                    const buffer             &raw_request, 
+                    bool                     recursion_available, 
+                    unsigned short           edns_size,
+                    size_t                   max_size,
+                    bool                     &truncated);
+
+        /**
+         * skip over a name in wire format, returns false if it runs off the end of the data. 
+         * pointer is set if the name ends in a compression pointer.
+         */
+        static bool skip_name(const octet *raw, size_t size, size_t &offset, bool &pointer);
+    };
+}
@@ -0,0 +1,91 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include "exception.hpp"
+#include "dns_message_parser.hpp"
+#include "dns_encoded_response.hpp"
+
+using namespace std;
+using namespace adns;
+
+dns_encoded_response::dns_encoded_response(const dns_message &response) : m_question_end(0), m_min_ttl(0)
+{
+    dns_message m(response);
+
+    m.set_edns(false, STANDARD_MESSAGE_SIZE);
+    m.set_min_ttl();
+    m_min_ttl = max(m.get_min_ttl(), 0);
+
+    buffer raw;
+
+    try
+    {
+        dns_message_parser p;
+        raw = p.to_wire(m, true, MAX_EXTENDED_MESSAGE_SIZE);
+    }
+    catch (adns::exception &e)
+    {
+        // leave it unencoded, the response will be sent the slow way
+        return;
+    }
+
+    const octet *w = raw.get_data();
+    size_t size = raw.get_size();
+    size_t offset = 12;
+    bool pointer;
+
+    if ((size < 12) || (((w[4] << 8) | w[5]) != 1) || !skip_name(w, size, offset, pointer) || (offset + 4 > size))
+    {
+        return;
+    }
+
+    m_wire.assign(w, w + size);
+    m_question_end = offset + 4;
+}
+
+dns_encoded_response::~dns_encoded_response()
+{
+}
+
+bool dns_encoded_response::is_encoded() const
+{
+    return !m_wire.empty();
+}
+
+buffer dns_encoded_response::to_wire(
+                    const dns_message &request, 
+                    const buffer      &raw_request, 
+                    bool              recursion_available, 
+                    unsigned short    edns_size,
+                    size_t            max_size) const
+{
+    if (m_wire.empty())
+    {
+        THROW(message_exception, "attempt to send a response that hasn't been encoded");
+    }
+
+    bool truncated;
+
+    return patch_response(m_wire, m_question_end, request, raw_request, recursion_available, edns_size, max_size, truncated);
+}
+
+uint dns_encoded_response::get_min_ttl() const
+{
+    return m_min_ttl;
+}
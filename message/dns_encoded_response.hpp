@@ -0,0 +1,70 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "dns_message.hpp"
+#include "dns_encoded_answer.hpp"
+
+namespace adns
+{
+    /**
+     * A complete response encoded once so that it can be sent to any number of requests
+     * for the same question, each copy only has its header and question patched.
+     */
+    class dns_encoded_response final : public dns_encoded_answer
+    {
+    public:
+
+        /**
+         * encode a response, check is_encoded() to see if it worked
+         */
+        dns_encoded_response(const dns_message &response);
+
+        /**
+         * destructor
+         */
+        virtual ~dns_encoded_response();
+
+        /**
+         * was the response encoded OK?
+         */
+        bool is_encoded() const;
+
+        buffer to_wire(
+                    const dns_message &request, 
+                    const buffer      &raw_request, 
+                    bool              recursion_available, 
+                    unsigned short    edns_size,
+                    size_t            max_size) const override;
+
+        uint get_min_ttl() const override;
+
+    private:
+
+        // the response without an OPT record and where the question ends in it
+        std::vector<octet> m_wire;
+        size_t             m_question_end;
+
+        uint m_min_ttl;
+    };
+}
@@ -46,6 +46,8 @@ dns_message::dns_message()
     m_is_edns = false;
     m_edns_version = 0;
     m_is_dnssec_ok = false;
+    m_tcp_keepalive = false;
+    m_tcp_keepalive_timeout = -1;
     m_min_ttl = -1;
 }
 
@@ -189,6 +191,11 @@ octet dns_message::get_edns_version() const
     return m_edns_version;
 }
 
+int dns_message::get_tcp_keepalive_timeout() const
+{
+    return m_tcp_keepalive_timeout;
+}
+
 dns_message::response_code_t dns_message::get_response_code() const
 {
     return m_response_code;
@@ -271,6 +278,11 @@ void dns_message::set_edns(bool b, unsigned short payload_size)
     m_payload_size = payload_size;
 }
 
+void dns_message::set_tcp_keepalive(bool b)
+{
+    m_tcp_keepalive = b;
+}
+
 const list<shared_ptr<dns_rr>> &dns_message::get_answers() const
 {
     return m_answers;
@@ -443,6 +455,8 @@ dns_message *dns_message::clone()
     res->m_is_edns = m_is_edns;
     res->m_is_dnssec_ok = m_is_dnssec_ok;
     res->m_edns_version = m_edns_version;
+    res->m_tcp_keepalive = m_tcp_keepalive;
+    res->m_tcp_keepalive_timeout = m_tcp_keepalive_timeout;
     res->m_response_code = m_response_code;
     res->m_an_count = m_an_count;
     res->m_ns_count = m_ns_count;
@@ -34,6 +34,7 @@
 #define MAX_DOMAIN_NAME_LENGTH 253
 #define MAX_DOMAIN_NAME_COMPONENTS 128
 #define EDNS_VERSION 0
+#define EDNS_OPTION_TCP_KEEPALIVE 11
 
 EXCEPTION_CLASS(message_exception, exception)
 
@@ -185,6 +186,12 @@ namespace adns
          */
         bool get_is_dnssec_ok() const;
 
+        /**
+         * Idle timeout in units of 100ms from an edns-tcp-keepalive option (RFC 7828) or -1
+         * if there wasn't one with a timeout in it.
+         */
+        int get_tcp_keepalive_timeout() const;
+
         /**
          * ANCOUNT - see RFC1035 4.1.1
          */
@@ -217,6 +224,7 @@ namespace adns
         void set_is_recursion_desired(bool b);
         void set_is_recursion_available(bool b);
         void set_edns(bool b, unsigned short payload_size);
+        void set_tcp_keepalive(bool b);
         void set_question(const std::shared_ptr<dns_question> &q);
 
         template<class RR> void add_answer(const std::shared_ptr<RR> &a)
@@ -347,6 +355,8 @@ namespace adns
         bool m_is_edns;
         bool m_is_dnssec_ok;
         octet m_edns_version;
+        bool m_tcp_keepalive;
+        int m_tcp_keepalive_timeout;
         response_code_t m_response_code;
         unsigned short m_an_count;
         unsigned short m_ns_count;
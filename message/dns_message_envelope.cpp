@@ -23,7 +23,14 @@
 using namespace std;
 using namespace adns;
 
-dns_message_envelope::dns_message_envelope() : m_channel(0), m_socket(nullptr), m_request(nullptr), m_response(nullptr)
+dns_message_envelope::dns_message_envelope() : 
+    m_channel(0), 
+    m_connection_id(0), 
+    m_prefetch(false), 
+    m_received_time(chrono::steady_clock::now()),
+    m_socket(nullptr), 
+    m_request(nullptr), 
+    m_response(nullptr)
 {
 }
 
@@ -33,7 +40,12 @@ dns_message_envelope::dns_message_envelope(const dns_message_envelope &other)
     m_remote_address = other.m_remote_address;
     m_socket = other.m_socket;
     m_channel = other.m_channel;
+    m_connection_id = other.m_connection_id;
     m_min_ttl = other.m_min_ttl;
+    m_prefetch = other.m_prefetch;
+    m_received_time = other.m_received_time;
+    m_encoded_answer = other.m_encoded_answer;
+    m_forwarders = other.m_forwarders;
 
     if (other.m_request != nullptr)
     {
@@ -61,11 +73,13 @@ dns_message_envelope::dns_message_envelope(
     m_raw(raw),
     m_remote_address(remote_address),
     m_channel(0),
+    m_connection_id(0),
     m_min_ttl(0),
+    m_prefetch(false),
+    m_received_time(chrono::steady_clock::now()),
     m_socket(s),
     m_request(nullptr), 
-    m_response(nullptr),
-    m_forward_port(0)
+    m_response(nullptr)
 {
 }
 
@@ -133,20 +147,24 @@ int dns_message_envelope::get_channel() const
     return m_channel;
 }
 
-void dns_message_envelope::set_forwarding(const ip_address &forward_ip, int forward_port)
+void dns_message_envelope::set_connection_id(uint64_t id)
+{
+    m_connection_id = id;
+}
+
+uint64_t dns_message_envelope::get_connection_id() const
 {
-    m_forward_ip = forward_ip;
-    m_forward_port = forward_port;
+    return m_connection_id;
 }
 
-const ip_address &dns_message_envelope::get_forwarding_address() const
+void dns_message_envelope::set_forwarding(const shared_ptr<const vector<dns_forwarder>> &forwarders)
 {
-    return m_forward_ip;
+    m_forwarders = forwarders;
 }
 
-int dns_message_envelope::get_forwarding_port() const
+const shared_ptr<const vector<dns_forwarder>> &dns_message_envelope::get_forwarders() const
 {
-    return m_forward_port;
+    return m_forwarders;
 }
 
 void dns_message_envelope::set_min_ttl(int min_ttl)
@@ -158,3 +176,33 @@ int dns_message_envelope::get_min_ttl() const
 {
     return m_min_ttl;
 }
+
+void dns_message_envelope::set_prefetch(bool prefetch)
+{
+    m_prefetch = prefetch;
+}
+
+bool dns_message_envelope::is_prefetch() const
+{
+    return m_prefetch;
+}
+
+void dns_message_envelope::set_encoded_answer(const shared_ptr<const dns_encoded_answer> &answer)
+{
+    m_encoded_answer = answer;
+}
+
+const shared_ptr<const dns_encoded_answer> &dns_message_envelope::get_encoded_answer() const
+{
+    return m_encoded_answer;
+}
+
+void dns_message_envelope::set_received_time(chrono::steady_clock::time_point t)
+{
+    m_received_time = t;
+}
+
+chrono::steady_clock::time_point dns_message_envelope::get_received_time() const
+{
+    return m_received_time;
+}
@@ -19,11 +19,16 @@
  
 #pragma once
 
+#include <vector>
+#include <chrono>
+
 #include "dns_message_parser.hpp"
 #include "types.hpp"
 #include "buffer.hpp"
 #include "socket_address.hpp"
 #include "udp_socket.hpp"
+#include "dns_encoded_answer.hpp"
+#include "dns_forwarder.hpp"
 
 namespace adns
 {
@@ -108,19 +113,24 @@ namespace adns
         int get_channel() const;
 
         /**
-         * Set forwarding details
+         * set the ID of the TCP connection the request arrived on
+         */
+        void set_connection_id(uint64_t id);
+
+        /**
+         * get the ID of the TCP connection the request arrived on (0 if it didn't)
          */
-        void set_forwarding(const ip_address &forward_ip, int forward_port);
+        uint64_t get_connection_id() const;
 
         /**
-         * Get forwarding ip address
+         * Set the servers to forward the request to
          */
-        const ip_address &get_forwarding_address() const;
+        void set_forwarding(const std::shared_ptr<const std::vector<dns_forwarder>> &forwarders);
 
         /**
-         * Get forwarding port
+         * Get the servers to forward the request to
          */
-        int get_forwarding_port() const;
+        const std::shared_ptr<const std::vector<dns_forwarder>> &get_forwarders() const;
 
         /**
          * set the minimum TTL of a record in the contained message
@@ -132,19 +142,54 @@ namespace adns
          */
         int get_min_ttl() const;
 
+        /**
+         * mark as an internally generated refresh of a cache entry rather than a client query
+         */
+        void set_prefetch(bool prefetch);
+
+        /**
+         * is this an internally generated refresh of a cache entry? (nobody to send a response to)
+         */
+        bool is_prefetch() const;
+
+        /**
+         * set a pre-encoded answer to send instead of a parsed response
+         */
+        void set_encoded_answer(const std::shared_ptr<const dns_encoded_answer> &answer);
+
+        /**
+         * get the pre-encoded answer, nullptr if there isn't one
+         */
+        const std::shared_ptr<const dns_encoded_answer> &get_encoded_answer() const;
+
+        /**
+         * set when the request arrived, defaults to when the envelope was created
+         */
+        void set_received_time(std::chrono::steady_clock::time_point t);
+
+        /**
+         * get when the request arrived
+         */
+        std::chrono::steady_clock::time_point get_received_time() const;
+
     private:
 
         buffer         m_raw;
         socket_address m_remote_address;
         int            m_channel;
+        uint64_t       m_connection_id;
         int            m_min_ttl;
+        bool           m_prefetch;
+
+        std::chrono::steady_clock::time_point m_received_time;
 
         udp_socket  *m_socket;
 
         dns_message *m_request;
         dns_message *m_response;
 
-        ip_address m_forward_ip;
-        int        m_forward_port;
+        std::shared_ptr<const dns_encoded_answer> m_encoded_answer;
+
+        std::shared_ptr<const std::vector<dns_forwarder>> m_forwarders;
     };
 }
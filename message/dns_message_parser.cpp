@@ -79,6 +79,29 @@ void dns_message_parser::parse_edns_options(dns_message *m, dns_rr_OPT *rr)
     m->m_response_code = static_cast<dns_message::response_code_t>(static_cast<int>(m->m_response_code) | ((rr->get_ttl() & 0xff000000) >> 16));
     m->m_edns_version = (rr->get_ttl() & 0x00ff0000) >> 16;
     m->m_is_dnssec_ok = (rr->get_ttl() & 0x00008000) != 0;
+
+    const octet *raw = rr->get_data().get_data();
+    size_t size = rr->get_data().get_size();
+    size_t i = 0;
+
+    // the only option looked at is edns-tcp-keepalive, anything else is skipped
+    while (i + 4 <= size)
+    {
+        unsigned short code = parse_short(raw, size, i);
+        unsigned short length = parse_short(raw, size, i);
+
+        if (i + length > size)
+        {
+            THROW(message_parser_format_exception, "EDNS option length overruns the OPT record");
+        }
+
+        if ((code == EDNS_OPTION_TCP_KEEPALIVE) && (length == 2))
+        {
+            m->m_tcp_keepalive_timeout = (raw[i] << 8) | raw[i + 1];
+        }
+
+        i += length;
+    }
 }
 
 dns_message *dns_message_parser::from_wire(const buffer &raw_buffer)
@@ -318,8 +341,18 @@ buffer dns_message_parser::to_wire(const dns_message &m, bool compress, size_t m
             // TTL
             unparse_uint(ttl, raw, max_size, i);
 
-            // data length
-            unparse_unsigned_short(0, raw, max_size, i);
+            if (m.m_tcp_keepalive)
+            {
+                // data length then an edns-tcp-keepalive option with no timeout, as sent by clients
+                unparse_unsigned_short(4, raw, max_size, i);
+                unparse_unsigned_short(EDNS_OPTION_TCP_KEEPALIVE, raw, max_size, i);
+                unparse_unsigned_short(0, raw, max_size, i);
+            }
+            else
+            {
+                // data length
+                unparse_unsigned_short(0, raw, max_size, i);
+            }
         }
     }
     catch (...)
@@ -370,6 +403,38 @@ dns_message::op_code_t dns_message_parser::extract_opcode(const buffer &raw) noe
     }
 }
 
+bool dns_message_parser::extract_recursion_desired(const buffer &raw) noexcept
+{
+    if (raw.get_size() >= 3)
+    {
+        header_part_1 part_1;
+        memcpy(&part_1, raw.get_data() + 2, 1);
+        return part_1.rd != 0;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+shared_ptr<dns_question> dns_message_parser::extract_question(const buffer &raw) noexcept
+{
+    if ((raw.get_size() < HEADER_SIZE) || (((raw.get_data()[4] << 8) | raw.get_data()[5]) != 1))
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        size_t offset = HEADER_SIZE;
+        return parse_question(raw.get_data(), raw.get_size(), offset);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
 void dns_message_parser::set_truncated(const buffer &raw, bool truncated)
 {
     if (raw.get_size() >= 3)
@@ -91,6 +91,17 @@ namespace adns
          */
         dns_message::op_code_t extract_opcode(const buffer &raw) noexcept;
 
+        /**
+         * extract just the RD flag - return false if the message is too short.
+         */
+        bool extract_recursion_desired(const buffer &raw) noexcept;
+
+        /**
+         * extract just the question without parsing the rest of the message - return nullptr
+         * if there isn't exactly one or it can't be parsed.
+         */
+        std::shared_ptr<dns_question> extract_question(const buffer &raw) noexcept;
+
         /**
          * set the truncated flag in the header part of a message without
          * parsing/unparsing.
@@ -0,0 +1,135 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <random>
+#include <algorithm>
+
+#include "dns_forwarder_selector.hpp"
+#include "dns_ip_selector.hpp"
+
+using namespace std;
+using namespace adns;
+
+mutex dns_forwarder_selector::o_lock;
+map<socket_address, uint> dns_forwarder_selector::o_in_flight;
+
+const uint dns_forwarder_selector::unknown_srtt_ms;
+const uint dns_forwarder_selector::min_hedge_delay_ms;
+
+const dns_forwarder *dns_forwarder_selector::select(
+                                const vector<dns_forwarder>      &forwarders, 
+                                uint                             max_in_flight,
+                                const set<const dns_forwarder *> &exclude)
+{
+    static thread_local mt19937 g(random_device{}());
+
+    // the best candidates are live and not too busy, then live but busy, then anything left
+    vector<pair<const dns_forwarder *, double>> candidates[3];
+
+    {
+        lock_guard<mutex> guard(o_lock);
+
+        for (auto &f : forwarders)
+        {
+            if (exclude.find(&f) != exclude.end())
+            {
+                continue;
+            }
+
+            dns_ip_selector::server_stats_t stats;
+
+            bool known = dns_ip_selector::get_stats(f.get_address().get_ip_address(), stats);
+            uint srtt = known ? max(stats.srtt_ms, 1u) : unknown_srtt_ms;
+            double share = double(f.get_weight()) / srtt;
+
+            if (known && stats.dead)
+            {
+                candidates[2].emplace_back(&f, share);
+            }
+            else
+            {
+                auto i = o_in_flight.find(f.get_address());
+                bool busy = (i != o_in_flight.end()) && (i->second >= max_in_flight);
+
+                candidates[busy ? 1 : 0].emplace_back(&f, share);
+            }
+        }
+    }
+
+    for (auto &c : candidates)
+    {
+        if (c.empty())
+        {
+            continue;
+        }
+
+        double total = 0;
+
+        for (auto &p : c)
+        {
+            total += p.second;
+        }
+
+        double r = uniform_real_distribution<double>(0, total)(g);
+
+        for (auto &p : c)
+        {
+            if (r < p.second)
+            {
+                return p.first;
+            }
+
+            r -= p.second;
+        }
+
+        return c.back().first;
+    }
+
+    return nullptr;
+}
+
+void dns_forwarder_selector::query_started(const dns_forwarder &f)
+{
+    lock_guard<mutex> guard(o_lock);
+    o_in_flight[f.get_address()]++;
+}
+
+void dns_forwarder_selector::query_finished(const dns_forwarder &f)
+{
+    lock_guard<mutex> guard(o_lock);
+
+    auto i = o_in_flight.find(f.get_address());
+
+    if (i != o_in_flight.end() && --(i->second) == 0)
+    {
+        o_in_flight.erase(i);
+    }
+}
+
+uint dns_forwarder_selector::hedge_delay_ms(const dns_forwarder &f, uint max_ms)
+{
+    dns_ip_selector::server_stats_t stats;
+
+    if (!dns_ip_selector::get_stats(f.get_address().get_ip_address(), stats) || stats.dead)
+    {
+        return max_ms;
+    }
+
+    return min(max(stats.srtt_ms + 4 * stats.rttvar_ms, min_hedge_delay_ms), max_ms);
+}
@@ -0,0 +1,83 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <vector>
+
+#include "types.hpp"
+#include "socket_address.hpp"
+#include "dns_forwarder.hpp"
+
+namespace adns
+{
+    /**
+     * Picks which of a forwarded zone's servers a query goes to. The load is shared out
+     * in proportion to each server's weight divided by its smoothed round trip time (as 
+     * tracked by dns_ip_selector) so faster servers get more of it. Servers that recently
+     * stopped responding and those with too many queries already outstanding are avoided
+     * while there's an alternative.
+     */
+    class dns_forwarder_selector
+    {
+    public:
+
+        dns_forwarder_selector() = delete;
+
+        /**
+         * pick a forwarder, nullptr if they're all in exclude
+         */
+        static const dns_forwarder *select(
+                                const std::vector<dns_forwarder>      &forwarders, 
+                                uint                                  max_in_flight,
+                                const std::set<const dns_forwarder *> &exclude);
+
+        /**
+         * count a query as outstanding to a forwarder
+         */
+        static void query_started(const dns_forwarder &f);
+
+        /**
+         * a query to a forwarder has been answered or has timed out
+         */
+        static void query_finished(const dns_forwarder &f);
+
+        /**
+         * How long to wait for a forwarder before trying another as well. This is the 
+         * RFC 6298 retransmission timeout based on its RTT, capped at max_ms.
+         */
+        static uint hedge_delay_ms(const dns_forwarder &f, uint max_ms);
+
+    private:
+
+        // SRTT assumed for a forwarder that hasn't answered anything yet
+        static const uint unknown_srtt_ms = 32;
+
+        // don't race another forwarder sooner than this
+        static const uint min_hedge_delay_ms = 5;
+
+        static std::mutex o_lock;
+
+        // queries outstanding per forwarder
+        static std::map<socket_address, uint> o_in_flight;
+    };
+}
@@ -17,14 +17,24 @@
 //  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
  
+#include <chrono>
+
 #include "types.hpp"
+#include "config.hpp"
+#include "monitor.hpp"
+#include "run_state.hpp"
+#include "timer_service.hpp"
 #include "dns_forwarding_resolver.hpp"
+#include "dns_outbound_multiplexer.hpp"
 
 using namespace std;
+using namespace chrono;
 using namespace adns;
 using namespace boost::log::trivial;
 
-dns_forwarding_resolver::dns_forwarding_resolver(const server_config &sc)
+dns_forwarding_resolver::dns_forwarding_resolver(const server_config &sc) : 
+                m_monitor_snapshot_saved_id(0), 
+                m_monitor_snapshot_save_ms_id(0)
 {
     shared_ptr<dns_forwarding_cache> c;
     if (sc.dns.use_forwarding_cache)
@@ -39,6 +49,44 @@ dns_forwarding_resolver::dns_forwarding_resolver(const server_config &sc)
                 << sc.dns.forward_cache_max_entries
                 << " gc % = "
                 << sc.dns.forward_cache_garbage_collect_pct;
+
+        auto cc = config::get_cache_config();
+
+        if (!cc.snapshot_file.empty())
+        {
+            // one snapshot per server as each has its own forwarding cache
+            auto instance = to_string(sc.server_id);
+
+            m_snapshot_file = cc.snapshot_file + "." + instance;
+
+            auto loaded_id = monitor::add_thing("forwarding cache", instance, "snapshot entries loaded", 0);
+            auto load_ms_id = monitor::add_thing("forwarding cache", instance, "snapshot load time (miliseconds)", 0);
+            m_monitor_snapshot_saved_id = monitor::add_thing("forwarding cache", instance, "snapshot entries saved", 0);
+            m_monitor_snapshot_save_ms_id = monitor::add_thing("forwarding cache", instance, "snapshot save time (miliseconds)", 0);
+
+            auto start = steady_clock::now();
+            size_t n = 0;
+
+            try
+            {
+                n = c->load_snapshot(m_snapshot_file);
+            }
+            catch (adns::exception &e)
+            {
+                e.log(warning, "failed to load forwarding cache snapshot");
+            }
+
+            auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+            LOG(info) << "loaded " << n << " forwarding cache entries from " << m_snapshot_file << " in " << ms << "ms";
+
+            monitor::set_value(loaded_id, uint(n));
+            monitor::set_value(load_ms_id, uint(ms));
+
+            schedule_snapshot(c, m_snapshot_file, cc.snapshot_interval_s, m_monitor_snapshot_saved_id, m_monitor_snapshot_save_ms_id);
+        }
+
+        m_cache = c;
     }
 
     dns_forwarding_slot::params_t p(sc, m_slot_manager, c, sc.dns.use_forwarding_emergency_cache);
@@ -86,4 +134,59 @@ dns_message_envelope *dns_forwarding_resolver::dequeue()
 void dns_forwarding_resolver::join()
 {
     m_slot_pool->join();
+    dns_outbound_multiplexer::get_instance()->join();
+
+    if (m_cache && !m_snapshot_file.empty())
+    {
+        save_snapshot(m_cache, m_snapshot_file, m_monitor_snapshot_saved_id, m_monitor_snapshot_save_ms_id);
+    }
+}
+
+void dns_forwarding_resolver::save_snapshot(
+                        const shared_ptr<dns_forwarding_cache> &cache, 
+                        const string                           &file_name, 
+                        uint                                   monitor_saved_id, 
+                        uint                                   monitor_save_ms_id)
+{
+    try
+    {
+        auto start = steady_clock::now();
+        auto n = cache->save_snapshot(file_name);
+        auto ms = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+        LOG(info) << "saved " << n << " forwarding cache entries to " << file_name << " in " << ms << "ms";
+
+        monitor::set_value(monitor_saved_id, uint(n));
+        monitor::set_value(monitor_save_ms_id, uint(ms));
+    }
+    catch (adns::exception &e)
+    {
+        e.log(warning, "failed to save forwarding cache snapshot");
+    }
+}
+
+void dns_forwarding_resolver::schedule_snapshot(
+                        const weak_ptr<dns_forwarding_cache> &cache, 
+                        const string                         &file_name, 
+                        uint                                 interval_s,
+                        uint                                 monitor_saved_id, 
+                        uint                                 monitor_save_ms_id)
+{
+    if (interval_s == 0)
+    {
+        return;
+    }
+
+    timer_service::get_instance()->add(seconds(interval_s), [=]()
+    {
+        auto c = cache.lock();
+
+        if (!c || (run_state::o_state == run_state::shutdown_e))
+        {
+            return;
+        }
+
+        save_snapshot(c, file_name, monitor_saved_id, monitor_save_ms_id);
+        schedule_snapshot(cache, file_name, interval_s, monitor_saved_id, monitor_save_ms_id);
+    });
 }
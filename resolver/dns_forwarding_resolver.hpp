@@ -64,5 +64,35 @@ namespace adns
 
         dns_recursive_slot_manager m_slot_manager;
 
+        // answers from the forwarders, nullptr if not configured
+        std::shared_ptr<dns_forwarding_cache> m_cache;
+
+        // where the cache is saved between restarts (empty for nowhere)
+        std::string m_snapshot_file;
+
+        // IDs of the snapshot monitors
+        uint m_monitor_snapshot_saved_id;
+        uint m_monitor_snapshot_save_ms_id;
+
+        /**
+         * save the cache contents to a snapshot file, logging how long it took
+         */
+        static void save_snapshot(
+                        const std::shared_ptr<dns_forwarding_cache> &cache, 
+                        const std::string                           &file_name, 
+                        uint                                        monitor_saved_id, 
+                        uint                                        monitor_save_ms_id);
+
+        /**
+         * save the cache contents after the given interval, and keep doing so for as long as 
+         * the cache is around
+         */
+        static void schedule_snapshot(
+                        const std::weak_ptr<dns_forwarding_cache> &cache, 
+                        const std::string                         &file_name, 
+                        uint                                      interval_s,
+                        uint                                      monitor_saved_id, 
+                        uint                                      monitor_save_ms_id);
+
     };
 }
@@ -18,10 +18,13 @@
 //
  
 #include "dns_forwarding_slot.hpp"
-#include "dns_parallel_client.hpp"
+#include "dns_forwarder_selector.hpp"
+#include "dns_outbound_multiplexer.hpp"
 #include "client_config.hpp"
+#include "timer_service.hpp"
 
 using namespace std;
+using namespace chrono;
 using namespace adns;
 using namespace boost::log::trivial;
 
@@ -38,6 +41,16 @@ dns_forwarding_slot::params_t::params_t(
 {
 }
 
+const uint dns_forwarding_slot::max_forward_attempts;
+
+dns_forwarding_slot::forward_t::forward_t(const dns_message &request, const shared_ptr<const vector<dns_forwarder>> &forwarders) :
+                m_request(request),
+                m_forwarders(forwarders),
+                m_outstanding(0),
+                m_done(false)
+{
+}
+
 dns_forwarding_slot::dns_forwarding_slot(const params_t &params, message_queue<dns_message_envelope *> &queue) :
                 m_params(params),
                 m_out_queue(queue)
@@ -76,18 +89,132 @@ void dns_forwarding_slot::process(dns_message_envelope *m)
             }
         }
 
-        client_config config = m_params.m_config.dns.client;
-        config.server_port = m->get_forwarding_port();
-        dns_parallel_client c(config);
-        c.set_ip_address(m->get_forwarding_address());
-        
+        if (!m->get_forwarders() || m->get_forwarders()->empty())
+        {
+            THROW(forwarding_slot_exception, "no forwarders for query");
+        }
+
         dns_message qm;
         qm.set_type(dns_message::query_e);
         qm.set_op_code(dns_message::op_query_e);
         qm.set_is_recursion_desired(m->get_request()->get_is_recursion_desired());
         qm.set_question(m->get_request()->get_question());
 
-        auto res = c.query(qm);
+        auto f = make_shared<forward_t>(qm, m->get_forwarders());
+
+        // don't wait for the answer, it's picked up on the multiplexer thread
+        forward(m, f);
+    }
+    catch (adns::exception &e)
+    {
+        e.log(error, "exception contacting forwarder");
+    }
+}
+
+bool dns_forwarding_slot::forward(dns_message_envelope *m, const shared_ptr<forward_t> &f)
+{
+    const dns_forwarder *fw;
+    bool first;
+
+    {
+        lock_guard<mutex> guard(f->m_lock);
+
+        if (f->m_done || (f->m_tried.size() >= max_forward_attempts))
+        {
+            return false;
+        }
+
+        fw = dns_forwarder_selector::select(*f->m_forwarders, m_params.m_config.dns.forward_max_in_flight, f->m_tried);
+
+        if (!fw)
+        {
+            return false;
+        }
+
+        first = f->m_tried.empty();
+        f->m_tried.insert(fw);
+        f->m_outstanding++;
+    }
+
+    client_config config = m_params.m_config.dns.client;
+    config.server_port = fw->get_address().get_port();
+
+    if (fw->get_use_tls())
+    {
+        config.use_udp = false;
+        config.use_tcp = true;
+        config.use_tls = true;
+    }
+
+    dns_forwarder_selector::query_started(*fw);
+
+    dns_outbound_multiplexer::get_instance()->query(
+            f->m_request, 
+            { fw->get_address().get_ip_address() }, 
+            config, 
+            [this, m, f, fw](dns_message *res) { answered(m, f, *fw, res); });
+
+    if (first && m_params.m_config.dns.forward_hedge_queries && (f->m_forwarders->size() > 1))
+    {
+        // if the first forwarder is slower than usual, race another one against it
+        timer_service::get_instance()->add(
+                milliseconds(dns_forwarder_selector::hedge_delay_ms(*fw, config.udp_timeout_ms)),
+                [this, m, f]() { forward(m, f); });
+    }
+
+    return true;
+}
+
+void dns_forwarding_slot::answered(dns_message_envelope *m, const shared_ptr<forward_t> &f, const dns_forwarder &fw, dns_message *res)
+{
+    dns_forwarder_selector::query_finished(fw);
+
+    {
+        lock_guard<mutex> guard(f->m_lock);
+
+        f->m_outstanding--;
+
+        if (f->m_done)
+        {
+            // lost the race, the envelope has already gone
+            delete res;
+            return;
+        }
+
+        if (!res && (f->m_outstanding > 0))
+        {
+            // another forwarder might still answer
+            return;
+        }
+
+        f->m_done = (res != nullptr);
+    }
+
+    // nothing back from this one so fail over to another if there is one
+    if (!res && forward(m, f))
+    {
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(f->m_lock);
+
+        if (!res && (f->m_done || (f->m_outstanding > 0)))
+        {
+            return;
+        }
+
+        f->m_done = true;
+    }
+
+    forwarded(m, res);
+}
+
+void dns_forwarding_slot::forwarded(dns_message_envelope *m, dns_message *res)
+{
+    try
+    {
+        auto id = m->get_request()->get_id();
 
         if (res)
         {
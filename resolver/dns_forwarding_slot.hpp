@@ -22,6 +22,9 @@
 #include <thread>
 #include <unordered_map>
 #include <chrono>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include "types.hpp"
 
@@ -30,6 +33,7 @@
 #include "dns_message_envelope.hpp"
 #include "dns_recursive_slot_manager.hpp"
 #include "dns_forwarding_cache.hpp"
+#include "dns_forwarder.hpp"
 
 EXCEPTION_CLASS(forwarding_slot_exception, exception)
 
@@ -69,7 +73,7 @@ namespace adns
         void join();
 
         /**
-         * forward a single query
+         * forward a single query, the response is dealt with by forwarded()
          */
         void process(dns_message_envelope *m);
 
@@ -81,10 +85,51 @@ namespace adns
 
     private:
 
+        /**
+         * a query on its way to one or more of the zone's forwarders
+         */
+        struct forward_t
+        {
+            forward_t(const dns_message &request, const std::shared_ptr<const std::vector<dns_forwarder>> &forwarders);
+
+            std::mutex m_lock;
+
+            dns_message m_request;
+
+            // the envelope's forwarders, kept here as the envelope is gone once answered
+            std::shared_ptr<const std::vector<dns_forwarder>> m_forwarders;
+
+            // forwarders sent to so far and how many of those haven't come back yet
+            std::set<const dns_forwarder *> m_tried;
+            uint m_outstanding;
+
+            // set once a response (or the lack of one) has been passed on
+            bool m_done;
+        };
+
+        // a query goes to the first forwarder picked and, if that's slow or fails, to one other
+        static const uint max_forward_attempts = 2;
+
         // parameters - e.g. the slot manager
         params_t m_params;
 
         // outgoing message queue 
         message_queue<dns_message_envelope *> &m_out_queue;
+
+        /**
+         * deal with the response (or lack of one) from the forwarder
+         */
+        void forwarded(dns_message_envelope *m, dns_message *res);
+
+        /**
+         * send a query to another forwarder, false if it's already been answered or there's 
+         * no forwarder left to try
+         */
+        bool forward(dns_message_envelope *m, const std::shared_ptr<forward_t> &f);
+
+        /**
+         * a forwarder has responded, or not, the first response is the one that's used
+         */
+        void answered(dns_message_envelope *m, const std::shared_ptr<forward_t> &f, const dns_forwarder &fw, dns_message *res);
     };
 }
@@ -0,0 +1,199 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include "config.hpp"
+#include "monitor.hpp"
+#include "run_state.hpp"
+#include "dns_outbound_multiplexer.hpp"
+#include "dns_recursive_loop.hpp"
+#include "dns_recursive_slot.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+dns_recursive_loop::upstream_query::upstream_query(
+                        dns_recursive_loop    &loop, 
+                        const dns_message     &request, 
+                        const set<ip_address> &ips) :
+                    m_loop(loop),
+                    m_request(request),
+                    m_all_ips(ips)
+{
+}
+
+dns_recursive_loop::upstream_query::~upstream_query()
+{
+}
+
+void dns_recursive_loop::upstream_query::await_suspend(coroutine_handle<> awaiter)
+{
+    m_awaiter = awaiter;
+
+    // the completion runs on the multiplexer thread so hop back onto the loop before resuming
+    dns_outbound_multiplexer::get_instance()->query(
+            m_request, 
+            m_all_ips, 
+            m_loop.m_config.dns.client,
+            [this](dns_message *response)
+            {
+                m_loop.post([this, response]()
+                {
+                    m_result.reset(response);
+                    m_awaiter.resume();
+                });
+            });
+}
+
+unique_ptr<dns_message> dns_recursive_loop::upstream_query::await_resume()
+{
+    return std::move(m_result);
+}
+
+dns_recursive_loop::dns_recursive_loop(
+                    const string                          &name,
+                    const server_config                   &config,
+                    dns_recursive_slot_manager            &slot_manager,
+                    message_queue<dns_message_envelope *> &out_queue,
+                    function<void ()>                     slot_done) :
+                m_name(name),
+                m_config(config),
+                m_slot_manager(slot_manager),
+                m_out_queue(out_queue),
+                m_slot_done(slot_done),
+                m_notify(make_shared<notify_socket>()),
+                m_active(0)
+{
+    m_sockets.add(m_notify);
+    m_monitor_active_id = monitor::add_thing("recursive loop", m_name, "active resolutions", 0);
+}
+
+dns_recursive_loop::~dns_recursive_loop()
+{
+}
+
+void dns_recursive_loop::run()
+{
+    m_thread.reset(new thread(&dns_recursive_loop::loop, this));
+}
+
+void dns_recursive_loop::join()
+{
+    if (m_thread)
+    {
+        m_thread->join();
+    }
+}
+
+void dns_recursive_loop::start(dns_message_envelope *m)
+{
+    post([this, m]()
+    {
+        monitor::set_value(m_monitor_active_id, ++m_active);
+        
+        dns_recursive_slot::run(
+                make_unique<dns_recursive_slot>(
+                        dns_recursive_slot::params_t(m_config, m_slot_manager), 
+                        *this, 
+                        m_out_queue), 
+                m);
+    });
+}
+
+void dns_recursive_loop::post(const function<void ()> &f)
+{
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        m_posted.push_back(f);
+    }
+
+    m_notify->notify();
+}
+
+dns_recursive_loop::upstream_query dns_recursive_loop::query(const dns_message &request, const set<ip_address> &ips)
+{
+    return upstream_query(*this, request, ips);
+}
+
+void dns_recursive_loop::slot_finished()
+{
+    monitor::set_value(m_monitor_active_id, --m_active);
+    m_slot_done();
+}
+
+timer_wheel::timer_id_t dns_recursive_loop::add_timer(milliseconds delay, const function<void ()> &f)
+{
+    return m_timers.add(delay, f);
+}
+
+void dns_recursive_loop::cancel_timer(timer_wheel::timer_id_t id)
+{
+    m_timers.cancel(id);
+}
+
+void dns_recursive_loop::loop()
+{
+    uint wait_ms = 1000;
+
+    while (run_state::o_state != run_state::shutdown_e)
+    {
+        try
+        {
+            auto e = m_sockets.wait_one(wait_ms);
+
+            if (get<0>(e) == m_notify)
+            {
+                m_notify->clear();
+                run_posted();
+            }
+        }
+        catch (socket_set_timeout_exception &e)
+        {
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught in dns_recursive_loop::loop");
+        }
+
+        wait_ms = m_timers.advance();
+    }
+}
+
+void dns_recursive_loop::run_posted()
+{
+    list<function<void ()>> work;
+
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        work.swap(m_posted);
+    }
+
+    for (auto &f : work)
+    {
+        try
+        {
+            f();
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught running posted work in dns_recursive_loop");
+        }
+    }
+}
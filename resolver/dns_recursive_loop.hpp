@@ -0,0 +1,190 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <set>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <coroutine>
+
+#include "types.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+#include "server_config.hpp"
+#include "message_queue.hpp"
+#include "socket_set.hpp"
+#include "notify_socket.hpp"
+#include "dns_message.hpp"
+#include "dns_message_envelope.hpp"
+#include "dns_recursive_slot_manager.hpp"
+
+EXCEPTION_CLASS(recursive_loop_exception, exception)
+
+namespace adns
+{
+    /**
+     * An event loop thread driving recursive resolutions. Each resolution is a coroutine (see
+     * dns_recursive_slot) that only ever runs on the loop that started it. Whilst waiting for
+     * an upstream nameserver (via the outbound multiplexer) a resolution is just a suspended
+     * frame, so a handful of loops can have a very large number of resolutions in progress.
+     */
+    class dns_recursive_loop final
+    {
+    public:
+
+        /**
+         * A single query to a set of nameserver addresses. co_await the result of
+         * dns_recursive_loop::query() to send it and wait for a response. The response is
+         * null if nothing useful came back in time.
+         */
+        class upstream_query final
+        {
+        public:
+
+            upstream_query(dns_recursive_loop &loop, const dns_message &request, const std::set<ip_address> &ips);
+
+            upstream_query(const upstream_query &other) = delete;
+            upstream_query &operator=(const upstream_query &other) = delete;
+
+            virtual ~upstream_query();
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            /**
+             * hand the query to the outbound multiplexer, the awaiter is resumed on the loop 
+             * thread once it's done
+             */
+            void await_suspend(std::coroutine_handle<> awaiter);
+
+            /**
+             * the response, if any
+             */
+            std::unique_ptr<dns_message> await_resume();
+
+        private:
+
+            friend class dns_recursive_loop;
+
+            dns_recursive_loop &m_loop;
+
+            // what's being asked and where
+            dns_message          m_request;
+            std::set<ip_address> m_all_ips;
+
+            std::coroutine_handle<> m_awaiter;
+            std::unique_ptr<dns_message> m_result;
+        };
+
+        /**
+         * new loop, thread isn't started until run() is called. slot_done is called (on the
+         * loop thread) every time a resolution finishes.
+         */
+        dns_recursive_loop(
+                    const std::string                     &name,
+                    const server_config                   &config,
+                    dns_recursive_slot_manager            &slot_manager,
+                    message_queue<dns_message_envelope *> &out_queue,
+                    std::function<void ()>                slot_done);
+
+        virtual ~dns_recursive_loop();
+
+        /**
+         * start the loop thread
+         */
+        void run();
+
+        /**
+         * wait for the loop thread to finish
+         */
+        void join();
+
+        /**
+         * start resolving a query (may be called from any thread)
+         */
+        void start(dns_message_envelope *m);
+
+        /**
+         * run a function on the loop thread (may be called from any thread)
+         */
+        void post(const std::function<void ()> &f);
+
+        /**
+         * make an upstream query (loop thread only)
+         */
+        upstream_query query(const dns_message &request, const std::set<ip_address> &ips);
+
+        /**
+         * called by a slot when it's finished (loop thread only)
+         */
+        void slot_finished();
+
+        /**
+         * call f on the loop thread after a delay (loop thread only)
+         */
+        timer_wheel::timer_id_t add_timer(std::chrono::milliseconds delay, const std::function<void ()> &f);
+
+        /**
+         * cancel a timer set with add_timer (loop thread only)
+         */
+        void cancel_timer(timer_wheel::timer_id_t id);
+
+    private:
+
+        std::string   m_name;
+        server_config m_config;
+
+        dns_recursive_slot_manager            &m_slot_manager;
+        message_queue<dns_message_envelope *> &m_out_queue;
+        std::function<void ()>                m_slot_done;
+
+        // just the notifier used to wake the loop for posted work
+        socket_set                     m_sockets;
+        std::shared_ptr<notify_socket> m_notify;
+
+        // resolution deadlines
+        timer_wheel m_timers;
+
+        // work handed to the loop from other threads
+        std::mutex                        m_posted_lock;
+        std::list<std::function<void ()>> m_posted;
+
+        // resolutions currently in progress on this loop
+        uint m_active;
+        uint m_monitor_active_id;
+
+        std::shared_ptr<std::thread> m_thread;
+
+        /**
+         * main loop
+         */
+        void loop();
+
+        /**
+         * run anything posted from other threads
+         */
+        void run_posted();
+    };
+}
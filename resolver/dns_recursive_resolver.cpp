@@ -23,37 +23,60 @@
 #include "ip_address.hpp"
 #include "types.hpp"
 #include "dns_recursive_resolver.hpp"
+#include "dns_outbound_multiplexer.hpp"
+#include "dns_recursive_cache.hpp"
 #include "socket_set.hpp"
 
 using namespace std;
+using namespace chrono;
 using namespace adns;
 using namespace boost::log::trivial;
 
 static shared_ptr<dns_recursive_resolver> instance;
 
-dns_recursive_resolver::dns_recursive_resolver(const server_config &sc, bool is_tcp) : m_config(sc)
+dns_recursive_resolver::dns_recursive_resolver(const server_config &sc, bool is_tcp) : 
+                m_config(sc),
+                m_in_queue("recursive resolver " + boost::lexical_cast<string>(sc.server_id) + " input queue", sc.dns.max_in_message_queue_length),
+                m_out_queue("recursive resolver " + boost::lexical_cast<string>(sc.server_id) + " output queue", sc.dns.max_out_message_queue_length),
+                m_multiplexer(nullptr),
+                m_free_slots(is_tcp ? sc.dns.num_tcp_recursive_slots : sc.dns.num_udp_recursive_slots),
+                m_num_expired(0)
 {
-    dns_recursive_slot::params_t p(sc, m_slot_manager);
-    m_slot_pool = new handler_pool<dns_message_envelope *, dns_recursive_slot, dns_recursive_slot::params_t>(
-            "recursive slot pool",
-            p,
-            m_config.dns.max_in_message_queue_length,
-            m_config.dns.max_out_message_queue_length,
-            is_tcp ? m_config.dns.num_tcp_recursive_slots : m_config.dns.num_udp_recursive_slots);
     m_meter = make_shared<frequency_meter>(60);
 
+    uint n = max<uint>(1, m_config.dns.num_recursive_threads);
+
+    for (uint i = 0; i < n; i++)
+    {
+        auto l = make_shared<dns_recursive_loop>(
+                        boost::lexical_cast<string>(sc.server_id) + " " + boost::lexical_cast<string>(i), 
+                        m_config, 
+                        m_slot_manager, 
+                        m_out_queue, 
+                        [this]() { m_free_slots.release(); });
+        l->run();
+        m_loops.push_back(l);
+    }
+
+    m_dispatch_thread.reset(new thread(&dns_recursive_resolver::dispatch, this));
+
     m_monitor_tps_id = monitor::add_thing("recursive resolver", boost::lexical_cast<string>(sc.server_id), "TPS", 0);
 
     // for convenience - makes debug a bit easier to see these in the monitor status
     monitor::add_thing("recursive resolver", boost::lexical_cast<string>(sc.server_id), "protocol", sc.protocol);
     monitor::add_thing("recursive resolver", boost::lexical_cast<string>(sc.server_id), "transport", sc.transport);
 
+    m_monitor_expired_id = monitor::add_thing("recursive resolver", boost::lexical_cast<string>(sc.server_id), "queries dropped past deadline", 0);
+
     m_monitor_thread.reset(new thread(&dns_recursive_resolver::monitor_tps, this));
+
+    // refreshes go through whichever resolver was created last, they all share the cache
+    dns_recursive_cache::get_instance()->set_prefetcher([this](const shared_ptr<dns_question> &q) { prefetch(q); });
 }
 
 dns_recursive_resolver::~dns_recursive_resolver()
 {
-    delete m_slot_pool;
+    delete m_multiplexer;
 }
 
 void dns_recursive_resolver::monitor_tps()
@@ -70,9 +93,95 @@ void dns_recursive_resolver::monitor_tps()
     }
 }
 
+void dns_recursive_resolver::dispatch()
+{
+    uint next = 0;
+
+    while (run_state::o_state != run_state::shutdown_e)
+    {
+        if (!m_free_slots.try_acquire_for(seconds(2)))
+        {
+            continue;
+        }
+
+        try
+        {
+            auto m = m_in_queue.dequeue();
+
+            if (expired(m))
+            {
+                m = drop_expired(m);
+
+                if (!m)
+                {
+                    m_free_slots.release();
+                    continue;
+                }
+            }
+
+            m_loops[next++ % m_loops.size()]->start(m);
+        }
+        catch (message_queue_timeout_exception &e)
+        {
+            m_free_slots.release();
+        }
+        catch (adns::exception &e)
+        {
+            m_free_slots.release();
+            e.log(error, "exception caught in dns_recursive_resolver::dispatch");
+        }
+    }
+}
+
+bool dns_recursive_resolver::expired(dns_message_envelope *m) const
+{
+    if (m_config.dns.max_queue_wait_ms == 0 || m->is_prefetch())
+    {
+        return false;
+    }
+
+    return (steady_clock::now() - m->get_received_time()) > milliseconds(m_config.dns.max_queue_wait_ms);
+}
+
+dns_message_envelope *dns_recursive_resolver::drop_expired(dns_message_envelope *m)
+{
+    // m is first in its own waiting list
+    auto w = m_slot_manager.clear_waiters(*(m->get_request()->get_question()));
+    dns_message_envelope *leader = nullptr;
+
+    for (auto q : w)
+    {
+        if (expired(q))
+        {
+            monitor::set_value(m_monitor_expired_id, ++m_num_expired);
+            delete q;
+        }
+        else if (!m_slot_manager.already_resolving(q))
+        {
+            // the first one still in time takes over the question and the rest wait on it. If
+            // a new query got in first after the list was cleared they all wait on that instead.
+            leader = q;
+        }
+    }
+
+    return leader;
+}
+
 void dns_recursive_resolver::join()
 {
-    m_slot_pool->join();
+    m_dispatch_thread->join();
+
+    for (auto l : m_loops)
+    {
+        l->join();
+    }
+
+    if (m_multiplexer)
+    {
+        m_multiplexer->join();
+    }
+
+    dns_outbound_multiplexer::get_instance()->join();
     m_monitor_thread->join();
 }
 
@@ -84,10 +193,10 @@ void dns_recursive_resolver::enqueue(dns_message_envelope *q)
     {
         // for peformance, the already_resolving method will add the query to the
         // queue for a given slot if it's not there already. A false return says
-        // we also need to queue it up for the handler pool.
+        // we also need to queue it up for a free slot.
         if (!m_slot_manager.already_resolving(q))
         {
-            if (!m_slot_pool->enqueue(q))
+            if (!m_in_queue.enqueue(q))
             {
                 delete q;
             }
@@ -101,14 +210,42 @@ void dns_recursive_resolver::enqueue(dns_message_envelope *q)
     }
 }
 
+void dns_recursive_resolver::prefetch(const shared_ptr<dns_question> &question)
+{
+    auto r = new dns_message();
+    r->set_type(dns_message::query_e);
+    r->set_op_code(dns_message::op_query_e);
+    r->set_is_recursion_desired(true);
+    r->set_question(question);
+
+    auto q = new dns_message_envelope();
+    q->set_request(r);
+    q->set_prefetch(true);
+
+    // clients asking the same question whilst the refresh is running wait for it like any
+    // other query
+    if (!m_slot_manager.already_resolving(q))
+    {
+        if (!m_in_queue.enqueue(q))
+        {
+            delete q;
+        }
+    }
+}
+
 dns_message_envelope *dns_recursive_resolver::dequeue()
 {
-    return m_slot_pool->dequeue();
+    return m_out_queue.dequeue();
 }
 
 void dns_recursive_resolver::add_channel(
         shared_ptr<message_queue<dns_message_envelope *>> resolver_in, 
         shared_ptr<message_queue<dns_message_envelope *>> resolver_out)
 {
-    m_slot_pool->get_multiplexer()->add_channel(resolver_in, resolver_out);
+    if (m_multiplexer == nullptr)
+    {
+        m_multiplexer = new queue_multiplexer<dns_message_envelope *>(m_out_queue, m_in_queue);
+    }
+
+    m_multiplexer->add_channel(resolver_in, resolver_out);
 }
@@ -21,18 +21,20 @@
 
 #include <thread>
 #include <mutex>
+#include <vector>
+#include <semaphore>
 
 #include "types.hpp"
 #include "server_config.hpp"
 #include "socket_address.hpp"
 #include "message_queue.hpp"
-#include "handler_pool.hpp"
+#include "queue_multiplexer.hpp"
 #include "exception.hpp"
 #include "frequency_meter.hpp"
 
 #include "dns_message.hpp"
 #include "dns_message_envelope.hpp"
-#include "dns_recursive_slot.hpp"
+#include "dns_recursive_loop.hpp"
 #include "dns_recursive_slot_manager.hpp"
 
 EXCEPTION_CLASS(recursive_resolver_fail_exception, exception)
@@ -40,7 +42,9 @@ EXCEPTION_CLASS(recursive_resolver_fail_exception, exception)
 namespace adns
 {
     /**
-     * recursive DNS resolver. Sends asynchronous responses to requests.
+     * recursive DNS resolver. Sends asynchronous responses to requests. Resolutions are
+     * spread over a small number of event loop threads, the slot count limits how many
+     * can be in progress at once.
      */
     class dns_recursive_resolver final
     {
@@ -81,9 +85,6 @@ namespace adns
 
     private:
 
-        // pool of recursive resolver slots
-        handler_pool<dns_message_envelope *, dns_recursive_slot, dns_recursive_slot::params_t> *m_slot_pool;
-
         // recursive slot manager - records which slot is resolving
         // what.
         dns_recursive_slot_manager m_slot_manager;
@@ -91,6 +92,22 @@ namespace adns
         // general config
         server_config m_config;
 
+        // queries waiting for a free slot and responses waiting to be sent
+        message_queue<dns_message_envelope *> m_in_queue;
+        message_queue<dns_message_envelope *> m_out_queue;
+
+        // created on the first call to add_channel()
+        queue_multiplexer<dns_message_envelope *> *m_multiplexer;
+
+        // event loops doing the actual resolution
+        std::vector<std::shared_ptr<dns_recursive_loop>> m_loops;
+
+        // one permit per slot, taken when a query is handed to a loop
+        std::counting_semaphore<> m_free_slots;
+
+        // thread handing queries out to the loops
+        std::shared_ptr<std::thread> m_dispatch_thread;
+
         // used to measure transactions per second averaged over 10 seconds
         std::shared_ptr<frequency_meter> m_meter;
 
@@ -100,6 +117,10 @@ namespace adns
         // ID of the monitor for TPS
         uint m_monitor_tps_id;
 
+        // queries dropped for waiting too long for a free slot
+        uint m_num_expired;
+        uint m_monitor_expired_id;
+
         /**
          * monitor TPS 
          */
@@ -111,8 +132,26 @@ namespace adns
         void send_response(dns_message_envelope *m);
 
         /**
-         * main processing loop - one per thread
+         * hand queued queries to the loops as slots become free
+         */
+        void dispatch();
+
+        /**
+         * Has a query waited longer than max_queue_wait_ms since it arrived? Refreshes
+         * never expire as there's no client waiting on them.
+         */
+        bool expired(dns_message_envelope *m) const;
+
+        /**
+         * The query leading a question has expired. Drop it and any of its waiters that
+         * have also expired.
+         * @return  a waiter that's still in time to take over as leader, null if none
+         */
+        dns_message_envelope *drop_expired(dns_message_envelope *m);
+
+        /**
+         * queue up a background refresh of a popular cached answer
          */
-        void process();
+        void prefetch(const std::shared_ptr<dns_question> &question);
     };
 }
@@ -22,9 +22,11 @@
 #include "dns_rr_AAAA.hpp"
 #include "dns_rr_CNAME.hpp"
 #include "dns_rr_DNAME.hpp"
+#include "dns_encoded_response.hpp"
 #include "dns_recursive_slot.hpp"
 #include "dns_recursive_slot_manager.hpp"
 #include "dns_recursive_resolver.hpp"
+#include "dns_recursive_loop.hpp"
 
 using namespace std;
 using namespace chrono;
@@ -37,14 +39,101 @@ dns_recursive_slot::params_t::params_t(const server_config &config, dns_recursiv
 {
 }
 
-dns_recursive_slot::dns_recursive_slot(const params_t &params, message_queue<dns_message_envelope *> &q) : 
+dns_recursive_slot::dns_recursive_slot(
+                    const params_t                        &params, 
+                    dns_recursive_loop                    &loop, 
+                    message_queue<dns_message_envelope *> &q) : 
                     m_params(params), 
+                    m_loop(loop),
                     m_out_queue(q),
-                    m_client(params.m_config.dns.client),
-                    m_cache(dns_recursive_cache::get_instance())
+                    m_timed_out(false),
+                    m_deadline(timer_wheel::no_timer),
+                    m_cache(dns_recursive_cache::get_instance()),
+                    m_children(0)
 {
 }
 
+dns_recursive_slot::ns_lookups_t::ns_lookups_t() : m_outstanding(0)
+{
+}
+
+set<ip_address> dns_recursive_slot::next_ns_addresses::await_resume()
+{
+    if (m_lookups->m_ready.empty())
+    {
+        return set<ip_address>();
+    }
+
+    auto res = std::move(m_lookups->m_ready.front());
+    m_lookups->m_ready.pop_front();
+
+    return res;
+}
+
+dns_recursive_slot::shared_lookup::state_t::state_t() : m_done(false), m_timer(timer_wheel::no_timer)
+{
+}
+
+dns_recursive_slot::shared_lookup::shared_lookup(dns_recursive_slot &slot, const dns_question &q) :
+                    m_slot(slot),
+                    m_question(q),
+                    m_owner(false),
+                    m_state(make_shared<state_t>())
+{
+}
+
+bool dns_recursive_slot::shared_lookup::await_suspend(coroutine_handle<> awaiter)
+{
+    auto s = m_state;
+    auto &loop = m_slot.m_loop;
+
+    s->m_awaiter = awaiter;
+
+    // whoever finishes the lookup may be on another loop so hop back onto this one to resume
+    m_owner = !m_slot.m_params.m_slot_manager.join_lookup(
+                    m_question, 
+                    [s, &loop](const shared_ptr<const dns_recursive_cache_answer> &a)
+                    {
+                        loop.post([s, &loop, a]()
+                        {
+                            if (!s->m_done)
+                            {
+                                s->m_done = true;
+                                s->m_answer = a;
+                                loop.cancel_timer(s->m_timer);
+                                s->m_awaiter.resume();
+                            }
+                        });
+                    });
+
+    if (m_owner)
+    {
+        return false;
+    }
+
+    // the other slot may end up waiting on this one so don't wait forever
+    s->m_timer = loop.add_timer(
+                    milliseconds(m_slot.m_params.m_config.dns.recursive_timeout_ms),
+                    [s, &loop]()
+                    {
+                        loop.post([s]()
+                        {
+                            if (!s->m_done)
+                            {
+                                s->m_done = true;
+                                s->m_awaiter.resume();
+                            }
+                        });
+                    });
+
+    return true;
+}
+
+shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::shared_lookup::get_answer() const
+{
+    return m_state->m_answer;
+}
+
 dns_recursive_slot::query_t::query_t(const dns_question &q, const ip_address &ip)
 {
     m_question = q;
@@ -71,22 +160,53 @@ dns_recursive_slot::~dns_recursive_slot()
 {
 }
 
-void dns_recursive_slot::join()
+detached_task dns_recursive_slot::run(unique_ptr<dns_recursive_slot> slot, dns_message_envelope *m)
 {
+    try
+    {
+        co_await slot->process(m);
+    }
+    catch (adns::exception &e)
+    {
+        e.log(error, "exception caught in dns_recursive_slot::run");
+    }
+
+    // the response has gone but lookups started along the way may still be using the slot
+    co_await children_finished{*slot};
+
+    slot->m_loop.slot_finished();
 }
 
 void dns_recursive_slot::send_response(dns_message_envelope *m)
 {
     auto w = m_params.m_slot_manager.clear_waiters(*(m->get_request()->get_question()));
 
+    // encode the response once for everyone waiting rather than copying it for each of them
+    if (!m->get_encoded_answer() && m->get_response() && (w.size() > 1))
+    {
+        auto er = make_shared<dns_encoded_response>(*m->get_response());
+
+        if (er->is_encoded())
+        {
+            m->set_encoded_answer(er);
+        }
+    }
+
     // m is one of these, don't delete it until the end as we need the response it holds to still
     // be valid through this loop
     for (auto q : w)
     {
         if (q != m)
         {
-            q->set_response(new dns_message(*m->get_response()));
-            q->get_response()->set_id(q->get_request()->get_id());
+            if (m->get_encoded_answer())
+            {
+                q->set_encoded_answer(m->get_encoded_answer());
+            }
+            else
+            {
+                q->set_response(new dns_message(*m->get_response()));
+                q->get_response()->set_id(q->get_request()->get_id());
+            }
             if (!m_out_queue.enqueue(q))
             {
                 delete q;
@@ -94,8 +214,13 @@ void dns_recursive_slot::send_response(dns_message_envelope *m)
         }
     }
 
-    m->get_response()->set_id(m->get_request()->get_id());
-    if (!m_out_queue.enqueue(m))
+    if (m->get_response())
+    {
+        m->get_response()->set_id(m->get_request()->get_id());
+    }
+
+    // a prefetch has nobody to send a response to, it's just there to refresh the cache
+    if (m->is_prefetch() || !m_out_queue.enqueue(m))
     {
         delete m;
     }
@@ -169,70 +294,115 @@ void dns_recursive_slot::get_glue_ips(
     }
 }
 
-void dns_recursive_slot::resolve_nameserver_ips(set<ip_address> &ip_addresses, const shared_ptr<dns_name> &n, uint depth)
+task<set<ip_address>> dns_recursive_slot::resolve_nameserver_address(const shared_ptr<dns_name> &n, dns_rr::type_t t, uint depth)
 {
-    ip_addresses.clear();
+    set<ip_address> ip_addresses;
+    dns_question q(*n, dns_question::QT_RR_e, t);
 
-    if (m_params.m_config.dns.client.use_ip4)
+    if (m_owned_lookups.count(q) != 0)
     {
-        auto q = make_shared<dns_question>(*n, dns_question::QT_RR_e, dns_rr::T_A_e);
+        // already being looked up further up this resolution, going round again won't help
+        co_return ip_addresses;
+    }
+
+    shared_ptr<const dns_recursive_cache_answer> ca;
+    shared_lookup l(*this, q);
 
+    if (co_await l)
+    {
         dns_message *m = new dns_message();
         m->set_type(dns_message::query_e);
         m->set_op_code(dns_message::op_query_e);
         m->set_is_recursion_desired(false);
-        m->set_question(q);
+        m->set_question(make_shared<dns_question>(q));
 
         unique_ptr<dns_message_envelope> rq(new dns_message_envelope());
 
         rq->set_request(m);
 
-        auto ca = resolve(rq.get(), depth);
+        m_owned_lookups.insert(q);
+
+        try
+        {
+            ca = co_await resolve(rq.get(), depth);
+        }
+        catch (adns::exception &e)
+        {
+            m_owned_lookups.erase(q);
+            m_params.m_slot_manager.finish_lookup(q, nullptr);
+            throw;
+        }
+
+        m_owned_lookups.erase(q);
+        m_params.m_slot_manager.finish_lookup(q, ca);
+    }
+    else
+    {
+        ca = l.get_answer();
+    }
 
-        if (ca->get_type() == dns_recursive_cache_answer::data_e)
+    if (ca && ca->get_type() == dns_recursive_cache_answer::data_e)
+    {
+        for (auto a : ca->get_answer_records())
         {
-            for (auto a : ca->get_answer_records())
+            if ((a->get_type() == dns_rr::T_A_e) && (t == dns_rr::T_A_e) && (*n == *a->get_name()))
             {
-                if ((a->get_type() == dns_rr::T_A_e) && (*n == *a->get_name()))
-                {
-                    dns_rr_A *ar = dynamic_cast<dns_rr_A *>(a.get());
-                    ip_addresses.insert(ar->get_ip4_addr());
-                }
+                dns_rr_A *ar = dynamic_cast<dns_rr_A *>(a.get());
+                ip_addresses.insert(ar->get_ip4_addr());
+            }
+            else if ((a->get_type() == dns_rr::T_AAAA_e) && (t == dns_rr::T_AAAA_e) && (*n == *a->get_name()))
+            {
+                dns_rr_AAAA *ar = dynamic_cast<dns_rr_AAAA *>(a.get());
+                ip_addresses.insert(ar->get_ip6_addr());
             }
         }
     }
 
-    if (m_params.m_config.dns.client.use_ip6)
-    {
-        auto q = make_shared<dns_question>(*n, dns_question::QT_RR_e, dns_rr::T_AAAA_e);
+    co_return ip_addresses;
+}
 
-        dns_message *m = new dns_message();
-        m->set_type(dns_message::query_e);
-        m->set_op_code(dns_message::op_query_e);
-        m->set_is_recursion_desired(false);
-        m->set_question(q);
+detached_task dns_recursive_slot::lookup_nameserver_address(
+                    shared_ptr<ns_lookups_t> lookups,
+                    shared_ptr<dns_name>     n,
+                    dns_rr::type_t           t,
+                    uint                     depth)
+{
+    m_children++;
+    lookups->m_outstanding++;
 
-        unique_ptr<dns_message_envelope> rq(new dns_message_envelope());
+    set<ip_address> ips;
 
-        rq->set_request(m);
+    try
+    {
+        ips = co_await resolve_nameserver_address(n, t, depth);
+    }
+    catch (adns::exception &e)
+    {
+        // as good as not finding anything
+    }
 
-        auto ca = resolve(rq.get(), depth);
+    lookups->m_outstanding--;
 
-        if (ca->get_type() == dns_recursive_cache_answer::data_e)
-        {
-            for (auto a : ca->get_answer_records())
-            {
-                if ((a->get_type() == dns_rr::T_AAAA_e) && (*n == *a->get_name()))
-                {
-                    dns_rr_AAAA *ar = dynamic_cast<dns_rr_AAAA *>(a.get());
-                    ip_addresses.insert(ar->get_ip6_addr());
-                }
-            }
-        }
+    if (!ips.empty())
+    {
+        lookups->m_ready.push_back(std::move(ips));
+    }
+
+    // resume from the loop rather than from inside this coroutine
+    if (lookups->m_awaiter)
+    {
+        auto a = std::exchange(lookups->m_awaiter, nullptr);
+        m_loop.post([a]() { a.resume(); });
+    }
+
+    if ((--m_children == 0) && m_children_awaiter)
+    {
+        auto a = std::exchange(m_children_awaiter, nullptr);
+        m_loop.post([a]() { a.resume(); });
     }
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserver_cname(
+task<shared_ptr<const dns_recursive_cache_answer>> dns_recursive_slot::query_nameserver_cname(
                                                     dns_message_envelope                               *m,
                                                     const shared_ptr<const dns_recursive_cache_answer> &ans,
                                                     uint                                               depth)
@@ -256,7 +426,7 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
 
     rq->set_request(rm);
 
-    auto ca = make_shared<dns_recursive_cache_answer>(*resolve(rq.get(), depth));
+    auto ca = make_shared<dns_recursive_cache_answer>(*co_await resolve(rq.get(), depth));
 
     switch (ca->get_type())
     {
@@ -271,10 +441,10 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
         THROW(recursive_resolver_fail_exception, "CNAME resolution failed");
     }
 
-    return ca;
+    co_return ca;
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserver_dname(
+task<shared_ptr<const dns_recursive_cache_answer>> dns_recursive_slot::query_nameserver_dname(
                                                     dns_message_envelope                               *m,
                                                     const shared_ptr<const dns_recursive_cache_answer> &ans,
                                                     uint                                               depth)
@@ -300,7 +470,7 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
     else
     {
         // dnames must come from the domain being queried
-        return nullptr;
+        co_return nullptr;
     }
 
     // now resolve it
@@ -319,7 +489,7 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
 
     rq->set_request(rm);
 
-    auto ca = make_shared<dns_recursive_cache_answer>(*resolve(rq.get(), depth));
+    auto ca = make_shared<dns_recursive_cache_answer>(*co_await resolve(rq.get(), depth));
 
     switch (ca->get_type())
     {
@@ -334,10 +504,10 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
         THROW(recursive_resolver_fail_exception, "DNAME resolution failed");
     }
 
-    return ca;
+    co_return ca;
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserver_ips(
+task<shared_ptr<const dns_recursive_cache_answer>> dns_recursive_slot::query_nameserver_ips(
                                                     const shared_ptr<const dns_recursive_cache_answer> &referred_by,
                                                     dns_message_envelope  *m,
                                                     const set<ip_address> &ip_addresses,
@@ -345,7 +515,7 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
 {
     if (ip_addresses.size() == 0)
     {
-        return shared_ptr<dns_recursive_cache_answer>(nullptr);
+        co_return shared_ptr<dns_recursive_cache_answer>(nullptr);
     }
 
     // query to be sent to the nameserver
@@ -355,13 +525,9 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
     qm.set_is_recursion_desired(false);
     qm.set_question(m->get_request()->get_question());
 
-    duration<double> elapsed = duration_cast<duration<double>>(steady_clock::now() - m_start_time);
-
     check_timeout(m);
 
-    m_client.set_ip_addresses(ip_addresses);
-
-    unique_ptr<dns_message> res(m_client.query(qm));
+    unique_ptr<dns_message> res(co_await m_loop.query(qm, ip_addresses));
     check_timeout(m);
 
     if (res)
@@ -380,24 +546,24 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
         case additional_data_e:
             // merge the additional records into the answer records
             ans->add_answer_records(ans->get_additional_records());
-            return ans;
+            co_return ans;
             
         case data_e:
         case no_data_e:
         case nxdomain_e:
         case fail_e:
             m_cache->add_answer(m->get_request()->get_question(), ans);
-            return ans;
+            co_return ans;
 
         case referral_e:
             m_cache->add_referral(m->get_request()->get_question()->get_qname(), ans);
-            return ans;
+            co_return ans;
 
         case cname_e :
-            return query_nameserver_cname(m, ans, depth);
+            co_return co_await query_nameserver_cname(m, ans, depth);
 
         case dname_e :
-            return query_nameserver_dname(m, ans, depth);
+            co_return co_await query_nameserver_dname(m, ans, depth);
 
         default:
             THROW(recursive_resolver_fail_exception, "unknown answer type");
@@ -405,11 +571,11 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
     }
     else
     {
-        return shared_ptr<dns_recursive_cache_answer>(nullptr);
+        co_return shared_ptr<dns_recursive_cache_answer>(nullptr);
     }
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserver(
+task<shared_ptr<const dns_recursive_cache_answer>> dns_recursive_slot::query_nameserver(
                                                     dns_message_envelope                               *m,
                                                     const shared_ptr<const dns_recursive_cache_answer> &cs,
                                                     uint                                               depth)
@@ -436,10 +602,10 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
         // we have glue so try to talk in parallel to the available IPs
         try
         {
-            auto res = query_nameserver_ips(cs, m, all_ip_addresses, depth);
+            auto res = co_await query_nameserver_ips(cs, m, all_ip_addresses, depth);
             if (res)
             {
-                return res;
+                co_return res;
             }
         }
         catch (exception &e)
@@ -451,39 +617,74 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::query_nameserve
         }
     }
 
-    // Either there was no glue or none of the namservers responded, 
-    // so now go nameserver by nameserver depth first but only for
-    // those that had no glue (don't want to retry a dead one).
+    // Either there was no glue or none of the namservers responded, so now
+    // look up the addresses of those that had no glue (don't want to retry a 
+    // dead one). Several lookups run at once and whichever addresses come 
+    // back first get used.
+    list<pair<shared_ptr<dns_name>, dns_rr::type_t>> pending;
+
     for (auto ns : lns_without_glue)
     {
         dns_rr_NS *nsr = dynamic_cast<dns_rr_NS *>(ns.get());
-        
-        resolve_nameserver_ips(all_ip_addresses, nsr->get_nsdname(), depth);
+
+        if (m_params.m_config.dns.client.use_ip4)
+        {
+            pending.push_back(make_pair(nsr->get_nsdname(), dns_rr::T_A_e));
+        }
+        if (m_params.m_config.dns.client.use_ip6)
+        {
+            pending.push_back(make_pair(nsr->get_nsdname(), dns_rr::T_AAAA_e));
+        }
+    }
+
+    auto lookups = make_shared<ns_lookups_t>();
+
+    while (!pending.empty() || (lookups->m_outstanding > 0) || !lookups->m_ready.empty())
+    {
+        while (!pending.empty() && (lookups->m_outstanding < max_parallel_ns_lookups))
+        {
+            auto p = pending.front();
+            pending.pop_front();
+            lookup_nameserver_address(lookups, p.first, p.second, depth);
+        }
+
+        all_ip_addresses = co_await next_ns_addresses{lookups};
+        check_timeout(m);
 
         check_loop(*m->get_request()->get_question(), all_ip_addresses);
 
         if (all_ip_addresses.size() > 0)
         {
-            auto res = query_nameserver_ips(cs, m, all_ip_addresses, depth);
+            auto res = co_await query_nameserver_ips(cs, m, all_ip_addresses, depth);
             if (res)
             {
-                return res;
+                co_return res;
             }
         }
     }
 
     // can't find any nameserver that will respond
-    return make_shared<dns_recursive_cache_answer>(dns_recursive_cache_answer::fail_e, m_cache->get_default_ttl());
+    co_return make_shared<dns_recursive_cache_answer>(dns_recursive_cache_answer::fail_e, m_cache->get_default_ttl());
 }
 
-shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::resolve(dns_message_envelope *m, uint depth)
+task<shared_ptr<const dns_recursive_cache_answer>> dns_recursive_slot::resolve(dns_message_envelope *m, uint depth)
 {
     if (++depth > m_params.m_config.dns.max_recursion_depth)
     {
         THROW(recursive_resolver_fail_exception, "maximum recursion depth exceeded");
     }
 
-    auto ca = m_cache->get_answer(m->get_request()->get_question(), true);
+    shared_ptr<const dns_recursive_cache_answer> ca;
+
+    if (m == m_top_level_query && m->is_prefetch())
+    {
+        // the whole point is to replace what's in the cache so go straight to the nameservers
+        ca = m_cache->get_referral(m->get_request()->get_question());
+    }
+    else
+    {
+        ca = m_cache->get_answer(m->get_request()->get_question(), true);
+    }
 
     while (true)
     {
@@ -493,10 +694,22 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::resolve(dns_mes
         case dns_recursive_cache_answer::no_data_e:
         case dns_recursive_cache_answer::fail_e:
         case dns_recursive_cache_answer::nxdomain_e:
-            return ca;
+            co_return ca;
 
         case dns_recursive_cache_answer::referral_e:
-            ca = query_nameserver(m, ca, depth);
+            if (ca->get_referral_name().is_root())
+            {
+                // RFC 8806 - answer from the local copy of the root zone rather than asking the root servers
+                auto local = m_cache->get_root_zone_answer(*m->get_request()->get_question());
+
+                if (local)
+                {
+                    ca = local;
+                    break;
+                }
+            }
+
+            ca = co_await query_nameserver(m, ca, depth);
             break;
 
         default:
@@ -507,9 +720,7 @@ shared_ptr<const dns_recursive_cache_answer> dns_recursive_slot::resolve(dns_mes
 
 void dns_recursive_slot::check_timeout(const dns_message_envelope *m)
 {
-    duration<uint, milli> elapsed = duration_cast<duration<uint, milli>>(steady_clock::now() - m_start_time);
-
-    if (elapsed.count() > m_params.m_config.dns.recursive_timeout_ms)
+    if (m_timed_out)
     {
         THROW(recursive_resolver_fail_exception, "timeout, query took more than the configured maximum time");
     }
@@ -544,12 +755,16 @@ void dns_recursive_slot::check_loop(const dns_question &q, set<ip_address> &ip_a
     }
 }
 
-void dns_recursive_slot::process(dns_message_envelope *m)
+task<void> dns_recursive_slot::process(dns_message_envelope *m)
 {
-    m_start_time = steady_clock::now();
     m_query_trail.clear();
     m_top_level_query = m;
-    m_client.reset_sockets();
+    m_timed_out = false;
+    m_deadline = m_loop.add_timer(
+                        milliseconds(m_params.m_config.dns.recursive_timeout_ms), 
+                        [this]() { m_timed_out = true; });
+
+    shared_ptr<const dns_recursive_cache_answer> a;
 
     try
     {
@@ -560,41 +775,70 @@ void dns_recursive_slot::process(dns_message_envelope *m)
         } 
         else
         {
-            auto a = resolve(m);
+            a = co_await resolve(m);
+        }
+    }
+    catch (adns::exception &e)
+    {
+        a = nullptr;
+    }
 
-            switch (a->get_type())
-            {
-            case dns_recursive_cache_answer::data_e:
-                respond_with_answer(m, a);
-                break;
-
-            case dns_recursive_cache_answer::no_data_e:
-                respond_with_no_data(m, a);
-                break;
-
-            case dns_recursive_cache_answer::fail_e:
-                respond_with_error(m, dns_message::server_failure_e);
-                break;
-
-            case dns_recursive_cache_answer::nxdomain_e:
-                respond_with_nxdomain(m, a);
-                break;
-
-            // the resolution process should mean we never get these here
-            default :
-                THROW(recursive_resolver_fail_exception, "got unexpected answer type from resolve()");
-                break;
-            }
+    m_loop.cancel_timer(m_deadline);
+
+    if (!a || a->get_type() == dns_recursive_cache_answer::fail_e)
+    {
+        // RFC 8767 - if the nameservers aren't responding, an old answer beats no answer
+        auto stale = m_cache->get_stale_answer(*m->get_request()->get_question());
+
+        if (stale)
+        {
+            a = stale;
         }
-        m_client.close_sockets();
+    }
+
+    try
+    {
+        respond(m, a);
     }
     catch (adns::exception &e)
     {
-        m_client.close_sockets();
         respond_with_error(m, dns_message::server_failure_e);
     }
 }
 
+void dns_recursive_slot::respond(dns_message_envelope *m, const shared_ptr<const dns_recursive_cache_answer> &a)
+{
+    if (!a)
+    {
+        respond_with_error(m, dns_message::server_failure_e);
+        return;
+    }
+
+    switch (a->get_type())
+    {
+    case dns_recursive_cache_answer::data_e:
+        respond_with_answer(m, a);
+        break;
+
+    case dns_recursive_cache_answer::no_data_e:
+        respond_with_no_data(m, a);
+        break;
+
+    case dns_recursive_cache_answer::fail_e:
+        respond_with_error(m, dns_message::server_failure_e);
+        break;
+
+    case dns_recursive_cache_answer::nxdomain_e:
+        respond_with_nxdomain(m, a);
+        break;
+
+    // the resolution process should mean we never get these here
+    default :
+        THROW(recursive_resolver_fail_exception, "got unexpected answer type from resolve()");
+        break;
+    }
+}
+
 dns_message *dns_recursive_slot::construct_base_response(dns_message_envelope *e)
 {
     dns_message *r = new dns_message;
@@ -610,12 +854,34 @@ dns_message *dns_recursive_slot::construct_base_response(dns_message_envelope *e
     return r;
 }
 
+list<shared_ptr<dns_rr>> dns_recursive_slot::aged_records(const list<shared_ptr<dns_rr>> &rrs, uint age)
+{
+    list<shared_ptr<dns_rr>> res;
+
+    for (auto rr : rrs)
+    {
+        shared_ptr<dns_rr> c(rr->clone());
+        c->set_ttl(rr->get_ttl() > age ? rr->get_ttl() - age : 0);
+        res.push_back(c);
+    }
+
+    return res;
+}
+
 void dns_recursive_slot::respond_with_answer(
                     dns_message_envelope                              *e,
                     const shared_ptr<const dns_recursive_cache_answer> &answer)
 {
-    e->set_response(construct_base_response(e));
-    e->get_response()->add_answers(answer->get_answer_records());
+    if (answer->is_encoded_for(*e->get_request()->get_question()))
+    {
+        e->set_encoded_answer(answer);
+    }
+    else
+    {
+        e->set_response(construct_base_response(e));
+        e->get_response()->add_answers(aged_records(answer->get_answer_records(), answer->get_age()));
+    }
+
     send_response(e);
 }
 
@@ -630,16 +896,25 @@ void dns_recursive_slot::respond_with_no_data(
                     dns_message_envelope                               *e, 
                     const shared_ptr<const dns_recursive_cache_answer> &answer)
 {
+    if (answer->is_encoded_for(*e->get_request()->get_question()))
+    {
+        e->set_encoded_answer(answer);
+        send_response(e);
+        return;
+    }
+
+    uint age = answer->get_age();
+
     e->set_response(construct_base_response(e));
 
     auto soa = answer->get_soa_record();
     if (soa)
     {
-        e->get_response()->add_nameserver(soa);
+        e->get_response()->add_nameserver(aged_records({ soa }, age).front());
     }
 
-    e->get_response()->add_answers(answer->get_answer_records(dns_rr::T_CNAME_e));
-    e->get_response()->add_answers(answer->get_answer_records(dns_rr::T_DNAME_e));
+    e->get_response()->add_answers(aged_records(answer->get_answer_records(dns_rr::T_CNAME_e), age));
+    e->get_response()->add_answers(aged_records(answer->get_answer_records(dns_rr::T_DNAME_e), age));
 
     send_response(e);
 }
@@ -648,17 +923,26 @@ void dns_recursive_slot::respond_with_nxdomain(
                     dns_message_envelope                               *e, 
                     const shared_ptr<const dns_recursive_cache_answer> &answer)
 {
+    if (answer->is_encoded_for(*e->get_request()->get_question()))
+    {
+        e->set_encoded_answer(answer);
+        send_response(e);
+        return;
+    }
+
+    uint age = answer->get_age();
+
     e->set_response(construct_base_response(e));
     e->get_response()->set_response_code(dns_message::name_error_e);
 
     auto soa = answer->get_soa_record();
     if (soa)
     {
-        e->get_response()->add_nameserver(soa);
+        e->get_response()->add_nameserver(aged_records({ soa }, age).front());
     }
 
-    e->get_response()->add_answers(answer->get_answer_records(dns_rr::T_CNAME_e));
-    e->get_response()->add_answers(answer->get_answer_records(dns_rr::T_DNAME_e));
+    e->get_response()->add_answers(aged_records(answer->get_answer_records(dns_rr::T_CNAME_e), age));
+    e->get_response()->add_answers(aged_records(answer->get_answer_records(dns_rr::T_DNAME_e), age));
 
     send_response(e);
 }
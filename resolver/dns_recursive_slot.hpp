@@ -19,22 +19,35 @@
  
 #pragma once
 
+#include <set>
+#include <list>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <coroutine>
 
 #include "types.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
 
 #include "server_config.hpp"
 #include "message_queue.hpp"
 #include "dns_message_envelope.hpp"
 #include "dns_recursive_cache.hpp"
 #include "dns_recursive_slot_manager.hpp"
-#include "dns_parallel_client.hpp"
 
 EXCEPTION_CLASS(recursive_slot_exception, exception)
 
 namespace adns
 {
+    class dns_recursive_loop;
+
+    /**
+     * A single recursive resolution. Slots are coroutines driven by a dns_recursive_loop,
+     * they suspend whilst waiting on upstream nameservers rather than blocking a thread.
+     * Addresses of nameservers without glue are looked up several at a time by child
+     * coroutines, the slot isn't deleted until they've all finished.
+     */
     class dns_recursive_slot
     {
     public:
@@ -58,9 +71,12 @@ namespace adns
         };
 
         /**
-         * constructor - processes updates as part of a handler pool
+         * constructor - upstream queries are made via the given loop
          */
-        dns_recursive_slot(const params_t &params, message_queue<dns_message_envelope *> &queue);
+        dns_recursive_slot(
+                const params_t                        &params, 
+                dns_recursive_loop                    &loop, 
+                message_queue<dns_message_envelope *> &queue);
 
         /** 
          * destructor
@@ -68,14 +84,15 @@ namespace adns
         virtual ~dns_recursive_slot();
 
         /**
-         * wait for any running threads to join
+         * Resolve a single query on the slot's loop thread, the slot is deleted and the loop 
+         * told once the response has been sent.
          */
-        void join();
+        static detached_task run(std::unique_ptr<dns_recursive_slot> slot, dns_message_envelope *m);
 
         /**
          * resolve a single query
          */
-        void process(dns_message_envelope *m);
+        task<void> process(dns_message_envelope *m);
 
         /**
          * send a response to any waiters on the slot
@@ -101,11 +118,15 @@ namespace adns
         // parameters - e.g. the slot manager
         params_t m_params;
 
+        // loop this slot runs on
+        dns_recursive_loop &m_loop;
+
         // outgoing message queue 
         message_queue<dns_message_envelope *> &m_out_queue;
 
-        // time the resolution attempt started
-        std::chrono::steady_clock::time_point m_start_time;
+        // set by a loop timer once the resolution has taken too long
+        bool                    m_timed_out;
+        timer_wheel::timer_id_t m_deadline;
 
         // top level query for this slot
         dns_message_envelope *m_top_level_query;
@@ -113,16 +134,125 @@ namespace adns
         // places we've already asked the question - used for loop checking
         std::set<query_t> m_query_trail;
 
-        // client connection
-        dns_parallel_client m_client;
-
         // shared cache
         std::shared_ptr<dns_recursive_cache> m_cache;
 
+        /**
+         * nameserver address lookups running alongside a resolution, the addresses found 
+         * are collected here as each one finishes
+         */
+        struct ns_lookups_t
+        {
+            ns_lookups_t();
+
+            uint                            m_outstanding;
+            std::list<std::set<ip_address>> m_ready;
+            std::coroutine_handle<>         m_awaiter;
+        };
+
+        /**
+         * co_await to get the next set of addresses from a group of lookups, empty once 
+         * they've all finished without finding anything more
+         */
+        struct next_ns_addresses
+        {
+            std::shared_ptr<ns_lookups_t> m_lookups;
+
+            bool await_ready() const noexcept
+            {
+                return !m_lookups->m_ready.empty() || (m_lookups->m_outstanding == 0);
+            }
+
+            void await_suspend(std::coroutine_handle<> awaiter) noexcept
+            {
+                m_lookups->m_awaiter = awaiter;
+            }
+
+            std::set<ip_address> await_resume();
+        };
+
+        /**
+         * co_await to join a nameserver address lookup another slot is already doing. Resumes 
+         * true straight away if nobody is, the caller must then do it and tell the slot manager 
+         * when it's done.
+         */
+        class shared_lookup
+        {
+        public:
+
+            shared_lookup(dns_recursive_slot &slot, const dns_question &q);
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiter);
+
+            bool await_resume() const noexcept
+            {
+                return m_owner;
+            }
+
+            /**
+             * answer from the other slot (null if it failed or took too long)
+             */
+            std::shared_ptr<const dns_recursive_cache_answer> get_answer() const;
+
+        private:
+
+            struct state_t
+            {
+                state_t();
+
+                bool                                              m_done;
+                std::coroutine_handle<>                           m_awaiter;
+                std::shared_ptr<const dns_recursive_cache_answer> m_answer;
+                timer_wheel::timer_id_t                           m_timer;
+            };
+
+            dns_recursive_slot       &m_slot;
+            dns_question             m_question;
+            bool                     m_owner;
+            std::shared_ptr<state_t> m_state;
+        };
+
+        /**
+         * co_await until all the slot's child lookups have finished
+         */
+        struct children_finished
+        {
+            dns_recursive_slot &m_slot;
+
+            bool await_ready() const noexcept
+            {
+                return m_slot.m_children == 0;
+            }
+
+            void await_suspend(std::coroutine_handle<> awaiter) noexcept
+            {
+                m_slot.m_children_awaiter = awaiter;
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        // max nameserver address lookups (A and AAAA count separately) in progress at once per referral
+        static const uint max_parallel_ns_lookups = 6;
+
+        // child lookups still running and what's waiting for them to finish
+        uint                    m_children;
+        std::coroutine_handle<> m_children_awaiter;
+
+        // nameserver address lookups this slot is doing on behalf of others
+        std::set<dns_question> m_owned_lookups;
+
         /**
          * recursively resolve a query
          */
-        std::shared_ptr<const dns_recursive_cache_answer> resolve(
+        task<std::shared_ptr<const dns_recursive_cache_answer>> resolve(
                         dns_message_envelope *m,
                         uint                 depth = 0);
 
@@ -140,7 +270,7 @@ namespace adns
         /**
          * query a nameserver for an answer - automatically caching as we go
          */
-        std::shared_ptr<const dns_recursive_cache_answer> query_nameserver(
+        task<std::shared_ptr<const dns_recursive_cache_answer>> query_nameserver(
                             dns_message_envelope                                    *m,
                             const std::shared_ptr<const dns_recursive_cache_answer> &cs,
                             uint                                                    depth);
@@ -166,32 +296,51 @@ namespace adns
                     std::shared_ptr<dns_rr>                                 &ns, 
                     const std::shared_ptr<const dns_recursive_cache_answer> &cs);
 
-        // recursively resolve A & AAAA records for a nameserver
-        void resolve_nameserver_ips(
-                    std::set<ip_address>            &ip_addresses, 
+        // recursively resolve the A or AAAA records for a nameserver, sharing the work with other slots
+        task<std::set<ip_address>> resolve_nameserver_address(
                     const std::shared_ptr<dns_name> &n,
+                    dns_rr::type_t                  t,
                     uint                            depth);
 
+        /**
+         * child coroutine resolving a nameserver address into a group of lookups
+         */
+        detached_task lookup_nameserver_address(
+                    std::shared_ptr<ns_lookups_t> lookups,
+                    std::shared_ptr<dns_name>     n,
+                    dns_rr::type_t                t,
+                    uint                          depth);
+
+        /**
+         * send the response for a resolved answer (servfail if there isn't one)
+         */
+        void respond(dns_message_envelope *m, const std::shared_ptr<const dns_recursive_cache_answer> &a);
+
         // recursively resolve a CNAME
-        std::shared_ptr<const dns_recursive_cache_answer> query_nameserver_cname(
+        task<std::shared_ptr<const dns_recursive_cache_answer>> query_nameserver_cname(
                             dns_message_envelope                                    *m,
                             const std::shared_ptr<const dns_recursive_cache_answer> &ans,
                             uint                                                    depth);
 
         // recursively resolve a DNAME
-        std::shared_ptr<const dns_recursive_cache_answer> query_nameserver_dname(
+        task<std::shared_ptr<const dns_recursive_cache_answer>> query_nameserver_dname(
                             dns_message_envelope                                    *m,
                             const std::shared_ptr<const dns_recursive_cache_answer> &ans,
                             uint                                                    depth);
 
         // query a set of IP addresses of nameservers in parallel
-        std::shared_ptr<const dns_recursive_cache_answer> query_nameserver_ips(
+        task<std::shared_ptr<const dns_recursive_cache_answer>> query_nameserver_ips(
                             const std::shared_ptr<const dns_recursive_cache_answer> &referred_by,
                             dns_message_envelope       *m,
                             const std::set<ip_address> &ip_addresses,
                             uint                       depth);
 
     
+        /**
+         * copies of records with their TTLs reduced by the age of the answer they came from
+         */
+        static std::list<std::shared_ptr<dns_rr>> aged_records(const std::list<std::shared_ptr<dns_rr>> &rrs, uint age);
+
         /**
          * respond to a request with an answer containing resource records
          */
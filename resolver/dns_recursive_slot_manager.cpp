@@ -61,3 +61,39 @@ list<dns_message_envelope *> dns_recursive_slot_manager::clear_waiters(const dns
         return res;
     }
 }
+
+bool dns_recursive_slot_manager::join_lookup(const dns_question &q, const lookup_done_t &done)
+{
+    lock_guard<mutex> guard(m_mutex);
+    auto l = m_lookups.find(q);
+    if (l == m_lookups.end())
+    {
+        m_lookups[q];
+        return false;
+    }
+    else
+    {
+        l->second.push_back(done);
+        return true;
+    }
+}
+
+void dns_recursive_slot_manager::finish_lookup(const dns_question &q, const shared_ptr<const dns_recursive_cache_answer> &a)
+{
+    list<lookup_done_t> w;
+
+    {
+        lock_guard<mutex> guard(m_mutex);
+        auto l = m_lookups.find(q);
+        if (l != m_lookups.end())
+        {
+            w.swap(l->second);
+            m_lookups.erase(l);
+        }
+    }
+
+    for (auto &done : w)
+    {
+        done(a);
+    }
+}
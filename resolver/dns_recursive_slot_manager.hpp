@@ -19,24 +19,34 @@
  
 #pragma once
 
+#include <list>
 #include <mutex>
+#include <memory>
+#include <functional>
 #include <unordered_map>
 
 #include "types.hpp"
 
 #include "dns_message_envelope.hpp"
+#include "dns_recursive_cache_answer.hpp"
 
 namespace adns
 {
     /**
      * Keep track of whether a slot is currently handling a specific question.
      * This stops loads of parallel requests to the same external servers
-     * with the same question under heavy load scenarios.
+     * with the same question under heavy load scenarios. The same goes for 
+     * the nameserver address lookups slots make part way through a resolution.
      */
     class dns_recursive_slot_manager
     {
     public:
 
+        /**
+         * called with the answer when a shared lookup finishes (null if it failed)
+         */
+        typedef std::function<void (const std::shared_ptr<const dns_recursive_cache_answer> &)> lookup_done_t;
+
         // constructor
         dns_recursive_slot_manager();
 
@@ -52,8 +62,22 @@ namespace adns
          */
         std::list<dns_message_envelope*> clear_waiters(const dns_question &q);
 
+        /**
+         * Wait for a nameserver address lookup some other slot is already doing. done is 
+         * called on whichever thread finishes the lookup.
+         * @return  false if nobody is doing it yet, the caller must then do it and call
+         *          finish_lookup
+         */
+        bool join_lookup(const dns_question &q, const lookup_done_t &done);
+
+        /**
+         * a nameserver address lookup has finished, pass the answer on to anyone waiting
+         */
+        void finish_lookup(const dns_question &q, const std::shared_ptr<const dns_recursive_cache_answer> &a);
+
     private:
         std::unordered_map<dns_question, std::list<dns_message_envelope *>> m_waiters;
+        std::unordered_map<dns_question, std::list<lookup_done_t>> m_lookups;
         std::mutex m_mutex;
     };
 }
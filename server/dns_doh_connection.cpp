@@ -43,7 +43,10 @@ dns_doh_connection::dns_doh_connection(
                         shared_ptr<dns_forwarding_resolver> p_forwarding_resolver,
                         thread_pool<dns_doh_connection>     &pool) :
                             m_config(config),
-                            m_pool(pool)
+                            m_pool(pool),
+                            m_session(nullptr),
+                            m_in_flight(0),
+                            m_session_id(0)
 {
     m_connection_arrived = false;
 
@@ -62,10 +65,16 @@ dns_doh_connection::dns_doh_connection(
     params.p_forwarding_resolver = p_forwarding_resolver;
     params.check_message_length = false;
 
+    // the queues need to be long enough for every stream a client is allowed to have open
     m_handler_pool = new handler_pool<dns_message_envelope *, dns_handler, dns_handler::params_t>(
-                                    "DNS DoH connection mini-handler pool", params, 100, 100, 1);
+                                    "DNS DoH connection mini-handler pool", 
+                                    params, 
+                                    max(100u, config.dns.max_doh_streams), 
+                                    max(100u, config.dns.max_doh_streams), 
+                                    1);
 
     m_receive_thread.reset(new thread(&dns_doh_connection::run, this));
+    m_send_thread.reset(new thread(&dns_doh_connection::send_answers, this));
 }
 
 dns_doh_connection::~dns_doh_connection()
@@ -116,109 +125,245 @@ void dns_doh_connection::run()
                 }
             }
 
-            http h(http::doh_e, *m_socket, m_config.dns.doh_client_timeout_ms);
+            try
+            {
+                serve();
+            }
+            catch (tcp_socket_timeout_exception &e)
+            {
+            }
+            catch (tcp_socket_eof_exception &e)
+            {
+            }
 
-            while (true)
+            done();
+
+            if (run_state::o_state == run_state::shutdown_e)
             {
-                try
-                {
-                    auto req = h.from_wire();
+                return;
+            }
+        }
+        catch (adns::exception &e)
+        {
+            done();
 
-                    buffer b;
-                    dns_message_envelope *m = nullptr;
+            if (run_state::o_state == run_state::shutdown_e)
+            {
+                return;
+            }
+        }
+    }
+}
 
-                    if (req->get_method() == "GET")
-                    {
-                        extract_get_request(req, b);
-                        m = new dns_message_envelope(b, m_socket->get_remote_address());
-                    }
-                    else if (req->get_method() == "POST")
-                    {
-                        extract_post_request(req, b);
-                        m = new dns_message_envelope(b, m_socket->get_remote_address());
-                    }
-                    else
-                    {
-                        THROW(dns_doh_connection_exception, "invalid method", req->get_method());
-                    }
+void dns_doh_connection::serve()
+{
+    http h(http::doh_e, *m_socket, m_config.dns.doh_client_timeout_ms, m_config.dns.max_doh_streams);
 
-                    // pass it to the handler (via the multiplexer) for processing
-                    if (!m_handler_pool->enqueue(m))
-                    {
-                        // something failed, cleanup and exit this connection
-                        delete m;
-                        done();
-                        break;
-                    }
+    {
+        lock_guard<mutex> guard(m_session_lock);
+        m_session = &h;
+        m_session_id++;
+        m_in_flight = 0;
+    }
 
-                    // wait for a response
-                    while (true)
-                    {
-                        try
-                        {
-                            m = m_handler_pool->dequeue();
-                            break;
-                        }
-                        catch (message_queue_timeout_exception &e)
-                        {
-                            if (run_state::o_state == run_state::shutdown_e)
-                            {
-                                done();
-                                return;
-                            }
-                        }
-                    }
+    try
+    {
+        if (h.is_multiplexed())
+        {
+            serve_streams(h);
+        }
+        else
+        {
+            serve_requests(h);
+        }
+    }
+    catch (...)
+    {
+        lock_guard<mutex> guard(m_session_lock);
+        m_session = nullptr;
+        throw;
+    }
 
-                    try
-                    {
-                        auto res = make_shared<http_response>(req->get_stream_id(), http_response::ok_200, m->get_raw());
-                        res->add_header("cache-control", "private, max-age=" + boost::lexical_cast<string>(m->get_response()->get_min_ttl()));
-                        h.to_wire(*res);
+    lock_guard<mutex> guard(m_session_lock);
+    m_session = nullptr;
+}
 
-                        // cleanup
-                        delete m;
-                    }
-                    catch (...)
-                    {
-                        // cleanup
-                        delete m;
+void dns_doh_connection::serve_requests(http &h)
+{
+    while (true)
+    {
+        auto req = h.from_wire();
 
-                        throw;
-                    }
-        
-                    if (!h.keep_alive())
-                    {
-                        done();
-                        return;
-                    }
+        if (!dispatch(req))
+        {
+            return;
+        }
 
-                }
-                catch (tcp_socket_timeout_exception &e)
+        // responses have to go back in the order the requests came in so wait for this
+        // one to be sent before reading the next
+        {
+            unique_lock<mutex> guard(m_session_lock);
+
+            while (m_in_flight > 0)
+            {
+                if ((m_answered.wait_for(guard, chrono::seconds(2)) == cv_status::timeout) &&
+                    (run_state::o_state == run_state::shutdown_e))
                 {
-                    done();
-                    break;
+                    return;
                 }
-                catch (tcp_socket_eof_exception &e)
+            }
+        }
+
+        if (!h.keep_alive() || (run_state::o_state == run_state::shutdown_e))
+        {
+            return;
+        }
+    }
+}
+
+void dns_doh_connection::serve_streams(http &h)
+{
+    m_socket->set_non_blocking();
+    m_sockets.add(m_socket);
+
+    try
+    {
+        auto last_request = chrono::steady_clock::now();
+        chrono::duration<int, milli> timeout(m_config.dns.doh_client_timeout_ms);
+
+        while (run_state::o_state != run_state::shutdown_e)
+        {
+            vector<shared_ptr<http_request>> requests;
+
+            {
+                lock_guard<mutex> guard(m_session_lock);
+                requests = h.from_wire_available();
+            }
+
+            for (auto &req : requests)
+            {
+                if (!dispatch(req))
                 {
-                    done();
-                    break;
+                    THROW(dns_doh_connection_exception, "handler queue full");
                 }
+                last_request = chrono::steady_clock::now();
+            }
+
+            try
+            {
+                (void)m_sockets.wait_many(1000);
+            }
+            catch (socket_set_timeout_exception &e)
+            {
+                // idle clients are dropped, but not whilst they're still owed answers
+                lock_guard<mutex> guard(m_session_lock);
 
-                if (run_state::o_state == run_state::shutdown_e)
+                if ((m_in_flight == 0) && ((chrono::steady_clock::now() - last_request) > timeout))
                 {
-                    return;
+                    break;
                 }
             }
         }
-        catch (adns::exception &e)
-        {
-            done();
+    }
+    catch (...)
+    {
+        m_sockets.remove(m_socket);
+        throw;
+    }
+
+    m_sockets.remove(m_socket);
+}
+
+bool dns_doh_connection::dispatch(shared_ptr<http_request> &req)
+{
+    buffer b;
+
+    if (req->get_method() == "GET")
+    {
+        extract_get_request(req, b);
+    }
+    else if (req->get_method() == "POST")
+    {
+        extract_post_request(req, b);
+    }
+    else
+    {
+        THROW(dns_doh_connection_exception, "invalid method", req->get_method());
+    }
+
+    auto m = new dns_message_envelope(b, m_socket->get_remote_address());
+
+    // the session and stream are needed to get the answer back to the right place
+    {
+        lock_guard<mutex> guard(m_session_lock);
+        m->set_connection_id((uint64_t(m_session_id) << 32) | req->get_stream_id());
+        m_in_flight++;
+    }
+
+    // pass it to the handler (via the multiplexer) for processing
+    if (!m_handler_pool->enqueue(m))
+    {
+        lock_guard<mutex> guard(m_session_lock);
+        m_in_flight--;
+        delete m;
+        return false;
+    }
 
+    return true;
+}
+
+void dns_doh_connection::send_answers()
+{
+    while (true)
+    {
+        try
+        {
+            answer(m_handler_pool->dequeue());
+        }
+        catch (message_queue_timeout_exception &e)
+        {
             if (run_state::o_state == run_state::shutdown_e)
             {
                 return;
             }
         }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught in dns_doh_connection::send_answers");
+        }
+    }
+}
+
+void dns_doh_connection::answer(dns_message_envelope *m)
+{
+    lock_guard<mutex> guard(m_session_lock);
+
+    // the client the query came from has gone, nobody to answer
+    if ((m_session == nullptr) || ((m->get_connection_id() >> 32) != m_session_id))
+    {
+        delete m;
+        return;
+    }
+
+    m_in_flight--;
+    m_answered.notify_all();
+
+    try
+    {
+        auto res = make_shared<http_response>(uint32_t(m->get_connection_id() & 0xffffffff), http_response::ok_200, m->get_raw());
+        res->add_header("cache-control", "private, max-age=" + boost::lexical_cast<string>(m->get_response() ? m->get_response()->get_min_ttl() : m->get_min_ttl()));
+        m_session->to_wire(*res);
+
+        // cleanup
+        delete m;
+    }
+    catch (adns::exception &e)
+    {
+        // cleanup
+        delete m;
+
+        // the connection's no good any more, make sure the reader finds out
+        m_socket->shutdown();
     }
 }
 
@@ -243,5 +388,6 @@ void dns_doh_connection::serve(const shared_ptr<tcp_socket> &socket)
 void dns_doh_connection::join()
 {
     m_receive_thread->join();
+    m_send_thread->join();
     m_handler_pool->join();
 }
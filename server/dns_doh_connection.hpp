@@ -21,6 +21,7 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 
 #include "types.hpp"
 
@@ -30,7 +31,9 @@
 #include "dns_message_envelope.hpp"
 #include "dns_handler.hpp"
 #include "tcp_socket.hpp"
+#include "socket_set.hpp"
 #include "server_config.hpp"
+#include "http.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
 
@@ -43,7 +46,9 @@ namespace adns
     /**
      * Handle a single https connection. Reads messages off the wire, passes
      * them onto a handler, takes back the results and puts them back
-     * on the wire.
+     * on the wire. With HTTP 2 every stream is passed on as soon as it's complete
+     * and the answers go back in whatever order they're ready, with HTTP 1.1 it's
+     * one request at a time.
      */
     class dns_doh_connection final
     {
@@ -76,7 +81,7 @@ namespace adns
         void serve(const std::shared_ptr<tcp_socket> &socket);
 
         /**
-         * wait for the service thread to complete
+         * wait for the service and send threads to complete
          */
         void join();
 
@@ -94,12 +99,59 @@ namespace adns
 
         thread_pool<dns_doh_connection> &m_pool;
         std::shared_ptr<std::thread> m_receive_thread;
+        std::shared_ptr<std::thread> m_send_thread;
+
+        // used to wait for an HTTP 2 client to send more
+        socket_set m_sockets;
+
+        // the session for the client being served (null between clients) along with how
+        // many of its queries are with the handler. The send thread writes to the session
+        // so it's only used with the session lock held.
+        std::mutex m_session_lock;
+        std::condition_variable m_answered;
+        http *m_session;
+        uint m_in_flight;
+
+        // goes up by one for each client, answers for earlier ones are thrown away
+        uint32_t m_session_id;
 
         /**
          * pool of exactly one handler for TCP
          */
         handler_pool<dns_message_envelope *, dns_handler, dns_handler::params_t> *m_handler_pool;
 
+        /**
+         * serve the current client until it goes away, times out or errors
+         */
+        void serve();
+
+        /**
+         * HTTP 1.1 - read a request, wait for it to be answered, read the next and so on
+         */
+        void serve_requests(http &h);
+
+        /**
+         * HTTP 2 - pass on every request as soon as it has been read, the send thread 
+         * answers them as they come back
+         */
+        void serve_streams(http &h);
+
+        /**
+         * make a query from a request and pass it on to the handler, false if the
+         * handler couldn't take it
+         */
+        bool dispatch(std::shared_ptr<http_request> &req);
+
+        /**
+         * take answers back from the handler and write them to the client they're for
+         */
+        void send_answers();
+
+        /**
+         * write an answer to the client (if it's still there), takes ownership
+         */
+        void answer(dns_message_envelope *m);
+
         /**
          * wait for a connection to arrive, then return
          */
@@ -24,6 +24,7 @@
 
 #include "types.hpp"
 #include "dns_doh_server.hpp"
+#include "dns_recursive_cache.hpp"
 #include "config.hpp"
 #include "run_state.hpp"
 #include "dns_zone.hpp"
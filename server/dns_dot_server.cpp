@@ -22,8 +22,11 @@
 #include <memory>
 #include <thread>
 
+#include <boost/lexical_cast.hpp>
+
 #include "types.hpp"
 #include "dns_dot_server.hpp"
+#include "dns_recursive_cache.hpp"
 #include "config.hpp"
 #include "run_state.hpp"
 #include "dns_zone.hpp"
@@ -35,26 +38,77 @@ using namespace boost::log::trivial;
 dns_dot_server::dns_dot_server(boost::asio::io_service &io_service, const server_config &config) :
     server(io_service),
     m_config(config),
+    m_next_loop(0),
     m_auth_resolver(dns_auth_resolver::get_instance(config)),
     m_recursive_resolver(new dns_recursive_resolver(config, true)),
     m_forwarding_resolver(new dns_forwarding_resolver(config))
 {
-    for (uint i = 0; i < m_config.dns.num_tcp_threads; i++)
+    dns_handler::params_t params;
+
+    params.config = m_config;
+    params.is_tcp = true;
+    params.p_auth_resolver = m_auth_resolver;
+    params.p_recursive_resolver = m_recursive_resolver;
+    params.p_forwarding_resolver = m_forwarding_resolver;
+    params.check_message_length = false;
+
+    m_handler_pool = new handler_pool<dns_message_envelope *, dns_handler, dns_handler::params_t>(
+                                                                "DNS DoT server handler pool",
+                                                                params,
+                                                                m_config.dns.max_in_message_queue_length,
+                                                                m_config.dns.max_out_message_queue_length,
+                                                                m_config.dns.num_tcp_threads,
+                                                                vector<int>(),
+                                                                dns_handler::num_lanes,
+                                                                dns_handler::get_shed_policy(m_config));
+
+    uint n = max<uint>(1, m_config.dns.num_receive_threads);
+
+    for (uint i = 0; i < n; i++)
     {
-        m_server_threads.add(new dns_tcp_connection(m_config, m_auth_resolver, m_recursive_resolver, m_forwarding_resolver, m_server_threads));
+        m_loops.push_back(make_shared<dns_tcp_loop>(
+                                name() + " " + boost::lexical_cast<string>(m_config.server_id) + " " + boost::lexical_cast<string>(i),
+                                i,
+                                n,
+                                m_config,
+                                [this](dns_message_envelope *m) { return m_handler_pool->enqueue(m, dns_handler::get_lane(m)); }));
     }
+
     dns_zone::init();
 }
 
 void dns_dot_server::run()
 {
+    for (auto l : m_loops)
+    {
+        l->run();
+    }
+
+    for (uint i = 0; i < max<uint>(1, m_config.dns.num_send_threads); i++)
+    {
+        m_send_threads.push_back(make_shared<thread>(&dns_dot_server::send_outbound, this));
+    }
+
     m_receive_thread = make_shared<thread>(&dns_dot_server::accept_inbound, this);
 }
 
 void dns_dot_server::join()
 {
     m_receive_thread->join();
-    m_server_threads.join();
+
+    for (auto l : m_loops)
+    {
+        l->join();
+    }
+
+    m_handler_pool->join();
+
+    while (!m_send_threads.empty())
+    {
+        m_send_threads.front()->join();
+        m_send_threads.pop_front();
+    }
+
     m_recursive_resolver->join();
     m_forwarding_resolver->join();
     dns_recursive_cache::get_instance()->join();
@@ -62,6 +116,7 @@ void dns_dot_server::join()
 
 dns_dot_server::~dns_dot_server()
 {
+    delete m_handler_pool;
 }
 
 void dns_dot_server::connect()
@@ -94,9 +149,10 @@ void dns_dot_server::accept_inbound()
                 {
                     auto s = get<0>(m_socket_set.wait_one());
 
-                    for (auto cs : dynamic_cast<ssl_server_socket *>(s.get())->accept_many())
+                    // the handshake is left to the loop so a slow client can't hold up the others
+                    for (auto cs : dynamic_cast<ssl_server_socket *>(s.get())->accept_pending())
                     {
-                        m_server_threads.get()->serve(cs);
+                        m_loops[m_next_loop++ % m_loops.size()]->add(cs, true);
                     }
                 }
             }
@@ -106,8 +162,11 @@ void dns_dot_server::accept_inbound()
             catch (socket_set_timeout_exception &e)
             {
             }
-            catch (thread_pool_timeout_exception &e)
+            catch (tcp_socket_exception &e)
             {
+                // most likely out of file descriptors, the connections already open carry on
+                e.log(error, "failed to accept connection");
+                sleep(1);
             }
         }
     }
@@ -118,6 +177,29 @@ void dns_dot_server::accept_inbound()
     }
 }
 
+void dns_dot_server::send_outbound()
+{
+    while (true)
+    {
+        try
+        {
+            auto m = m_handler_pool->dequeue();
+            m_loops[dns_tcp_loop::get_loop_index(m->get_connection_id(), m_loops.size())]->respond(m);
+        }
+        catch (message_queue_timeout_exception &e)
+        {
+            if (run_state::o_state == run_state::shutdown_e)
+            {
+                return;
+            }
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "failed to send message, dropping");
+        }
+    }
+}
+
 string dns_dot_server::name() const
 {
     return "DNS DoT server";
@@ -29,16 +29,22 @@
 #include "dns_zone_guard.hpp"
 #include "run_state.hpp"
 #include "dns_horizon.hpp"
+#include "log_queue.hpp"
+#include "monitor.hpp"
 
 using namespace std;
+using namespace chrono;
 using namespace adns;
 using namespace boost::log::trivial;
 
+atomic<uint> dns_handler::o_num_expired(0);
+
 dns_handler::dns_handler(const params_t &params, message_queue<dns_message_envelope *> &q) :
             m_config(params.config), 
             m_auth_resolver(params.p_auth_resolver),
             m_recursive_resolver(params.p_recursive_resolver),
             m_forwarding_resolver(params.p_forwarding_resolver),
+            m_recursive_cache(dns_recursive_cache::get_instance()),
             m_out_queue(q),
             m_check_message_length(params.check_message_length),
             m_is_tcp(params.is_tcp)
@@ -63,6 +69,83 @@ dns_handler::~dns_handler()
 {
 }
 
+uint dns_handler::get_lane(dns_message_envelope *m)
+{
+    dns_message_parser p;
+
+    // without RD it's authoritative or refused, either way there's nothing to wait for
+    if (!p.extract_recursion_desired(m->get_raw()))
+    {
+        return priority_lane;
+    }
+
+    auto q = p.extract_question(m->get_raw());
+    dns_horizon *h = dns_horizon::get(m->get_remote_address().get_ip_address());
+
+    if (!q || !h)
+    {
+        // either garbage or black holed, cheap to deal with whichever
+        return priority_lane;
+    }
+
+    {
+        dns_zone_guard guard(dns_zone_guard::read_e);
+
+        if (dns_zone::find(h->get_horizon_id(), q->get_qname()))
+        {
+            return priority_lane;
+        }
+    }
+
+    if (h->allow_recursion())
+    {
+        auto cache = dns_recursive_cache::get_instance();
+
+        if (cache)
+        {
+            auto a = cache->get_inline_answer(q);
+
+            if (a)
+            {
+                m->set_encoded_answer(a);
+                return priority_lane;
+            }
+        }
+    }
+
+    return normal_lane;
+}
+
+message_queue<dns_message_envelope *>::shed_policy_t dns_handler::get_shed_policy(const server_config &config)
+{
+    if (config.dns.queue_shed_policy == "shed_lowest")
+    {
+        return message_queue<dns_message_envelope *>::shed_lowest_e;
+    }
+    else
+    {
+        return message_queue<dns_message_envelope *>::refuse_new_e;
+    }
+}
+
+bool dns_handler::expired(dns_message_envelope *m) const
+{
+    if (m_config.dns.max_queue_wait_ms == 0)
+    {
+        return false;
+    }
+
+    return (steady_clock::now() - m->get_received_time()) > milliseconds(m_config.dns.max_queue_wait_ms);
+}
+
+void dns_handler::count_expired()
+{
+    // one monitor for all the handlers, set up on first use
+    static uint id = monitor::add_thing("DNS handler", "singleton", "queries dropped past deadline", 0);
+
+    monitor::set_value(id, ++o_num_expired);
+}
+
 dns_message_envelope *dns_handler::dequeue_from_resolver()
 {
     if (m_is_tcp)
@@ -224,6 +307,18 @@ bool dns_handler::feature_not_supported(dns_message *request, string &notes)
 
 void dns_handler::process(dns_message_envelope *m)
 {
+    if (expired(m))
+    {
+        // the client has most likely retried or given up by now so answering is wasted effort
+        count_expired();
+        delete m;
+        return;
+    }
+
+    // any answer found in the cache when the query was queued
+    auto cached = m->get_encoded_answer();
+    m->set_encoded_answer(nullptr);
+
     dns_horizon *h = dns_horizon::get(m->get_remote_address().get_ip_address());
 
     if (!h)
@@ -265,24 +360,27 @@ void dns_handler::process(dns_message_envelope *m)
 
     if (feature_not_supported(m->get_request(), notes))
     {
-        LOG(info) << notes;
+        ALOG_LIMITED(info, 10) << notes;
         respond_with_error(m, h->allow_recursion(), dns_message::not_implemented_e);
         return;
     }
 
     if (m->get_request()->get_type() == dns_message::response_e)
     {
-        LOG(warning) << "got a response on the main server port - potential cache poisoning attempt";
+        ALOG_LIMITED(warning, 1) << "got a response on the main server port - potential cache poisoning attempt";
         delete m;
         return;
     }
     else
     {
-        handle_request(m, h);
+        handle_request(m, h, cached);
     }
 }
 
-void dns_handler::handle_request(dns_message_envelope *m, const dns_horizon *h)
+void dns_handler::handle_request(
+                dns_message_envelope                             *m, 
+                const dns_horizon                                *h,
+                const shared_ptr<const dns_encoded_answer>       &cached)
 {
     auto request = m->get_request();
     auto remote_address = m->get_remote_address();
@@ -312,7 +410,7 @@ void dns_handler::handle_request(dns_message_envelope *m, const dns_horizon *h)
                 }
                 else
                 {
-                    m->set_forwarding(z->get_forward_ip_address(), z->get_forward_port());
+                    m->set_forwarding(z->get_forwarders());
                     m_forwarding_resolver->enqueue(m);
                 }
             }
@@ -342,7 +440,7 @@ void dns_handler::handle_request(dns_message_envelope *m, const dns_horizon *h)
             {
                 respond_with_error(m, h->allow_recursion(), dns_message::refused_e);
             }
-            else
+            else if (!respond_from_cache(m, h->allow_recursion(), cached))
             {
                 enqueue_to_resolver(m);
             }
@@ -376,12 +474,18 @@ void dns_handler::handle_request(dns_message_envelope *m, const dns_horizon *h)
 
 void dns_handler::send_response(dns_message_envelope *m, bool allow_recursion)
 {
+    if (m->get_encoded_answer())
+    {
+        send_encoded_response(m, allow_recursion);
+        return;
+    }
+
     // a null response is valid - it means don't send anything back
     auto response = m->get_response();
 
     if (!response)
     {
-        LOG(info) << "null response";
+        ALOG_LIMITED(info, 10) << "null response";
         return;
     }
 
@@ -450,6 +554,61 @@ void dns_handler::send_response(dns_message_envelope *m, bool allow_recursion)
     }
 }
 
+bool dns_handler::respond_from_cache(
+                dns_message_envelope                             *m, 
+                bool                                             allow_recursion,
+                const shared_ptr<const dns_encoded_answer>       &cached)
+{
+    if (!m_recursive_cache)
+    {
+        return false;
+    }
+
+    auto a = cached ? cached : m_recursive_cache->get_inline_answer(m->get_request()->get_question());
+
+    if (!a)
+    {
+        return false;
+    }
+
+    m->set_encoded_answer(a);
+    send_encoded_response(m, allow_recursion);
+
+    return true;
+}
+
+void dns_handler::send_encoded_response(dns_message_envelope *m, bool allow_recursion)
+{
+    auto request = m->get_request();
+    auto &answer = m->get_encoded_answer();
+
+    try
+    {
+        bool edns = config::support_edns() && request->get_is_edns();
+        size_t max_size;
+
+        // only care about the message length (unless it's > 64K) for UDP
+        if (m_check_message_length)
+        {
+            max_size = edns ? min<size_t>(config::edns_size(), request->get_edns_payload_size()) : STANDARD_MESSAGE_SIZE;
+        }
+        else
+        {
+            max_size = MAX_EXTENDED_MESSAGE_SIZE - 1;
+        }
+
+        m->set_min_ttl(answer->get_min_ttl());
+        m->set_raw(answer->to_wire(*request, m->get_raw(), allow_recursion, edns ? config::edns_size() : 0, max_size));
+
+        enqueue_to_return(m);
+    }
+    catch (adns::exception &e)
+    {
+        e.log(error, "exception sending encoded response");
+        respond_with_error(m, allow_recursion, dns_message::server_failure_e);
+    }
+}
+
 void dns_handler::join()
 {
     m_resolver_thread->join();
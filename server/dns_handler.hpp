@@ -20,6 +20,7 @@
 #pragma once
 
 #include <thread>
+#include <atomic>
 
 #include "dns_message_envelope.hpp"
 #include "message_queue.hpp"
@@ -30,6 +31,7 @@
 #include "dns_recursive_resolver.hpp"
 #include "dns_auth_resolver.hpp"
 #include "dns_forwarding_resolver.hpp"
+#include "dns_recursive_cache.hpp"
 
 namespace adns
 {
@@ -47,11 +49,29 @@ namespace adns
             bool                                     check_message_length;
         };
 
+        // input queue lanes, queries that can be answered on the spot go ahead of those that
+        // need the recursive resolver
+        static const uint priority_lane = 0;
+        static const uint normal_lane = 1;
+        static const uint num_lanes = 2;
+
         /**
          * constructor - set up any thread specific data needed
          */
         dns_handler(const params_t &params, message_queue<dns_message_envelope *> &q);
 
+        /**
+         * Pick the input queue lane for a newly arrived query from a quick look at it. A
+         * recursive query found in the cache has the answer attached to save looking it
+         * up again.
+         */
+        static uint get_lane(dns_message_envelope *m);
+
+        /**
+         * what a handler pool's input queue should do when it's full
+         */
+        static message_queue<dns_message_envelope *>::shed_policy_t get_shed_policy(const server_config &config);
+
         /**
          * destructor
          */
@@ -84,6 +104,9 @@ namespace adns
         // forwarding resolver instance
         std::shared_ptr<dns_forwarding_resolver> m_forwarding_resolver;
 
+        // recursive cache - looked at before anything is passed to the recursive resolver
+        std::shared_ptr<dns_recursive_cache> m_recursive_cache;
+
         // thread that gets responses from the recursive resolver and forwards them
         std::shared_ptr<std::thread> m_resolver_thread;
 
@@ -104,6 +127,19 @@ namespace adns
         // TCP or UDP origin?
         bool m_is_tcp;
 
+        // queries dropped for having waited too long, shared by all handlers
+        static std::atomic<uint> o_num_expired;
+
+        /**
+         * has the query waited so long since arriving that the client will have given up?
+         */
+        bool expired(dns_message_envelope *m) const;
+
+        /**
+         * add one to the count of queries dropped for waiting too long
+         */
+        static void count_expired();
+
         /**
          * Send an error response to a message that couldn't be fully parsed.
          */
@@ -128,13 +164,30 @@ namespace adns
         /**
          * handle a request message
          */
-        void handle_request(dns_message_envelope *m, const dns_horizon *h);
+        void handle_request(
+                        dns_message_envelope                             *m, 
+                        const dns_horizon                                *h,
+                        const std::shared_ptr<const dns_encoded_answer> &cached);
 
         /**
          * send a response dealing with EDNS sizing etc.
          */
         void send_response(dns_message_envelope *m, bool allow_recursion);
 
+        /**
+         * answer a recursive query straight from the cache if possible, returns false if the 
+         * query needs to go to the recursive resolver
+         */
+        bool respond_from_cache(
+                        dns_message_envelope                             *m, 
+                        bool                                             allow_recursion,
+                        const std::shared_ptr<const dns_encoded_answer> &cached);
+
+        /**
+         * send a response from a pre-encoded answer
+         */
+        void send_encoded_response(dns_message_envelope *m, bool allow_recursion);
+
         /**
          * get responses from the recursive resolver and forward them on - works in its own thread
          */
@@ -0,0 +1,449 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <boost/lexical_cast.hpp>
+
+#include "types.hpp"
+#include "monitor.hpp"
+#include "run_state.hpp"
+#include "log_queue.hpp"
+#include "ssl_server_socket.hpp"
+#include "dns_tcp_loop.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+using namespace boost::log::trivial;
+
+dns_tcp_loop::connection::connection(uint64_t id, const shared_ptr<tcp_server_socket> &s, bool tls) :
+                    m_id(id),
+                    m_socket(s),
+                    m_handshaking(tls),
+                    m_in_flight(0),
+                    m_eof(false),
+                    m_written(0),
+                    m_wait(none_e),
+                    m_timer(timer_wheel::no_timer)
+{
+}
+
+dns_tcp_loop::dns_tcp_loop(
+                    const string        &name,
+                    uint                index,
+                    uint                num_loops,
+                    const server_config &config,
+                    const dispatch_t    &dispatch) :
+                m_name(name),
+                m_config(config),
+                m_dispatch(dispatch),
+                m_next_id(index + num_loops),
+                m_num_loops(num_loops),
+                m_max_connections(max<size_t>(1, config.dns.max_tcp_connections / num_loops)),
+                m_max_in_flight(max<uint>(1, config.dns.max_tcp_queries_in_flight)),
+                m_notify(make_shared<notify_socket>()),
+                m_refused(0),
+                m_pipelined(0),
+                m_queries(0),
+                m_last_cpu_report(steady_clock::now())
+{
+    m_sockets.add(m_notify);
+
+    m_monitor_open_id = monitor::add_thing("DNS TCP loop", m_name, "open connections", 0);
+    m_monitor_refused_id = monitor::add_thing("DNS TCP loop", m_name, "refused connections", 0);
+    m_monitor_pipelined_id = monitor::add_thing("DNS TCP loop", m_name, "pipelined queries", 0);
+    m_monitor_cpu_id = monitor::add_thing("DNS TCP loop", m_name, "CPU microseconds per query", 0);
+}
+
+dns_tcp_loop::~dns_tcp_loop()
+{
+}
+
+void dns_tcp_loop::run()
+{
+    m_thread.reset(new thread(&dns_tcp_loop::loop, this));
+}
+
+void dns_tcp_loop::join()
+{
+    if (m_thread && m_thread->joinable())
+    {
+        m_thread->join();
+    }
+}
+
+uint dns_tcp_loop::get_loop_index(uint64_t connection_id, uint num_loops)
+{
+    return connection_id % num_loops;
+}
+
+void dns_tcp_loop::add(const shared_ptr<tcp_server_socket> &s, bool tls)
+{
+    post([this, s, tls]() { open_connection(s, tls); });
+}
+
+void dns_tcp_loop::respond(dns_message_envelope *m)
+{
+    post([this, m]() { send_response(m); });
+}
+
+void dns_tcp_loop::post(const function<void ()> &f)
+{
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        m_posted.push_back(f);
+    }
+
+    m_notify->notify();
+}
+
+void dns_tcp_loop::loop()
+{
+    uint wait_ms = 1000;
+
+    while (run_state::o_state != run_state::shutdown_e)
+    {
+        try
+        {
+            for (auto &e : m_sockets.wait_many(wait_ms))
+            {
+                auto s = get<0>(e).get();
+
+                if (s == m_notify.get())
+                {
+                    m_notify->clear();
+                    run_posted();
+                }
+                else
+                {
+                    // may have been closed whilst handling an earlier event
+                    auto c = m_connections.find(s);
+
+                    if (c != m_connections.end())
+                    {
+                        handle(c->second.get());
+                    }
+                }
+            }
+        }
+        catch (socket_set_timeout_exception &e)
+        {
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught in dns_tcp_loop::loop");
+        }
+
+        wait_ms = m_timers.advance();
+
+        report_cpu();
+    }
+}
+
+void dns_tcp_loop::report_cpu()
+{
+    auto now = steady_clock::now();
+
+    if ((m_queries == 0) || ((now - m_last_cpu_report) < seconds(1)))
+    {
+        return;
+    }
+
+    m_last_cpu_report = now;
+
+    struct timespec cpu;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) == 0)
+    {
+        uint64_t us = cpu.tv_sec * 1000000ULL + cpu.tv_nsec / 1000;
+        monitor::set_value(m_monitor_cpu_id, static_cast<uint>(us / m_queries));
+    }
+}
+
+void dns_tcp_loop::run_posted()
+{
+    list<function<void ()>> work;
+
+    {
+        lock_guard<mutex> guard(m_posted_lock);
+        work.swap(m_posted);
+    }
+
+    for (auto &f : work)
+    {
+        try
+        {
+            f();
+        }
+        catch (adns::exception &e)
+        {
+            e.log(error, "exception caught running posted work in dns_tcp_loop");
+        }
+    }
+}
+
+void dns_tcp_loop::open_connection(const shared_ptr<tcp_server_socket> &s, bool tls)
+{
+    if (m_connections.size() >= m_max_connections)
+    {
+        // the socket is closed as it goes out of scope
+        ALOG_LIMITED(warning, 10) << m_name << " has too many open connections, refusing a new one";
+        monitor::set_value(m_monitor_refused_id, ++m_refused);
+        return;
+    }
+
+    auto c = make_shared<connection>(m_next_id, s, tls);
+    m_next_id += m_num_loops;
+
+    m_sockets.add(s);
+    m_connections[s.get()] = c;
+    m_ids[c->m_id] = c.get();
+
+    monitor::set_value(m_monitor_open_id, m_connections.size());
+
+    // anything already sent arrives as an event once the socket is in the set
+    set_timeout(c.get());
+}
+
+void dns_tcp_loop::handle(connection *c)
+{
+    try
+    {
+        if (c->m_handshaking)
+        {
+            if (!static_cast<ssl_server_socket *>(c->m_socket.get())->handshake())
+            {
+                set_timeout(c);
+                return;
+            }
+
+            c->m_handshaking = false;
+        }
+
+        read(c);
+        flush(c);
+
+        if (!next_queries(c))
+        {
+            return;
+        }
+
+        if (c->m_eof && (c->m_in_flight == 0) && c->m_write.empty())
+        {
+            // anything left in the read buffer is a query that's never going to be finished
+            close_connection(c);
+            return;
+        }
+
+        set_timeout(c);
+    }
+    catch (adns::exception &e)
+    {
+        // clients going away part way through, failed handshakes and so on
+        close_connection(c);
+    }
+}
+
+void dns_tcp_loop::read(connection *c)
+{
+    octet data[16384];
+    int n;
+
+    try
+    {
+        // stop once there's plenty buffered, the rest is read once some queries are answered
+        while ((c->m_read.size() < max_read_buffered) && ((n = c->m_socket->read_some(data, sizeof(data))) > 0))
+        {
+            c->m_read.insert(c->m_read.end(), data, data + n);
+        }
+    }
+    catch (tcp_socket_eof_exception &e)
+    {
+        c->m_eof = true;
+    }
+}
+
+void dns_tcp_loop::flush(connection *c)
+{
+    while (c->m_written < c->m_write.size())
+    {
+        int n = c->m_socket->write_some(c->m_write.data() + c->m_written, c->m_write.size() - c->m_written);
+
+        if (n == 0)
+        {
+            // the rest goes when the socket says it's writable again. Responses keep being 
+            // added to the end so don't let what's already gone build up at the front.
+            if (c->m_written >= MAX_EXTENDED_MESSAGE_SIZE)
+            {
+                c->m_write.erase(c->m_write.begin(), c->m_write.begin() + c->m_written);
+                c->m_written = 0;
+            }
+
+            return;
+        }
+
+        c->m_written += n;
+    }
+
+    c->m_write.clear();
+    c->m_written = 0;
+}
+
+bool dns_tcp_loop::next_queries(connection *c)
+{
+    size_t used = 0;
+
+    while ((c->m_in_flight < m_max_in_flight) && 
+           (c->m_write.size() - c->m_written < max_write_buffered) &&
+           (c->m_read.size() - used >= 2))
+    {
+        auto data = c->m_read.data() + used;
+        size_t len = (data[0] << 8) | data[1];
+
+        // if the message isn't long enough to parse, close the connection
+        if (len < MIN_POSSIBLE_MESSAGE_SIZE)
+        {
+            close_connection(c);
+            return false;
+        }
+
+        if (c->m_read.size() - used < len + 2)
+        {
+            break;
+        }
+
+        auto m = new dns_message_envelope(buffer(len, data + 2), c->m_socket->get_remote_address(), nullptr);
+        m->set_connection_id(c->m_id);
+
+        used += len + 2;
+
+        if (!m_dispatch(m))
+        {
+            delete m;
+            close_connection(c);
+            return false;
+        }
+
+        m_queries++;
+
+        if (c->m_in_flight++ > 0)
+        {
+            monitor::set_value(m_monitor_pipelined_id, ++m_pipelined);
+        }
+    }
+
+    c->m_read.erase(c->m_read.begin(), c->m_read.begin() + used);
+
+    return true;
+}
+
+void dns_tcp_loop::send_response(dns_message_envelope *m)
+{
+    unique_ptr<dns_message_envelope> r(m);
+
+    auto i = m_ids.find(m->get_connection_id());
+
+    if (i == m_ids.end())
+    {
+        // the client has already gone
+        return;
+    }
+
+    auto c = i->second;
+    auto &raw = m->get_raw();
+
+    if (raw.get_size() >= MAX_EXTENDED_MESSAGE_SIZE)
+    {
+        // the handlers should never let this happen, there's no way to answer so give up
+        LOG(error) << "response too big for a TCP message, closing connection";
+        close_connection(c);
+        return;
+    }
+
+    c->m_write.push_back((raw.get_size() >> 8) & 0xff);
+    c->m_write.push_back(raw.get_size() & 0xff);
+    c->m_write.insert(c->m_write.end(), raw.get_data(), raw.get_data() + raw.get_size());
+
+    c->m_in_flight--;
+
+    // writes what it can and passes on anything that was held back by the in-flight limit
+    handle(c);
+}
+
+void dns_tcp_loop::set_timeout(connection *c)
+{
+    connection::wait_t w;
+    uint ms;
+
+    if (c->m_handshaking)
+    {
+        w = connection::handshake_e;
+        ms = m_config.dns.tcp_max_body_wait_ms;
+    }
+    else if (!c->m_write.empty())
+    {
+        w = connection::write_e;
+        ms = m_config.dns.tcp_max_body_wait_ms;
+    }
+    else if (!c->m_read.empty() && (c->m_in_flight < m_max_in_flight))
+    {
+        w = connection::rest_of_query_e;
+        ms = m_config.dns.tcp_max_body_wait_ms;
+    }
+    else if (c->m_in_flight > 0)
+    {
+        // the handlers don't say when they drop a query so don't wait for ever on one
+        w = connection::answer_e;
+        ms = m_config.dns.recursive_timeout_ms + m_config.dns.tcp_max_body_wait_ms;
+    }
+    else
+    {
+        w = connection::query_e;
+        ms = m_config.dns.tcp_max_len_wait_ms;
+    }
+
+    // the timeout runs from when the connection started waiting for something, not from the
+    // last bit of data, so a client trickling a byte at a time can't keep it open
+    if (w == c->m_wait)
+    {
+        return;
+    }
+
+    m_timers.cancel(c->m_timer);
+    c->m_wait = w;
+
+    c->m_timer = m_timers.add(milliseconds(ms), [this, c]()
+    {
+        c->m_timer = timer_wheel::no_timer;
+        close_connection(c);
+    });
+}
+
+void dns_tcp_loop::close_connection(connection *c)
+{
+    m_timers.cancel(c->m_timer);
+    c->m_timer = timer_wheel::no_timer;
+
+    m_sockets.remove(c->m_socket);
+    m_ids.erase(c->m_id);
+
+    // c is deleted along with the map entry
+    m_connections.erase(c->m_socket.get());
+
+    monitor::set_value(m_monitor_open_id, m_connections.size());
+}
@@ -0,0 +1,252 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "types.hpp"
+#include "timer_wheel.hpp"
+#include "server_config.hpp"
+#include "socket_set.hpp"
+#include "notify_socket.hpp"
+#include "tcp_server_socket.hpp"
+#include "dns_message_envelope.hpp"
+
+namespace adns
+{
+    /**
+     * An event loop thread looking after a large number of DNS over TCP or DNS over TLS
+     * client connections. Every socket is non-blocking and has its own read and write 
+     * buffers, so a slow client only ever holds up its own connection. Complete queries are 
+     * handed to the handler pool shared by all of a server's loops and the responses are 
+     * posted back with respond(). Clients can pipeline queries (RFC 7766), several from one
+     * connection are answered at once and the responses go back in whatever order they're
+     * ready.
+     */
+    class dns_tcp_loop final
+    {
+    public:
+
+        /**
+         * hands a query on to be answered, false if it couldn't be taken
+         */
+        typedef std::function<bool (dns_message_envelope *)> dispatch_t;
+
+        /**
+         * New loop, the thread isn't started until run() is called. The index and number of
+         * loops are used to hand out connection IDs that say which loop they belong to.
+         */
+        dns_tcp_loop(
+                    const std::string   &name,
+                    uint                index,
+                    uint                num_loops,
+                    const server_config &config,
+                    const dispatch_t    &dispatch);
+
+        virtual ~dns_tcp_loop();
+
+        /**
+         * start the loop thread
+         */
+        void run();
+
+        /**
+         * wait for the loop thread to finish
+         */
+        void join();
+
+        /**
+         * take on a newly accepted connection, TLS ones still need their handshake doing
+         * (may be called from any thread)
+         */
+        void add(const std::shared_ptr<tcp_server_socket> &s, bool tls);
+
+        /**
+         * send a response back on the connection the request came in on, takes ownership
+         * (may be called from any thread)
+         */
+        void respond(dns_message_envelope *m);
+
+        /**
+         * index of the loop that owns a connection
+         */
+        static uint get_loop_index(uint64_t connection_id, uint num_loops);
+
+    private:
+
+        // most client data buffered ahead of the query being answered, enough for the
+        // largest possible message plus some
+        static const size_t max_read_buffered = 2 * MAX_EXTENDED_MESSAGE_SIZE;
+
+        // no more queries are passed on whilst a client has this much waiting to be written
+        // to it, they're read again once it catches up
+        static const size_t max_write_buffered = 2 * MAX_EXTENDED_MESSAGE_SIZE;
+
+        /**
+         * a single client connection
+         */
+        class connection final
+        {
+        public:
+
+            // what the connection is waiting for, each has its own timeout
+            typedef enum
+            {
+                none_e,
+                handshake_e,
+                query_e,
+                rest_of_query_e,
+                answer_e,
+                write_e
+            }
+            wait_t;
+
+            connection(uint64_t id, const std::shared_ptr<tcp_server_socket> &s, bool tls);
+
+            uint64_t                           m_id;
+            std::shared_ptr<tcp_server_socket> m_socket;
+            bool                               m_handshaking;
+
+            // queries passed to the handlers and not answered yet
+            uint m_in_flight;
+
+            // the client has closed its side, ours is closed once everything's answered
+            bool m_eof;
+
+            // data read but not yet passed on and responses not yet written
+            std::vector<octet> m_read;
+            std::vector<octet> m_write;
+            size_t             m_written;
+
+            wait_t                  m_wait;
+            timer_wheel::timer_id_t m_timer;
+        };
+
+        std::string   m_name;
+        server_config m_config;
+        dispatch_t    m_dispatch;
+
+        // connection IDs are index + n * num_loops so any thread can tell which loop has one
+        uint64_t m_next_id;
+        uint     m_num_loops;
+
+        // most connections this loop will hold open at once
+        size_t m_max_connections;
+
+        // most queries from one connection with the handlers at once
+        uint m_max_in_flight;
+
+        socket_set                     m_sockets;
+        std::shared_ptr<notify_socket> m_notify;
+
+        // connection timeouts
+        timer_wheel m_timers;
+
+        // work handed to the loop from other threads
+        std::mutex                        m_posted_lock;
+        std::list<std::function<void ()>> m_posted;
+
+        // connections by socket (for events) and by ID (for responses)
+        std::unordered_map<socket *, std::shared_ptr<connection>> m_connections;
+        std::unordered_map<uint64_t, connection *>                m_ids;
+
+        uint m_refused;
+        uint m_pipelined;
+        uint m_monitor_open_id;
+        uint m_monitor_refused_id;
+        uint m_monitor_pipelined_id;
+
+        // the loop thread's CPU time per query passed on, i.e. the cost of reading, writing
+        // and (for DoT) encrypting and decrypting, reported once a second
+        uint64_t                              m_queries;
+        uint                                  m_monitor_cpu_id;
+        std::chrono::steady_clock::time_point m_last_cpu_report;
+
+        std::shared_ptr<std::thread> m_thread;
+
+        /**
+         * main loop
+         */
+        void loop();
+
+        /**
+         * run a function on the loop thread
+         */
+        void post(const std::function<void ()> &f);
+
+        /**
+         * run anything posted from other threads
+         */
+        void run_posted();
+
+        /**
+         * start looking after a new connection (loop thread only)
+         */
+        void open_connection(const std::shared_ptr<tcp_server_socket> &s, bool tls);
+
+        /**
+         * do whatever a connection is ready for - handshake, read, write, pass on a query
+         */
+        void handle(connection *c);
+
+        /**
+         * read whatever is waiting on a connection
+         */
+        void read(connection *c);
+
+        /**
+         * write as much of the waiting output as the socket will take
+         */
+        void flush(connection *c);
+
+        /**
+         * pass complete queries on to the handlers as far as the in-flight limit allows,
+         * false if the connection had to be closed
+         */
+        bool next_queries(connection *c);
+
+        /**
+         * queue up the response to a connection's query and carry on with it
+         */
+        void send_response(dns_message_envelope *m);
+
+        /**
+         * update the CPU per query monitor if it's due
+         */
+        void report_cpu();
+
+        /**
+         * (re)start the connection's timeout if what it's waiting for has changed
+         */
+        void set_timeout(connection *c);
+
+        /**
+         * drop a connection, c is gone once this returns
+         */
+        void close_connection(connection *c);
+    };
+}
@@ -19,7 +19,10 @@
  
 #pragma once
 
+#include <list>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -28,12 +31,11 @@
 #include "config.hpp"
 #include "server_config.hpp"
 #include "handler_pool.hpp"
-#include "thread_pool.hpp"
 #include "socket_set.hpp"
 
 #include "dns_handler.hpp"
 #include "dns_message_envelope.hpp"
-#include "dns_tcp_connection.hpp"
+#include "dns_tcp_loop.hpp"
 #include "tcp_server_socket.hpp"
 #include "dns_auth_resolver.hpp"
 #include "dns_forwarding_resolver.hpp"
@@ -93,10 +95,23 @@ namespace adns
          */
         std::shared_ptr<std::thread> m_receive_thread;
 
+        /**
+         * threads taking responses from the handlers back to the loops
+         */
+        std::list<std::shared_ptr<std::thread>> m_send_threads;
+
         /** 
-         * pool of threads to service connections
+         * event loops looking after the connections, one per receive thread
+         */
+        std::vector<std::shared_ptr<dns_tcp_loop>> m_loops;
+
+        // loop the next connection goes to
+        uint m_next_loop;
+
+        /**
+         * handlers shared by every connection
          */
-        thread_pool<dns_tcp_connection> m_server_threads;
+        handler_pool<dns_message_envelope *, dns_handler, dns_handler::params_t> *m_handler_pool;
 
         // authoritative resolver instance shared by all connections
         std::shared_ptr<dns_auth_resolver> m_auth_resolver;
@@ -111,10 +126,15 @@ namespace adns
         socket_set m_socket_set;
 
         /**
-         * Wait for connections to be made and then pass them to threads from the pool to be serviced.
+         * Wait for connections to be made and then pass them to the loops to be serviced.
          */
         void accept_inbound();
 
+        /**
+         * Take responses from the handlers and pass them to the loop with their connection.
+         */
+        void send_outbound();
+
         /**
          * connect the inbound socket
          */
@@ -22,10 +22,15 @@
 #include <vector>
 #include <memory>
 
+#include <boost/lexical_cast.hpp>
+
 #include "types.hpp"
 #include "dns_udp_server.hpp"
+#include "dns_recursive_cache.hpp"
 #include "config.hpp"
 #include "run_state.hpp"
+#include "log_queue.hpp"
+#include "cpu_affinity.hpp"
 #include "dns_zone.hpp"
 
 using namespace std;
@@ -41,11 +46,40 @@ dns_udp_server::dns_udp_server(
 {
     dns_handler::params_t params;
 
-    for (auto sa : m_config.socket_addresses)
+    m_receive_cpus = cpu_affinity::parse(m_config.dns.receive_thread_cpus);
+    m_handler_cpus = cpu_affinity::parse(m_config.dns.handler_thread_cpus);
+    m_send_cpus = cpu_affinity::parse(m_config.dns.send_thread_cpus);
+
+    if (m_receive_cpus.empty())
+    {
+        for (auto sa : m_config.socket_addresses)
+        {
+            socket_address s_addr(ip_address(sa.ip_address), sa.port);
+            auto s = make_shared<udp_socket>(s_addr);
+            s->set_receive_timestamps();
+            m_socket_set.add(s);
+        }
+    }
+    else
     {
-        socket_address s_addr(ip_address(sa.ip_address), sa.port);
-        auto s = make_shared<udp_socket>(s_addr);
-        m_socket_set.add(s);
+        // one socket per address per receive thread, all sharing the port. Each socket asks
+        // the kernel for the packets it handled on the receive thread's CPU so a packet stays
+        // on the same core from the NIC queue through to the handler queue.
+        for (uint i = 0; i < m_config.dns.num_receive_threads; i++)
+        {
+            auto ss = make_shared<socket_set>();
+
+            for (auto sa : m_config.socket_addresses)
+            {
+                socket_address s_addr(ip_address(sa.ip_address), sa.port);
+                auto s = make_shared<udp_socket>(s_addr, true);
+                s->set_incoming_cpu(cpu_affinity::select(m_receive_cpus, i));
+                s->set_receive_timestamps();
+                ss->add(s);
+            }
+
+            m_receive_socket_sets.push_back(ss);
+        }
     }
 
     params.config = m_config;
@@ -60,7 +94,10 @@ dns_udp_server::dns_udp_server(
                                                                 params,
                                                                 m_config.dns.max_in_message_queue_length,
                                                                 m_config.dns.max_out_message_queue_length,
-                                                                m_config.dns.num_udp_threads);
+                                                                m_config.dns.num_udp_threads,
+                                                                m_handler_cpus,
+                                                                dns_handler::num_lanes,
+                                                                dns_handler::get_shed_policy(m_config));
 
     dns_zone::init();
 }
@@ -107,14 +144,25 @@ void dns_udp_server::send_outbound()
 
 void dns_udp_server::run()
 {
+    string instance = name() + " " + boost::lexical_cast<string>(m_config.server_id);
+
     for (uint i = 0; i < m_config.dns.num_receive_threads; i++)
     {
-        m_receive_threads.push_back(make_shared<thread>(&dns_udp_server::receive_inbound, this));
+        socket_set *sockets = m_receive_cpus.empty() ? &m_socket_set : m_receive_socket_sets[i].get();
+        int cpu = cpu_affinity::select(m_receive_cpus, i);
+
+        m_receive_threads.push_back(make_shared<thread>(&dns_udp_server::receive_inbound, this, sockets));
+        cpu_affinity::pin(*m_receive_threads.back(), cpu);
+        cpu_affinity::report(instance, "receive", i, cpu);
     }
 
     for (uint i = 0; i < m_config.dns.num_send_threads; i++)
     {
+        int cpu = cpu_affinity::select(m_send_cpus, i);
+
         m_send_threads.push_back(make_shared<thread>(&dns_udp_server::send_outbound, this));
+        cpu_affinity::pin(*m_send_threads.back(), cpu);
+        cpu_affinity::report(instance, "send", i, cpu);
     }
 }
 
@@ -141,7 +189,7 @@ dns_udp_server::~dns_udp_server()
     delete m_handler_pool;
 }
 
-void dns_udp_server::receive_inbound()
+void dns_udp_server::receive_inbound(socket_set *sockets)
 {
     while (true)
     {
@@ -157,7 +205,7 @@ void dns_udp_server::receive_inbound()
             }
             else
             {
-                shared_ptr<socket> ready_socket = get<0>(m_socket_set.wait_one());
+                shared_ptr<socket> ready_socket = get<0>(sockets->wait_one());
 
                 udp_socket::message *messages[100];
 
@@ -175,14 +223,17 @@ void dns_udp_server::receive_inbound()
                                         messages[i]->get_remote_address(), 
                                         dynamic_cast<udp_socket *>(ready_socket.get()));
 
-                            if (!m_handler_pool->enqueue(m))
+                            // deadlines run from when the kernel saw the packet, not from when we got to it
+                            m->set_received_time(messages[i]->get_received_time());
+
+                            if (!m_handler_pool->enqueue(m, dns_handler::get_lane(m)))
                             {
                                 delete m;
                             }
                         }
                         else
                         {
-                            LOG(warning) << "short packet received, ignoring";
+                            ALOG_LIMITED(warning, 1) << "short packet received, ignoring";
                         }
                     }
 
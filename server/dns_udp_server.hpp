@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -85,6 +86,19 @@ namespace adns
          */
         socket_set m_socket_set;
 
+        /**
+         * when the receive threads are pinned, each thread gets its own set of sockets
+         * sharing the configured ports rather than using m_socket_set
+         */
+        std::vector<std::shared_ptr<socket_set>> m_receive_socket_sets;
+
+        /**
+         * CPUs to pin the receive, handler and send threads to (empty for no pinning)
+         */
+        std::vector<int> m_receive_cpus;
+        std::vector<int> m_handler_cpus;
+        std::vector<int> m_send_cpus;
+
         /**
          * queue with attached pool of dns handler threads
          */
@@ -118,7 +132,7 @@ namespace adns
         /** 
          * Wait for things and handle them.
          */
-        void receive_inbound();
+        void receive_inbound(socket_set *sockets);
 
         /**
          * Pick up messages from the thread pool and send them out.
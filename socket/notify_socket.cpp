@@ -0,0 +1,67 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "notify_socket.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace adns;
+
+notify_socket::notify_socket() : socket()
+{
+    m_fd = eventfd(0, EFD_NONBLOCK);
+
+    if (m_fd == -1)
+    {
+        THROW(notify_socket_exception, "eventfd() failed", util::strerror(), errno);
+    }
+}
+
+notify_socket::~notify_socket()
+{
+}
+
+bool notify_socket::is_stream()
+{
+    return false;
+}
+
+void notify_socket::notify()
+{
+    uint64_t one = 1;
+
+    if ((::write(m_fd, &one, sizeof(one)) != sizeof(one)) && (errno != EAGAIN))
+    {
+        THROW(notify_socket_exception, "write() to eventfd failed", util::strerror(), errno);
+    }
+}
+
+void notify_socket::clear()
+{
+    uint64_t count;
+
+    // a single read resets the counter, EAGAIN means there was nothing to reset
+    if ((::read(m_fd, &count, sizeof(count)) != sizeof(count)) && (errno != EAGAIN))
+    {
+        THROW(notify_socket_exception, "read() from eventfd failed", util::strerror(), errno);
+    }
+}
@@ -0,0 +1,55 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include "socket.hpp"
+
+EXCEPTION_CLASS(notify_socket_exception, socket_exception)
+
+namespace adns
+{
+    /**
+     * Not really a socket, an eventfd that can be added to a socket_set so that another thread
+     * can wake up whoever is waiting on the set.
+     */
+    class notify_socket : public socket
+    {
+    public:
+
+        notify_socket();
+
+        virtual ~notify_socket();
+
+        /**
+         * is a stream socket? (returns false)
+         */
+        virtual bool is_stream();
+
+        /**
+         * wake up the waiter
+         */
+        void notify();
+
+        /**
+         * reset ready for the next notify() call
+         */
+        void clear();
+    };
+}
@@ -140,6 +140,24 @@ void socket::set_send_timeout(uint n)
     }
 }
 
+void socket::set_reuse_port()
+{
+    int opt = 1;
+
+    if (setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(int)) != 0)
+    {
+        THROW(socket_exception, "setsockopt() SO_REUSEPORT failed", util::strerror(), errno);
+    }
+}
+
+void socket::set_incoming_cpu(int cpu)
+{
+    if (setsockopt(m_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(int)) != 0)
+    {
+        THROW(socket_exception, "setsockopt() SO_INCOMING_CPU failed", util::strerror(), errno);
+    }
+}
+
 void socket::set_non_blocking()
 {
     int flags;
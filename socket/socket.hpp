@@ -63,6 +63,18 @@ namespace adns
          */
         void set_send_timeout(uint timeout_ms);
 
+        /**
+         * allow several sockets to bind to the same address with the kernel spreading packets
+         * between them (must be called before binding)
+         */
+        void set_reuse_port();
+
+        /**
+         * prefer this socket for packets processed by the kernel on the given CPU, only
+         * meaningful for a group of sockets sharing a port
+         */
+        void set_incoming_cpu(int cpu);
+
         /**
          * is this a streaming socket?
          */
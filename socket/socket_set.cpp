@@ -158,6 +158,87 @@ socket_set::event socket_set::wait_one(uint timeout_ms)
     }
 }
 
+vector<socket_set::event> socket_set::wait_many(uint timeout_ms)
+{
+    struct epoll_event events[SOCKET_SET_MAX_EVENTS];
+
+    unique_lock<mutex> guard(m_poll_lock);
+
+    if (run_state::o_state == run_state::shutdown_e)
+    {
+        THROW(socket_set_timeout_exception, "epoll_wait timeout");
+    }
+
+    {
+        // sockets removed by the caller since the last wait are closed now rather than 
+        // waiting on the next event
+        unique_lock<mutex> map_guard(m_lock);
+        process_remove_list();
+    }
+
+    int num_events = epoll_wait(m_epoll_fd, events, SOCKET_SET_MAX_EVENTS, timeout_ms);
+
+    unique_lock<mutex> map_guard(m_lock);
+
+    if (num_events == 0)
+    {
+        THROW(socket_set_timeout_exception, "epoll_wait timeout");
+    }
+    else if (num_events == -1)
+    {
+        if (errno == EINTR)
+        {
+            THROW(socket_set_timeout_exception, "epoll_wait timeout");
+        }
+        else
+        {
+            THROW(socket_set_exception, "epoll_wait failed", util::strerror(), errno);
+        }
+    }
+
+    // anything removed by another thread during the wait is dropped before the events are 
+    // matched up so nothing is returned for a socket the caller has finished with
+    process_remove_list();
+
+    vector<event> res;
+    res.reserve(num_events);
+
+    for (int i = 0; i < num_events; i++)
+    {
+        auto p = m_socket_map.find(events[i].data.fd);
+
+        if (p == m_socket_map.end())
+        {
+            continue;
+        }
+
+        if (events[i].events & EPOLLIN)
+        {
+            res.push_back(make_tuple(p->second, ready_read_e));
+        }
+        else if (events[i].events & EPOLLOUT)
+        {
+            res.push_back(make_tuple(p->second, ready_write_e));
+        }
+        else if (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        {
+            // the next read on the socket will say what went wrong
+            res.push_back(make_tuple(p->second, peer_hup_e));
+        }
+        else
+        {
+            LOG(warning) << "unexpected epoll event " << events[i].events << " on socket " << events[i].data.fd;
+        }
+    }
+
+    if (res.empty())
+    {
+        THROW(socket_set_timeout_exception, "epoll_wait timeout");
+    }
+
+    return res;
+}
+
 void socket_set::process_remove_list()
 {
     unique_lock<mutex> guard(m_remove_list_lock);
@@ -80,6 +80,12 @@ namespace adns
          */
         event wait_one(uint timeout_ms=2000);
 
+        /**
+         * wait for any of the sockets in the set to have IO activity pending and return up to
+         * SOCKET_SET_MAX_EVENTS of them at once or throw a timeout exception 
+         */
+        std::vector<event> wait_many(uint timeout_ms=2000);
+
     private:
 
         // lock for the poll call
@@ -0,0 +1,257 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <chrono>
+
+#include "run_state.hpp"
+#include "ssl_client_socket.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace adns;
+
+mutex                        ssl_client_socket::o_lock;
+SSL_CTX                      *ssl_client_socket::o_ctx = nullptr;
+map<socket_address, SSL_SESSION *> ssl_client_socket::o_sessions;
+
+ssl_client_socket::ssl_client_socket(ip_address::ip_type_t t) : tcp_client_socket(t)
+{
+    m_ssl = nullptr;
+}
+
+ssl_client_socket::~ssl_client_socket()
+{
+    if (m_ssl != nullptr)
+    {
+        // best effort, don't wait around for the server's close_notify
+        SSL_shutdown(m_ssl);
+        SSL_free(m_ssl);
+    }
+}
+
+string ssl_client_socket::ssl_error_string()
+{
+    char error[1024];
+
+    ERR_error_string_n(ERR_get_error(), error, 1024);
+
+    error[1023] = '\0';
+
+    return string(error);
+}
+
+SSL_CTX *ssl_client_socket::get_context()
+{
+    lock_guard<mutex> guard(o_lock);
+
+    if (o_ctx == nullptr)
+    {
+        auto ctx = SSL_CTX_new(TLS_client_method());
+
+        if (ctx == nullptr)
+        {
+            THROW(ssl_client_socket_exception, "SSL_CTX_new failed", ssl_error_string());
+        }
+
+        SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+        // opportunistic privacy profile (RFC 8310), forwarders are configured by address so
+        // there's no name to authenticate the certificate against
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+        // servers routinely close idle connections without a close_notify
+        SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+
+        // sessions (TLS 1.3 tickets included) arrive via the callback and are kept here per 
+        // server rather than in OpenSSL's own cache, which is keyed by session ID only
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+
+        o_ctx = ctx;
+    }
+
+    return o_ctx;
+}
+
+int ssl_client_socket::new_session_cb(SSL *ssl, SSL_SESSION *session)
+{
+    auto s = static_cast<ssl_client_socket *>(SSL_get_app_data(ssl));
+
+    if (s == nullptr)
+    {
+        return 0;
+    }
+
+    lock_guard<mutex> guard(o_lock);
+
+    auto i = o_sessions.find(s->m_remote_address);
+
+    if (i != o_sessions.end())
+    {
+        SSL_SESSION_free(i->second);
+        i->second = session;
+    }
+    else
+    {
+        o_sessions[s->m_remote_address] = session;
+    }
+
+    // we now own the reference
+    return 1;
+}
+
+bool ssl_client_socket::handshake()
+{
+    if (m_ssl == nullptr)
+    {
+        m_ssl = SSL_new(get_context());
+
+        if (m_ssl == nullptr)
+        {
+            THROW(ssl_client_socket_exception, "SSL_new failed", ssl_error_string());
+        }
+
+        SSL_set_app_data(m_ssl, this);
+
+        if (SSL_set_fd(m_ssl, m_fd) != 1)
+        {
+            THROW(ssl_client_socket_exception, "SSL_set_fd failed", ssl_error_string());
+        }
+
+        {
+            lock_guard<mutex> guard(o_lock);
+
+            auto i = o_sessions.find(m_remote_address);
+
+            if (i != o_sessions.end())
+            {
+                // the session takes its own reference so the cached copy stays valid
+                SSL_set_session(m_ssl, i->second);
+            }
+        }
+
+        SSL_set_connect_state(m_ssl);
+    }
+
+    ERR_clear_error();
+
+    int ret = SSL_do_handshake(m_ssl);
+
+    if (ret == 1)
+    {
+        return true;
+    }
+
+    switch (SSL_get_error(m_ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return false;
+
+    default:
+        THROW(ssl_client_socket_exception, "SSL handshake failed", ssl_error_string(), ret);
+    }
+}
+
+bool ssl_client_socket::get_session_reused() const
+{
+    return (m_ssl != nullptr) && (SSL_session_reused(m_ssl) == 1);
+}
+
+int ssl_client_socket::read_some(octet *data, int n)
+{
+    if (m_ssl == nullptr)
+    {
+        THROW(ssl_client_socket_exception, "trying to read before the TLS handshake");
+    }
+
+    ERR_clear_error();
+
+    int ret = SSL_read(m_ssl, data, n);
+
+    if (ret > 0)
+    {
+        return ret;
+    }
+
+    switch (SSL_get_error(m_ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return 0;
+
+    case SSL_ERROR_ZERO_RETURN:
+        THROW(tcp_socket_eof_exception, "end of file");
+
+    default:
+        THROW(ssl_client_socket_exception, "SSL_read failed", ssl_error_string(), ret);
+    }
+}
+
+void ssl_client_socket::write(const octet *data, uint n, uint timeout_ms)
+{
+    if (m_ssl == nullptr)
+    {
+        THROW(ssl_client_socket_exception, "trying to write before the TLS handshake");
+    }
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    int ret;
+    size_t written_so_far = 0;
+
+    time_point<steady_clock> start_time = steady_clock::now();
+    duration<int, milli> timeout(timeout_ms);
+
+    while (written_so_far < n)
+    {
+        ERR_clear_error();
+
+        ret = SSL_write(m_ssl, data + written_so_far, n - written_so_far);
+
+        if (ret > 0)
+        {
+            written_so_far += ret;
+        }
+        else // ret <= 0
+        {
+            int e = SSL_get_error(m_ssl, ret);
+
+            if ((e != SSL_ERROR_WANT_WRITE) && (e != SSL_ERROR_WANT_READ))
+            {
+                THROW(ssl_client_socket_exception, "SSL_write failed", ssl_error_string(), ret);
+            }
+        }
+
+        if (run_state::o_state == run_state::shutdown_e)
+        {
+            THROW(ssl_client_socket_exception, "shutdown");
+        }
+
+        if ((steady_clock::now() - start_time) > timeout)
+        {   
+            THROW(tcp_socket_timeout_exception, "write timed out");
+        }
+    }
+}
@@ -0,0 +1,103 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "types.hpp"
+#include "socket_address.hpp"
+#include "tcp_client_socket.hpp"
+#include "exception.hpp"
+
+EXCEPTION_CLASS(ssl_client_socket_exception, tcp_socket_exception)
+
+namespace adns
+{
+    /**
+     * Non-blocking TLS client sockets for DNS over TLS (RFC 7858) to upstream servers. Connect 
+     * as for a TCP client socket then call handshake() each time the socket is ready until it
+     * returns true. Sessions are remembered per server and offered on the next connection so
+     * reconnects can skip the full handshake.
+     */
+    class ssl_client_socket : public tcp_client_socket
+    {
+    public:
+
+        /**
+         * open but not connected socket of given IP type
+         */
+        ssl_client_socket(ip_address::ip_type_t t = ip_address::ip_v4_e);
+
+        /**
+         * destructor - close etc.
+         */
+        virtual ~ssl_client_socket();
+
+        /**
+         * move the TLS handshake on once connected, true when it's complete
+         */
+        bool handshake();
+
+        /**
+         * was a previous session resumed by the handshake?
+         */
+        bool get_session_reused() const;
+
+        /**
+         * read whatever is available without waiting, up to n bytes. Returns the number
+         * of bytes read, 0 if there's nothing there yet.
+         */
+        virtual int read_some(octet *data, int n);
+
+        /**
+         * write data with a timeout - throw tcp_socket_exception in that case.
+         */
+        virtual void write(const octet *data, uint n, uint timeout_ms);
+
+    private:
+
+        SSL *m_ssl;
+
+        // one context shared by every client connection and the last session seen per server
+        static std::mutex                              o_lock;
+        static SSL_CTX                                 *o_ctx;
+        static std::map<socket_address, SSL_SESSION *> o_sessions;
+
+        /**
+         * get the shared context, creating it on first use
+         */
+        static SSL_CTX *get_context();
+
+        /**
+         * SSL callback when the server hands over a session that can be resumed later
+         */
+        static int new_session_cb(SSL *ssl, SSL_SESSION *session);
+
+        /**
+         * get the error string generated by the SSL library
+         */
+        static std::string ssl_error_string();
+    };
+}
@@ -0,0 +1,295 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include <string.h>
+
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/core_names.h>
+
+#include "config.hpp"
+#include "monitor.hpp"
+#include "ssl_server_context.hpp"
+
+using namespace std;
+using namespace adns;
+using namespace boost::log::trivial;
+
+// most early data accepted from a client, enough for a handful of queries
+#define SSL_MAX_EARLY_DATA 16384
+
+mutex    ssl_server_context::o_lock;
+SSL_CTX *ssl_server_context::o_ctx = nullptr;
+bool     ssl_server_context::o_early_data = false;
+
+ssl_server_context::ticket_key_t ssl_server_context::o_ticket_key;
+ssl_server_context::ticket_key_t ssl_server_context::o_previous_ticket_key;
+uint                             ssl_server_context::o_ticket_key_lifetime_s = 0;
+
+atomic<uint> ssl_server_context::o_handshakes(0);
+atomic<uint> ssl_server_context::o_resumed(0);
+atomic<uint> ssl_server_context::o_early_data_accepted(0);
+atomic<uint> ssl_server_context::o_ktls_send(0);
+atomic<uint> ssl_server_context::o_ktls_receive(0);
+
+uint ssl_server_context::o_monitor_handshakes_id = 0;
+uint ssl_server_context::o_monitor_resumed_id = 0;
+uint ssl_server_context::o_monitor_early_data_id = 0;
+uint ssl_server_context::o_monitor_ktls_send_id = 0;
+uint ssl_server_context::o_monitor_ktls_receive_id = 0;
+
+static string ssl_error_string()
+{
+    char error[1024];
+
+    ERR_error_string_n(ERR_get_error(), error, 1024);
+
+    error[1023] = '\0';
+
+    return string(error);
+}
+
+SSL_CTX *ssl_server_context::get()
+{
+    lock_guard<mutex> guard(o_lock);
+
+    if (o_ctx == nullptr)
+    {
+        o_ctx = create();
+    }
+
+    return o_ctx;
+}
+
+bool ssl_server_context::early_data_enabled()
+{
+    return o_early_data;
+}
+
+SSL_CTX *ssl_server_context::create()
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+
+    if (ctx == nullptr) 
+    {
+        THROW(ssl_server_context_exception, "SSL_CTX_new failed", ssl_error_string());
+    }
+
+    try
+    {
+        if (SSL_CTX_use_certificate_chain_file(ctx, config::ssl_server_chain_file().c_str()) <= 0) 
+        {
+            THROW(ssl_server_context_exception, "SSL_CTX_use_certificate_chain_file failed", ssl_error_string());
+        }
+
+        if (SSL_CTX_use_PrivateKey_file(ctx, config::ssl_server_key_file().c_str(), SSL_FILETYPE_PEM) <= 0) 
+        {
+            THROW(ssl_server_context_exception, "SSL_CTX_use_PrivateKey_file failed", ssl_error_string());
+        }
+
+        // no error codes are returned from this call, the socket is found from the SSL object
+        SSL_CTX_set_alpn_select_cb(ctx, ssl_server_socket::alpn_cb, nullptr);
+
+        // sessions are cached here for clients that resume by session ID or, with TLS 1.3 and
+        // tickets turned off, with a ticket that refers back to the cache
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, config::ssl_session_cache_size());
+        SSL_CTX_set_session_id_context(ctx, reinterpret_cast<const unsigned char *>("argo-dns"), 8);
+
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+        // plenty of clients just close the connection without a close_notify, OpenSSL treats
+        // that as an error and throws the session away, so it couldn't be resumed. Messages
+        // carry their own lengths so a truncated connection can't be mistaken for a short one.
+        SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+
+        o_ticket_key_lifetime_s = config::ssl_ticket_key_lifetime_s();
+
+        if (o_ticket_key_lifetime_s == 0)
+        {
+            SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        }
+        else
+        {
+            new_ticket_key(o_ticket_key);
+            new_ticket_key(o_previous_ticket_key);
+
+            // a ticket is good for as long as its key is in use, plus one more key lifetime
+            // as the previous key
+            SSL_CTX_set_timeout(ctx, 2 * o_ticket_key_lifetime_s);
+
+            if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_key_cb) != 1)
+            {
+                THROW(ssl_server_context_exception, "SSL_CTX_set_tlsext_ticket_key_evp_cb failed", ssl_error_string());
+            }
+        }
+
+        o_early_data = config::ssl_early_data();
+
+        if (o_early_data)
+        {
+            // OpenSSL's anti-replay protection stays on, each ticket can only be used for
+            // early data once
+            SSL_CTX_set_max_early_data(ctx, SSL_MAX_EARLY_DATA);
+            SSL_CTX_set_recv_max_early_data(ctx, SSL_MAX_EARLY_DATA);
+        }
+
+        if (config::ssl_kernel_tls())
+        {
+#ifdef SSL_OP_ENABLE_KTLS
+            // only takes effect if OpenSSL was built with kTLS and the kernel has the tls
+            // module, handshake_complete() counts the connections it actually worked for
+            SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+            LOG(info) << "kernel TLS requested but not supported by this version of OpenSSL";
+#endif
+        }
+    }
+    catch (...)
+    {
+        SSL_CTX_free(ctx);
+        throw;
+    }
+
+    o_monitor_handshakes_id = monitor::add_thing("TLS server", "shared context", "handshakes", 0);
+    o_monitor_resumed_id = monitor::add_thing("TLS server", "shared context", "resumed handshakes", 0);
+    o_monitor_early_data_id = monitor::add_thing("TLS server", "shared context", "early data accepted", 0);
+    o_monitor_ktls_send_id = monitor::add_thing("TLS server", "shared context", "kernel TLS send", 0);
+    o_monitor_ktls_receive_id = monitor::add_thing("TLS server", "shared context", "kernel TLS receive", 0);
+
+    return ctx;
+}
+
+void ssl_server_context::handshake_complete(SSL *ssl)
+{
+    monitor::set_value(o_monitor_handshakes_id, ++o_handshakes);
+
+    if (SSL_session_reused(ssl))
+    {
+        monitor::set_value(o_monitor_resumed_id, ++o_resumed);
+    }
+
+    if (SSL_get_early_data_status(ssl) == SSL_EARLY_DATA_ACCEPTED)
+    {
+        monitor::set_value(o_monitor_early_data_id, ++o_early_data_accepted);
+    }
+
+#ifdef BIO_get_ktls_send
+    if (BIO_get_ktls_send(SSL_get_wbio(ssl)))
+    {
+        monitor::set_value(o_monitor_ktls_send_id, ++o_ktls_send);
+    }
+
+    if (BIO_get_ktls_recv(SSL_get_rbio(ssl)))
+    {
+        monitor::set_value(o_monitor_ktls_receive_id, ++o_ktls_receive);
+    }
+#endif
+}
+
+void ssl_server_context::new_ticket_key(ticket_key_t &k)
+{
+    if ((RAND_bytes(k.name, sizeof(k.name)) != 1) ||
+        (RAND_bytes(k.aes_key, sizeof(k.aes_key)) != 1) ||
+        (RAND_bytes(k.hmac_key, sizeof(k.hmac_key)) != 1))
+    {
+        THROW(ssl_server_context_exception, "RAND_bytes failed", ssl_error_string());
+    }
+
+    k.created = time(nullptr);
+}
+
+int ssl_server_context::use_ticket_key(const ticket_key_t &k, unsigned char *iv, EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc)
+{
+    OSSL_PARAM params[] = 
+    {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<octet *>(k.hmac_key), sizeof(k.hmac_key)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char *>("SHA256"), 0),
+        OSSL_PARAM_construct_end()
+    };
+
+    if (EVP_MAC_CTX_set_params(hctx, params) != 1)
+    {
+        return -1;
+    }
+
+    if (EVP_CipherInit_ex(cctx, EVP_aes_256_cbc(), nullptr, k.aes_key, iv, enc) != 1)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+int ssl_server_context::ticket_key_cb(
+                    SSL            *ssl,
+                    unsigned char  *key_name,
+                    unsigned char  *iv,
+                    EVP_CIPHER_CTX *cctx,
+                    EVP_MAC_CTX    *hctx,
+                    int            enc)
+{
+    try
+    {
+        lock_guard<mutex> guard(o_lock);
+
+        bool key_expired = (time(nullptr) - o_ticket_key.created) >= o_ticket_key_lifetime_s;
+
+        if (enc == 1)
+        {
+            if (key_expired)
+            {
+                o_previous_ticket_key = o_ticket_key;
+                new_ticket_key(o_ticket_key);
+            }
+
+            memcpy(key_name, o_ticket_key.name, sizeof(o_ticket_key.name));
+
+            if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) != 1)
+            {
+                return -1;
+            }
+
+            return use_ticket_key(o_ticket_key, iv, cctx, hctx, 1);
+        }
+
+        // 2 asks for a new ticket to be issued, done once the key is due to be replaced
+        // so clients move over to the new key before the old one is dropped
+        if (memcmp(key_name, o_ticket_key.name, sizeof(o_ticket_key.name)) == 0)
+        {
+            int r = use_ticket_key(o_ticket_key, iv, cctx, hctx, 0);
+            return ((r == 1) && key_expired) ? 2 : r;
+        }
+        else if (memcmp(key_name, o_previous_ticket_key.name, sizeof(o_previous_ticket_key.name)) == 0)
+        {
+            int r = use_ticket_key(o_previous_ticket_key, iv, cctx, hctx, 0);
+            return (r == 1) ? 2 : r;
+        }
+        else
+        {
+            // unknown or long gone key, fall back to a full handshake
+            return 0;
+        }
+    }
+    catch (adns::exception &e)
+    {
+        e.log(error, "exception caught in ssl_server_context::ticket_key_cb");
+        return -1;
+    }
+}
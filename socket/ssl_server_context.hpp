@@ -0,0 +1,127 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <ctime>
+
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+
+#include "types.hpp"
+#include "exception.hpp"
+#include "ssl_server_socket.hpp"
+
+EXCEPTION_CLASS(ssl_server_context_exception, ssl_accept_failed_exception)
+
+namespace adns
+{
+    /**
+     * The SSL_CTX shared by every SSL server socket in the process. The certificate chain and
+     * key are loaded once, and resumption works across all of the servers and threads that
+     * accept TLS connections. It has a server side session cache, session tickets encrypted
+     * with keys that are rotated regularly, TLS 1.3 early data (0-RTT) if it's been turned on
+     * and kernel TLS where OpenSSL and the kernel support it.
+     */
+    class ssl_server_context final
+    {
+    public:
+
+        /**
+         * the shared context, created on first use
+         */
+        static SSL_CTX *get();
+
+        /**
+         * is early data (0-RTT) accepted from clients resuming a session?
+         */
+        static bool early_data_enabled();
+
+        /**
+         * count a completed handshake for monitoring (full or resumed, whether early data
+         * was accepted and kernel TLS turned on etc.)
+         */
+        static void handshake_complete(SSL *ssl);
+
+    private:
+
+        /**
+         * a session ticket encryption key
+         */
+        typedef struct
+        {
+            octet  name[16];
+            octet  aes_key[32];
+            octet  hmac_key[32];
+            time_t created;
+        }
+        ticket_key_t;
+
+        static std::mutex o_lock;
+        static SSL_CTX    *o_ctx;
+        static bool       o_early_data;
+
+        // tickets are issued with the current key and accepted with either the current or
+        // the previous one, the client gets a new ticket in the latter case
+        static ticket_key_t o_ticket_key;
+        static ticket_key_t o_previous_ticket_key;
+        static uint         o_ticket_key_lifetime_s;
+
+        static std::atomic<uint> o_handshakes;
+        static std::atomic<uint> o_resumed;
+        static std::atomic<uint> o_early_data_accepted;
+        static std::atomic<uint> o_ktls_send;
+        static std::atomic<uint> o_ktls_receive;
+
+        static uint o_monitor_handshakes_id;
+        static uint o_monitor_resumed_id;
+        static uint o_monitor_early_data_id;
+        static uint o_monitor_ktls_send_id;
+        static uint o_monitor_ktls_receive_id;
+
+        /**
+         * create the context from the config
+         */
+        static SSL_CTX *create();
+
+        /**
+         * fill a ticket key with new random values
+         */
+        static void new_ticket_key(ticket_key_t &k);
+
+        /**
+         * OpenSSL callback to set up ticket encryption (enc == 1) or find the key for
+         * decryption (enc == 0)
+         */
+        static int ticket_key_cb(
+                    SSL            *ssl,
+                    unsigned char  *key_name,
+                    unsigned char  *iv,
+                    EVP_CIPHER_CTX *cctx,
+                    EVP_MAC_CTX    *hctx,
+                    int            enc);
+
+        /**
+         * set up the cipher and HMAC contexts for a ticket key
+         */
+        static int use_ticket_key(const ticket_key_t &k, unsigned char *iv, EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc);
+    };
+}
@@ -23,6 +23,7 @@
 #include "util.hpp"
 #include "config.hpp"
 #include "ssl_server_socket.hpp"
+#include "ssl_server_context.hpp"
 #include "run_state.hpp"
 
 using namespace std;
@@ -31,8 +32,9 @@ using namespace adns;
 
 ssl_server_socket::ssl_server_socket(const socket_address &sa) : tcp_server_socket(sa)
 {
-    m_ctx = nullptr;
     m_ssl = nullptr;
+    m_reading_early_data = false;
+    m_early_data_read = 0;
 }
 
 string ssl_server_socket::ssl_error_string()
@@ -50,12 +52,17 @@ ssl_server_socket::~ssl_server_socket()
 {
     if (m_ssl != nullptr)
     {
+        // OpenSSL drops the session from the shared cache if the connection wasn't shut down
+        // cleanly, which would stop the client resuming it (and, with early data on, using
+        // its ticket at all). How the client went away doesn't matter for that so say it
+        // was clean.
+        if (SSL_is_init_finished(m_ssl))
+        {
+            SSL_set_shutdown(m_ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+
         SSL_free(m_ssl);
     }
-    if (m_ctx != nullptr)
-    {
-        SSL_CTX_free(m_ctx);
-    }
 }
 
 shared_ptr<tcp_server_socket> ssl_server_socket::accept()
@@ -65,6 +72,9 @@ shared_ptr<tcp_server_socket> ssl_server_socket::accept()
 
 ssl_server_socket::ssl_server_socket(tcp_server_socket *ts) : tcp_server_socket(ts->m_fd, ts->m_remote_address)
 {
+    m_ssl = nullptr;
+    m_reading_early_data = false;
+    m_early_data_read = 0;
 }
 
 
@@ -82,6 +92,99 @@ list<std::shared_ptr<tcp_server_socket>> ssl_server_socket::accept_many()
     return sockets;
 }
 
+list<std::shared_ptr<tcp_server_socket>> ssl_server_socket::accept_pending()
+{
+    list<shared_ptr<tcp_server_socket>> sockets;
+
+    auto tsl = tcp_server_socket::accept_many();
+
+    for (auto ts : tsl)
+    {
+        sockets.push_back(make_ssl_socket(ts, false));
+    }
+
+    return sockets;
+}
+
+bool ssl_server_socket::handshake()
+{
+    if (m_ssl == nullptr)
+    {
+        THROW(ssl_socket_exception, "trying to handshake on an unconnected socket");
+    }
+
+    ERR_clear_error();
+
+    while (m_reading_early_data)
+    {
+        octet data[4096];
+        size_t n = 0;
+
+        switch (SSL_read_early_data(m_ssl, data, sizeof(data), &n))
+        {
+        case SSL_READ_EARLY_DATA_SUCCESS:
+            m_early_data.insert(m_early_data.end(), data, data + n);
+            break;
+
+        case SSL_READ_EARLY_DATA_FINISH:
+            m_reading_early_data = false;
+            break;
+
+        default:
+            switch (SSL_get_error(m_ssl, 0))
+            {
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                return false;
+
+            default:
+                THROW(ssl_accept_failed_exception, "SSL_read_early_data failed", ssl_error_string());
+            }
+        }
+    }
+
+    int ret = SSL_do_handshake(m_ssl);
+
+    if (ret == 1)
+    {
+        ssl_server_context::handshake_complete(m_ssl);
+        return true;
+    }
+
+    switch (SSL_get_error(m_ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return false;
+
+    default:
+        THROW(ssl_accept_failed_exception, "SSL handshake failed", ssl_error_string(), ret);
+    }
+}
+
+int ssl_server_socket::read_early_data(octet *data, int n)
+{
+    size_t available = m_early_data.size() - m_early_data_read;
+
+    if (available == 0)
+    {
+        return 0;
+    }
+
+    size_t c = min(available, static_cast<size_t>(n));
+
+    memcpy(data, m_early_data.data() + m_early_data_read, c);
+    m_early_data_read += c;
+
+    if (m_early_data_read == m_early_data.size())
+    {
+        m_early_data.clear();
+        m_early_data_read = 0;
+    }
+
+    return c;
+}
+
 int ssl_server_socket::alpn_cb(SSL *ssl,
              const unsigned char **out,
              unsigned char *outlen,
@@ -110,14 +213,14 @@ int ssl_server_socket::alpn_cb(SSL *ssl,
     {
         out[0] = (unsigned char *)"h2";
         outlen[0] = 2;
-        static_cast<ssl_server_socket *>(arg)->m_protocol = http_2_e;
+        static_cast<ssl_server_socket *>(SSL_get_app_data(ssl))->m_protocol = http_2_e;
         return SSL_TLSEXT_ERR_OK;
     }
     else if (http_1_found)
     {
         out[0] = (unsigned char *)"http/1.1";
         outlen[0] = 8;
-        static_cast<ssl_server_socket *>(arg)->m_protocol = http_1_1_e;
+        static_cast<ssl_server_socket *>(SSL_get_app_data(ssl))->m_protocol = http_1_1_e;
         return SSL_TLSEXT_ERR_OK;
     }
     else
@@ -126,7 +229,7 @@ int ssl_server_socket::alpn_cb(SSL *ssl,
     }
 }
 
-shared_ptr<tcp_server_socket> ssl_server_socket::make_ssl_socket(const shared_ptr<tcp_server_socket> &ts)
+shared_ptr<tcp_server_socket> ssl_server_socket::make_ssl_socket(const shared_ptr<tcp_server_socket> &ts, bool handshake)
 {
     auto res = unique_ptr<ssl_server_socket>(new ssl_server_socket(ts.get()));
 
@@ -134,41 +237,34 @@ shared_ptr<tcp_server_socket> ssl_server_socket::make_ssl_socket(const shared_pt
     // to prevent closure when the old instance is destructed
     ts->m_fd = -1;
 
-    res->m_ctx = SSL_CTX_new(TLS_server_method());
-
-    if (res->m_ctx == nullptr) 
-    {
-        THROW(ssl_accept_failed_exception, "SSL_CTX_new failed", ssl_error_string());
-    }
-
-    if (SSL_CTX_use_certificate_chain_file(res->m_ctx, config::ssl_server_chain_file().c_str()) <= 0) 
-    {
-        THROW(ssl_accept_failed_exception, "SSL_CTX_use_certificate_chain_file failed", ssl_error_string());
-    }
-
-    if (SSL_CTX_use_PrivateKey_file(res->m_ctx, config::ssl_server_key_file().c_str(), SSL_FILETYPE_PEM) <= 0) 
-    {
-        THROW(ssl_accept_failed_exception, "SSL_CTX_use_PrivateKey_file failed", ssl_error_string());
-    }
-
-    res->m_ssl = SSL_new(res->m_ctx);
+    res->m_ssl = SSL_new(ssl_server_context::get());
 
     if (res->m_ssl == nullptr) 
     {
         THROW(ssl_accept_failed_exception, "SSL_new failed", ssl_error_string());
     }
 
-    // no error codes are returned from this call
-    SSL_CTX_set_alpn_select_cb(res->m_ctx, alpn_cb, res.get());
+    // for the callbacks on the shared context to find their way back here
+    SSL_set_app_data(res->m_ssl, res.get());
     
     if (SSL_set_fd(res->m_ssl, res->m_fd) != 1)
     {
         THROW(ssl_accept_failed_exception, "SSL_set_fd failed", ssl_error_string());
     }
 
-    if (SSL_accept(res->m_ssl) <= 0) 
+    SSL_set_accept_state(res->m_ssl);
+    res->m_reading_early_data = ssl_server_context::early_data_enabled();
+
+    if (!handshake)
+    {
+        // left to the caller once the socket is non-blocking. Writes then go out a record at
+        // a time from a buffer that can grow or move between retries.
+        SSL_set_mode(res->m_ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    }
+    else if (!res->handshake())
     {
-        THROW(ssl_accept_failed_exception, "SSL_accept failed", ssl_error_string());
+        // the socket blocks (with a receive timeout) so it's only left unfinished on a timeout
+        THROW(ssl_accept_failed_exception, "SSL_accept failed", "timed out");
     }
 
     return shared_ptr<tcp_server_socket>(res.release());
@@ -187,7 +283,7 @@ buffer ssl_server_socket::read(int n, uint timeout_ms)
     }
 
     unique_ptr<octet[]> data(new octet[n]);
-    int ret, total_read = 0;
+    int ret, total_read = read_early_data(data.get(), n);
 
     time_point<steady_clock> start_time = steady_clock::now();
     duration<int, milli> timeout(timeout_ms);
@@ -224,6 +320,75 @@ buffer ssl_server_socket::read(int n, uint timeout_ms)
     return buffer(n, data.get());
 }
 
+int ssl_server_socket::read_some(octet *data, int n)
+{
+    if (m_ssl == nullptr)
+    {
+        THROW(ssl_socket_exception, "trying to read from an unconnected socket");
+    }
+
+    int early = read_early_data(data, n);
+
+    if (early > 0)
+    {
+        return early;
+    }
+
+    ERR_clear_error();
+
+    int ret = SSL_read(m_ssl, data, n);
+
+    if (ret > 0)
+    {
+        return ret;
+    }
+
+    switch (SSL_get_error(m_ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return 0;
+
+    case SSL_ERROR_ZERO_RETURN:
+        THROW(tcp_socket_eof_exception, "end of file");
+
+    default:
+        THROW(ssl_socket_exception, "SSL_read failed", ssl_error_string(), ret);
+    }
+}
+
+int ssl_server_socket::write_some(const octet *data, int n)
+{
+    if (m_ssl == nullptr)
+    {
+        THROW(ssl_socket_exception, "trying to write to an unconnected socket");
+    }
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    ERR_clear_error();
+
+    int ret = SSL_write(m_ssl, data, n);
+
+    if (ret > 0)
+    {
+        return ret;
+    }
+
+    switch (SSL_get_error(m_ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return 0;
+
+    default:
+        THROW(ssl_socket_exception, "SSL_write failed", ssl_error_string(), ret);
+    }
+}
+
 void ssl_server_socket::write(const octet *data, uint n, uint timeout_ms)
 {
     if (m_ssl == nullptr)
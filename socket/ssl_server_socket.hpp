@@ -20,6 +20,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
@@ -36,12 +37,15 @@ EXCEPTION_CLASS(ssl_accept_failed_exception, socket_exception)
 namespace adns
 {
     /**
-     * SSL server sockets.
+     * SSL server sockets. Accepted connections all share the one SSL context (see
+     * ssl_server_context).
      */
     class ssl_server_socket : public tcp_server_socket
     {
     public:
 
+        friend class ssl_server_context;
+
         /**
          * SSL socket bound to the given address (IP type is derived from the address).
          */
@@ -62,11 +66,35 @@ namespace adns
          */
         virtual std::list<std::shared_ptr<tcp_server_socket>> accept_many();
 
+        /**
+         * accept any new connection queued up without doing the TLS handshake. Call 
+         * handshake() on each of them whenever they're ready until it returns true.
+         */
+        std::list<std::shared_ptr<tcp_server_socket>> accept_pending();
+
+        /**
+         * move the TLS handshake on for a socket from accept_pending(), true when it's complete.
+         * Any early data (0-RTT) the client sends is read here and returned by the first reads.
+         */
+        bool handshake();
+
         /**
          * read N bytes with a timeout - throw tcp_socket_exception in that case.
          */
         virtual buffer read(int n, uint timeout_ms);
 
+        /**
+         * read whatever is available without waiting, up to n bytes. Returns the number
+         * of bytes read, 0 if there's nothing there yet.
+         */
+        virtual int read_some(octet *data, int n);
+
+        /**
+         * write as much as will go without waiting, up to n bytes. Returns the number of
+         * bytes written, 0 if the socket can't take any more yet.
+         */
+        virtual int write_some(const octet *data, int n);
+
         /**
          * write data with a timeout - throw tcp_socket_exception in that case.
          */
@@ -74,8 +102,19 @@ namespace adns
 
     private:
 
-        SSL_CTX *m_ctx;
-        SSL     *m_ssl;
+        SSL *m_ssl;
+
+        // still to call SSL_read_early_data() until it says there's no more
+        bool m_reading_early_data;
+
+        // early data received during the handshake and not yet read
+        std::vector<octet> m_early_data;
+        size_t             m_early_data_read;
+
+        /**
+         * copy out any early data not yet read, returns the number of bytes copied
+         */
+        int read_early_data(octet *data, int n);
 
         /**
          * get the error string generated by the SSL library
@@ -90,7 +129,7 @@ namespace adns
         /**
          * construct a new ssl socket from the tcp socket returned from an accept call
          */
-        std::shared_ptr<tcp_server_socket> make_ssl_socket(const std::shared_ptr<tcp_server_socket> &ts);
+        std::shared_ptr<tcp_server_socket> make_ssl_socket(const std::shared_ptr<tcp_server_socket> &ts, bool handshake = true);
 
         /**
          * SSL callback for protocol negotiation
@@ -87,3 +87,20 @@ void tcp_client_socket::start_connect(const socket_address &remote_address)
         THROW(tcp_socket_exception, "start_connect() failed", util::strerror(), errno);
     }
 }
+
+void tcp_client_socket::finish_connect()
+{
+    int e = 0;
+    socklen_t len = sizeof(e);
+
+    if (getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &e, &len) != 0)
+    {
+        THROW(tcp_socket_exception, "getsockopt() failed", util::strerror(), errno);
+    }
+
+    if (e != 0)
+    {
+        errno = e;
+        THROW(tcp_socket_exception, "connect() failed", util::strerror(), e);
+    }
+}
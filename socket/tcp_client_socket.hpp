@@ -53,5 +53,10 @@ namespace adns
          */
         void start_connect(const socket_address &remote_address);
 
+        /**
+         * check the result of an asynchronous connect once the socket is writable
+         */
+        void finish_connect();
+
     };
 }
@@ -127,6 +127,54 @@ buffer tcp_socket::read(int n, uint timeout_ms)
     }
 }
 
+int tcp_socket::read_some(octet *data, int n)
+{
+    int bytes_read = ::read(m_fd, data, n);
+
+    if (bytes_read > 0)
+    {
+        return bytes_read;
+    }
+    else if (bytes_read == 0)
+    {
+        THROW(tcp_socket_eof_exception, "end of file");
+    }
+    else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+    {
+        return 0;
+    }
+    else
+    {
+        THROW(tcp_socket_exception, "read() failed", util::strerror(), errno);
+    }
+}
+
+int tcp_socket::read_available(octet *data, int n, uint timeout_ms)
+{
+    time_point<steady_clock> start_time = steady_clock::now();
+    duration<int, milli> timeout(timeout_ms);
+
+    while (true)
+    {
+        int bytes_read = read_some(data, n);
+
+        if (bytes_read > 0)
+        {
+            return bytes_read;
+        }
+
+        if (run_state::o_state == run_state::shutdown_e)
+        {
+            THROW(tcp_socket_timeout_exception, "read timed out on shutdown");
+        }
+
+        if ((steady_clock::now() - start_time) > timeout)
+        {   
+            THROW(tcp_socket_timeout_exception, "read timed out");
+        }
+    }
+}
+
 void tcp_socket::write(const buffer &data, uint timeout_ms)
 {
     write(data.get_data(), data.get_size(), timeout_ms);
@@ -190,6 +238,24 @@ void tcp_socket::write(const octet *data, uint n, uint timeout_ms)
     }
 }
 
+int tcp_socket::write_some(const octet *data, int n)
+{
+    int bytes_written = ::write(m_fd, data, n);
+
+    if (bytes_written >= 0)
+    {
+        return bytes_written;
+    }
+    else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+    {
+        return 0;
+    }
+    else
+    {
+        THROW(tcp_socket_exception, "write() failed", util::strerror(), errno);
+    }
+}
+
 const socket_address &tcp_socket::get_remote_address()
 {
     return m_remote_address;
@@ -74,6 +74,18 @@ namespace adns
          */
         virtual buffer read(int n, uint timeout_ms);
 
+        /**
+         * read whatever is available without waiting, up to n bytes. Returns the number
+         * of bytes read, 0 if there's nothing there yet.
+         */
+        virtual int read_some(octet *data, int n);
+
+        /**
+         * read at least one and up to n bytes, waiting up to the timeout for something to
+         * arrive. Returns the number of bytes read - throw tcp_socket_exception on timeout.
+         */
+        int read_available(octet *data, int n, uint timeout_ms);
+
         /**
          * write buffer with a timeout - throw tcp_socket_exception in that case.
          */
@@ -84,6 +96,12 @@ namespace adns
          */
         virtual void write(const octet *data, uint n, uint timeout_ms);
 
+        /**
+         * write as much as will go without waiting, up to n bytes. Returns the number of
+         * bytes written, 0 if the socket can't take any more yet.
+         */
+        virtual int write_some(const octet *data, int n);
+
         /**
          * get the remote address - only valid for connected sockets
          */
@@ -32,9 +32,13 @@ using namespace std;
 using namespace chrono;
 using namespace adns;
 
-udp_socket::udp_socket(const socket_address &sa) : socket()
+udp_socket::udp_socket(const socket_address &sa, bool reuse_port) : socket()
 {
     create_socket(sa.get_ip_address().get_type(), false);
+    if (reuse_port)
+    {
+        set_reuse_port();
+    }
     bind_socket(sa);
 }
 
@@ -114,14 +118,50 @@ buffer udp_socket::receive(socket_address &remote_address, uint timeout_ms)
     }
 }
 
+void udp_socket::set_receive_timestamps()
+{
+    int on = 1;
+
+    if (setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0)
+    {
+        THROW(udp_socket_exception, "setsockopt() failed", util::strerror(), errno);
+    }
+}
+
+static steady_clock::time_point kernel_receive_time(struct msghdr &h)
+{
+    for (auto c = CMSG_FIRSTHDR(&h); c != nullptr; c = CMSG_NXTHDR(&h, c))
+    {
+        if ((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == SCM_TIMESTAMPNS))
+        {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+
+            // the stamp is wall clock time so work out how long ago that was and go back
+            // that far from now on the steady clock
+            auto stamp = system_clock::time_point(duration_cast<system_clock::duration>(seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec)));
+            auto age = system_clock::now() - stamp;
+
+            if (age > system_clock::duration::zero())
+            {
+                return steady_clock::now() - duration_cast<steady_clock::duration>(age);
+            }
+
+            break;
+        }
+    }
+
+    return steady_clock::now();
+}
+
 int udp_socket::receive_many(int max, message **messages)
 {
     int num_read = 0;
 
     int res = -1;
-    socklen_t remote_len;
 
     octet data[MAX_UDP_MESSAGE_SIZE];
+    octet control[CMSG_SPACE(sizeof(struct timespec))];
 
     try
     {
@@ -133,29 +173,22 @@ int udp_socket::receive_many(int max, message **messages)
             }
 
             socket_address remote_address;
+            struct sockaddr_storage remote;
+            struct iovec iov;
+            struct msghdr h;
 
-            if (m_ip_type == ip_address::ip_v4_e)
-            {
-                struct sockaddr_in remote;
-                remote_len = sizeof(remote);
+            iov.iov_base = data;
+            iov.iov_len = MAX_UDP_MESSAGE_SIZE;
 
-                res = ::recvfrom(m_fd, data, MAX_UDP_MESSAGE_SIZE, 0, (struct sockaddr *)&remote, &remote_len);
-                if (res != -1)
-                {
-                    remote_address = socket_address(remote);
-                }
-            }
-            else
-            {
-                struct sockaddr_in6 remote;
-                remote_len = sizeof(remote);
+            memset(&h, 0, sizeof(h));
+            h.msg_name = &remote;
+            h.msg_namelen = sizeof(remote);
+            h.msg_iov = &iov;
+            h.msg_iovlen = 1;
+            h.msg_control = control;
+            h.msg_controllen = sizeof(control);
 
-                res = ::recvfrom(m_fd, data, MAX_UDP_MESSAGE_SIZE, 0, (struct sockaddr *)&remote, &remote_len);
-                if (res != -1)
-                {
-                    remote_address = socket_address(remote);
-                }
-            }
+            res = ::recvmsg(m_fd, &h, 0);
 
             if (res ==-1)
             {
@@ -165,14 +198,23 @@ int udp_socket::receive_many(int max, message **messages)
                 }
                 else
                 {
-                    THROW(udp_socket_exception, "recvfrom() failed", util::strerror(), errno);
+                    THROW(udp_socket_exception, "recvmsg() failed", util::strerror(), errno);
                 }
             }
             else
             {
+                if (m_ip_type == ip_address::ip_v4_e)
+                {
+                    remote_address = socket_address(*reinterpret_cast<struct sockaddr_in *>(&remote));
+                }
+                else
+                {
+                    remote_address = socket_address(*reinterpret_cast<struct sockaddr_in6 *>(&remote));
+                }
+
                 buffer b(res, data);
 
-                messages[num_read++] = new message(b, remote_address);
+                messages[num_read++] = new message(b, remote_address, kernel_receive_time(h));
             
                 if (num_read >= max)
                 {
@@ -209,8 +251,8 @@ void udp_socket::send(const buffer &data, const socket_address &remote_address)
     }
 }
 
-udp_socket::message::message(buffer &b, socket_address &remote_address) : 
-                                            m_message(b), m_remote_address(remote_address)
+udp_socket::message::message(buffer &b, socket_address &remote_address, steady_clock::time_point received_time) : 
+                                            m_message(b), m_remote_address(remote_address), m_received_time(received_time)
 {
 }
 
@@ -224,6 +266,11 @@ const socket_address &udp_socket::message::get_remote_address() const noexcept
     return m_remote_address;
 }
 
+steady_clock::time_point udp_socket::message::get_received_time() const noexcept
+{
+    return m_received_time;
+}
+
 bool udp_socket::is_stream()
 {
     return false;
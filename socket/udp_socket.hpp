@@ -20,6 +20,7 @@
 #pragma once
 
 #include <list>
+#include <chrono>
 
 #include "socket.hpp"
 #include "socket_address.hpp"
@@ -40,20 +41,22 @@ namespace adns
     public:
 
         /** 
-         * wrapper of a message from a socket along with its source address
+         * wrapper of a message from a socket along with its source address and when it arrived
          */
         class message final
         {
         public:
 
-            message(buffer &b, socket_address &remote_address);
+            message(buffer &b, socket_address &remote_address, std::chrono::steady_clock::time_point received_time);
             const buffer &get_message() const noexcept;
             const socket_address &get_remote_address() const noexcept;
+            std::chrono::steady_clock::time_point get_received_time() const noexcept;
 
         private:
         
             buffer m_message;
             socket_address m_remote_address;
+            std::chrono::steady_clock::time_point m_received_time;
         };
 
         /**
@@ -62,9 +65,10 @@ namespace adns
         udp_socket(ip_address::ip_type_t t = ip_address::ip_v4_e);
 
         /**
-         * socket bound to the given address (IP type is derived from the address).
+         * socket bound to the given address (IP type is derived from the address). With
+         * reuse_port set, other sockets may bind to the same address.
          */
-        udp_socket(const socket_address &sa);
+        udp_socket(const socket_address &sa, bool reuse_port = false);
 
         /**
          * close and destroy
@@ -81,6 +85,12 @@ namespace adns
          */
         buffer receive(socket_address &remote_address, uint timeout_ms);
 
+        /**
+         * have the kernel stamp packets with their arrival time so that receive_many() can 
+         * tell how long they sat in the socket buffer
+         */
+        void set_receive_timestamps();
+
         /**
          * receive up to N available messages (could be 0) from a previously bound socket in non-blocking mode.
          * @param   IN  max      - maximum number of messages to be read
@@ -106,6 +106,17 @@ def test_monitor():
     else:
         print('monitor test 1: FAILED')
 
+def test_upstream_server():
+
+    print('TESTING upstream server API')
+
+    response_code, data = make_request('GET', '1/upstream_server', None)
+    print('response code is', response_code)
+    if response_code == 200:
+        print(json.dumps(json.loads(data), indent=4, sort_keys=True))
+    else:
+        print('upstream server test 1: FAILED')
+
 def test_server():
 
     print('TESTING server API')
@@ -234,8 +245,18 @@ def test_cache_config():
 
     m = {
         "cache_garbage_collect_ms": 60001,
-        "cache_max_answer_rrs": 10001,
-        "cache_max_referral_rrs": 10001,
+        "cache_max_answer_kb": 65537,
+        "cache_max_referral_kb": 16385,
+        "cache_shards": 16,
+        "prefetch_min_hits": 11,
+        "prefetch_ttl_pct": 11,
+        "serve_stale": True,
+        "stale_answer_ttl": 31,
+        "max_stale_ttl": 86401,
+        "snapshot_file": "/tmp/argo-dns-cache.snapshot",
+        "snapshot_interval_s": 301,
+        "root_zone_file": "/tmp/root.zone",
+        "root_zone_refresh_s": 3601,
         "client": {
             "connect_tcp_timeout_ms": 1001,
             "num_parallel_udp": 3,
@@ -525,6 +546,7 @@ def test():
     #test_run_state()
     test_auth_token()
     #test_monitor()
+    #test_upstream_server()
     #test_server()
     #test_base_config()
     #test_cache_config()
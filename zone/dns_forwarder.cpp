@@ -0,0 +1,48 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#include "dns_forwarder.hpp"
+
+using namespace adns;
+
+dns_forwarder::dns_forwarder(const socket_address &address, uint weight, bool use_tls) : 
+                    m_address(address), 
+                    m_weight(weight), 
+                    m_use_tls(use_tls)
+{
+}
+
+dns_forwarder::~dns_forwarder()
+{
+}
+
+const socket_address &dns_forwarder::get_address() const
+{
+    return m_address;
+}
+
+uint dns_forwarder::get_weight() const
+{
+    return m_weight;
+}
+
+bool dns_forwarder::get_use_tls() const
+{
+    return m_use_tls;
+}
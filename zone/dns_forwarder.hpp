@@ -0,0 +1,66 @@
+//
+//  Copyright 2025 Andrew Haisley
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and 
+//  associated documentation files (the “Software”), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all copies or substantial 
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT 
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+ 
+#pragma once
+
+#include "types.hpp"
+#include "socket_address.hpp"
+
+namespace adns
+{
+    /**
+     * an upstream server that queries for a forwarded zone can be sent to
+     */
+    class dns_forwarder final
+    {
+    public:
+
+        /**
+         * constructor, weight is the share of queries relative to the zone's other forwarders
+         * and use_tls sends them over DNS over TLS (RFC 7858) rather than plain UDP/TCP
+         */
+        dns_forwarder(const socket_address &address, uint weight = 1, bool use_tls = false);
+
+        /**
+         * destructor
+         */
+        virtual ~dns_forwarder();
+
+        /**
+         * where to send the queries
+         */
+        const socket_address &get_address() const;
+
+        /**
+         * relative share of queries
+         */
+        uint get_weight() const;
+
+        /**
+         * DNS over TLS?
+         */
+        bool get_use_tls() const;
+
+    private:
+
+        socket_address m_address;
+        uint           m_weight;
+        bool           m_use_tls;
+    };
+}
@@ -29,6 +29,7 @@
 #include "connection_guard.hpp"
 #include "connection_pool.hpp"
 #include "row_zone.hpp"
+#include "row_zone_forwarder.hpp"
 #include "dns_rr_cache.hpp"
 #include "dns_rr_dal.hpp"
 #include "dns_rr_parser.hpp"
@@ -78,6 +79,7 @@ dns_zone::dns_zone()
 void dns_zone::delete_zone_db(connection &conn)
 {
     o_rr_cache->delete_records_db(conn, *this);
+    row_zone_forwarder::delete_by_zone_id(conn, get_zone_id());
     auto row = row_zone::get_by_zone_id(conn, get_zone_id());
     row->delete_row(conn);
 }
@@ -95,7 +97,8 @@ dns_zone::dns_zone(
             uuid                        horizon_id, 
             bool                        is_forwarded,
             const nullable<ip_address>  &forward_ip_address,
-            nullable<uint>              forward_port)
+            nullable<uint>              forward_port,
+            const vector<dns_forwarder> &additional_forwarders)
 {
     m_zone_id = zone_id;
     m_name = name;
@@ -106,6 +109,35 @@ dns_zone::dns_zone(
     {
         m_forward_ip_address = forward_ip_address.value();
         m_forward_port = forward_port.value();
+        m_additional_forwarders = additional_forwarders;
+        build_forwarders();
+    }
+}
+
+void dns_zone::build_forwarders()
+{
+    auto f = make_shared<vector<dns_forwarder>>();
+
+    f->push_back(dns_forwarder(socket_address(m_forward_ip_address, m_forward_port)));
+    f->insert(f->end(), m_additional_forwarders.begin(), m_additional_forwarders.end());
+
+    m_forwarders = f;
+}
+
+void dns_zone::insert_forwarders_db(connection &conn)
+{
+    for (auto &f : m_additional_forwarders)
+    {
+        row_zone_forwarder r;
+
+        r.set_new_primary_key_value();
+        r.set_zone_id(m_zone_id);
+        r.set_ip_address(f.get_address().get_ip_address().to_string());
+        r.set_port(f.get_address().get_port());
+        r.set_weight(f.get_weight());
+        r.set_use_tls(f.get_use_tls());
+
+        r.insert_row(conn);
     }
 }
 
@@ -165,6 +197,30 @@ void dns_zone::from_json(const json &j)
     {
         m_forward_ip_address = ip_address(j["forward_ip_address"]);
         m_forward_port = int(j["forward_port"]);
+
+        auto forwarders = j["forwarders"];
+
+        if (forwarders != json())
+        {
+            for (auto &f : forwarders.get_array())
+            {
+                auto weight = (*f)["weight"];
+                auto use_tls = (*f)["use_tls"];
+
+                m_additional_forwarders.push_back(
+                        dns_forwarder(
+                            socket_address(ip_address((*f)["ip_address"]), int((*f)["port"])), 
+                            (weight == json()) ? 1 : int(weight),
+                            (use_tls == json()) ? false : bool(use_tls)));
+
+                if (m_additional_forwarders.back().get_weight() == 0)
+                {
+                    THROW(dns_zone_exception, "forwarder weights must be greater than zero");
+                }
+            }
+        }
+
+        build_forwarders();
     }
     else
     {
@@ -213,6 +269,25 @@ json dns_zone::to_json() const
     {
         m["forward_ip_address"] = m_forward_ip_address.to_string();
         m["forward_port"] = int(m_forward_port);
+
+        if (!m_additional_forwarders.empty())
+        {
+            json forwarders(json::array_e);
+
+            for (auto &f : m_additional_forwarders)
+            {
+                json fj(json::object_e);
+
+                fj["ip_address"] = f.get_address().get_ip_address().to_string();
+                fj["port"] = f.get_address().get_port();
+                fj["weight"] = int(f.get_weight());
+                fj["use_tls"] = f.get_use_tls();
+
+                forwarders.append(fj);
+            }
+
+            m["forwarders"] = forwarders;
+        }
     }
 
     auto rrs = get_resource_records();
@@ -356,6 +431,18 @@ int dns_zone::get_forward_port() const
     }
 }
 
+const shared_ptr<const vector<dns_forwarder>> &dns_zone::get_forwarders() const
+{
+    if (m_is_forwarded)
+    {
+        return m_forwarders;
+    }
+    else
+    {
+        THROW(dns_zone_exception, "zone not forwarded");
+    }
+}
+
 list<shared_ptr<dns_rr_NS>> dns_zone::get_delegated_NS(const dns_name &name) const
 {
     return o_rr_cache->get_delegated_NS(*this, name);
@@ -463,6 +550,20 @@ void dns_zone::dns_zone_cache::read_data(const uuid &horizon_id)
     {
         uuid zone_id = row->get_zone_id();
 
+        vector<dns_forwarder> additional_forwarders;
+
+        if (row->get_is_forwarded())
+        {
+            for (auto f : row_zone_forwarder::get_by_zone_id(*conn, zone_id))
+            {
+                additional_forwarders.push_back(
+                        dns_forwarder(
+                            socket_address(ip_address(f->get_ip_address()), f->get_port()), 
+                            f->get_weight(), 
+                            f->get_use_tls()));
+            }
+        }
+
         shared_ptr<dns_zone> z(
                 new dns_zone(
                     zone_id, 
@@ -470,7 +571,8 @@ void dns_zone::dns_zone_cache::read_data(const uuid &horizon_id)
                     row->get_horizon_id(),
                     row->get_is_forwarded(),
                     row->get_forward_ip_address().is_null() ? nullable<ip_address>() : ip_address(row->get_forward_ip_address().value()),
-                    row->get_forward_port()));
+                    row->get_forward_port(),
+                    additional_forwarders));
 
         insert_zone(z);
     }
@@ -582,6 +684,8 @@ uuid dns_zone::insert_zone_db(connection &conn)
 
     z.insert_row(conn);
 
+    insert_forwarders_db(conn);
+
     if (!m_is_forwarded) 
     {
         for (auto rr : m_pending_resource_records)
@@ -627,6 +731,9 @@ void dns_zone::update_zone_db(connection &conn)
 
     z.update_row(conn);
 
+    row_zone_forwarder::delete_by_zone_id(conn, m_zone_id);
+    insert_forwarders_db(conn);
+
     if (m_pending_resource_records.size() > 0)
     {
         o_rr_cache->delete_records_db(conn, *this);
@@ -649,6 +756,8 @@ shared_ptr<dns_zone> dns_zone::clone() const
     res->m_name = m_name;
     res->m_forward_ip_address = m_forward_ip_address;
     res->m_forward_port = m_forward_port;
+    res->m_additional_forwarders = m_additional_forwarders;
+    res->m_forwarders = m_forwarders;
 
     return res;
 }
@@ -21,6 +21,7 @@
 
 #include <unordered_map>
 #include <map>
+#include <vector>
 #include <boost/functional/hash.hpp>
 
 #include "types.hpp"
@@ -36,6 +37,7 @@
 #include "dns_rr_CNAME.hpp"
 #include "dns_rr_DNAME.hpp"
 #include "dns_question.hpp"
+#include "dns_forwarder.hpp"
 #include "handler_pool.hpp"
 #include "connection.hpp"
 #include "connection.hpp"
@@ -106,6 +108,12 @@ namespace adns
         const ip_address &get_forward_ip_address() const;
         int get_forward_port() const;
 
+        /**
+         * Get every server that queries for a forwarded zone can be sent to. The first is 
+         * forward_ip_address/forward_port with a weight of 1, followed by any additional ones.
+         */
+        const std::shared_ptr<const std::vector<dns_forwarder>> &get_forwarders() const;
+
         /**
          * Get the SOA for the zone.
          */
@@ -371,6 +379,12 @@ namespace adns
         ip_address m_forward_ip_address;
         uint       m_forward_port;
 
+        // forwarders other than the one above, as stored in the DB
+        std::vector<dns_forwarder> m_additional_forwarders;
+
+        // all the forwarders, built once so queries can share them
+        std::shared_ptr<const std::vector<dns_forwarder>> m_forwarders;
+
         // temporary list of resource records pending update or insert of a new zone
         // instance into the DB and cache
         std::list<std::shared_ptr<dns_rr>> m_pending_resource_records;
@@ -384,7 +398,18 @@ namespace adns
             uuid                             horizon_id, 
             bool                             is_forwarded,
             const nullable<ip_address>       &forward_ip_address,
-            nullable<uint>                   forward_port);
+            nullable<uint>                   forward_port,
+            const std::vector<dns_forwarder> &additional_forwarders);
+
+        /**
+         * rebuild the full forwarder list after the primary or additional ones change
+         */
+        void build_forwarders();
+
+        /**
+         * write the additional forwarders for the zone to the DB
+         */
+        void insert_forwarders_db(db::connection &conn);
 
     };
 }